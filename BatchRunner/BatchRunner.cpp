@@ -0,0 +1,463 @@
+// Runs a universe without a window for a number of ticks, as fast as possible,
+// then prints the time spent in each phase of the update and statistics of the final universe.
+// Only links the simulation core, so it runs on machines without a display, such as servers and overnight batch jobs.
+
+#include "Universe.h"
+#include "UniverseSettings.h"
+#include "MyRandom.h"
+#include "SpatialPartitioning.h"
+#include "QuadTree.h"
+#include "Grid.h"
+#include "LineSweep.h"
+#include "SweepAndPrune.h"
+#include "DynamicAABBTree.h"
+#include "BarnesHutPartitioning.h"
+#include "NullPartitioning.h"
+#include "Checkpoint.h"
+#include "TrajectoryRecorder.h"
+#include "RemovalLog.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    // Everything the runner can be told on the command line.
+    struct RunSettings {
+        UniverseSettings universe;
+        std::string partitioning = "quadtree";
+        int ticks = 1000;
+        int seed = 1;
+
+        int quad_max_bodies = 10;
+        int quad_max_depth = 10;
+        int grid_nodes_per_row = 10;
+
+        // Checkpoint to resume from instead of generating a universe, and where to save checkpoints to.
+        std::string load_path;
+        std::string save_path;
+        int checkpoint_every = 0;
+
+        // Where to record the trajectory to, if anywhere.
+        std::string record_path;
+        TrajectoryRecorder::Settings recording;
+
+        // Where to log merges and deletions to, if anywhere, and the ticks each line of the summary printed from the log covers.
+        std::string removal_log_path;
+        int log_summary_every = 0;
+    };
+
+    constexpr std::string_view VALUE_OPTIONS[] = {
+        "--ticks", "--seed", "--capacity", "--systems", "--planets", "--size", "--gravity", "--approximation",
+        "--partitioning", "--quad-bodies", "--quad-depth", "--grid-nodes", "--load", "--save", "--checkpoint-every",
+        "--record", "--record-every", "--record-step", "--log-removals", "--log-summary-every"
+    };
+
+    void print_usage()
+    {
+        std::printf(
+            "Usage: BatchRunner [options]\n"
+            "  --ticks N              Number of ticks to run (default 1000)\n"
+            "  --seed N               Seed for universe generation (default 1)\n"
+            "  --capacity N           Maximum number of bodies\n"
+            "  --systems N            Number of random systems to generate\n"
+            "  --planets N            Number of random lone planets to generate\n"
+            "  --size X               Size of the area bodies start in\n"
+            "  --gravity exact|approx Exact n-body gravity, or the Barnes-Hut approximation (default exact)\n"
+            "  --approximation X      Barnes-Hut approximation value in [0, 1] (default 0.5)\n"
+            "  --partitioning NAME    quadtree, grid, linesweep, sweepandprune, aabbtree, barneshut, auto or none (default quadtree)\n"
+            "  --quad-bodies N        Max bodies per quad of a quad tree (default 10)\n"
+            "  --quad-depth N         Max depth of a quad tree (default 10)\n"
+            "  --grid-nodes N         Nodes per row of a grid (default 10)\n"
+            "  --neighbour-lists      Wrap the partitioning in neighbour lists\n"
+            "  --continuous           Also detect bodies passing through each other within a tick\n"
+            "  --load PATH            Resume the universe saved in a checkpoint, with its settings, instead of generating one\n"
+            "  --save PATH            Save a checkpoint of the universe after the last tick\n"
+            "  --checkpoint-every N   Also save a checkpoint every N ticks while running, without waiting for the write\n"
+            "  --record PATH          Record the trajectory of every body to a file while running\n"
+            "  --record-every N       Ticks between recorded frames (default 1)\n"
+            "  --record-step X        Precision positions and velocities are recorded with (default 1/256)\n"
+            "  --log-removals PATH    Append a record of every merge and deletion to a removal log while running\n"
+            "  --log-summary-every N  Ticks each line of the removal summary covers (default a tenth of the run)\n");
+    }
+
+    // What parsing the arguments ended in. Only RUN leaves settings to run with.
+    enum class ParseResult {
+        RUN,
+        HELP,
+        INVALID
+    };
+
+    // Parses the arguments into run. Returns INVALID after printing what was wrong, or HELP after printing the usage.
+    ParseResult parse_args(int argc, char* argv[], RunSettings& run)
+    {
+        run.universe.num_rand_systems = 10;
+        run.universe.universe_capacity = 10000;
+        run.universe.grav_approximation_value = 0.5f;
+
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+
+            if (arg == "--neighbour-lists") {
+                run.universe.use_neighbour_lists = true;
+                continue;
+            }
+            if (arg == "--continuous") {
+                run.universe.continuous_collisions = true;
+                continue;
+            }
+            if (arg == "--help" or arg == "-h") {
+                print_usage();
+                return ParseResult::HELP;
+            }
+
+            // Every other option takes a value.
+            if (std::ranges::find(VALUE_OPTIONS, arg) == std::end(VALUE_OPTIONS)) {
+                std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+                print_usage();
+                return ParseResult::INVALID;
+            }
+
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+                return ParseResult::INVALID;
+            }
+
+            const char* val = argv[++i];
+
+            if (arg == "--ticks") {
+                run.ticks = std::atoi(val);
+            }
+            else if (arg == "--seed") {
+                run.seed = std::atoi(val);
+            }
+            else if (arg == "--capacity") {
+                run.universe.universe_capacity = std::atoi(val);
+            }
+            else if (arg == "--systems") {
+                run.universe.num_rand_systems = std::atoi(val);
+            }
+            else if (arg == "--planets") {
+                run.universe.num_rand_planets = std::atoi(val);
+            }
+            else if (arg == "--size") {
+                run.universe.universe_size_start = std::atof(val);
+            }
+            else if (arg == "--gravity") {
+                std::string_view mode = val;
+                if (mode != "exact" and mode != "approx") {
+                    std::fprintf(stderr, "Unknown gravity mode %s\n", val);
+                    return ParseResult::INVALID;
+                }
+                run.universe.use_gravity_approximation = mode == "approx";
+            }
+            else if (arg == "--approximation") {
+                run.universe.grav_approximation_value = std::atof(val);
+            }
+            else if (arg == "--partitioning") {
+                run.partitioning = val;
+            }
+            else if (arg == "--quad-bodies") {
+                run.quad_max_bodies = std::atoi(val);
+            }
+            else if (arg == "--quad-depth") {
+                run.quad_max_depth = std::atoi(val);
+            }
+            else if (arg == "--grid-nodes") {
+                run.grid_nodes_per_row = std::atoi(val);
+            }
+            else if (arg == "--load") {
+                run.load_path = val;
+            }
+            else if (arg == "--save") {
+                run.save_path = val;
+            }
+            else if (arg == "--checkpoint-every") {
+                run.checkpoint_every = std::atoi(val);
+            }
+            else if (arg == "--record") {
+                run.record_path = val;
+            }
+            else if (arg == "--record-every") {
+                run.recording.record_every = std::max(1, std::atoi(val));
+            }
+            else if (arg == "--record-step") {
+                run.recording.step = std::atof(val);
+            }
+            else if (arg == "--log-removals") {
+                run.removal_log_path = val;
+            }
+            else if (arg == "--log-summary-every") {
+                run.log_summary_every = std::atoi(val);
+            }
+        }
+
+        if (run.checkpoint_every > 0 and run.save_path.empty()) {
+            std::fprintf(stderr, "--checkpoint-every needs --save\n");
+            return ParseResult::INVALID;
+        }
+
+        if (run.recording.step <= 0.0f) {
+            std::fprintf(stderr, "--record-step must be positive\n");
+            return ParseResult::INVALID;
+        }
+
+        run.universe.auto_tune_partitioning = run.partitioning == "auto";
+        return ParseResult::RUN;
+    }
+
+    // Creates the partitioning method named in the settings, or returns nullptr if there is no method with the name.
+    std::unique_ptr<SpatialPartitioning> make_partitioning(const RunSettings& run)
+    {
+        const std::string& name = run.partitioning;
+        float size = run.universe.universe_size_max;
+
+        if (name == "quadtree") {
+            return std::make_unique<QuadTree>(size, run.quad_max_bodies, run.quad_max_depth);
+        }
+        if (name == "grid") {
+            return std::make_unique<Grid>(size, run.grid_nodes_per_row);
+        }
+        if (name == "linesweep" or name == "auto") {
+            // The tuner swaps the line sweep for the fastest method after its first trial.
+            return std::make_unique<LineSweep>();
+        }
+        if (name == "sweepandprune") {
+            return std::make_unique<SweepAndPrune>();
+        }
+        if (name == "aabbtree") {
+            return std::make_unique<DynamicAABBTree>();
+        }
+        if (name == "barneshut") {
+            return std::make_unique<BarnesHutPartitioning>(size, run.universe.grav_approximation_value);
+        }
+        if (name == "none") {
+            return std::make_unique<NullPartitioning>();
+        }
+
+        return nullptr;
+    }
+
+    void print_phase(const char* name, double phase_ms, double total_ms, int ticks)
+    {
+        double share = total_ms > 0.0 ? 100.0 * phase_ms / total_ms : 0.0;
+        std::printf("  %-22s %12.1f %10.3f %7.1f%%\n", name, phase_ms, phase_ms / ticks, share);
+    }
+
+    // Reads the removal log back and prints the totals of the run's ticks, over spans of span_ticks.
+    void print_removal_summary(const std::string& path, int first_tick, int last_tick, int span_ticks)
+    {
+        std::string error;
+        std::optional<RemovalLogFile> log = RemovalLogFile::open(path, error);
+        if (!log) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return;
+        }
+
+        std::printf("  %-15s %9s %9s %11s %15s %12s\n", "Ticks", "Merges", "Deleted", "Merges/tick", "Mass absorbed", "Impact speed");
+        auto print_totals = [](const RemovalLogFile::Totals& totals) {
+            std::string ticks = std::to_string(totals.first_tick) + "-" + std::to_string(totals.last_tick);
+            std::printf("  %-15s %9lld %9lld %11.3f %15lld %12.3f\n", ticks.c_str(), totals.merges, totals.deletions,
+                totals.merges_per_tick(), totals.mass_absorbed, totals.mean_impact_speed());
+        };
+
+        for (const RemovalLogFile::Totals& totals : log->total_by_span(first_tick, last_tick, span_ticks)) {
+            print_totals(totals);
+        }
+        print_totals(log->total(first_tick, last_tick));
+        std::printf("\n");
+    }
+
+}
+
+int main(int argc, char* argv[])
+{
+    RunSettings run;
+    ParseResult parsed = parse_args(argc, argv, run);
+    if (parsed != ParseResult::RUN) {
+        return parsed == ParseResult::HELP ? 0 : 1;
+    }
+
+    if (run.ticks <= 0) {
+        std::fprintf(stderr, "Number of ticks must be positive\n");
+        return 1;
+    }
+
+    // A resumed universe keeps the settings it was saved with, so its partitioning is sized for them.
+    // Only auto tuning goes with the partitioning chosen on the command line.
+    std::optional<CheckpointFile> checkpoint;
+    if (!run.load_path.empty()) {
+        std::string error;
+        checkpoint = CheckpointFile::open(run.load_path, error);
+        if (!checkpoint) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+
+        bool auto_tune = run.universe.auto_tune_partitioning;
+        run.universe = checkpoint->get_settings();
+        run.universe.auto_tune_partitioning = auto_tune;
+    }
+
+    std::unique_ptr<SpatialPartitioning> partitioning = make_partitioning(run);
+    if (!partitioning) {
+        std::fprintf(stderr, "Unknown partitioning %s\n", run.partitioning.c_str());
+        return 1;
+    }
+
+    Rand::set_seed(run.seed);
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point generation_start = Clock::now();
+    std::optional<Universe> universe;
+    if (checkpoint) {
+        universe.emplace(*checkpoint, std::move(partitioning));
+    }
+    else {
+        universe.emplace(run.universe, std::move(partitioning));
+    }
+    double generation_ms = std::chrono::duration<double, std::milli>(Clock::now() - generation_start).count();
+
+    int start_bodies = universe->get_num_bodies();
+    int start_tick = universe->get_tick();
+
+    std::printf("Seed %d, capacity %d, %d systems, %d planets, %s gravity, %s partitioning%s%s\n",
+        run.seed, run.universe.universe_capacity, run.universe.num_rand_systems, run.universe.num_rand_planets,
+        run.universe.use_gravity_approximation ? "approximate" : "exact", run.partitioning.c_str(),
+        run.universe.use_neighbour_lists ? ", neighbour lists" : "", run.universe.continuous_collisions ? ", continuous collisions" : "");
+
+    if (checkpoint) {
+        std::printf("Restored %d bodies at tick %d from %s in %.1f ms\n\n", start_bodies, start_tick, run.load_path.c_str(), generation_ms);
+        checkpoint.reset();
+    }
+    else {
+        std::printf("Generated %d bodies in %.1f ms\n\n", start_bodies, generation_ms);
+    }
+
+    // Periodic checkpoints are written while the run goes on. One still being written when the next is due is waited for.
+    std::future<bool> pending_save;
+    int num_saves = 0;
+    auto finish_save = [&pending_save, &num_saves, &run]() {
+        if (pending_save.valid()) {
+            if (pending_save.get()) {
+                num_saves++;
+            }
+            else {
+                std::fprintf(stderr, "Could not save checkpoint to %s\n", run.save_path.c_str());
+            }
+        }
+    };
+
+    // Recorded frames are written on another thread. Any the writer is too slow for are dropped, and counted.
+    std::optional<TrajectoryRecorder> recorder;
+    if (!run.record_path.empty()) {
+        recorder.emplace(run.record_path, *universe, run.recording);
+        recorder->record(*universe);
+    }
+
+    // Removals are logged through a queue to another thread as well. Records are only dropped if the writer falls far behind.
+    std::optional<RemovalLogger> removal_logger;
+    if (!run.removal_log_path.empty()) {
+        removal_logger.emplace(run.removal_log_path, *universe, RemovalLogger::Settings {});
+    }
+
+    Clock::time_point run_start = Clock::now();
+    for (int i = 0; i < run.ticks; i++) {
+        universe->update();
+
+        if (recorder) {
+            recorder->record(*universe);
+        }
+
+        if (run.checkpoint_every > 0 and (i + 1) % run.checkpoint_every == 0 and i + 1 < run.ticks) {
+            finish_save();
+            pending_save = Checkpoint::save_async(Checkpoint::capture(*universe, Rand::get_state()), run.save_path);
+        }
+    }
+    double run_seconds = std::chrono::duration<double>(Clock::now() - run_start).count();
+
+    std::printf("Ran %d ticks in %.3f s (%.1f ticks/s)\n\n", run.ticks, run_seconds, run.ticks / run_seconds);
+
+    if (recorder) {
+        recorder->close();
+        TrajectoryRecorder::Stats stats = recorder->get_stats();
+        if (stats.failed) {
+            std::fprintf(stderr, "Could not record the trajectory to %s\n", run.record_path.c_str());
+        }
+        else {
+            std::printf("Recorded %lld frames to %s (%lld dropped), %.1f MiB as %.1f MiB, %.1fx compression, %.0f frames/s, %.1f MiB/s\n\n",
+                stats.frames_written, run.record_path.c_str(), stats.frames_dropped,
+                stats.raw_bytes / (1024.0 * 1024.0), stats.compressed_bytes / (1024.0 * 1024.0), stats.compression_ratio(),
+                stats.frames_per_second(), stats.raw_megabytes_per_second());
+        }
+    }
+
+    if (removal_logger) {
+        removal_logger->close();
+        RemovalLogger::Stats stats = removal_logger->get_stats();
+        if (stats.failed) {
+            std::fprintf(stderr, "Could not log removals to %s\n", run.removal_log_path.c_str());
+        }
+        else {
+            std::printf("Logged %lld removals to %s (%lld dropped), %.1f KiB\n\n",
+                stats.records_written, run.removal_log_path.c_str(), stats.records_dropped, stats.bytes_written / 1024.0);
+
+            int span_ticks = run.log_summary_every > 0 ? run.log_summary_every : std::max(1, run.ticks / 10);
+            print_removal_summary(run.removal_log_path, start_tick, universe->get_tick(), span_ticks);
+        }
+    }
+
+    finish_save();
+    if (!run.save_path.empty()) {
+        Clock::time_point save_start = Clock::now();
+        if (Checkpoint::capture(*universe, Rand::get_state()).save(run.save_path)) {
+            num_saves++;
+        }
+        else {
+            std::fprintf(stderr, "Could not save checkpoint to %s\n", run.save_path.c_str());
+        }
+        double save_ms = std::chrono::duration<double, std::milli>(Clock::now() - save_start).count();
+        std::printf("Saved %d checkpoints to %s, the last at tick %d in %.1f ms\n\n", num_saves, run.save_path.c_str(), universe->get_tick(), save_ms);
+    }
+
+    const Universe::PhaseTimes& times = universe->get_phase_times();
+    double total_ms = times.total_ms();
+
+    std::printf("  %-22s %12s %10s %8s\n", "Phase", "Total ms", "ms/tick", "Share");
+    print_phase("Gravity", times.gravity_ms, total_ms, run.ticks);
+    print_phase("Positions", times.positions_ms, total_ms, run.ticks);
+    print_phase("Partitioning update", times.partitioning_ms, total_ms, run.ticks);
+    print_phase("Collision detection", times.collision_detection_ms, total_ms, run.ticks);
+    print_phase("Collision handling", times.collision_handling_ms, total_ms, run.ticks);
+    print_phase("Partitioning tuning", times.tuning_ms, total_ms, run.ticks);
+    print_phase("Total", total_ms, total_ms, run.ticks);
+
+    std::printf("\nBodies: %d at start, %d at end\n", start_bodies, universe->get_num_bodies());
+    std::printf("Collision checks: %d total, %d last tick\n", universe->get_num_collision_checks(), universe->get_num_collision_checks_tick());
+
+    if (run.universe.continuous_collisions) {
+        std::printf("Swept collisions: %d\n", universe->get_num_swept_collisions());
+    }
+
+    if (const PartitioningTuner* tuner = universe->get_tuner()) {
+        std::printf("Partitioning (auto tuned): %s\n", tuner->get_active_name().c_str());
+        for (const std::string& entry : tuner->get_log()) {
+            std::printf("  %s\n", entry.c_str());
+        }
+    }
+
+    if (const NeighbourList* lists = universe->get_neighbour_lists()) {
+        std::printf("Neighbour lists: %d pairs, %zu KiB, rebuilt every %.1f ticks\n",
+            lists->get_num_pairs(), lists->get_memory_bytes() / 1024, lists->get_updates_per_rebuild());
+    }
+
+    return 0;
+}
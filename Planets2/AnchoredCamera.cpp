@@ -1,27 +1,32 @@
 #include "AnchoredCamera.h"
 #include "FreeCamera.h"
 #include "Body.h"
-#include "Universe.h"
+#include "UniverseSnapshot.h"
 
-AnchoredCamera::AnchoredCamera(const AdvCamera& starting_config, const Body& anchor_to, Universe& universe)
+AnchoredCamera::AnchoredCamera(const AdvCamera& starting_config, const Body& anchor_to, Event<RemovalBatch>& removal_event)
 {
     camera = starting_config;
 
-    listener = universe.removal_event().add_observer(
-        [this](Removal remove_event)
+    listener = removal_event.add_observer(
+        [this](RemovalBatch removals)
         {
-            if (anchored_to == remove_event.removed)
+            for (Removal remove_event : removals)
             {
-                // Since absorbed_by == -1 if just deleted, could switch to it without check.
-                // since -1 will transition out of anchored camera state on update.
-
-                if (remove_event.was_absorbed())
-                {
-                    this->switch_to(remove_event.absorbed_by);
-                }
-                else
+                if (anchored_to == remove_event.removed)
                 {
-                    unanchor();
+                    // Since absorbed_by == -1 if just deleted, could switch to it without check.
+                    // since -1 will transition out of anchored camera state on update.
+
+                    if (remove_event.was_absorbed())
+                    {
+                        this->switch_to(remove_event.absorbed_by);
+                    }
+                    else
+                    {
+                        unanchor();
+                    }
+
+                    // A snapshot can carry several ticks of removals, so the absorber may itself be absorbed later in the batch.
                 }
             }
         });
@@ -67,7 +72,7 @@ void AnchoredCamera::switch_to(int anchor_to)
     anchored_to = anchor_to;
 }
 
-CameraState* AnchoredCamera::update(Universe& universe)
+CameraState* AnchoredCamera::update(const UniverseSnapshot& universe, [[maybe_unused]] Event<RemovalBatch>& removal_event)
 {
     // Handle user switching to different bodies.
     if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
@@ -86,18 +91,20 @@ CameraState* AnchoredCamera::update(Universe& universe)
         }
     }
     
+    // A replay can seek past the anchored body's removal without its removal event, so the body may be gone.
+    const Body* body = is_anchored() ? universe.get_body(anchored_to) : nullptr;
+
     // Handle state transitions
     // anchored_to == nullptr if user right clicked on nothing or body deleted and was not absorbed by another body.
     // in any case, no body to anchor to, so return to a free camera state.
-    if (!is_anchored()) {
+    if (!body) {
         return new FreeCamera(camera);
     }
 
     // Will remain in an anchored camera state, so update camera and handle other user camera input.
 
     // Update camera to follow the body it is anchored to.
-    const Body& body = *universe.get_body(anchored_to); // Guaranteed valid id.
-    snap_camera_to_target(body);
+    snap_camera_to_target(*body);
 
     // Camera movement, offset to the target body
     // The center of the anchored body is never able to go off screen.
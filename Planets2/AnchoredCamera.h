@@ -17,7 +17,7 @@ class AnchoredCamera : public CameraState
 	int anchored_to = -1;
 	
 	// The listener returned when adding camera as an observer to anchored_to's remove event observer list.
-	EventHandle<Removal> listener;
+	EventHandle<RemovalBatch> listener;
 
 	// Moves the camera's target position to the center of the anchored body.
 	void snap_camera_to_target(const Body& target);
@@ -34,14 +34,15 @@ class AnchoredCamera : public CameraState
 public:
 
 	// Sets the anchored camera to the provided configuration.
-	AnchoredCamera(const AdvCamera& starting_config, const Body& anchor_to, Universe& universe);
+	// Listens to the removal event for the anchored body being absorbed or deleted.
+	AnchoredCamera(const AdvCamera& starting_config, const Body& anchor_to, Event<RemovalBatch>& removal_event);
 
 	// Adjusts the camera to focus on the given body.
 	void goto_body(Body& body);
 
 	// Snaps camera target to the currently anchored body's center.
 	// Processes input related to the camera, and updates and returns next camera state.
-	CameraState* update(Universe& universe) override;
+	CameraState* update(const UniverseSnapshot& universe, Event<RemovalBatch>& removal_event) override;
 
 	// Notifies the camera that the screen has been resized
 	void notify_resize(int width, int height);
@@ -1,8 +1,12 @@
 #include "BarnesHut.h"
 #include "Body.h"
 #include "Physics.h"
-#include <raymath.h>
-#include "MyRandom.h"
+#include "SimTypes.h"
+#include "Collision.h"
+#include "DebugInfo.h"
+#include "SpatialPartitioning.h"
+#include <string>
+#include <algorithm>
 
 BarnesHutNode::BarnesHutNode(float x, float y, float size) :
 	dimensions { x, y, size, size }
@@ -74,8 +78,37 @@ void BarnesHutNode::update_mass_add(Vector2 center, long mass)
 
 }
 
-void BarnesHutNode::add_body(Vector2 center, long mass)
+void BarnesHutNode::update_mass_rem(Vector2 center, long mass)
 {
+	// Reverse of update_mass_add.
+	auto& p = leaf_or_parent.parent;
+	long remaining_mass = p.mass_sum - mass;
+
+	if (remaining_mass <= 0)
+	{
+		p.center_of_mass = { 0, 0 };
+		p.mass_sum = 0;
+		return;
+	}
+
+	Vector2 current_moment_sum = Physics::moment(p.center_of_mass, p.mass_sum);
+	Vector2 removed_moment = Physics::moment(center, mass);
+
+	p.center_of_mass.x = (current_moment_sum.x - removed_moment.x) / remaining_mass;
+	p.center_of_mass.y = (current_moment_sum.y - removed_moment.y) / remaining_mass;
+	p.mass_sum = remaining_mass;
+}
+
+void BarnesHutNode::add_body(Vector2 center, long mass, Body* body)
+{
+	if (body)
+	{
+		// Bounds are grown on the way down, in the same pass as the center of mass.
+		Rectangle box = body->get_bounding_box();
+		bounds = num_tracked == 0 ? box : Physics::rects_union(bounds, box);
+		++num_tracked;
+	}
+
 	if (is_leaf())
 	{
 		auto& p = leaf_or_parent.leaf;
@@ -83,32 +116,33 @@ void BarnesHutNode::add_body(Vector2 center, long mass)
 		if (p.num_bodies == NODE_MAX_CAP)
 		{
 			split();
-			add_to_child(center, mass);
+			add_to_child(center, mass, body);
 			update_mass_add(center, mass);
 		}
 		else
 		{
 			p.point_masses[p.num_bodies] = { center, mass };
+			p.bodies[p.num_bodies] = body;
 			++p.num_bodies;
 		}
 	}
 	else
 	{
 		// add to one of our children
-		add_to_child(center, mass);
+		add_to_child(center, mass, body);
 		update_mass_add(center, mass);
 	}
 
 }
 
-void BarnesHutNode::add_to_child(Vector2 center, long mass)
+void BarnesHutNode::add_to_child(Vector2 center, long mass, Body* body)
 {
 	// Get the child quad that fully contains the body.
 	BarnesHutNode* contained_in = children->get_quad<&BarnesHutNode::contains>(center);
 
 	if (contained_in)
 	{
-		contained_in->add_body(center, mass);
+		contained_in->add_body(center, mass, body);
 	}
 	else
 	{
@@ -129,9 +163,18 @@ void BarnesHutNode::add_to_child(Vector2 center, long mass)
 		* than it is to crash because the depth got too high and the quad boxes don't line up perfectly.
 		*/
 
-		// Try to place in any empty quad, to avoid splitting even further.
-		BarnesHutNode* place_in = &children.get()->UL() + Rand::num(0, 4);
-		place_in->add_body(center, mass);
+		// Place in the lightest quad, to avoid splitting even further.
+		// Ties go to the first, so the tree, and the ticks using it, don't depend on random numbers.
+		BarnesHutNode* place_in = &children->UL();
+		for (BarnesHutNode* child : { &children->UR(), &children->LL(), &children->LR() })
+		{
+			if (child->total_mass() < place_in->total_mass())
+			{
+				place_in = child;
+			}
+		}
+
+		place_in->add_body(center, mass, body);
 	}
 
 }
@@ -141,6 +184,22 @@ bool BarnesHutNode::contains(Vector2 point) const
 	return Physics::point_in_rect(point, dimensions);
 }
 
+long BarnesHutNode::total_mass() const
+{
+	if (!is_leaf())
+	{
+		return leaf_or_parent.parent.mass_sum;
+	}
+
+	long mass = 0;
+	for (const auto& [center, point_mass] : leaf_or_parent.leaf.data_to_span())
+	{
+		mass += point_mass;
+	}
+
+	return mass;
+}
+
 bool BarnesHutNode::is_leaf() const
 {
 	return children == nullptr;
@@ -148,14 +207,112 @@ bool BarnesHutNode::is_leaf() const
 
 void BarnesHutNode::update(std::span<const Body> bodies)
 {
+	update(bodies.begin(), bodies.end());
+}
+
+void BarnesHutNode::rebuild()
+{
+	std::vector<Body*> bodies;
+	bodies.reserve(num_tracked);
+	collect_bodies(bodies);
+
+	// Added in id order, so the tree only depends on which bodies it has, not on the order they were added in before.
+	std::ranges::sort(bodies, {}, &Body::get_id);
+
 	concatenate();
 	leaf_or_parent.leaf.num_bodies = 0;
+	num_tracked = 0;
+
+	for (Body* body : bodies)
+	{
+		add_body(*body);
+	}
+}
+
+void BarnesHutNode::collect_bodies(std::vector<Body*>& bodies) const
+{
+	if (is_leaf())
+	{
+		for (int i = 0; i < leaf_or_parent.leaf.num_bodies; ++i)
+		{
+			if (Body* body = leaf_or_parent.leaf.bodies[i])
+			{
+				bodies.push_back(body);
+			}
+		}
+	}
+	else
+	{
+		for (const BarnesHutNode& child : *children)
+		{
+			child.collect_bodies(bodies);
+		}
+	}
+}
+
+void BarnesHutNode::add_body(Body& body)
+{
+	add_body(body.pos(), body.get_mass(), &body);
+}
+
+void BarnesHutNode::rem_body(const Body& body)
+{
+	rem_body(&body, body.pos());
+}
 
-	for (const Body& body : bodies)
+std::optional<std::pair<Vector2, long>> BarnesHutNode::rem_body(const Body* body, Vector2 near)
+{
+	if (is_leaf())
 	{
-		add_body(body.pos(), body.get_mass());
+		auto& p = leaf_or_parent.leaf;
+		for (int i = 0; i < p.num_bodies; ++i)
+		{
+			if (p.bodies[i] == body)
+			{
+				std::pair<Vector2, long> removed = p.point_masses[i];
+
+				// Keep the remaining point masses packed at the front.
+				for (int j = i + 1; j < p.num_bodies; ++j)
+				{
+					p.point_masses[j - 1] = p.point_masses[j];
+					p.bodies[j - 1] = p.bodies[j];
+				}
+
+				--p.num_bodies;
+				--num_tracked;
+				return removed;
+			}
+		}
+
+		return std::nullopt;
 	}
 
+	// Bounds are left as they are. They still contain every remaining body, and are recalculated on rebuild.
+	for (BarnesHutNode* child : children_towards(near))
+	{
+		if (auto removed = child->rem_body(body, near))
+		{
+			update_mass_rem(removed->first, removed->second);
+			--num_tracked;
+			return removed;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::array<BarnesHutNode*, 4> BarnesHutNode::children_towards(Vector2 point) const
+{
+	std::array<BarnesHutNode*, 4> ordered { &children->UL(), &children->UR(), &children->LL(), &children->LR() };
+
+	// Bodies are placed in the child that contains them, so searching it first nearly always finds them.
+	auto first = std::find_if(ordered.begin(), ordered.end(), [point](const BarnesHutNode* child) { return child->contains(point); });
+	if (first != ordered.end())
+	{
+		std::rotate(ordered.begin(), first, ordered.end());
+	}
+
+	return ordered;
 }
 
 void BarnesHutNode::split()
@@ -173,9 +330,11 @@ void BarnesHutNode::split()
 	// add children to new leaves and calculate center of mass / mass sum set here.
 	Vector2 moment_sum { 0, 0 };
 	long mass_sum = 0l;
-	for (const auto& p : leaf_or_parent.leaf.data_to_span())
+	const auto& leaf = leaf_or_parent.leaf;
+	for (int i = 0; i < leaf.num_bodies; ++i)
 	{
-		add_to_child(p.first, p.second);
+		const auto& p = leaf.point_masses[i];
+		add_to_child(p.first, p.second, leaf.bodies[i]);
 
 		moment_sum = Vector2Add(moment_sum, Physics::moment(p.first, p.second));
 		mass_sum += p.second;
@@ -191,6 +350,249 @@ void BarnesHutNode::concatenate()
 	children.reset();
 }
 
+int BarnesHutNode::get_collisions(std::vector<Collision>& collisions) const
+{
+	int checks = 0;
+
+	if (is_leaf())
+	{
+		const auto& p = leaf_or_parent.leaf;
+		for (int i = 0; i < p.num_bodies; ++i)
+		{
+			for (int j = i + 1; j < p.num_bodies; ++j)
+			{
+				if (!p.bodies[i] or !p.bodies[j])
+				{
+					continue;
+				}
+
+				++checks;
+				if (p.bodies[i]->collided_with(*p.bodies[j]))
+				{
+					collisions.emplace_back(Body::get_sorted_pair(*p.bodies[i], *p.bodies[j]));
+				}
+			}
+		}
+
+		return checks;
+	}
+
+	if (num_tracked >= PARALLEL_MIN_BODIES)
+	{
+		return get_collisions_children_parallel(collisions);
+	}
+
+	for (const BarnesHutNode& child : *children)
+	{
+		checks += child.get_collisions(collisions);
+	}
+
+	// Bodies are placed by their center, so they can reach into sibling nodes.
+	for (auto it1 = children->begin(); it1 != children->end(); ++it1)
+	{
+		for (auto it2 = it1 + 1; it2 != children->end(); ++it2)
+		{
+			checks += it1->get_collisions_between(*it2, collisions);
+		}
+	}
+
+	return checks;
+}
+
+int BarnesHutNode::get_collisions_children_parallel(std::vector<Collision>& collisions) const
+{
+	// Either a child's whole subtree (second == nullptr), or a pair of sibling subtrees.
+	struct SubtreeWork
+	{
+		const BarnesHutNode* first;
+		const BarnesHutNode* second;
+	};
+
+	std::vector<SubtreeWork> work;
+	work.reserve(10);
+
+	for (const BarnesHutNode& child : *children)
+	{
+		work.push_back({ &child, nullptr });
+	}
+
+	for (auto it1 = children->begin(); it1 != children->end(); ++it1)
+	{
+		for (auto it2 = it1 + 1; it2 != children->end(); ++it2)
+		{
+			work.push_back({ &*it1, &*it2 });
+		}
+	}
+
+	return SpatialPartitioning::gather_parallel(work.size(), [&work](int unit, std::vector<Collision>& unit_collisions)
+	{
+		const SubtreeWork& subtrees = work[unit];
+		if (subtrees.second)
+		{
+			return subtrees.first->get_collisions_between(*subtrees.second, unit_collisions);
+		}
+
+		return subtrees.first->get_collisions(unit_collisions);
+	}, collisions);
+}
+
+int BarnesHutNode::get_collisions_between(const BarnesHutNode& other, std::vector<Collision>& collisions) const
+{
+	// Only descend while the bounding boxes of both subtrees overlap.
+	if (num_tracked == 0 or other.num_tracked == 0 or !Physics::rects_intersect(bounds, other.bounds))
+	{
+		return 0;
+	}
+
+	int checks = 0;
+
+	if (is_leaf() and other.is_leaf())
+	{
+		const auto& p1 = leaf_or_parent.leaf;
+		const auto& p2 = other.leaf_or_parent.leaf;
+		for (int i = 0; i < p1.num_bodies; ++i)
+		{
+			// Skip bodies that don't reach any of the other leaf's bodies.
+			if (!p1.bodies[i] or !Physics::rects_intersect(p1.bodies[i]->get_bounding_box(), other.bounds))
+			{
+				continue;
+			}
+
+			for (int j = 0; j < p2.num_bodies; ++j)
+			{
+				if (!p2.bodies[j])
+				{
+					continue;
+				}
+
+				++checks;
+				if (p1.bodies[i]->collided_with(*p2.bodies[j]))
+				{
+					collisions.emplace_back(Body::get_sorted_pair(*p1.bodies[i], *p2.bodies[j]));
+				}
+			}
+		}
+	}
+	else if (other.is_leaf() or (!is_leaf() and dimensions.width >= other.dimensions.width))
+	{
+		// Split the larger node, so both sides shrink at a similar rate.
+		for (const BarnesHutNode& child : *children)
+		{
+			checks += child.get_collisions_between(other, collisions);
+		}
+	}
+	else
+	{
+		for (const BarnesHutNode& child : *other.children)
+		{
+			checks += get_collisions_between(child, collisions);
+		}
+	}
+
+	return checks;
+}
+
+Body* BarnesHutNode::find_body(Vector2 point) const
+{
+	if (num_tracked == 0 or !Physics::point_in_rect(point, bounds))
+	{
+		return nullptr;
+	}
+
+	if (is_leaf())
+	{
+		const auto& p = leaf_or_parent.leaf;
+		for (int i = 0; i < p.num_bodies; ++i)
+		{
+			if (p.bodies[i] and p.bodies[i]->contains_point(point))
+			{
+				return p.bodies[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	for (const BarnesHutNode& child : *children)
+	{
+		if (Body* body = child.find_body(point))
+		{
+			return body;
+		}
+	}
+
+	return nullptr;
+}
+
+void BarnesHutNode::query_rect(Rectangle area, std::vector<Body*>& found) const
+{
+	if (num_tracked == 0 or !Physics::rects_intersect(bounds, area))
+	{
+		return;
+	}
+
+	if (is_leaf())
+	{
+		const auto& p = leaf_or_parent.leaf;
+		for (int i = 0; i < p.num_bodies; ++i)
+		{
+			if (p.bodies[i] and p.bodies[i]->intersects_rect(area))
+			{
+				found.push_back(p.bodies[i]);
+			}
+		}
+
+		return;
+	}
+
+	for (const BarnesHutNode& child : *children)
+	{
+		child.query_rect(area, found);
+	}
+}
+
+void BarnesHutNode::get_representation(std::vector<Rectangle>& rep) const
+{
+	if (is_leaf())
+	{
+		rep.push_back(dimensions);
+	}
+	else
+	{
+		for (const BarnesHutNode& child : *children)
+		{
+			child.get_representation(rep);
+		}
+	}
+}
+
+int BarnesHutNode::find_depth(const Body& body, int depth) const
+{
+	if (is_leaf())
+	{
+		const auto& p = leaf_or_parent.leaf;
+		bool found = std::find(p.bodies.begin(), p.bodies.begin() + p.num_bodies, &body) != p.bodies.begin() + p.num_bodies;
+		return found ? depth : -1;
+	}
+
+	for (const BarnesHutNode* child : children_towards(body.pos()))
+	{
+		int found_depth = child->find_depth(body, depth + 1);
+		if (found_depth != -1)
+		{
+			return found_depth;
+		}
+	}
+
+	return -1;
+}
+
+void BarnesHutNode::get_info(const Body& body, DebugInfo& info) const
+{
+	info.add("Tree Depth: " + std::to_string(find_depth(body, 0)));
+	info.add("Tree Bodies: " + std::to_string(num_tracked));
+}
+
 Vector2 BarnesHutNode::force_applied_to(Vector2 point, long mass, float approximation_value) const
 {
 	if (is_leaf())
@@ -209,6 +611,11 @@ Vector2 BarnesHutNode::force_applied_to(Vector2 point, long mass, float approxim
 
 	const auto& parent_data = leaf_or_parent.parent;
 
+	if (parent_data.mass_sum == 0)
+	{
+		// Every body below this node has been removed since it was built.
+		return { 0, 0 };
+	}
 
 	if (sufficiently_far(point, approximation_value))
 	{
@@ -240,3 +647,10 @@ Vector2 BarnesHut::force_applied_to(const Body& body) const
 {
 	return root.force_applied_to(body.pos(), body.get_mass(), approximation_value_squared);
 }
+
+std::vector<Rectangle> BarnesHut::get_representation() const
+{
+	std::vector<Rectangle> rep;
+	root.get_representation(rep);
+	return rep;
+}
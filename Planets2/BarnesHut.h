@@ -1,10 +1,16 @@
 #pragma once
 
-#include "raylib.h"
+#include "SimTypes.h"
 #include <span>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <cstring>
 #include "QuadChildren.h"
 
 class Body;
+struct Collision;
+class DebugInfo;
 
 class BarnesHutNode
 {
@@ -16,6 +22,9 @@ class BarnesHutNode
 	// Leaf nodes modified to hold more than 1 body
 	//	to reduce depth of result tree.
 
+	// Nodes with at least this many bodies added by reference below them check their child nodes in parallel.
+	static constexpr int PARALLEL_MIN_BODIES = 1024;
+
 	// Union between leaf node info and parent node info.
 	// Could use variant.
 	static constexpr int NODE_MAX_CAP = 8;
@@ -31,6 +40,10 @@ class BarnesHutNode
 		struct
 		{
 			std::array<std::pair<Vector2, long>, NODE_MAX_CAP> point_masses;
+
+			// Bodies the point masses came from, if they were added by reference. Otherwise nullptr.
+			std::array<Body*, NODE_MAX_CAP> bodies;
+
 			int num_bodies;
 
 			std::span<const std::pair<Vector2, long>> data_to_span() const
@@ -48,6 +61,13 @@ class BarnesHutNode
 	// Area of this quad node.
 	Rectangle dimensions {};
 
+	// Bounding box of all bodies added by reference in and below this node.
+	// Grows as bodies are added, and is only shrunk by a rebuild.
+	Rectangle bounds {};
+
+	// Number of bodies added by reference in and below this node.
+	int num_tracked = 0;
+
 	// The node's 4 potential children.
 	std::unique_ptr<QuadChildren<BarnesHutNode>> children;
 
@@ -61,12 +81,39 @@ class BarnesHutNode
 	// Handles calculations for updating this node's mass sum and center of mass when a new point mass is added.
 	void update_mass_add(Vector2 center, long mass);
 
+	// Handles calculations for updating this node's mass sum and center of mass when a point mass is removed.
+	void update_mass_rem(Vector2 center, long mass);
+
 	// Will add a point mass to the most appropriate quad node.
 	// Potentially splits that node if it reached its capacity.
-	void add_body(Vector2 center, long mass);
+	// If the point mass comes from a body, the body is kept with it and the node's bounds are grown to contain it.
+	void add_body(Vector2 center, long mass, Body* body = nullptr);
 
 	// Adds the point mass to the correct child quad.
-	void add_to_child(Vector2 center, long mass);
+	void add_to_child(Vector2 center, long mass, Body* body);
+
+	// Returns the child nodes, starting with the one whose dimensions contain the point.
+	// Points are placed in another child when floating point error leaves them outside all four.
+	std::array<BarnesHutNode*, 4> children_towards(Vector2 point) const;
+
+	// Removes the body's point mass from the node or its children. Returns the removed point mass, if found.
+	std::optional<std::pair<Vector2, long>> rem_body(const Body* body, Vector2 near);
+
+	// Adds all bodies added by reference in and below this node to the vector.
+	void collect_bodies(std::vector<Body*>& bodies) const;
+
+	// Returns the depth of the leaf holding the body below this node, or -1 if not found.
+	int find_depth(const Body& body, int depth) const;
+
+	// Get collisions between bodies in this node's subtree and bodies in another, unrelated node's subtree.
+	int get_collisions_between(const BarnesHutNode& other, std::vector<Collision>& collisions) const;
+
+	// Gets collisions within each child node's subtree and between each pair of them.
+	// The subtrees and pairs of subtrees are checked in parallel, and their results merged in order.
+	int get_collisions_children_parallel(std::vector<Collision>& collisions) const;
+
+	// Returns the mass of every point mass in and below this node.
+	long total_mass() const;
 
 	// Returns true if this is a leaf node.
 	bool is_leaf() const;
@@ -92,6 +139,44 @@ public:
 	// Rebuilds the quadtree used for Barnes-Hut approximation.
 	void update(std::span<const Body> bodies);
 
+	// Rebuilds the quadtree used for Barnes-Hut approximation, from the bodies in [first, last).
+	template <typename It>
+	void update(It first, It last)
+	{
+		concatenate();
+		leaf_or_parent.leaf.num_bodies = 0;
+		num_tracked = 0;
+
+		for (; first != last; ++first)
+		{
+			add_body(first->pos(), first->get_mass());
+		}
+	}
+
+	// Rebuilds the quadtree from the bodies that were added to it by reference, at their current positions.
+	void rebuild();
+
+	// Adds the body by reference, so it can be used in collision detection.
+	void add_body(Body& body);
+
+	// Removes a body that was added by reference.
+	void rem_body(const Body& body);
+
+	// Adds all collisions between bodies added by reference to collisions vector. Returns the number of checks performed.
+	int get_collisions(std::vector<Collision>& collisions) const;
+
+	// Returns a pointer to a body added by reference that overlaps with the point. Returns nullptr if no body found.
+	Body* find_body(Vector2 point) const;
+
+	// Adds every body added by reference that overlaps with the area to found.
+	void query_rect(Rectangle area, std::vector<Body*>& found) const;
+
+	// Adds the dimensions of all leaves to rep.
+	void get_representation(std::vector<Rectangle>& rep) const;
+
+	// Attaches text related to the leaf which holds the body to info.
+	void get_info(const Body& body, DebugInfo& info) const;
+
 };
 
 // A specialized quad tree used in the Barnes Hut algorithm for approximating gravity simulation.
@@ -117,4 +202,61 @@ public:
 		root.update(bodies);
 	}
 
+	// Rebuilds the quadtree used for Barnes-Hut approximation, from the bodies in [first, last).
+	template <typename It>
+	void update(It first, It last)
+	{
+		root.update(first, last);
+	}
+
+	// The tree can also keep the bodies themselves, instead of only their point masses.
+	// Leaves then have the bodies' bounding boxes, so the tree can also be used to detect collisions.
+
+	// Rebuilds the quadtree from the bodies that were added to it by reference, at their current positions.
+	void rebuild()
+	{
+		root.rebuild();
+	}
+
+	// Adds the body by reference, so it can be used in collision detection.
+	void add_body(Body& body)
+	{
+		root.add_body(body);
+	}
+
+	// Removes a body that was added by reference.
+	void rem_body(const Body& body)
+	{
+		root.rem_body(body);
+	}
+
+	// Adds all collisions between bodies added by reference to collisions vector. Returns the number of checks performed.
+	int get_collisions(std::vector<Collision>& collisions) const
+	{
+		return root.get_collisions(collisions);
+	}
+
+	// Returns a pointer to a body added by reference that overlaps with the point. Returns nullptr if no body found.
+	Body* find_body(Vector2 point) const
+	{
+		return root.find_body(point);
+	}
+
+	// Returns every body added by reference that overlaps with the area.
+	std::vector<Body*> query_rect(Rectangle area) const
+	{
+		std::vector<Body*> found;
+		root.query_rect(area, found);
+		return found;
+	}
+
+	// Returns the dimensions of all leaves.
+	std::vector<Rectangle> get_representation() const;
+
+	// Attaches text related to the leaf which holds the body to info.
+	void get_info(const Body& body, DebugInfo& info) const
+	{
+		root.get_info(body, info);
+	}
+
 };
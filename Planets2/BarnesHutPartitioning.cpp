@@ -0,0 +1,57 @@
+#include "BarnesHutPartitioning.h"
+#include "SimTypes.h"
+
+#include "Collision.h"
+#include "Body.h"
+
+#include "DebugInfo.h"
+
+BarnesHutPartitioning::BarnesHutPartitioning(float size, float approximation_value) : tree(size, approximation_value)
+{}
+
+void BarnesHutPartitioning::add_body(Body& body)
+{
+    tree.add_body(body);
+}
+
+void BarnesHutPartitioning::rem_body(const Body& body)
+{
+    tree.rem_body(body);
+}
+
+void BarnesHutPartitioning::update()
+{
+    tree.rebuild();
+}
+
+Body* BarnesHutPartitioning::find_body(Vector2 point) const
+{
+    return tree.find_body(point);
+}
+
+std::vector<Body*> BarnesHutPartitioning::query_rect(Rectangle area) const
+{
+    return tree.query_rect(area);
+}
+
+std::vector<Rectangle> BarnesHutPartitioning::get_representation() const
+{
+    return tree.get_representation();
+}
+
+void BarnesHutPartitioning::get_info(const Body& body, DebugInfo& info) const
+{
+    tree.get_info(body, info);
+}
+
+const BarnesHut* BarnesHutPartitioning::get_gravity_tree() const
+{
+    return &tree;
+}
+
+std::vector<Collision> BarnesHutPartitioning::get_collisions_impl()
+{
+    std::vector<Collision> collisions;
+    num_collision_checks_tick = tree.get_collisions(collisions);
+    return collisions;
+}
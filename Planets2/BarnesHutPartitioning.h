@@ -0,0 +1,45 @@
+#pragma once
+#include "SpatialPartitioning.h"
+#include "BarnesHut.h"
+
+// Collision detection using the same Barnes-Hut tree that approximates gravity.
+// The tree is rebuilt once per tick after bodies move, and kept up to date through removals and merges,
+// so the universe can use it for the next tick's gravity instead of building a tree of its own.
+class BarnesHutPartitioning : public SpatialPartitioning
+{
+
+	BarnesHut tree;
+
+	// Detects collisions by traversing the tree, only descending where the bounds of nodes overlap.
+	std::vector<Collision> get_collisions_impl() override;
+
+public:
+
+	// Constructs a tree covering the universe's area, using the approximation value for gravity.
+	BarnesHutPartitioning(float size, float approximation_value);
+
+	// Adds the body to the tree.
+	void add_body(Body& body) override;
+
+	// Removes the body from the tree, and its mass from the tree's centers of mass.
+	void rem_body(const Body& body) override;
+
+	// Rebuilds the tree at the bodies' current positions.
+	void update() override;
+
+	// Returns a pointer to the body that contains the point. If none do, returns nullptr.
+	Body* find_body(Vector2 point) const override;
+
+	// Returns every body that overlaps with the area, only descending into nodes whose bounds overlap it.
+	std::vector<Body*> query_rect(Rectangle area) const override;
+
+	// Returns the dimensions of the tree's leaves.
+	std::vector<Rectangle> get_representation() const override;
+
+	// Attaches text indicating the depth of the body's leaf, and the number of bodies in the tree to info.
+	void get_info(const Body& body, DebugInfo& info) const override;
+
+	// Returns the tree, so that gravity is approximated with it.
+	const BarnesHut* get_gravity_tree() const override;
+
+};
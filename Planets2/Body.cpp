@@ -1,6 +1,6 @@
 #include "Body.h"
 #include "Physics.h"
-#include <raymath.h>
+#include "SimTypes.h"
 #include <cmath>
 
 #include "Orbit.h"
@@ -272,6 +272,21 @@ bool Body::intersects_rect(Rectangle rect) const
 	return Physics::circle_intersects_rect(Circle{ position, radius }, rect);
 }
 
+void Body::set_partition_bounds(Rectangle bounds)
+{
+	partition_bounds = bounds;
+}
+
+Rectangle Body::get_partition_bounds() const
+{
+	return partition_bounds;
+}
+
+bool Body::left_partition_bounds() const
+{
+	return !Physics::point_in_rect(position, partition_bounds);
+}
+
 bool Body::operator==(const Body& other) const
 {
 	return id == other.id;
@@ -1,7 +1,7 @@
 #ifndef BODY_H
 #define BODY_H
 
-#include <raylib.h>
+#include "SimTypes.h"
 #include "PlanetType.h"
 
 struct Orbit;
@@ -44,6 +44,10 @@ class Body {
 	// A pointer to this body's current planetary type.
 	const PlanetType* type = &TYPES[1]; // Starts as asteroid, updates on construction.
 
+	// Area the body's center can move within without its place in the spatial partitioning changing.
+	// Only set by partitionings that relocate just the bodies which left it.
+	Rectangle partition_bounds{};
+
 public:
 
 	// Returns a pair of body pointers, where the first has more mass than the second.
@@ -172,6 +176,15 @@ public:
 	bool in_rect(Rectangle rect) const;
 	bool intersects_rect(Rectangle rect) const;
 
+	// Sets the area the body's center can move within before the spatial partitioning has to relocate it.
+	void set_partition_bounds(Rectangle bounds);
+
+	// Returns the area set by set_partition_bounds.
+	Rectangle get_partition_bounds() const;
+
+	// Returns true if the body's center is outside the area set by set_partition_bounds.
+	bool left_partition_bounds() const;
+
 	// Returns true if this body's id is equal to the other body's id, else false.
 	bool operator==(const Body& other) const;
 
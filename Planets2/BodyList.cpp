@@ -1,28 +1,74 @@
 #include "BodyList.h"
+#include <algorithm>
 
-void BodyList::add(Body&& body)
+Body& BodyList::add(Body&& body)
 {
-	Body& added = active_bodies.emplace_back(body);
+	int slot;
+	if (free_slots.empty())
+	{
+		slot = slots.size();
+		slots.push_back(std::move(body));
+		active_index.push_back(0);
+	}
+	else
+	{
+		slot = free_slots.back();
+		free_slots.pop_back();
+		slots[slot] = std::move(body);
+	}
+
+	Body& added = slots[slot];
 	int id = generated_bodies++;
 	added.set_id(id);
 
-	// Map id to index that the new body was placed in.
-	id_map[id] = active_bodies.size() - 1;
+	id_slots.push_back(slot);
+	active_index[slot] = active_bodies.size();
+	active_bodies.push_back(&added);
 
+	return added;
 }
 
-void BodyList::rem(Body& body)
+void BodyList::restore(std::vector<Body>&& bodies, int next_id)
 {
-	Body& last = active_bodies.back();
+	// Ids given out since the state being restored stay given out, so records of their bodies never get mixed up with later ones.
+	next_id = std::max(next_id, generated_bodies);
+	clear();
+	generated_bodies = next_id;
 
-	// This code works even if body == last, no conflict.
-	int index_removed = id_map[body.get_id()];
-	id_map[last.get_id()] = index_removed;
-	id_map.erase(body.get_id());
+	slots.assign(std::make_move_iterator(bodies.begin()), std::make_move_iterator(bodies.end()));
+	bodies.clear();
 
+	active_index.resize(slots.size());
+	id_slots.assign(next_id, -1);
+	active_bodies.reserve(slots.size());
 
-	std::swap(body, last);
+	for (int slot = 0; slot < slots.size(); ++slot)
+	{
+		Body& body = slots[slot];
+		id_slots[body.get_id()] = slot;
+		active_index[slot] = slot;
+		active_bodies.push_back(&body);
+	}
+}
+
+int BodyList::get_next_id() const
+{
+	return generated_bodies;
+}
+
+void BodyList::rem(const Body& body)
+{
+	int slot = id_slots[body.get_id()];
+	int index = active_index[slot];
+
+	// Only the pointer to the last body moves, the body itself stays in its slot.
+	Body* last = active_bodies.back();
+	active_bodies[index] = last;
+	active_index[id_slots[last->get_id()]] = index;
 	active_bodies.pop_back();
+
+	id_slots[body.get_id()] = -1;
+	free_slots.push_back(slot);
 }
 
 int BodyList::size() const
@@ -38,60 +84,70 @@ bool BodyList::empty() const
 void BodyList::clear()
 {
 	generated_bodies = 0;
+	slots.clear();
+	free_slots.clear();
 	active_bodies.clear();
-	id_map.clear();
+	active_index.clear();
+	id_slots.clear();
 }
 
 void BodyList::reserve(int size)
 {
 	active_bodies.reserve(size);
+	active_index.reserve(size);
 }
 
-Body& BodyList::back()
+BodyList::iterator BodyList::begin()
 {
-	return active_bodies.back();
+	return iterator(active_bodies.cbegin());
 }
 
-std::span<const Body> BodyList::span() const
+BodyList::iterator BodyList::end()
 {
-	return active_bodies;
+	return iterator(active_bodies.cend());
 }
 
-std::vector<Body>::iterator BodyList::begin()
+BodyList::const_iterator BodyList::begin() const
 {
-	return active_bodies.begin();
+	return const_iterator(active_bodies.cbegin());
 }
 
-std::vector<Body>::iterator BodyList::end()
+BodyList::const_iterator BodyList::end() const
 {
-	return active_bodies.end();
+	return const_iterator(active_bodies.cend());
 }
 
-std::vector<Body>::const_iterator BodyList::cbegin() const
+BodyList::const_iterator BodyList::cbegin() const
 {
-	return active_bodies.cbegin();
+	return begin();
 }
 
-std::vector<Body>::const_iterator BodyList::cend() const
+BodyList::const_iterator BodyList::cend() const
 {
-	return active_bodies.cend();
+	return end();
 }
 
 Body& BodyList::operator[](int index)
 {
-	return active_bodies[index];
+	return *active_bodies[index];
 }
 
-int BodyList::get_index(int id) const
+Body* BodyList::get(int id)
 {
-	auto it = id_map.find(id);
-
-	if (it != id_map.end())
+	if (id < 0 or id >= id_slots.size() or id_slots[id] == -1)
 	{
-		return it->second;
+		return nullptr;
 	}
-	else
+
+	return &slots[id_slots[id]];
+}
+
+const Body* BodyList::get(int id) const
+{
+	if (id < 0 or id >= id_slots.size() or id_slots[id] == -1)
 	{
-		return -1;
+		return nullptr;
 	}
+
+	return &slots[id_slots[id]];
 }
@@ -1,29 +1,91 @@
 #pragma once
 
 #include <vector>
-#include <unordered_map>
+#include <deque>
+#include <iterator>
+#include <compare>
 #include "Body.h"
-#include <span>
 
+// A slot map of bodies, keyed by body id.
+// Bodies stay at the same address for as long as they are in the list, even as other bodies are added and removed.
+// So partitionings and collision events can hold on to pointers and references to them, without any fixups on removal.
 class BodyList
 {
-	// Bodies that are being updated every tick.
-	// No longer guaranteed sorted by id.
-	std::vector<Body> active_bodies;
+	// Storage for bodies. A deque does not move its elements when it grows.
+	// Slots of removed bodies are reused by later additions.
+	std::deque<Body> slots;
 
-	// Maps body ids to indices in active_bodies.
-	std::unordered_map<int, int> id_map;
+	// Slots whose bodies have been removed.
+	std::vector<int> free_slots;
+
+	// Bodies that are being updated every tick, in no particular order.
+	std::vector<Body*> active_bodies;
+
+	// Index in active_bodies of the body in each slot.
+	std::vector<int> active_index;
+
+	// Slot of each body id, or -1 if the body has been removed.
+	// Ids are never reused, not even after restoring an earlier state, so an id can't refer to another body once its own has been removed.
+	std::vector<int> id_slots;
 
 	// Total number of generated bodies (through calls to add())
 	int generated_bodies = 0;
 
 public:
 
-	// Adds body to the list and assigns it an id.
-	void add(Body&& body);
+	// Iterates over the active bodies by reference.
+	template <typename T>
+	class Iterator
+	{
+		std::vector<Body*>::const_iterator it;
+
+	public:
+
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Body;
+		using difference_type = std::ptrdiff_t;
+		using pointer = T*;
+		using reference = T&;
+
+		Iterator() = default;
+		explicit Iterator(std::vector<Body*>::const_iterator it) : it(it) {}
+
+		T& operator*() const { return **it; }
+		T* operator->() const { return *it; }
+		T& operator[](difference_type n) const { return *it[n]; }
+
+		Iterator& operator++() { ++it; return *this; }
+		Iterator operator++(int) { Iterator prev = *this; ++it; return prev; }
+		Iterator& operator--() { --it; return *this; }
+		Iterator operator--(int) { Iterator prev = *this; --it; return prev; }
 
-	// Removes the body associated with the id from active_bodies.
-	void rem(Body& body);
+		Iterator& operator+=(difference_type n) { it += n; return *this; }
+		Iterator& operator-=(difference_type n) { it -= n; return *this; }
+		Iterator operator+(difference_type n) const { return Iterator(it + n); }
+		Iterator operator-(difference_type n) const { return Iterator(it - n); }
+		friend Iterator operator+(difference_type n, Iterator iter) { return iter + n; }
+		difference_type operator-(const Iterator& other) const { return it - other.it; }
+
+		bool operator==(const Iterator& other) const = default;
+		auto operator<=>(const Iterator& other) const = default;
+	};
+
+	using iterator = Iterator<Body>;
+	using const_iterator = Iterator<const Body>;
+
+	// Adds body to the list and assigns it an id. Returns a reference to the added body.
+	Body& add(Body&& body);
+
+	// Replaces every body in the list with the given ones in a single pass. The bodies keep their ids and their order.
+	// next_id is the id the next added body gets, and must be greater than every given body's id.
+	// If ids up to a higher one have already been given out, counting carries on from there instead.
+	void restore(std::vector<Body>&& bodies, int next_id);
+
+	// Returns the id the next added body gets.
+	int get_next_id() const;
+
+	// Removes the body from the list. Other bodies keep their addresses.
+	void rem(const Body& body);
 
 	int size() const;
 	bool empty() const;
@@ -31,20 +93,19 @@ public:
 	void clear();
 	void reserve(int size);
 
-	Body& back();
-	
-	std::span<const Body> span() const;
-
-	// using vector iterators instead of custom.
-	std::vector<Body>::iterator begin();
-	std::vector<Body>::iterator end();
-	std::vector<Body>::const_iterator cbegin() const;
-	std::vector<Body>::const_iterator cend() const;
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator cbegin() const;
+	const_iterator cend() const;
 
 	Body& operator[](int index);
 
-	int get_index(int id) const;
+	// Returns the body with the id, or nullptr if it is not in the list.
+	Body* get(int id);
 
+	// Returns the body with the id, or nullptr if it is not in the list.
+	const Body* get(int id) const;
 
 };
-
@@ -0,0 +1,167 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/*
+* Writing and reading of binary files' contents, in the machine's byte order.
+*
+* Fixed width values are copied as they are in memory. Varints take one byte per 7 bits of the value,
+* so the small values that dominate delta encoded data take a byte or two instead of eight.
+* Signed varints are zigzag encoded first (0, -1, 1, -2, ... become 0, 1, 2, 3, ...), so small negative values stay small too.
+*/
+
+// Appends values to a buffer.
+class ByteWriter
+{
+	std::vector<std::byte>& out;
+
+public:
+
+	explicit ByteWriter(std::vector<std::byte>& out);
+
+	template <class T>
+	void put(T value);
+
+	void put_bytes(std::span<const std::byte> bytes);
+
+	void put_varint(std::uint64_t value);
+	void put_signed_varint(std::int64_t value);
+};
+
+// Reads values from a buffer. Every read after one that would have gone past the end fails, and returns zero.
+class ByteReader
+{
+	std::span<const std::byte> in;
+	size_t at = 0;
+	bool failed = false;
+
+public:
+
+	explicit ByteReader(std::span<const std::byte> in);
+
+	template <class T>
+	T get();
+
+	std::span<const std::byte> get_bytes(size_t size);
+
+	std::uint64_t get_varint();
+	std::int64_t get_signed_varint();
+
+	// Returns false if any read failed.
+	bool ok() const;
+
+	// Returns the number of bytes read so far.
+	size_t position() const;
+};
+
+
+inline ByteWriter::ByteWriter(std::vector<std::byte>& out) : out(out)
+{
+}
+
+template <class T>
+void ByteWriter::put(T value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	size_t at = out.size();
+	out.resize(at + sizeof(T));
+	std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+inline void ByteWriter::put_bytes(std::span<const std::byte> bytes)
+{
+	out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+inline void ByteWriter::put_varint(std::uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<std::byte>(value | 0x80));
+		value >>= 7;
+	}
+
+	out.push_back(static_cast<std::byte>(value));
+}
+
+inline void ByteWriter::put_signed_varint(std::int64_t value)
+{
+	put_varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+inline ByteReader::ByteReader(std::span<const std::byte> in) : in(in)
+{
+}
+
+template <class T>
+T ByteReader::get()
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	T value {};
+	if (failed or in.size() - at < sizeof(T))
+	{
+		failed = true;
+		return value;
+	}
+
+	std::memcpy(&value, in.data() + at, sizeof(T));
+	at += sizeof(T);
+	return value;
+}
+
+inline std::span<const std::byte> ByteReader::get_bytes(size_t size)
+{
+	if (failed or in.size() - at < size)
+	{
+		failed = true;
+		return {};
+	}
+
+	std::span<const std::byte> bytes = in.subspan(at, size);
+	at += size;
+	return bytes;
+}
+
+inline std::uint64_t ByteReader::get_varint()
+{
+	std::uint64_t value = 0;
+	for (int shift = 0; shift < 64 and !failed; shift += 7)
+	{
+		if (at == in.size())
+		{
+			break;
+		}
+
+		std::uint64_t byte = std::to_integer<std::uint64_t>(in[at++]);
+		value |= (byte & 0x7f) << shift;
+
+		if (!(byte & 0x80))
+		{
+			return value;
+		}
+	}
+
+	// Ran past the end, or more than ten bytes.
+	failed = true;
+	return 0;
+}
+
+inline std::int64_t ByteReader::get_signed_varint()
+{
+	std::uint64_t value = get_varint();
+	return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+inline bool ByteReader::ok() const
+{
+	return !failed;
+}
+
+inline size_t ByteReader::position() const
+{
+	return at;
+}
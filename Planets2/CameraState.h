@@ -1,9 +1,11 @@
 #pragma once
 #include "AdvCamera.h"
 #include <utility>
+#include "Event.h"
+#include "Removal.h"
 
 struct Camera2D;
-class Universe;
+class UniverseSnapshot;
 class Body;
 
 // Camera mode state machine.
@@ -19,8 +21,9 @@ public:
 	// Adjusts the camera to focus on the given body.
 	virtual void goto_body(Body& body) = 0;
 
-	// Handles camera-related input.
-	virtual CameraState* update(Universe& universe) = 0;
+	// Handles camera-related input, reading bodies from the snapshot being shown.
+	// The removal event is notified of bodies removed since the previous snapshot, so an anchored camera can follow merges.
+	virtual CameraState* update(const UniverseSnapshot& universe, Event<RemovalBatch>& removal_event) = 0;
 
 	// Notifies the camera that the screen has been resized
 	virtual void notify_resize(int width, int height) = 0;
@@ -0,0 +1,385 @@
+#include "Checkpoint.h"
+#include "Universe.h"
+#include "Body.h"
+#include "ByteStream.h"
+#include <array>
+#include <fstream>
+
+namespace {
+
+    constexpr std::array<char, 8> MAGIC { 'P', 'L', 'A', 'N', 'E', 'T', 'C', 'K' };
+
+    // Written as a native integer, so a file from a machine with another byte order reads it differently.
+    constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // Identifies each column in the column table, so later versions can add columns that older readers skip.
+    enum class Column : std::uint32_t {
+        IDS,
+        POS_X,
+        POS_Y,
+        VEL_X,
+        VEL_Y,
+        MASSES,
+    };
+
+    constexpr int NUM_COLUMNS = 6;
+
+    // Size in bytes of a column table entry: id, element size and offset.
+    constexpr size_t COLUMN_ENTRY_SIZE = 4 + 4 + 8;
+
+    size_t align_up(size_t offset)
+    {
+        return (offset + Checkpoint::COLUMN_ALIGNMENT - 1) / Checkpoint::COLUMN_ALIGNMENT * Checkpoint::COLUMN_ALIGNMENT;
+    }
+
+    template <class T>
+    std::span<const std::byte> as_bytes(const std::vector<T>& column)
+    {
+        return std::as_bytes(std::span(column));
+    }
+
+}
+
+void Checkpoint::write_settings(ByteWriter& writer, const UniverseSettings& settings)
+{
+    writer.put<std::int32_t>(settings.universe_capacity);
+    writer.put<float>(settings.universe_size_start);
+    writer.put<float>(settings.universe_size_max);
+    writer.put<double>(settings.grav_const);
+    writer.put<std::uint8_t>(settings.use_gravity_approximation);
+    writer.put<float>(settings.grav_approximation_value);
+    writer.put<std::int32_t>(settings.system_min_planets);
+    writer.put<std::int32_t>(settings.system_max_planets);
+    writer.put<float>(settings.system_mass_ratio);
+    writer.put<float>(settings.satellite_min_dist);
+    writer.put<float>(settings.satellite_max_dist);
+    writer.put<double>(settings.moon_chance);
+    writer.put<double>(settings.retrograde_chance);
+    writer.put<std::uint8_t>(settings.continuous_collisions);
+    writer.put<std::uint8_t>(settings.auto_tune_partitioning);
+    writer.put<std::uint8_t>(settings.use_neighbour_lists);
+    writer.put<float>(settings.neighbour_list_skin);
+    writer.put<std::int32_t>(settings.num_rand_planets);
+    writer.put<std::int32_t>(settings.num_rand_systems);
+}
+
+UniverseSettings Checkpoint::read_settings(ByteReader& reader)
+{
+    UniverseSettings settings;
+    settings.universe_capacity = reader.get<std::int32_t>();
+    settings.universe_size_start = reader.get<float>();
+    settings.universe_size_max = reader.get<float>();
+    settings.grav_const = reader.get<double>();
+    settings.use_gravity_approximation = reader.get<std::uint8_t>() != 0;
+    settings.grav_approximation_value = reader.get<float>();
+    settings.system_min_planets = reader.get<std::int32_t>();
+    settings.system_max_planets = reader.get<std::int32_t>();
+    settings.system_mass_ratio = reader.get<float>();
+    settings.satellite_min_dist = reader.get<float>();
+    settings.satellite_max_dist = reader.get<float>();
+    settings.moon_chance = reader.get<double>();
+    settings.retrograde_chance = reader.get<double>();
+    settings.continuous_collisions = reader.get<std::uint8_t>() != 0;
+    settings.auto_tune_partitioning = reader.get<std::uint8_t>() != 0;
+    settings.use_neighbour_lists = reader.get<std::uint8_t>() != 0;
+    settings.neighbour_list_skin = reader.get<float>();
+    settings.num_rand_planets = reader.get<std::int32_t>();
+    settings.num_rand_systems = reader.get<std::int32_t>();
+    return settings;
+}
+
+Checkpoint Checkpoint::capture(const Universe& universe, std::string rng_state)
+{
+    Checkpoint checkpoint;
+    checkpoint.settings = universe.get_settings();
+    checkpoint.tick = universe.get_tick();
+    checkpoint.next_id = universe.get_bodies().get_next_id();
+    checkpoint.num_collision_checks = universe.get_num_collision_checks();
+    checkpoint.num_swept_collisions = universe.get_num_swept_collisions();
+    checkpoint.rng_state = std::move(rng_state);
+
+    int num_bodies = universe.get_num_bodies();
+    checkpoint.ids.reserve(num_bodies);
+    checkpoint.pos_x.reserve(num_bodies);
+    checkpoint.pos_y.reserve(num_bodies);
+    checkpoint.vel_x.reserve(num_bodies);
+    checkpoint.vel_y.reserve(num_bodies);
+    checkpoint.masses.reserve(num_bodies);
+
+    for (const Body& body : universe.get_bodies()) {
+        checkpoint.ids.push_back(body.get_id());
+        checkpoint.pos_x.push_back(body.pos().x);
+        checkpoint.pos_y.push_back(body.pos().y);
+        checkpoint.vel_x.push_back(body.vel().x);
+        checkpoint.vel_y.push_back(body.vel().y);
+        checkpoint.masses.push_back(body.get_mass());
+    }
+
+    return checkpoint;
+}
+
+bool Checkpoint::save(const std::filesystem::path& path) const
+{
+    std::vector<std::byte> header;
+    ByteWriter writer(header);
+
+    writer.put(MAGIC);
+    writer.put<std::uint32_t>(VERSION);
+    writer.put<std::uint32_t>(BYTE_ORDER_MARK);
+    writer.put<std::int64_t>(tick);
+    writer.put<std::int64_t>(next_id);
+    writer.put<std::int64_t>(num_collision_checks);
+    writer.put<std::int64_t>(num_swept_collisions);
+    writer.put<std::int64_t>(ids.size());
+
+    // Settings and random state are prefixed with their size, so readers can skip what they don't know.
+    std::vector<std::byte> settings_record;
+    ByteWriter settings_writer(settings_record);
+    write_settings(settings_writer, settings);
+    writer.put<std::uint32_t>(settings_record.size());
+    writer.put_bytes(settings_record);
+
+    writer.put<std::uint32_t>(rng_state.size());
+    writer.put_bytes(std::as_bytes(std::span(rng_state)));
+
+    struct ColumnData {
+        Column column;
+        std::uint32_t element_size;
+        std::span<const std::byte> bytes;
+    };
+
+    const std::array<ColumnData, NUM_COLUMNS> columns { {
+        { Column::IDS, sizeof(std::int32_t), as_bytes(ids) },
+        { Column::POS_X, sizeof(float), as_bytes(pos_x) },
+        { Column::POS_Y, sizeof(float), as_bytes(pos_y) },
+        { Column::VEL_X, sizeof(float), as_bytes(vel_x) },
+        { Column::VEL_Y, sizeof(float), as_bytes(vel_y) },
+        { Column::MASSES, sizeof(std::int64_t), as_bytes(masses) },
+    } };
+
+    writer.put<std::uint32_t>(NUM_COLUMNS);
+
+    size_t offset = align_up(header.size() + NUM_COLUMNS * COLUMN_ENTRY_SIZE);
+    std::array<size_t, NUM_COLUMNS> offsets;
+    for (int i = 0; i < NUM_COLUMNS; i++) {
+        offsets[i] = offset;
+        writer.put<std::uint32_t>(static_cast<std::uint32_t>(columns[i].column));
+        writer.put<std::uint32_t>(columns[i].element_size);
+        writer.put<std::uint64_t>(offset);
+        offset = align_up(offset + columns[i].bytes.size());
+    }
+
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+
+        auto write = [&out](std::span<const std::byte> bytes) {
+            out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        };
+
+        // Columns are written straight from their vectors, padded up to the next column's offset.
+        const std::array<std::byte, COLUMN_ALIGNMENT> padding {};
+        size_t written = header.size();
+        write(header);
+
+        for (int i = 0; i < NUM_COLUMNS; i++) {
+            write(std::span(padding).first(offsets[i] - written));
+            write(columns[i].bytes);
+            written = offsets[i] + columns[i].bytes.size();
+        }
+
+        if (!out.flush()) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    return !error;
+}
+
+std::future<bool> Checkpoint::save_async(Checkpoint&& checkpoint, std::filesystem::path path)
+{
+    return std::async(std::launch::async, [checkpoint = std::move(checkpoint), path = std::move(path)]() {
+        return checkpoint.save(path);
+    });
+}
+
+CheckpointColumns Checkpoint::get_columns() const
+{
+    return { ids, pos_x, pos_y, vel_x, vel_y, masses };
+}
+
+int Checkpoint::get_num_bodies() const
+{
+    return ids.size();
+}
+
+int Checkpoint::get_tick() const
+{
+    return tick;
+}
+
+CheckpointFile::CheckpointFile(MappedFile&& file) : file(std::move(file))
+{
+}
+
+std::optional<CheckpointFile> CheckpointFile::open(const std::filesystem::path& path, std::string& error)
+{
+    std::optional<MappedFile> mapped = MappedFile::open(path);
+    if (!mapped) {
+        error = "Could not open " + path.string();
+        return std::nullopt;
+    }
+
+    CheckpointFile checkpoint(std::move(*mapped));
+    std::span<const std::byte> bytes = checkpoint.file.bytes();
+    ByteReader reader(bytes);
+
+    if (reader.get<std::array<char, 8>>() != MAGIC) {
+        error = "Not a checkpoint file";
+        return std::nullopt;
+    }
+
+    std::uint32_t version = reader.get<std::uint32_t>();
+    if (version != Checkpoint::VERSION) {
+        error = "Unsupported checkpoint version " + std::to_string(version);
+        return std::nullopt;
+    }
+
+    if (reader.get<std::uint32_t>() != BYTE_ORDER_MARK) {
+        error = "Checkpoint was saved on a machine with a different byte order";
+        return std::nullopt;
+    }
+
+    checkpoint.tick = static_cast<int>(reader.get<std::int64_t>());
+    checkpoint.next_id = static_cast<int>(reader.get<std::int64_t>());
+    checkpoint.num_collision_checks = static_cast<int>(reader.get<std::int64_t>());
+    checkpoint.num_swept_collisions = static_cast<int>(reader.get<std::int64_t>());
+    std::int64_t num_bodies = reader.get<std::int64_t>();
+
+    ByteReader settings_reader(reader.get_bytes(reader.get<std::uint32_t>()));
+    checkpoint.settings = Checkpoint::read_settings(settings_reader);
+
+    std::span<const std::byte> rng_bytes = reader.get_bytes(reader.get<std::uint32_t>());
+    checkpoint.rng_state = std::string_view(reinterpret_cast<const char*>(rng_bytes.data()), rng_bytes.size());
+
+    std::uint32_t num_columns = reader.get<std::uint32_t>();
+
+    if (!reader.ok() or !settings_reader.ok() or num_bodies < 0 or checkpoint.next_id < 0) {
+        error = "Checkpoint header is truncated or corrupt";
+        return std::nullopt;
+    }
+
+    // Finds each known column in the table and checks it lies aligned within the file.
+    std::array<std::span<const std::byte>, NUM_COLUMNS> found;
+    constexpr std::array<std::uint32_t, NUM_COLUMNS> ELEMENT_SIZES { 4, 4, 4, 4, 4, 8 };
+
+    for (std::uint32_t i = 0; i < num_columns; i++) {
+        std::uint32_t id = reader.get<std::uint32_t>();
+        std::uint32_t element_size = reader.get<std::uint32_t>();
+        std::uint64_t offset = reader.get<std::uint64_t>();
+
+        if (!reader.ok()) {
+            error = "Checkpoint column table is truncated";
+            return std::nullopt;
+        }
+
+        if (id >= NUM_COLUMNS) {
+            continue;
+        }
+
+        std::uint64_t length = static_cast<std::uint64_t>(num_bodies) * element_size;
+        if (element_size != ELEMENT_SIZES[id] or offset % Checkpoint::COLUMN_ALIGNMENT != 0 or offset > bytes.size() or length > bytes.size() - offset) {
+            error = "Checkpoint column " + std::to_string(id) + " is corrupt";
+            return std::nullopt;
+        }
+
+        found[id] = bytes.subspan(offset, length);
+    }
+
+    // The mapping starts on a page boundary and columns are aligned within the file, so they can be read in place.
+    auto column = [&found, num_bodies]<class T>(Column id, std::span<const T>& out) {
+        std::span<const std::byte> column_bytes = found[static_cast<int>(id)];
+        out = { reinterpret_cast<const T*>(column_bytes.data()), column_bytes.size() / sizeof(T) };
+        return out.size() == num_bodies;
+    };
+
+    CheckpointColumns& columns = checkpoint.columns;
+    if (!column(Column::IDS, columns.ids) or !column(Column::POS_X, columns.pos_x) or !column(Column::POS_Y, columns.pos_y)
+        or !column(Column::VEL_X, columns.vel_x) or !column(Column::VEL_Y, columns.vel_y) or !column(Column::MASSES, columns.masses)) {
+        error = "Checkpoint is missing a column";
+        return std::nullopt;
+    }
+
+    // Restoring trusts ids to be unique and below the next id.
+    std::vector<bool> seen(checkpoint.next_id, false);
+    for (std::int32_t id : columns.ids) {
+        if (id < 0 or id >= checkpoint.next_id or seen[id]) {
+            error = "Checkpoint has an invalid body id " + std::to_string(id);
+            return std::nullopt;
+        }
+        seen[id] = true;
+    }
+
+    return checkpoint;
+}
+
+std::vector<Body> CheckpointFile::make_bodies() const
+{
+    std::vector<Body> bodies;
+    bodies.reserve(columns.ids.size());
+
+    for (size_t i = 0; i < columns.ids.size(); i++) {
+        Body& body = bodies.emplace_back(columns.pos_x[i], columns.pos_y[i], static_cast<long>(columns.masses[i]));
+        body.set_vel({ columns.vel_x[i], columns.vel_y[i] });
+        body.set_id(columns.ids[i]);
+    }
+
+    return bodies;
+}
+
+const UniverseSettings& CheckpointFile::get_settings() const
+{
+    return settings;
+}
+
+int CheckpointFile::get_tick() const
+{
+    return tick;
+}
+
+int CheckpointFile::get_next_id() const
+{
+    return next_id;
+}
+
+int CheckpointFile::get_num_collision_checks() const
+{
+    return num_collision_checks;
+}
+
+int CheckpointFile::get_num_swept_collisions() const
+{
+    return num_swept_collisions;
+}
+
+std::string_view CheckpointFile::get_rng_state() const
+{
+    return rng_state;
+}
+
+const CheckpointColumns& CheckpointFile::get_columns() const
+{
+    return columns;
+}
+
+int CheckpointFile::get_num_bodies() const
+{
+    return columns.ids.size();
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "UniverseSettings.h"
+#include "MappedFile.h"
+
+class Universe;
+class Body;
+class ByteWriter;
+class ByteReader;
+
+/*
+* The state of a universe between ticks, saved so a long run can be resumed later, or an exact starting state shared.
+*
+* A checkpoint file is laid out as:
+*   header:  magic, format version, byte order mark, tick, statistics, the id the next body gets, number of bodies,
+*            the settings, the random engine's state, and a table of where each column starts.
+*   columns: body ids, x and y positions, x and y velocities and masses, one array each,
+*            every one starting at a multiple of COLUMN_ALIGNMENT bytes from the start of the file.
+* Bodies are stored in the order the universe updates them, since gravity sums forces in that order.
+* Radius and type follow from mass, and forces are recomputed every tick, so neither is stored.
+*
+* Files are only read by machines with the byte order they were written with.
+*/
+
+// Body state, one array per field, with a body's fields at the same index in each.
+struct CheckpointColumns
+{
+	std::span<const std::int32_t> ids;
+	std::span<const float> pos_x;
+	std::span<const float> pos_y;
+	std::span<const float> vel_x;
+	std::span<const float> vel_y;
+	std::span<const std::int64_t> masses;
+};
+
+// A checkpoint of a universe held in memory, to be written to a file.
+class Checkpoint
+{
+public:
+
+	static constexpr std::uint32_t VERSION = 1;
+
+	// Alignment of the start of each column in the file, so columns can be read in place from a mapping.
+	static constexpr size_t COLUMN_ALIGNMENT = 64;
+
+private:
+
+	UniverseSettings settings;
+	int tick = 0;
+	int next_id = 0;
+	int num_collision_checks = 0;
+	int num_swept_collisions = 0;
+	std::string rng_state;
+
+	std::vector<std::int32_t> ids;
+	std::vector<float> pos_x;
+	std::vector<float> pos_y;
+	std::vector<float> vel_x;
+	std::vector<float> vel_y;
+	std::vector<std::int64_t> masses;
+
+public:
+
+	// Copies the universe's state, along with the state of the random engine that generates the universe's bodies.
+	// Only copies: nothing is written until save is called, so it can be written without holding up the universe.
+	static Checkpoint capture(const Universe& universe, std::string rng_state);
+
+	// Writes the checkpoint to the path. Returns false if the file couldn't be written.
+	// Writes to a temporary file first, so a failed save leaves any earlier checkpoint at the path intact.
+	bool save(const std::filesystem::path& path) const;
+
+	// Saves the checkpoint on another thread. The future holds what save returned.
+	static std::future<bool> save_async(Checkpoint&& checkpoint, std::filesystem::path path);
+
+	// Writes or reads every universe setting, in the same order both ways. Later versions only append settings.
+	// Also used by other files that store the settings of the universe they came from.
+	static void write_settings(ByteWriter& writer, const UniverseSettings& settings);
+	static UniverseSettings read_settings(ByteReader& reader);
+
+	CheckpointColumns get_columns() const;
+	int get_num_bodies() const;
+	int get_tick() const;
+};
+
+// A checkpoint file mapped into memory. Body columns are read in place from the mapping.
+class CheckpointFile
+{
+	MappedFile file;
+
+	UniverseSettings settings;
+	int tick = 0;
+	int next_id = 0;
+	int num_collision_checks = 0;
+	int num_swept_collisions = 0;
+
+	// Points into the mapping.
+	std::string_view rng_state;
+	CheckpointColumns columns;
+
+	explicit CheckpointFile(MappedFile&& file);
+
+public:
+
+	// Maps and validates the checkpoint file at the path.
+	// Returns nullopt, with error describing why, if it can't be read or isn't a checkpoint this version can restore.
+	static std::optional<CheckpointFile> open(const std::filesystem::path& path, std::string& error);
+
+	// Creates the stored bodies, with their ids, in their stored order.
+	std::vector<Body> make_bodies() const;
+
+	const UniverseSettings& get_settings() const;
+	int get_tick() const;
+	int get_next_id() const;
+	int get_num_collision_checks() const;
+	int get_num_swept_collisions() const;
+	std::string_view get_rng_state() const;
+	const CheckpointColumns& get_columns() const;
+	int get_num_bodies() const;
+};
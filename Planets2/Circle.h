@@ -1,5 +1,5 @@
 #pragma once
-#include <raylib.h>
+#include "SimTypes.h"
 
 struct Circle {
 	Vector2 center;
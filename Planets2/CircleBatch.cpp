@@ -0,0 +1,105 @@
+#include "CircleBatch.h"
+#include "Collision.h"
+
+// SSE2 is part of every x64 target, so 4 circles are tested per instruction there.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CIRCLE_BATCH_SSE2
+#endif
+
+CircleBatch::CircleBatch(std::span<Body* const> bodies)
+{
+    reserve(bodies.size());
+
+    for (Body* body : bodies) {
+        add(*body);
+    }
+}
+
+void CircleBatch::add(Body& body)
+{
+    Vector2 pos = body.pos();
+    xs.push_back(pos.x);
+    ys.push_back(pos.y);
+    radii.push_back(body.get_radius());
+    bodies.push_back(&body);
+}
+
+void CircleBatch::clear()
+{
+    xs.clear();
+    ys.clear();
+    radii.clear();
+    bodies.clear();
+}
+
+void CircleBatch::reserve(int capacity)
+{
+    xs.reserve(capacity);
+    ys.reserve(capacity);
+    radii.reserve(capacity);
+    bodies.reserve(capacity);
+}
+
+int CircleBatch::size() const
+{
+    return bodies.size();
+}
+
+bool CircleBatch::empty() const
+{
+    return bodies.empty();
+}
+
+Body& CircleBatch::body(int i) const
+{
+    return *bodies[i];
+}
+
+CircleBatch::HitMask CircleBatch::hits(Vector2 center, float radius, int first) const
+{
+    int count = std::min(MASK_WIDTH, size() - first);
+    const float* x = xs.data() + first;
+    const float* y = ys.data() + first;
+    const float* r = radii.data() + first;
+
+    HitMask mask = 0;
+    int i = 0;
+
+#ifdef CIRCLE_BATCH_SSE2
+    __m128 center_x = _mm_set1_ps(center.x);
+    __m128 center_y = _mm_set1_ps(center.y);
+    __m128 own_radius = _mm_set1_ps(radius);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), center_x);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), center_y);
+        __m128 dist_squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        __m128 combined_radius = _mm_add_ps(own_radius, _mm_loadu_ps(r + i));
+        __m128 hit = _mm_cmplt_ps(dist_squared, _mm_mul_ps(combined_radius, combined_radius));
+
+        mask |= static_cast<HitMask>(_mm_movemask_ps(hit)) << i;
+    }
+#endif
+
+    // Remaining circles, or all of them without SSE2.
+    for (; i < count; i++) {
+        float dx = x[i] - center.x;
+        float dy = y[i] - center.y;
+        float combined_radius = radius + r[i];
+
+        if (dx * dx + dy * dy < combined_radius * combined_radius) {
+            mask |= HitMask { 1 } << i;
+        }
+    }
+
+    return mask;
+}
+
+int CircleBatch::collide(Body& body, int first, std::vector<Collision>& collisions) const
+{
+    return for_each_hit(body, first, [&body, &collisions](Body& other) {
+        collisions.emplace_back(Body::get_sorted_pair(body, other));
+    });
+}
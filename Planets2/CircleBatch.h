@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include "SimTypes.h"
+#include "Body.h"
+
+struct Collision;
+
+// Circles of candidate bodies for narrow phase collision checks,
+// stored as separate arrays of x, y and radius values so that a body can be tested against many of them at once with SIMD.
+// Partitionings gather the candidates of a body (or of a group of bodies) into a batch, then test each body against it.
+class CircleBatch
+{
+public:
+
+	// Each hit mask covers this many circles, one bit per circle.
+	static constexpr int MASK_WIDTH = 64;
+
+	using HitMask = std::uint64_t;
+
+private:
+
+	std::vector<float> xs;
+	std::vector<float> ys;
+	std::vector<float> radii;
+
+	// Body each circle was gathered from.
+	std::vector<Body*> bodies;
+
+public:
+
+	CircleBatch() = default;
+
+	// Gathers the bodies' current circles.
+	explicit CircleBatch(std::span<Body* const> bodies);
+
+	// Adds the body's current circle to the end of the batch.
+	void add(Body& body);
+
+	// Removes all circles.
+	void clear();
+
+	void reserve(int capacity);
+
+	int size() const;
+
+	bool empty() const;
+
+	// Returns the body the i'th circle was gathered from.
+	Body& body(int i) const;
+
+	// Removes every circle whose body matches the predicate, keeping the rest in order.
+	template <typename Predicate>
+	void erase_if(Predicate&& remove);
+
+	// Returns which of the circles first up to first + MASK_WIDTH overlap the circle. Bit i is set if circle first + i does.
+	// Circles overlap if their centers are closer than their combined radius, as in Physics::circles_intersect.
+	HitMask hits(Vector2 center, float radius, int first) const;
+
+	// Tests the body against every circle from first onwards, and calls on_hit with each body it overlaps, in batch order.
+	// Returns number of collision checks performed.
+	template <typename OnHit>
+	int for_each_hit(const Body& body, int first, OnHit&& on_hit) const;
+
+	// Tests the body against every circle from first onwards, and adds a collision for each body it overlaps.
+	// Returns number of collision checks performed.
+	int collide(Body& body, int first, std::vector<Collision>& collisions) const;
+
+};
+
+template <typename Predicate>
+void CircleBatch::erase_if(Predicate&& remove)
+{
+	int kept = 0;
+	for (int i = 0; i < size(); i++)
+	{
+		if (remove(*bodies[i]))
+		{
+			continue;
+		}
+
+		if (kept != i)
+		{
+			xs[kept] = xs[i];
+			ys[kept] = ys[i];
+			radii[kept] = radii[i];
+			bodies[kept] = bodies[i];
+		}
+		kept++;
+	}
+
+	xs.resize(kept);
+	ys.resize(kept);
+	radii.resize(kept);
+	bodies.resize(kept);
+}
+
+template <typename OnHit>
+int CircleBatch::for_each_hit(const Body& body, int first, OnHit&& on_hit) const
+{
+	Vector2 center = body.pos();
+	float radius = body.get_radius();
+
+	for (int block = first; block < size(); block += MASK_WIDTH)
+	{
+		for (HitMask mask = hits(center, radius, block); mask != 0; mask &= mask - 1)
+		{
+			on_hit(*bodies[block + std::countr_zero(mask)]);
+		}
+	}
+
+	return std::max(size() - first, 0);
+}
@@ -5,6 +5,7 @@
 class Body;
 
 // Represents a collision event between two bodies.
+// Bodies don't move in memory while they are in the universe, so the references stay valid until either body is removed.
 struct Collision {
 
 	Body& bigger;
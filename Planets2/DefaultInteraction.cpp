@@ -1,13 +1,13 @@
 #include "DefaultInteraction.h"
 
 #include "Body.h"
-#include "Universe.h"
+#include "SimulationThread.h"
 #include "CameraState.h"
 
 #include "PlanetCreation.h"
 #include "SystemCreation.h"
 
-InteractionState* DefaultInteraction::process_input(const CameraState& camera_state, Universe& universe)
+InteractionState* DefaultInteraction::process_input(const CameraState& camera_state, SimulationThread& simulation)
 {
 	if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
 		Vector2 screen_point = GetMousePosition();
@@ -16,10 +16,10 @@ InteractionState* DefaultInteraction::process_input(const CameraState& camera_st
 		if (IsKeyDown(KEY_LEFT_CONTROL)) {
 			// Ctrl-click = try to delete body.
 
-			Body* body = universe.get_body(universe_point);
+			const Body* body = simulation.get_snapshot().get_body(universe_point);
 
 			if (body) {
-				universe.rem_body(*body);
+				simulation.rem_body(body->get_id());
 			}
 
 		}
@@ -40,7 +40,7 @@ InteractionState* DefaultInteraction::process_input(const CameraState& camera_st
 		Vector2 screen_point = GetMousePosition();
 		Vector2 universe_point = GetScreenToWorld2D(screen_point, camera_state.get_raylib_camera());
 
-		return new SystemCreation{ universe_point, universe };
+		return new SystemCreation{ universe_point, simulation };
 	}
 
 	return this;
@@ -60,6 +60,11 @@ std::string_view DefaultInteraction::get_help_text() const
 		"[F] to show show force directions\n"
 		"[V] to show show velocity directions\n"
 		"[SPACE] to toggle pause\n"
+		"[T] to change time warp\n"
+		"[K] to save a checkpoint\n"
+		"[L] to start or stop recording the trajectory\n"
+		"[Z] to undo the last change, or step back to the last keyframe\n"
+		"[X] to rewind by a second\n"
 		"[W] [A] [S] [D] to move the camera\n"
 		"[-, +] to control the camera's speed\n"
 		"[COMMA] or scroll down to zoom out\n"
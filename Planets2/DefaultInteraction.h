@@ -10,7 +10,7 @@ public:
 	DefaultInteraction() = default;
 
 	// Handles user deleting a body and state transitions.
-	InteractionState* process_input(const CameraState& camera_state, Universe& universe) override;
+	InteractionState* process_input(const CameraState& camera_state, SimulationThread& simulation) override;
 
 	std::string_view get_name() const override;
 
@@ -0,0 +1,541 @@
+#include "DynamicAABBTree.h"
+
+#include "Collision.h"
+#include "Body.h"
+
+#include "Physics.h"
+#include "DebugInfo.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    // Insertion cost of a box. The perimeter favours compact boxes more than the area would.
+    float perimeter(Rectangle rect)
+    {
+        return 2.0f * (rect.width + rect.height);
+    }
+
+    // Returns the area a circle's center can be in while the circle stays inside the box.
+    Rectangle center_bounds(Rectangle box, float radius)
+    {
+        return { box.x + radius, box.y + radius, std::max(0.0f, box.width - 2 * radius), std::max(0.0f, box.height - 2 * radius) };
+    }
+
+}
+
+DynamicAABBTree::DynamicAABBTree(float fat_margin) : fat_margin(std::max(0.0f, fat_margin))
+{}
+
+int DynamicAABBTree::alloc_node()
+{
+    if (free_list == NULL_NODE) {
+        nodes.emplace_back();
+        return nodes.size() - 1;
+    }
+
+    int index = free_list;
+    free_list = nodes[index].parent;
+    nodes[index] = Node {};
+    return index;
+}
+
+void DynamicAABBTree::free_node(int index)
+{
+    nodes[index] = Node {};
+    nodes[index].parent = free_list;
+    free_list = index;
+}
+
+Rectangle DynamicAABBTree::fat_box(const Body& body) const
+{
+    float margin = fat_margin * body.get_radius();
+    Rectangle box = body.get_bounding_box();
+    box.x -= margin;
+    box.y -= margin;
+    box.width += 2 * margin;
+    box.height += 2 * margin;
+
+    // Stretch the box towards where the body is heading, so fast bodies are not reinserted every tick.
+    Vector2 displacement = body.vel();
+    displacement.x *= DISPLACEMENT_TICKS;
+    displacement.y *= DISPLACEMENT_TICKS;
+
+    if (displacement.x < 0.0f) {
+        box.x += displacement.x;
+    }
+    box.width += std::abs(displacement.x);
+
+    if (displacement.y < 0.0f) {
+        box.y += displacement.y;
+    }
+    box.height += std::abs(displacement.y);
+
+    return box;
+}
+
+void DynamicAABBTree::add_body(Body& body)
+{
+    int leaf = alloc_node();
+    nodes[leaf].body = &body;
+    nodes[leaf].box = fat_box(body);
+    body.set_partition_bounds(center_bounds(nodes[leaf].box, body.get_radius()));
+
+    leaves[&body] = leaf;
+    insert_leaf(leaf);
+}
+
+void DynamicAABBTree::rem_body(const Body& body)
+{
+    auto it = leaves.find(&body);
+    int leaf = it->second;
+    leaves.erase(it);
+
+    remove_leaf(leaf);
+    free_node(leaf);
+}
+
+void DynamicAABBTree::reinsert(int leaf)
+{
+    Body& body = *nodes[leaf].body;
+
+    remove_leaf(leaf);
+    nodes[leaf].box = fat_box(body);
+    body.set_partition_bounds(center_bounds(nodes[leaf].box, body.get_radius()));
+    insert_leaf(leaf);
+}
+
+void DynamicAABBTree::notify_radius_changed(Body& body, [[maybe_unused]] float old_radius)
+{
+    int leaf = leaves.at(&body);
+
+    if (body.in_rect(nodes[leaf].box)) {
+        // Still fits, but can move less far before leaving the box.
+        body.set_partition_bounds(center_bounds(nodes[leaf].box, body.get_radius()));
+    }
+    else {
+        reinsert(leaf);
+    }
+}
+
+void DynamicAABBTree::update()
+{
+    num_reinserted_tick = 0;
+
+    // Leaves never change index, only internal nodes are freed and allocated while reinserting.
+    // Walking the node storage (rather than the map) also keeps the order of reinsertions deterministic.
+    for (int i = 0; i < nodes.size(); i++) {
+        Body* body = nodes[i].body;
+
+        if (body == nullptr or body->in_rect(nodes[i].box)) {
+            continue;
+        }
+
+        reinsert(i);
+        num_reinserted_tick++;
+    }
+}
+
+void DynamicAABBTree::update_moved(std::span<Body* const> moved)
+{
+    num_reinserted_tick = 0;
+
+    for (Body* body : moved) {
+        reinsert(leaves.at(body));
+        num_reinserted_tick++;
+    }
+}
+
+void DynamicAABBTree::insert_leaf(int leaf)
+{
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    Rectangle leaf_box = nodes[leaf].box;
+
+    // Walk down, towards whichever child grows the least by also bounding the leaf.
+    int index = root;
+    while (!nodes[index].is_leaf()) {
+        const Node& node = nodes[index];
+
+        float area = perimeter(node.box);
+        float combined_area = perimeter(Physics::rects_union(node.box, leaf_box));
+
+        // Cost of making a new parent for this node and the leaf.
+        float cost = 2.0f * combined_area;
+
+        // Minimum cost of pushing the leaf further down, which grows this node's box.
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto descend_cost = [this, leaf_box, inheritance_cost](int child) {
+            const Node& child_node = nodes[child];
+            float grown_area = perimeter(Physics::rects_union(child_node.box, leaf_box));
+
+            if (child_node.is_leaf()) {
+                return grown_area + inheritance_cost;
+            }
+            else {
+                return grown_area - perimeter(child_node.box) + inheritance_cost;
+            }
+        };
+
+        float cost1 = descend_cost(node.child1);
+        float cost2 = descend_cost(node.child2);
+
+        if (cost < cost1 and cost < cost2) {
+            break;
+        }
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    int sibling = index;
+
+    // Allocating can grow the storage, so only keep indices across it.
+    int new_parent = alloc_node();
+    int old_parent = nodes[sibling].parent;
+
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+    refit(new_parent);
+
+    if (old_parent == NULL_NODE) {
+        root = new_parent;
+    }
+    else if (nodes[old_parent].child1 == sibling) {
+        nodes[old_parent].child1 = new_parent;
+    }
+    else {
+        nodes[old_parent].child2 = new_parent;
+    }
+
+    fix_upwards(old_parent);
+}
+
+void DynamicAABBTree::remove_leaf(int leaf)
+{
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandparent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    // The sibling takes the parent's place.
+    if (grandparent == NULL_NODE) {
+        root = sibling;
+    }
+    else if (nodes[grandparent].child1 == parent) {
+        nodes[grandparent].child1 = sibling;
+    }
+    else {
+        nodes[grandparent].child2 = sibling;
+    }
+
+    nodes[sibling].parent = grandparent;
+    nodes[leaf].parent = NULL_NODE;
+    free_node(parent);
+
+    fix_upwards(grandparent);
+}
+
+void DynamicAABBTree::fix_upwards(int index)
+{
+    while (index != NULL_NODE) {
+        index = balance(index);
+        refit(index);
+        index = nodes[index].parent;
+    }
+}
+
+int DynamicAABBTree::balance(int index_a)
+{
+    Node& a = nodes[index_a];
+    if (a.is_leaf() or a.height < 2) {
+        return index_a;
+    }
+
+    int index_b = a.child1;
+    int index_c = a.child2;
+    int difference = nodes[index_c].height - nodes[index_b].height;
+
+    // Rotates the taller child up into a's place.
+    // a keeps its shorter child, and takes the shorter of the taller child's children.
+    auto rotate_up = [this, index_a](int index_up, bool up_is_child1) {
+        Node& a = nodes[index_a];
+        Node& up = nodes[index_up];
+
+        int index_f = up.child1;
+        int index_g = up.child2;
+        int index_keep = nodes[index_f].height > nodes[index_g].height ? index_f : index_g;
+        int index_give = index_keep == index_f ? index_g : index_f;
+
+        up.child1 = index_a;
+        up.child2 = index_keep;
+        up.parent = a.parent;
+        a.parent = index_up;
+
+        if (up.parent == NULL_NODE) {
+            root = index_up;
+        }
+        else if (nodes[up.parent].child1 == index_a) {
+            nodes[up.parent].child1 = index_up;
+        }
+        else {
+            nodes[up.parent].child2 = index_up;
+        }
+
+        if (up_is_child1) {
+            a.child1 = index_give;
+        }
+        else {
+            a.child2 = index_give;
+        }
+        nodes[index_give].parent = index_a;
+
+        refit(index_a);
+        refit(index_up);
+        return index_up;
+    };
+
+    if (difference > 1) {
+        return rotate_up(index_c, false);
+    }
+    else if (difference < -1) {
+        return rotate_up(index_b, true);
+    }
+
+    return index_a;
+}
+
+void DynamicAABBTree::refit(int index)
+{
+    Node& node = nodes[index];
+    const Node& child1 = nodes[node.child1];
+    const Node& child2 = nodes[node.child2];
+
+    node.box = Physics::rects_union(child1.box, child2.box);
+    node.height = 1 + std::max(child1.height, child2.height);
+}
+
+int DynamicAABBTree::get_depth(int leaf) const
+{
+    int depth = 0;
+    for (int index = nodes[leaf].parent; index != NULL_NODE; index = nodes[index].parent) {
+        depth++;
+    }
+
+    return depth;
+}
+
+Body* DynamicAABBTree::find_body(Vector2 point) const
+{
+    if (root == NULL_NODE) {
+        return nullptr;
+    }
+
+    std::vector<int> stack { root };
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!Physics::point_in_rect(point, node.box)) {
+            continue;
+        }
+
+        if (node.is_leaf()) {
+            if (node.body->contains_point(point)) {
+                return node.body;
+            }
+        }
+        else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    return nullptr;
+}
+
+std::vector<Body*> DynamicAABBTree::query_rect(Rectangle area) const
+{
+    std::vector<Body*> found;
+    if (root == NULL_NODE) {
+        return found;
+    }
+
+    std::vector<int> stack { root };
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!Physics::rects_intersect(node.box, area)) {
+            continue;
+        }
+
+        if (node.is_leaf()) {
+            if (node.body->intersects_rect(area)) {
+                found.push_back(node.body);
+            }
+        }
+        else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    return found;
+}
+
+std::vector<Rectangle> DynamicAABBTree::get_representation() const
+{
+    std::vector<Rectangle> rep;
+    if (root == NULL_NODE) {
+        return rep;
+    }
+
+    std::vector<int> stack { root };
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        rep.push_back(node.box);
+
+        if (!node.is_leaf()) {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    return rep;
+}
+
+void DynamicAABBTree::get_info(const Body& body, DebugInfo& info) const
+{
+    int leaf = leaves.at(&body);
+
+    info.add("Leaf depth: " + std::to_string(get_depth(leaf)));
+    info.add("Tree height: " + std::to_string(nodes[root].height));
+    info.add("Reinserted (tick): " + std::to_string(num_reinserted_tick));
+}
+
+std::vector<Collision> DynamicAABBTree::get_collisions_impl()
+{
+    std::vector<Collision> collisions;
+    if (root == NULL_NODE) {
+        return collisions;
+    }
+
+    std::vector<SubtreeWork> work = split_collision_work();
+    num_collision_checks_tick = gather_parallel(work.size(), [this, &work](int unit, std::vector<Collision>& unit_collisions) {
+        const SubtreeWork& subtrees = work[unit];
+        if (subtrees.second == NULL_NODE) {
+            return get_collisions(subtrees.first, unit_collisions);
+        }
+
+        return get_collisions_between(subtrees.first, subtrees.second, unit_collisions);
+    }, collisions);
+
+    return collisions;
+}
+
+std::vector<DynamicAABBTree::SubtreeWork> DynamicAABBTree::split_collision_work() const
+{
+    std::vector<SubtreeWork> work { { root, NULL_NODE } };
+    std::vector<SubtreeWork> next;
+
+    bool expanded = true;
+    while (expanded and work.size() < MIN_COLLISION_UNITS) {
+        expanded = false;
+        next.clear();
+
+        for (SubtreeWork subtrees : work) {
+            const Node& node1 = nodes[subtrees.first];
+
+            if (subtrees.second == NULL_NODE) {
+                // A single body has no pairs within it.
+                if (!node1.is_leaf()) {
+                    next.push_back({ node1.child1, NULL_NODE });
+                    next.push_back({ node1.child2, NULL_NODE });
+                    next.push_back({ node1.child1, node1.child2 });
+                    expanded = true;
+                }
+
+                continue;
+            }
+
+            const Node& node2 = nodes[subtrees.second];
+            if (!Physics::rects_intersect(node1.box, node2.box)) {
+                continue;
+            }
+
+            // Split the same side get_collisions_between would descend into.
+            if (node1.is_leaf() and node2.is_leaf()) {
+                next.push_back(subtrees);
+            }
+            else if (node2.is_leaf() or (!node1.is_leaf() and perimeter(node1.box) >= perimeter(node2.box))) {
+                next.push_back({ node1.child1, subtrees.second });
+                next.push_back({ node1.child2, subtrees.second });
+                expanded = true;
+            }
+            else {
+                next.push_back({ subtrees.first, node2.child1 });
+                next.push_back({ subtrees.first, node2.child2 });
+                expanded = true;
+            }
+        }
+
+        work.swap(next);
+    }
+
+    return work;
+}
+
+int DynamicAABBTree::get_collisions(int index, std::vector<Collision>& collisions) const
+{
+    const Node& node = nodes[index];
+    if (node.is_leaf()) {
+        return 0;
+    }
+
+    // Pairs within each child, then pairs across the two children.
+    return get_collisions(node.child1, collisions)
+        + get_collisions(node.child2, collisions)
+        + get_collisions_between(node.child1, node.child2, collisions);
+}
+
+int DynamicAABBTree::get_collisions_between(int index1, int index2, std::vector<Collision>& collisions) const
+{
+    const Node& node1 = nodes[index1];
+    const Node& node2 = nodes[index2];
+
+    if (!Physics::rects_intersect(node1.box, node2.box)) {
+        return 0;
+    }
+
+    if (node1.is_leaf() and node2.is_leaf()) {
+        if (node1.body->collided_with(*node2.body)) {
+            collisions.emplace_back(Body::get_sorted_pair(*node1.body, *node2.body));
+        }
+
+        return 1;
+    }
+
+    // Descend into the larger subtree, so both sides shrink at a similar rate.
+    if (node2.is_leaf() or (!node1.is_leaf() and perimeter(node1.box) >= perimeter(node2.box))) {
+        return get_collisions_between(node1.child1, index2, collisions)
+            + get_collisions_between(node1.child2, index2, collisions);
+    }
+    else {
+        return get_collisions_between(index1, node2.child1, collisions)
+            + get_collisions_between(index1, node2.child2, collisions);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "SpatialPartitioning.h"
+#include "SimTypes.h"
+#include <unordered_map>
+
+// Dynamic bounding volume hierarchy for collision detection.
+// Each body is a leaf holding a fattened bounding box, so it is only reinserted once it moves out of that box.
+// Internal nodes bound their two children, and are kept balanced with tree rotations.
+// Adapts to any distribution of bodies and sizes, without a fixed world size or tuning of node capacities.
+class DynamicAABBTree : public SpatialPartitioning
+{
+
+	static constexpr int NULL_NODE = -1;
+
+	// Fat boxes are also extended in the direction of a body's velocity, by its displacement over this many ticks.
+	static constexpr float DISPLACEMENT_TICKS = 4.0f;
+
+	// Collision detection is split into at least this many units of work to check in parallel, if the tree is big enough.
+	static constexpr int MIN_COLLISION_UNITS = 64;
+
+	struct Node {
+		// Fat bounding box of a leaf's body, or union of an internal node's children's boxes.
+		Rectangle box {};
+
+		// Parent node while in the tree, next free node while in the free list.
+		int parent = NULL_NODE;
+		int child1 = NULL_NODE;
+		int child2 = NULL_NODE;
+
+		// Leaves have height 0. NULL_NODE's height would be -1.
+		int height = 0;
+
+		// Body of a leaf, nullptr for internal nodes.
+		Body* body = nullptr;
+
+		bool is_leaf() const { return child1 == NULL_NODE; }
+	};
+
+	// Margin added to every side of a body's bounding box, as a fraction of its radius.
+	float fat_margin;
+
+	// Node storage. Nodes refer to each other by index, so the vector can grow freely.
+	std::vector<Node> nodes;
+
+	// Start of the list of unused nodes, linked by their parent index.
+	int free_list = NULL_NODE;
+
+	int root = NULL_NODE;
+
+	// Leaf node of each body.
+	std::unordered_map<const Body*, int> leaves;
+
+	// Number of leaves that were reinserted during the last update.
+	int num_reinserted_tick = 0;
+
+	// Returns the index of an unused node, growing storage if there is none.
+	int alloc_node();
+
+	// Returns the node to the free list.
+	void free_node(int index);
+
+	// Returns the body's bounding box, fattened by the margin and its velocity.
+	Rectangle fat_box(const Body& body) const;
+
+	// Gives the leaf a new fat box and moves it to where it now fits best in the tree.
+	void reinsert(int leaf);
+
+	// Places a leaf next to the sibling which increases the total area of the tree the least.
+	void insert_leaf(int leaf);
+
+	// Detaches a leaf from the tree, replacing its parent with its sibling.
+	void remove_leaf(int leaf);
+
+	// Refits and rebalances every node from the given one up to the root.
+	void fix_upwards(int index);
+
+	// Rotates the node's children if their heights differ by more than 1. Returns the index of the subtree's new root.
+	int balance(int index);
+
+	// Recalculates an internal node's box and height from its children.
+	void refit(int index);
+
+	// Returns the height of the leaf's branch from the root.
+	int get_depth(int leaf) const;
+
+	// Either all pairs within a subtree (second == NULL_NODE), or all pairs across two disjoint subtrees.
+	struct SubtreeWork {
+		int first;
+		int second;
+	};
+
+	// Splits the tree's traversal against itself into independent units of work, expanding every unit a level at a time.
+	// Units that can't find any pairs are dropped.
+	std::vector<SubtreeWork> split_collision_work() const;
+
+	// Detects collisions between all bodies in a subtree.
+	int get_collisions(int index, std::vector<Collision>& collisions) const;
+
+	// Detects collisions between bodies of two disjoint subtrees.
+	int get_collisions_between(int index1, int index2, std::vector<Collision>& collisions) const;
+
+	// Returns collision events found by traversing the tree against itself.
+	std::vector<Collision> get_collisions_impl() override;
+
+public:
+
+	// Constructs an empty tree, which fattens each body's bounding box by fat_margin times its radius.
+	explicit DynamicAABBTree(float fat_margin = 0.5f);
+
+	// Adds a leaf for the body.
+	void add_body(Body& body) override;
+
+	// Removes the body's leaf.
+	void rem_body(const Body& body) override;
+
+	// Reinserts the body's leaf if its new bounding box no longer fits its fat box.
+	void notify_radius_changed(Body& body, float old_radius) override;
+
+	// Reinserts bodies which have moved out of their fat boxes.
+	void update() override;
+
+	bool uses_partition_bounds() const override { return true; }
+
+	// Reinserts only the bodies which have moved out of their fat boxes.
+	void update_moved(std::span<Body* const> moved) override;
+
+	// Returns a pointer to the body that contains the point. If none do, returns nullptr.
+	Body* find_body(Vector2 point) const override;
+
+	// Returns every body that overlaps with the area, only descending into nodes whose boxes overlap it.
+	std::vector<Body*> query_rect(Rectangle area) const override;
+
+	// Returns the boxes of all nodes in the tree.
+	std::vector<Rectangle> get_representation() const override;
+
+	// Attaches text indicating the body's leaf depth, the tree's height and the last update's reinsertions to info.
+	void get_info(const Body& body, DebugInfo& info) const override;
+
+};
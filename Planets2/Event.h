@@ -32,6 +32,9 @@ public:
 	// Calls all callback methods with the given message parameter.
 	void notify_all(const ParamType& message);
 
+	// Returns true if any callback is subscribed, so a message that is costly to put together can be skipped when none is.
+	bool has_observers() const;
+
 };
 
 
@@ -89,6 +92,11 @@ inline void Event<ParamType>::notify_all(const ParamType& message)
 	}
 }
 
+template<class ParamType>
+inline bool Event<ParamType>::has_observers() const
+{
+	return !observers.empty();
+}
 
 
 
@@ -1,6 +1,6 @@
 #include "FreeCamera.h"
 #include "Body.h"
-#include "Universe.h"
+#include "UniverseSnapshot.h"
 #include "AnchoredCamera.h"
 #include <utility>
 
@@ -32,7 +32,7 @@ void FreeCamera::goto_body(Body& body)
 	camera.set_target(body.pos());
 }
 
-CameraState* FreeCamera::update(Universe& universe)
+CameraState* FreeCamera::update(const UniverseSnapshot& universe, Event<RemovalBatch>& removal_event)
 {
 	// Camera state change
 	if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
@@ -42,7 +42,7 @@ CameraState* FreeCamera::update(Universe& universe)
 		const Body* body = universe.get_body(universe_point);
 
 		if (body) {
-			return new AnchoredCamera(camera, *body, universe);
+			return new AnchoredCamera(camera, *body, removal_event);
 		}
 	}
 
@@ -20,7 +20,7 @@ public:
 	void goto_body(Body& body);
 
 	// Processes input related to the camera, and updates and returns next camera state.
-	CameraState* update(Universe& universe);
+	CameraState* update(const UniverseSnapshot& universe, Event<RemovalBatch>& removal_event);
 
 	// Notifies the camera that the screen has been resized
 	void notify_resize(int width, int height);
@@ -2,7 +2,10 @@
 #include "Body.h"
 
 #include "Collision.h"
+#include "NearestBodies.h"
 #include <algorithm>
+#include <functional>
+#include <limits>
 
 Grid::Grid(float grid_size, int nodes_per_row) : grid_size(grid_size), node_size(grid_size / nodes_per_row), nodes_per_row(nodes_per_row)
 {
@@ -19,75 +22,115 @@ Grid::Grid(float grid_size, int nodes_per_row) : grid_size(grid_size), node_size
     }
 }
 
-void Grid::notify_move(const Body* from, Body* to)
-{
-    std::vector<GridNode*> nodes = get_all_nodes(*from);
-
-    for (GridNode* node : nodes) {
-        node->notify_move(from, to);
-    }
-
-    // may be better to not store bodies vector.
-    auto it = std::find(bodies.begin(), bodies.end(), from);
-    *it = to;
-}
-
 int Grid::get_index(int pos) const
 {
     return std::clamp(static_cast<int>((pos + grid_size / 2) / node_size), 0, nodes_per_row - 1);
 }
 
-GridNode& Grid::get_node(Vector2 pos)
+int Grid::get_node_id(Vector2 pos) const
 {
     int row = get_index(pos.y);
     int col = get_index(pos.x);
 
-    int grid_num = row * nodes_per_row + col;
-
-    return nodes[grid_num];
+    return row * nodes_per_row + col;
+}
 
+GridNode& Grid::get_node(Vector2 pos)
+{
+    return nodes[get_node_id(pos)];
 }
 
 const GridNode& Grid::get_node(Vector2 pos) const
 {
-    int row = get_index(pos.y);
-    int col = get_index(pos.x);
+    return nodes[get_node_id(pos)];
+}
+
+Grid::CellRange Grid::get_cells(const Body& body) const
+{
+    return { get_index(body.top()), get_index(body.left()), get_index(body.bottom()), get_index(body.right()) };
+}
+
+Grid::CellRange Grid::get_cells(Rectangle area) const
+{
+    return { get_index(area.y), get_index(area.x), get_index(area.y + area.height), get_index(area.x + area.width) };
+}
+
+float Grid::cell_start(int index) const
+{
+    // Large enough to be outside any universe, small enough that adding two of them doesn't overflow.
+    constexpr float unbounded = std::numeric_limits<float>::max() / 4;
 
-    int grid_num = row * nodes_per_row + col;
+    if (index <= 0) {
+        return -unbounded;
+    }
+    else if (index >= nodes_per_row) {
+        return unbounded;
+    }
 
-    return nodes[grid_num];
+    return index * node_size - grid_size / 2;
 }
 
-std::vector<GridNode*> Grid::get_all_nodes(const Body& body)
+Rectangle Grid::get_partition_bounds(const Body& body, CellRange cells) const
 {
-    std::vector<GridNode*> in_nodes;
+    // Coordinates are truncated to ints before finding their node, so keep a margin of 1 from every node edge.
+    constexpr float margin = 1.0f;
+    float radius = body.get_radius();
 
-    int first_row = get_index(body.top());
-    int first_col = get_index(body.left());
+    // The center can move as far as the box's sides can stay in their first and last nodes.
+    auto axis_bounds = [this, radius, margin](int first, int last) {
+        float min = std::max(cell_start(first) + radius, cell_start(last) - radius) + margin;
+        float max = std::min(cell_start(first + 1) + radius, cell_start(last + 1) - radius) - margin;
+        return std::make_pair(min, std::max(min, max));
+    };
 
-    int last_row = get_index(body.bottom());
-    int last_col = get_index(body.right());
+    auto [min_x, max_x] = axis_bounds(cells.first_col, cells.last_col);
+    auto [min_y, max_y] = axis_bounds(cells.first_row, cells.last_row);
 
-    for (int i = first_row; i <= last_row; i++)
-    {
-        for (int j = first_col; j <= last_col; j++)
-        {
-            int grid_num = i * nodes_per_row + j;
-            in_nodes.push_back(&nodes[grid_num]);
+    return { min_x, min_y, max_x - min_x, max_y - min_y };
+}
+
+void Grid::add_to_cells(Body& body, CellRange cells)
+{
+    for (int i = cells.first_row; i <= cells.last_row; i++) {
+        for (int j = cells.first_col; j <= cells.last_col; j++) {
+            nodes[i * nodes_per_row + j].add(body);
         }
     }
+}
 
-    return in_nodes;
+void Grid::rem_from_cells(const Body& body, CellRange cells)
+{
+    for (int i = cells.first_row; i <= cells.last_row; i++) {
+        for (int j = cells.first_col; j <= cells.last_col; j++) {
+            nodes[i * nodes_per_row + j].rem(body);
+        }
+    }
+}
+
+void Grid::relocate(int index)
+{
+    Body& body = *bodies[index];
+    CellRange cells = get_cells(body);
+
+    if (cells != body_cells[index]) {
+        rem_from_cells(body, body_cells[index]);
+        add_to_cells(body, cells);
+        body_cells[index] = cells;
+    }
+
+    body.set_partition_bounds(get_partition_bounds(body, cells));
 }
 
 void Grid::add_body(Body& body)
 {
+    CellRange cells = get_cells(body);
+
+    body_indices[&body] = bodies.size();
     bodies.push_back(&body);
-    std::vector<GridNode*> nodes = get_all_nodes(body);
+    body_cells.push_back(cells);
 
-    for (GridNode* node : nodes) {
-        node->add(body);
-    }
+    add_to_cells(body, cells);
+    body.set_partition_bounds(get_partition_bounds(body, cells));
 }
 
 void Grid::update()
@@ -96,24 +139,82 @@ void Grid::update()
         node.clear();
     }
 
-    for (Body* body : bodies) {
-        std::vector<GridNode*> nodes = get_all_nodes(*body);
+    for (int i = 0; i < bodies.size(); i++) {
+        Body& body = *bodies[i];
+        body_cells[i] = get_cells(body);
+        add_to_cells(body, body_cells[i]);
+        body.set_partition_bounds(get_partition_bounds(body, body_cells[i]));
+    }
+}
 
-        for (GridNode* node : nodes) {
-            node->add(*body);
-        }
+void Grid::update_moved(std::span<Body* const> moved)
+{
+    for (Body* body : moved) {
+        relocate(body_indices.at(body));
     }
+}
 
+void Grid::notify_radius_changed(Body& body, [[maybe_unused]] float old_radius)
+{
+    relocate(body_indices.at(&body));
 }
 
 void Grid::rem_body(const Body& body)
 {
-    auto it = std::find(bodies.begin(), bodies.end(), &body);
-    bodies.erase(it);
+    // Swap-pop, so removal doesn't shift every later body.
+    auto it = body_indices.find(&body);
+    int index = it->second;
+    body_indices.erase(it);
 
-    std::vector<GridNode*> nodes = get_all_nodes(body);
-    for (GridNode* node : nodes) {
-        node->rem(body);
+    rem_from_cells(body, body_cells[index]);
+
+    if (index != bodies.size() - 1) {
+        bodies[index] = bodies.back();
+        body_cells[index] = body_cells.back();
+        body_indices[bodies[index]] = index;
+    }
+    bodies.pop_back();
+    body_cells.pop_back();
+}
+
+void Grid::rem_bodies(std::span<const Body* const> removed)
+{
+    std::unordered_set<const Body*> removing(removed.begin(), removed.end());
+
+    // Nodes the removed bodies were in, each listed once.
+    std::vector<bool> touched(nodes.size(), false);
+    std::vector<int> touched_ids;
+
+    for (const Body* body : removed) {
+        CellRange cells = body_cells[body_indices.at(body)];
+        for (int i = cells.first_row; i <= cells.last_row; i++) {
+            for (int j = cells.first_col; j <= cells.last_col; j++) {
+                int id = i * nodes_per_row + j;
+                if (!touched[id]) {
+                    touched[id] = true;
+                    touched_ids.push_back(id);
+                }
+            }
+        }
+    }
+
+    for (int id : touched_ids) {
+        nodes[id].rem_all(removing);
+    }
+
+    // Swap-pop each body's entries, as rem_body does.
+    for (const Body* body : removed) {
+        auto it = body_indices.find(body);
+        int index = it->second;
+        body_indices.erase(it);
+
+        if (index != bodies.size() - 1) {
+            bodies[index] = bodies.back();
+            body_cells[index] = body_cells.back();
+            body_indices[bodies[index]] = index;
+        }
+        bodies.pop_back();
+        body_cells.pop_back();
     }
 }
 
@@ -123,6 +224,90 @@ Body* Grid::find_body(Vector2 point) const
     return node.find_body(point);
 }
 
+std::vector<Body*> Grid::query_rect(Rectangle area) const
+{
+    std::vector<Body*> found;
+    CellRange cells = get_cells(area);
+
+    auto node_id_at = [this](Vector2 pos) { return get_node_id(pos); };
+
+    for (int i = cells.first_row; i <= cells.last_row; i++) {
+        for (int j = cells.first_col; j <= cells.last_col; j++) {
+            nodes[i * nodes_per_row + j].query_rect(area, found, node_id_at);
+        }
+    }
+
+    return found;
+}
+
+std::vector<Body*> Grid::k_nearest(Vector2 point, int k) const
+{
+    NearestBodies nearest { point, k };
+
+    int row = get_index(point.y);
+    int col = get_index(point.x);
+
+    auto node_id_at = [this](Vector2 pos) { return get_node_id(pos); };
+    auto offer_node = [this, &nearest, &node_id_at](int i, int j) {
+        nodes[i * nodes_per_row + j].offer_nearest(nearest, node_id_at);
+    };
+
+    // Bodies are offered by the node their center is in, so bodies not offered yet have their centers outside the checked rings.
+    // Coordinates are truncated to ints before finding their node, so a center can be up to 1 past its node's edge.
+    constexpr float margin = 1.0f;
+    constexpr float unbounded = std::numeric_limits<float>::max();
+
+    for (int ring = 0; ; ring++) {
+        int first_row = row - ring;
+        int last_row = row + ring;
+        int first_col = col - ring;
+        int last_col = col + ring;
+
+        for (int i = std::max(first_row, 0); i <= std::min(last_row, nodes_per_row - 1); i++) {
+            if (i == first_row or i == last_row) {
+                for (int j = std::max(first_col, 0); j <= std::min(last_col, nodes_per_row - 1); j++) {
+                    offer_node(i, j);
+                }
+            }
+            else {
+                if (first_col >= 0) {
+                    offer_node(i, first_col);
+                }
+                if (last_col < nodes_per_row) {
+                    offer_node(i, last_col);
+                }
+            }
+        }
+
+        // Edge nodes extend past the grid, so there is nothing beyond a ring that reached an edge on that side.
+        float nearest_outside = unbounded;
+        if (first_row > 0) {
+            nearest_outside = std::min(nearest_outside, point.y - cell_start(first_row) - margin);
+        }
+        if (last_row < nodes_per_row - 1) {
+            nearest_outside = std::min(nearest_outside, cell_start(last_row + 1) - point.y - margin);
+        }
+        if (first_col > 0) {
+            nearest_outside = std::min(nearest_outside, point.x - cell_start(first_col) - margin);
+        }
+        if (last_col < nodes_per_row - 1) {
+            nearest_outside = std::min(nearest_outside, cell_start(last_col + 1) - point.x - margin);
+        }
+
+        if (nearest_outside == unbounded) {
+            // Every node has been checked.
+            break;
+        }
+
+        nearest_outside = std::max(0.0f, nearest_outside);
+        if (nearest.excludes(nearest_outside * nearest_outside)) {
+            break;
+        }
+    }
+
+    return nearest.take();
+}
+
 std::vector<Rectangle> Grid::get_representation() const
 {
     std::vector<Rectangle> rep;
@@ -147,9 +332,12 @@ std::vector<Collision> Grid::get_collisions_impl()
 {
     std::vector<Collision> collisions;
 
-    for (const GridNode& node : nodes) {
-        num_collision_checks_tick += node.get_collisions(collisions);
-    }
+    auto node_id_at = [this](Vector2 pos) { return get_node_id(pos); };
+
+    // Each node is a unit of work. A pair is only added by one of the nodes both bodies are in, so units don't find duplicates.
+    num_collision_checks_tick = gather_parallel(nodes.size(), [this, &node_id_at](int unit, std::vector<Collision>& unit_collisions) {
+        return nodes[unit].get_collisions(unit_collisions, node_id_at);
+    }, collisions);
 
     return collisions;
 }
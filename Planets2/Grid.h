@@ -1,6 +1,7 @@
 #pragma once
 #include "SpatialPartitioning.h"
 #include "GridNode.h"
+#include <unordered_map>
 
 struct Rectangle;
 struct Collision;
@@ -12,9 +13,26 @@ class Grid : public SpatialPartitioning
 	// A vector of all nodes in the grid.
 	std::vector<GridNode> nodes;
 
+	// Rows and columns of the nodes that a body's bounding box overlaps, inclusive.
+	struct CellRange {
+		int first_row;
+		int first_col;
+		int last_row;
+		int last_col;
+
+		bool operator==(const CellRange& other) const = default;
+	};
+
 	// A vector of all bodies in the grid.
 	std::vector<Body*> bodies;
 
+	// Nodes each body was placed in, by index in bodies.
+	// Lets a body be removed from its nodes after it has moved or grown.
+	std::vector<CellRange> body_cells;
+
+	// Index of each body in bodies.
+	std::unordered_map<const Body*, int> body_indices;
+
 	const float grid_size; // Total size of the grid
 	const float node_size; // Size of each node in the grid.
 	const int nodes_per_row; // Number of nodes in a row of the grid.
@@ -25,14 +43,36 @@ class Grid : public SpatialPartitioning
 	// Returns the x or y grid node index of a given coordinate position.
 	int get_index(int pos) const;
 
+	// Returns the id of the grid node at a given position.
+	int get_node_id(Vector2 pos) const;
+
 	// Returns a reference to the grid node at a given position.
 	GridNode& get_node(Vector2 pos);
 
 	// Returns a const reference to the grid node at a given position.
 	const GridNode& get_node(Vector2 pos) const;
 
-	// Returns a list of all grid nodes that the body overlaps with.
-	std::vector<GridNode*> get_all_nodes(const Body& body);
+	// Returns the range of grid nodes that the body overlaps with.
+	CellRange get_cells(const Body& body) const;
+
+	// Returns the range of grid nodes that the area overlaps with.
+	CellRange get_cells(Rectangle area) const;
+
+	// Returns the start coordinate of a node row or column. Unbounded for the first and one past the last,
+	// since positions outside the grid are clamped into its edge nodes.
+	float cell_start(int index) const;
+
+	// Returns the area the body's center can move within, while its bounding box still overlaps exactly the given nodes.
+	Rectangle get_partition_bounds(const Body& body, CellRange cells) const;
+
+	// Adds the body to every node in the range.
+	void add_to_cells(Body& body, CellRange cells);
+
+	// Removes the body from every node in the range.
+	void rem_from_cells(const Body& body, CellRange cells);
+
+	// Moves the body at an index of bodies into the nodes its bounding box now overlaps, and resets its partition bounds.
+	void relocate(int index);
 
 public:
 
@@ -45,15 +85,31 @@ public:
 	// Removes body from the grid.
 	void rem_body(const Body& body) override;
 
-	void notify_move(const Body* from, Body* to) override;
+	// Removes the bodies from the grid, going over each node they were in only once.
+	void rem_bodies(std::span<const Body* const> bodies) override;
+
+	// Moves the body into the nodes its new bounding box overlaps.
+	void notify_radius_changed(Body& body, float old_radius) override;
 
 	// Updates bodies to be in the correct grid node.
 	void update() override;
 
+	bool uses_partition_bounds() const override { return true; }
+
+	// Moves only the bodies that have left the nodes they were in.
+	void update_moved(std::span<Body* const> moved) override;
+
 	// Tries to find and return a pointer to the body that overlaps with the point.
 	// If none found, returns nullptr.
 	Body* find_body(Vector2 point) const override;
 
+	// Returns every body that overlaps with the area, only checking the nodes the area overlaps.
+	std::vector<Body*> query_rect(Rectangle area) const override;
+
+	// Returns the (up to) k bodies whose centers are nearest to the point, nearest first.
+	// Checks rings of nodes around the point's node, until no node left can hold a nearer body.
+	std::vector<Body*> k_nearest(Vector2 point, int k) const override;
+
 	// Returns a representation of the grid.
 	std::vector<Rectangle> get_representation() const override;
 
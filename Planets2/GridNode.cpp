@@ -3,6 +3,8 @@
 #include "Physics.h"
 #include "Collision.h"
 #include "DebugInfo.h"
+#include "NearestBodies.h"
+#include "CircleBatch.h"
 #include <algorithm>
 
 GridNode::GridNode(float x, float y, float node_size, int id) : dimensions{ x, y, node_size, node_size }, id(id)
@@ -20,10 +22,11 @@ void GridNode::rem(const Body& body)
     bodies.erase(it);
 }
 
-void GridNode::notify_move(const Body* from, Body* to)
+void GridNode::rem_all(const std::unordered_set<const Body*>& removing)
 {
-    auto it = std::find(bodies.begin(), bodies.end(), from);
-    *it = to;
+    std::erase_if(bodies, [&removing](const Body* body) {
+        return removing.contains(body);
+    });
 }
 
 void GridNode::clear()
@@ -42,6 +45,26 @@ Body* GridNode::find_body(Vector2 point) const
     return nullptr;
 }
 
+void GridNode::query_rect(Rectangle area, std::vector<Body*>& found, const std::function<int(Vector2)>& node_id_at) const
+{
+    for (Body* body : bodies) {
+        Vector2 overlap_corner { std::max(body->left(), area.x), std::max(body->top(), area.y) };
+
+        if (node_id_at(overlap_corner) == id and body->intersects_rect(area)) {
+            found.push_back(body);
+        }
+    }
+}
+
+void GridNode::offer_nearest(NearestBodies& nearest, const std::function<int(Vector2)>& node_id_at) const
+{
+    for (Body* body : bodies) {
+        if (node_id_at(body->pos()) == id) {
+            nearest.offer(*body);
+        }
+    }
+}
+
 Rectangle GridNode::get_representation() const
 {
     return dimensions;
@@ -53,34 +76,27 @@ void GridNode::get_info(const Body& body, DebugInfo& info) const
     info.add("Grid bodies: " + std::to_string(bodies.size()));
 }
 
-int GridNode::get_collisions(std::vector<Collision>& collisions) const
+int GridNode::get_collisions(std::vector<Collision>& collisions, const std::function<int(Vector2)>& node_id_at) const
 {
     int checks = 0;
 
-    if (bodies.empty()) {
+    if (bodies.size() < 2) {
         return checks;
     }
 
-    for (auto it1 = bodies.begin(); it1 != bodies.end() - 1; it1++) {
-        Body& body1 = **it1;
-        for (auto it2 = it1 + 1; it2 != bodies.end(); it2++) {
-            Body& body2 = **it2;
-
-            checks++;
+    CircleBatch candidates { bodies };
 
-            if (body1.collided_with(body2)) {
-                Collision collision { Body::get_sorted_pair(body1, body2) };
+    for (int i = 0; i + 1 < bodies.size(); i++) {
+        Body& body1 = *bodies[i];
 
-                auto is_same_collision = [collision](Collision other) {
-                    return collision == other;
-                };
+        checks += candidates.for_each_hit(body1, i + 1, [this, &body1, &collisions, &node_id_at](Body& body2) {
+            // Both bodies are in every node that this corner is in, so exactly one node adds the collision.
+            Vector2 overlap_corner { std::max(body1.left(), body2.left()), std::max(body1.top(), body2.top()) };
 
-                if (!std::any_of(collisions.begin(), collisions.end(), is_same_collision)) {
-                    collisions.emplace_back(Body::get_sorted_pair(body1, body2));
-                }
+            if (node_id_at(overlap_corner) == id) {
+                collisions.emplace_back(Body::get_sorted_pair(body1, body2));
             }
-
-        }
+        });
     }
 
     return checks;
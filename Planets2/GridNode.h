@@ -1,9 +1,12 @@
 #pragma once
 #include <vector>
-#include "raylib.h"
+#include <functional>
+#include <unordered_set>
+#include "SimTypes.h"
 
 class Body;
 struct Collision;
+class NearestBodies;
 
 class DebugInfo;
 
@@ -31,8 +34,9 @@ public:
 
 	// Removes body from the node.
 	void rem(const Body& body);
-	
-	void notify_move(const Body* from, Body* to);
+
+	// Removes every body in removing from the node, in one pass over its bodies.
+	void rem_all(const std::unordered_set<const Body*>& removing);
 
 	// Clears the node.
 	void clear();
@@ -41,6 +45,15 @@ public:
 	// Else, returns nullptr.
 	Body* find_body(Vector2 point) const;
 
+	// Adds the bodies in this node that overlap with the area to found.
+	// Bodies can be in several nodes, so a body is only added by the node whose id node_id_at returns
+	// for the top left corner of the overlap between the body's bounding box and the area.
+	void query_rect(Rectangle area, std::vector<Body*>& found, const std::function<int(Vector2)>& node_id_at) const;
+
+	// Offers the bodies in this node to nearest.
+	// A body is only offered by the node whose id node_id_at returns for its center.
+	void offer_nearest(NearestBodies& nearest, const std::function<int(Vector2)>& node_id_at) const;
+
 	// Returns this nodes's dimensions.
 	Rectangle get_representation() const;
 
@@ -48,8 +61,10 @@ public:
 	void get_info(const Body& body, DebugInfo& info) const;
 
 	// Scans for collisions between each body in this with each other and adds any to the collisions vector.
+	// Bodies can be in several nodes, so a collision is only added by the node whose id node_id_at returns
+	// for the top left corner of the overlap between the two bodies' bounding boxes.
 	// Returns number of collision checks performed.
-	int get_collisions(std::vector<Collision>& collisions) const;
+	int get_collisions(std::vector<Collision>& collisions, const std::function<int(Vector2)>& node_id_at) const;
 
 };
 
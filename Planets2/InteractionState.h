@@ -2,7 +2,8 @@
 #include <string_view>
 
 class CameraState;
-class Universe;
+class SimulationThread;
+class UniverseSnapshot;
 class Body;
 class AdvCamera;
 
@@ -12,7 +13,8 @@ class InteractionState
 public:
 
 	// Processes state-specific user input and returns the next interaction state.
-	virtual InteractionState* process_input(const CameraState& camera_state, Universe& universe) = 0;
+	// Reads the simulation's current snapshot, and submits any changes to the universe to the simulation.
+	virtual InteractionState* process_input(const CameraState& camera_state, SimulationThread& simulation) = 0;
 
 	// Returns the state's title.
 	virtual std::string_view get_name() const = 0;
@@ -21,7 +23,7 @@ public:
 	virtual std::string_view get_help_text() const = 0;
 
 	// State renders state-specific world-position elements.
-	virtual void render_world(const AdvCamera& camera, const Universe& universe)
+	virtual void render_world(const AdvCamera& camera, const UniverseSnapshot& universe)
 	{}
 
 	virtual ~InteractionState() = default;
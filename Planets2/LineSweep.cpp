@@ -1,54 +1,33 @@
 #include "LineSweep.h"
-#include "raylib.h"
+#include "SimTypes.h"
 
 #include "Collision.h"
 #include "Body.h"
 
 #include "Physics.h"
 #include "DebugInfo.h"
+#include "NearestBodies.h"
 #include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <unordered_set>
 
-LineSweep::LineSweep::SweepEvent LineSweep::get_next_event(int entries_processed, int leaves_processed) const
-{
-    if (entries_processed == entry_events.size()) {
-        // we have no entries, but we may have leave events.
-        // Nevertheless, return end event, since we only do collision checking on entry events.
-
-        return SweepEvent::END;
-
-    }
-
-    // We have entry events.
-
-    const Body& next_entry = *entry_events[entries_processed];
-
-    // Don't need to check if we have leaves.
-    // no way to have entries and not have leaves.
-
-    const Body& next_leave = *leave_events[leaves_processed];
-
-    // Return whichever event comes first.
-    if (next_entry.left() <= next_leave.right()) {
-        return SweepEvent::ENTRY;
-    }
-    else {
-        return SweepEvent::LEAVE;
-
-    }
-
-    return SweepEvent::END;
-}
+LineSweep::LineSweep(int min_bodies_per_strip) : min_bodies_per_strip(std::max(1, min_bodies_per_strip))
+{}
 
 void LineSweep::add_body(Body& body)
 {
-    auto it = std::upper_bound(entry_events.cbegin(), entry_events.cend(), &body, left_less_than);
+    auto entry_less = [this](const Body* body1, const Body* body2) { return entry_less_than(body1, body2); };
+    auto leave_less = [this](const Body* body1, const Body* body2) { return leave_less_than(body1, body2); };
+
+    auto it = std::upper_bound(entry_events.cbegin(), entry_events.cend(), &body, entry_less);
     entry_events.insert(it, &body);
 
-    it = std::upper_bound(leave_events.cbegin(), leave_events.cend(), &body, right_less_than);
+    it = std::upper_bound(leave_events.cbegin(), leave_events.cend(), &body, leave_less);
     leave_events.insert(it, &body);
 }
 
-void LineSweep::add_bodies(std::span<Body*> bodies)
+void LineSweep::add_bodies(std::span<Body* const> bodies)
 {
     for (Body* body : bodies) {
         entry_events.push_back(body);
@@ -68,45 +47,119 @@ void LineSweep::rem_body(const Body& body)
 
 }
 
-void LineSweep::notify_move(const Body* from, Body* to)
+void LineSweep::rem_bodies(std::span<const Body* const> bodies)
 {
-    auto entry_event_it = get_entry_it(*from);
-    auto leave_event_it = get_leave_it(*from);
+    std::unordered_set<const Body*> removing(bodies.begin(), bodies.end());
+    auto is_removing = [&removing](const Body* body) { return removing.contains(body); };
 
-    *entry_event_it = to;
-    *leave_event_it = to;
+    // Erasing keeps the order of the remaining events, so they stay sorted.
+    std::erase_if(entry_events, is_removing);
+    std::erase_if(leave_events, is_removing);
+}
 
+void LineSweep::notify_radius_changed([[maybe_unused]] Body& body, [[maybe_unused]] float old_radius)
+{
+    // Events are sorted by the bodies' current coordinates, so the old one can't be searched for. Only the grown body is out of place.
+    resort_events();
+}
+
+void LineSweep::notify_radii_changed([[maybe_unused]] std::span<Body* const> bodies, [[maybe_unused]] std::span<const float> old_radii)
+{
+    // Every absorber of a tick grows before any is notified about, so their events are only out of order around each other.
+    // Re-sorting once costs a pass over the events plus the places they move, rather than a search for each absorber.
+    resort_events();
 }
 
 void LineSweep::update()
 {
-    sort_events();
+    if (select_axis()) {
+        // Previous order was along the other axis, so it is of no use.
+        sort_events();
+    }
+    else {
+        resort_events();
+    }
 }
 
 Body* LineSweep::find_body(Vector2 point) const
 {
-    auto it = std::find_if(entry_events.begin(), entry_events.end(), [point](const Body* body) {
+    float coord = axis == Axis::X ? point.x : point.y;
+    std::span<Body* const> candidates = axis_candidates(coord, coord);
+
+    auto it = std::ranges::find_if(candidates, [point](const Body* body) {
         return body->contains_point(point);
     });
 
-    if (it != entry_events.end()) {
+    if (it != candidates.end()) {
         return *it;
     }
 
     return nullptr;
 }
 
+std::vector<Body*> LineSweep::query_rect(Rectangle area) const
+{
+    std::span<Body* const> candidates = axis == Axis::X
+        ? axis_candidates(area.x, area.x + area.width)
+        : axis_candidates(area.y, area.y + area.height);
+
+    std::vector<Body*> found;
+    std::ranges::copy_if(candidates, std::back_inserter(found), [area](const Body* body) {
+        return body->intersects_rect(area);
+    });
+
+    return found;
+}
+
+std::vector<Body*> LineSweep::k_nearest(Vector2 point, int k) const
+{
+    int num_bodies = entry_events.size();
+    if (k <= 0 or k >= num_bodies) {
+        // Every body is needed anyway.
+        return SpatialPartitioning::k_nearest(point, k);
+    }
+
+    // Start with a square that would hold about k bodies, if they were spread evenly along both axes.
+    float extent = leave_coord(*leave_events.back()) - entry_coord(*entry_events.front());
+    float half_size = std::max(1.0f, extent * std::sqrt(static_cast<float>(k) / num_bodies) / 2);
+
+    while (true) {
+        std::vector<Body*> found = query_rect({ point.x - half_size, point.y - half_size, 2 * half_size, 2 * half_size });
+
+        NearestBodies nearest { point, k };
+        for (Body* body : found) {
+            nearest.offer(*body);
+        }
+
+        // Every body whose center is within half_size of the point overlaps the square, so a body outside it can't be nearer.
+        if (found.size() == num_bodies or nearest.excludes(half_size * half_size)) {
+            return nearest.take();
+        }
+
+        half_size *= 2;
+    }
+}
+
 std::vector<Rectangle> LineSweep::get_representation() const
 {
-    // Return entry and exit lines. From top universe to bottom.
+    // Return entry and exit lines, perpendicular to the sweep axis.
     std::vector<Rectangle> rep;
 
+    auto add_line = [this, &rep](const Body* body, float coord) {
+        if (axis == Axis::X) {
+            rep.emplace_back(coord, body->top(), 2.0f, body->diameter());
+        }
+        else {
+            rep.emplace_back(body->left(), coord, body->diameter(), 2.0f);
+        }
+    };
+
     for (Body* body : entry_events) {
-        rep.emplace_back(body->left(), body->top(), 2.0f, body->diameter());
+        add_line(body, entry_coord(*body));
     }
 
     for (Body* body : leave_events) {
-        rep.emplace_back(body->right(), body->top(), 2.0f, body->diameter());
+        add_line(body, leave_coord(*body));
     }
 
     return rep;
@@ -123,85 +176,185 @@ void LineSweep::get_info(const Body& body, DebugInfo& info) const
     int entry_index = std::distance(entry_events.begin(), entry_event_it);
     int leave_index = std::distance(leave_events.begin(), leave_event_it);
 
+    info.add(axis == Axis::X ? "Sweep axis: x" : "Sweep axis: y");
     info.add("Entry event index: " + std::to_string(entry_index));
     info.add("Leave event index: " + std::to_string(leave_index));
 }
 
-std::vector<Collision> LineSweep::get_collisions_impl()
+float LineSweep::entry_coord(const Body& body) const
 {
-    std::vector<Collision> collisions;
-    collisions.reserve(entry_events.size());
+    return axis == Axis::X ? body.left() : body.top();
+}
 
-    // When entry event processed, new body scans collisions with these bodies.
-    // Then the new body is added here and removed on its leave event encounter.
-    // Sorted based on left(), like entry_events.
-    std::vector<Body*> currently_active;
-    currently_active.reserve(entry_events.size());
+float LineSweep::leave_coord(const Body& body) const
+{
+    return axis == Axis::X ? body.right() : body.bottom();
+}
 
-    // can just pop off back (scan right to left) and go until both empty.
-    int entries_processed = 0;
-    int leaves_processed = 0;
+std::span<Body* const> LineSweep::axis_candidates(float min, float max) const
+{
+    // Bodies that enter after max, or leave before min, can't overlap the range.
+    auto entered = std::upper_bound(entry_events.begin(), entry_events.end(), max, [this](float value, const Body* body) {
+        return value < entry_coord(*body);
+    });
+    auto not_left = std::lower_bound(leave_events.begin(), leave_events.end(), min, [this](const Body* body, float value) {
+        return leave_coord(*body) < value;
+    });
+
+    if (entered - entry_events.begin() <= leave_events.end() - not_left) {
+        return { entry_events.begin(), entered };
+    }
+    else {
+        return { not_left, leave_events.end() };
+    }
+}
+
+float LineSweep::center_variance(Axis along) const
+{
+    if (entry_events.empty()) {
+        return 0.0f;
+    }
 
-    // We can stop on last entry event.
+    // Accumulate in doubles, since coordinates can be far from the origin.
+    double sum = 0.0;
+    double sum_sq = 0.0;
 
-    SweepEvent next_event = get_next_event(entries_processed, leaves_processed);
-    while (next_event != SweepEvent::END) {
-        // if next entry event's left() comes before next leave event, add to curr active and advance entries_processed.
-        // if next leave event's right() comes before next entry event, remove from active and advance leaves_processed.
+    for (const Body* body : entry_events) {
+        Vector2 pos = body->pos();
+        double coord = along == Axis::X ? pos.x : pos.y;
+        sum += coord;
+        sum_sq += coord * coord;
+    }
 
+    double mean = sum / entry_events.size();
+    return sum_sq / entry_events.size() - mean * mean;
+}
 
-        if (next_event == SweepEvent::ENTRY) {
-            // Get collisions between the body just entering, and all active bodies.
-            // Then add to active bodies.
+bool LineSweep::select_axis()
+{
+    Axis other = axis == Axis::X ? Axis::Y : Axis::X;
 
-            Body& entry = *entry_events[entries_processed];
+    if (center_variance(other) > AXIS_SWITCH_RATIO * center_variance(axis)) {
+        // Bodies are more spread out along the other axis, so fewer bodies will be active at once sweeping along it.
+        axis = other;
+        return true;
+    }
 
-            num_collision_checks_tick += get_collisions(entry, currently_active, collisions);
+    return false;
+}
 
-            currently_active.push_back(&entry);
+std::vector<LineSweep::Strip> LineSweep::make_strips() const
+{
+    int num_bodies = entry_events.size();
+    int num_strips = std::clamp(num_bodies / min_bodies_per_strip, 1, MAX_STRIPS);
 
-            entries_processed++;
-        }
-        else if (next_event == SweepEvent::LEAVE) {
-            // Remove the body from the list of active bodies.
+    std::vector<Strip> strips;
+    strips.reserve(num_strips);
 
-            Body& leave = *leave_events[leaves_processed];
+    // Bodies that entered before the current strip and haven't been left behind by its start yet.
+    std::vector<Body*> active;
 
-            // Can do binary search, since currently_active is sorted.
-            auto it = std::lower_bound(currently_active.begin(), currently_active.end(), &leave, left_less_than);
-            currently_active.erase(it);
+    // Strips have an equal number of entry events rather than equal width,
+    // so that clustered bodies are still split evenly.
+    for (int i = 0; i < num_strips; i++) {
+        int first = static_cast<long long>(num_bodies) * i / num_strips;
+        int last = static_cast<long long>(num_bodies) * (i + 1) / num_strips;
 
-            leaves_processed++;
+        if (first != last) {
+            float strip_start = entry_coord(*entry_events[first]);
+            std::erase_if(active, [this, strip_start](const Body* body) { return leave_coord(*body) < strip_start; });
         }
 
-        next_event = get_next_event(entries_processed, leaves_processed);
+        strips.push_back({ first, last, active });
+        active.insert(active.end(), entry_events.begin() + first, entry_events.begin() + last);
     }
-    
 
-    return collisions;
+    return strips;
 }
 
-int LineSweep::get_collisions(Body& entry, std::span<Body*> currently_active, std::vector<Collision>& collisions) const
+int LineSweep::sweep_strip(const Strip& strip, std::vector<Collision>& collisions) const
 {
-    for (Body* body : currently_active) {
-        if (entry.collided_with(*body)) {
-            collisions.emplace_back(Body::get_sorted_pair(entry, *body));
-        }
+    // When entry event processed, new body scans collisions with these bodies.
+    // Then the new body is added here and dropped once the sweep line passes its leave coordinate.
+    CircleBatch currently_active;
+
+    // Bodies that entered in earlier strips, but straddle into this one, are active at the strip's start.
+    // They are only checked against bodies entering in this strip,
+    // since any pair that entered before this strip belongs to an earlier strip.
+    // So every pair is checked exactly once, by the strip containing the later entry event.
+    for (Body* body : strip.active_at_start) {
+        currently_active.add(*body);
+    }
+
+    collisions.reserve(strip.last - strip.first);
+
+    int checks = 0;
+    for (int i = strip.first; i < strip.last; i++) {
+        Body& entry = *entry_events[i];
+        checks += get_collisions(entry, currently_active, collisions);
+        currently_active.add(entry);
     }
 
+    return checks;
+}
+
+std::vector<Collision> LineSweep::get_collisions_impl()
+{
+    std::vector<Strip> strips = make_strips();
+
+    // Strips are merged in order, so results are the same as a single sweep's.
+    std::vector<Collision> collisions;
+    num_collision_checks_tick = gather_parallel(strips.size(), [this, &strips](int strip, std::vector<Collision>& strip_collisions) {
+        return sweep_strip(strips[strip], strip_collisions);
+    }, collisions);
+
+    return collisions;
+}
+
+int LineSweep::get_collisions(Body& entry, CircleBatch& currently_active, std::vector<Collision>& collisions) const
+{
+    float entry_start = entry_coord(entry);
+
+    // Drop bodies that have been left behind by the sweep line.
+    currently_active.erase_if([this, entry_start](const Body& body) { return leave_coord(body) < entry_start; });
+
     // Body is checked with all currently active bodies.
-    return currently_active.size();
+    return currently_active.collide(entry, 0, collisions);
 }
 
 void LineSweep::sort_events()
 {
-    std::sort(entry_events.begin(), entry_events.end(), left_less_than);
-    std::sort(leave_events.begin(), leave_events.end(), right_less_than);
+    auto entry_less = [this](const Body* body1, const Body* body2) { return entry_less_than(body1, body2); };
+    auto leave_less = [this](const Body* body1, const Body* body2) { return leave_less_than(body1, body2); };
+
+    std::sort(entry_events.begin(), entry_events.end(), entry_less);
+    std::sort(leave_events.begin(), leave_events.end(), leave_less);
+}
+
+void LineSweep::resort_events()
+{
+    // Bodies barely move between ticks, so the previous order is nearly sorted.
+    // An insertion sort over it does little more than a single pass.
+    auto insertion_sort = [](std::vector<Body*>& events, auto less_than) {
+        for (int i = 1; i < events.size(); i++) {
+            Body* body = events[i];
+            int j = i;
+            while (j > 0 and less_than(body, events[j - 1])) {
+                events[j] = events[j - 1];
+                j--;
+            }
+            events[j] = body;
+        }
+    };
+
+    insertion_sort(entry_events, [this](const Body* body1, const Body* body2) { return entry_less_than(body1, body2); });
+    insertion_sort(leave_events, [this](const Body* body1, const Body* body2) { return leave_less_than(body1, body2); });
 }
 
 std::vector<Body*>::const_iterator LineSweep::get_entry_it(const Body& body) const
 {
-    auto it = std::lower_bound(entry_events.cbegin(), entry_events.cend(), &body, left_less_than);
+    auto entry_less = [this](const Body* body1, const Body* body2) { return entry_less_than(body1, body2); };
+    auto it = std::lower_bound(entry_events.cbegin(), entry_events.cend(), &body, entry_less);
 
     // it can be pointing at leftmost body whose leftmost point >= body's leftmost point. should be guaranteed == if in entry events.
     // might be multiple entry events with same point.
@@ -214,7 +367,8 @@ std::vector<Body*>::const_iterator LineSweep::get_entry_it(const Body& body) con
 
 std::vector<Body*>::iterator LineSweep::get_entry_it(const Body& body)
 {
-    auto it = std::lower_bound(entry_events.begin(), entry_events.end(), &body, left_less_than);
+    auto entry_less = [this](const Body* body1, const Body* body2) { return entry_less_than(body1, body2); };
+    auto it = std::lower_bound(entry_events.begin(), entry_events.end(), &body, entry_less);
 
     // it can be pointing at leftmost body whose leftmost point >= body's leftmost point. should be guaranteed == if in entry events.
     // might be multiple entry events with same point.
@@ -227,7 +381,8 @@ std::vector<Body*>::iterator LineSweep::get_entry_it(const Body& body)
 
 std::vector<Body*>::const_iterator LineSweep::get_leave_it(const Body& body) const
 {
-    auto it = std::lower_bound(leave_events.cbegin(), leave_events.cend(), &body, right_less_than);
+    auto leave_less = [this](const Body* body1, const Body* body2) { return leave_less_than(body1, body2); };
+    auto it = std::lower_bound(leave_events.cbegin(), leave_events.cend(), &body, leave_less);
 
     // it is pointing at first body whose rightmost point >= body's rightmost point. if in events, should be first ==.
     while (it != leave_events.cend() and **it != body) { // if in events, shouldnt need to check for != cend().
@@ -239,7 +394,8 @@ std::vector<Body*>::const_iterator LineSweep::get_leave_it(const Body& body) con
 
 std::vector<Body*>::iterator LineSweep::get_leave_it(const Body& body)
 {
-    auto it = std::lower_bound(leave_events.begin(), leave_events.end(), &body, right_less_than);
+    auto leave_less = [this](const Body* body1, const Body* body2) { return leave_less_than(body1, body2); };
+    auto it = std::lower_bound(leave_events.begin(), leave_events.end(), &body, leave_less);
 
     // it is pointing at first body whose rightmost point >= body's rightmost point. if in events, should be first ==.
     while (it != leave_events.end() and **it != body) { // if in events, shouldnt need to check for != cend().
@@ -249,22 +405,12 @@ std::vector<Body*>::iterator LineSweep::get_leave_it(const Body& body)
     return it;
 }
 
-bool LineSweep::left_less_than_point(const Body* body, float entry_x)
-{
-    return body->left() < entry_x;
-}
-
-bool LineSweep::left_less_than(const Body* body1, const Body* body2)
-{
-    return body1->left() < body2->left();
-}
-
-bool LineSweep::right_less_than_point(const Body* body, float leave_x)
+bool LineSweep::entry_less_than(const Body* body1, const Body* body2) const
 {
-    return body->right() < leave_x;
+    return entry_coord(*body1) < entry_coord(*body2);
 }
 
-bool LineSweep::right_less_than(const Body* body1, const Body* body2)
+bool LineSweep::leave_less_than(const Body* body1, const Body* body2) const
 {
-    return body1->right() < body2->right();
+    return leave_coord(*body1) < leave_coord(*body2);
 }
@@ -1,30 +1,76 @@
 #pragma once
 #include "SpatialPartitioning.h"
+#include "CircleBatch.h"
 #include <span>
 
 // Line sweep algorithm for collision detection.
+// Sweeps along whichever axis the bodies are most spread out on,
+// and splits large sweeps into strips that are processed concurrently.
 class LineSweep : public SpatialPartitioning
 {
 
-	enum class SweepEvent {
-		END, // Algorithm should end because all entry events processed.
-		ENTRY, // Encountered a body's leftmost point.
-		LEAVE // Encountered a body's rightmost point.
+	enum class Axis {
+		X,
+		Y
 	};
 
+	// A contiguous range of entry events that is swept independently of the others.
+	struct Strip {
+		// Index of the strip's first entry event.
+		int first;
+		// Index one past the strip's last entry event.
+		int last;
+		// Bodies that entered in earlier strips and are still active at the strip's start, in entry order.
+		std::vector<Body*> active_at_start;
+	};
+
+	// Maximum number of strips a sweep is split into.
+	static constexpr int MAX_STRIPS = 64;
+
+	// Another axis must be spread out by at least this factor more than the current axis to switch to it.
+	// Prevents re-sorting from scratch every tick when the spread on both axes is similar.
+	static constexpr float AXIS_SWITCH_RATIO = 1.2f;
+
+	// Axis the sweep line travels along.
+	Axis axis = Axis::X;
+
+	// Minimum number of entry events in each strip.
+	int min_bodies_per_strip;
 
-	// Sorted in ascending order of body's leftmost x-coordinate.
+	// Sorted in ascending order of body's lowest coordinate on the sweep axis.
 	std::vector<Body*> entry_events;
 
-	// Sorted in ascending order of body's rightmost x-coordinate.
+	// Sorted in ascending order of body's highest coordinate on the sweep axis.
 	std::vector<Body*> leave_events;
 
-	// Returns the next event in the sweep line algorithm.
-	SweepEvent get_next_event(int entries_processed, int leaves_processed) const;
+	// Returns the body's lowest coordinate on the sweep axis.
+	float entry_coord(const Body& body) const;
+
+	// Returns the body's highest coordinate on the sweep axis.
+	float leave_coord(const Body& body) const;
+
+	// Returns the bodies of either the entry or the leave events, which include every body
+	// whose extent on the sweep axis overlaps [min, max]. Whichever is fewer.
+	std::span<Body* const> axis_candidates(float min, float max) const;
+
+	// Returns the variance of the bodies' centers along an axis.
+	float center_variance(Axis along) const;
+
+	// Picks the axis the bodies are most spread out on. Returns true if the axis changed.
+	bool select_axis();
 
 	// Scans for and adds any collision events between the entering body and the currently active bodies to the collisions vector.
+	// Drops any active bodies that the entering body has passed.
 	// Returns number of collision checks performed.
-	int get_collisions(Body& entry, std::span<Body*> currently_active, std::vector<Collision>& collisions) const;
+	int get_collisions(Body& entry, CircleBatch& currently_active, std::vector<Collision>& collisions) const;
+
+	// Sweeps the strip's entry events, starting with the earlier bodies that are still active at the strip's start.
+	// Returns number of collision checks performed.
+	int sweep_strip(const Strip& strip, std::vector<Collision>& collisions) const;
+
+	// Splits the entry events into strips to be swept independently.
+	// Finds the bodies active at each strip's start in a single serial sweep over all entry events.
+	std::vector<Strip> make_strips() const;
 
 	// Detects and returns a vector of all collision events.
 	std::vector<Collision> get_collisions_impl() override;
@@ -32,6 +78,9 @@ class LineSweep : public SpatialPartitioning
 	// Sorts entry and leave events in ascending order.
 	void sort_events();
 
+	// Sorts entry and leave events in ascending order, starting from their previous order.
+	void resort_events();
+
 
 	// Gets an iterator for the body's entry event.
 	std::vector<Body*>::const_iterator get_entry_it(const Body& body) const;
@@ -44,36 +93,50 @@ class LineSweep : public SpatialPartitioning
 	std::vector<Body*>::iterator get_leave_it(const Body& body);
 
 	// predicates for STL algorithms
-	static bool left_less_than_point(const Body* body, float entry_x);
-	static bool left_less_than(const Body* body1, const Body* body2);
-
-	static bool right_less_than_point(const Body* body, float leave_x);
-	static bool right_less_than(const Body* body1, const Body* body2);
+	bool entry_less_than(const Body* body1, const Body* body2) const;
+	bool leave_less_than(const Body* body1, const Body* body2) const;
 
 
 public:
 
+	// Constructs a line sweep that splits its sweep into strips of at least min_bodies_per_strip bodies.
+	explicit LineSweep(int min_bodies_per_strip = 512);
+
 	// Adds a body to be considered by the algorithm.
 	void add_body(Body& body) override;
 
-	// Adds all bodies to be considered by the algorithm.
-	void add_bodies(std::span<Body*> bodies);
+	// Adds all bodies to be considered by the algorithm, sorting the events once.
+	void add_bodies(std::span<Body* const> bodies) override;
+
+	// Removes all the bodies' events in a single pass over each event list.
+	void rem_bodies(std::span<const Body* const> bodies) override;
 
 	// Removes the body from being considered by the algorithm.
 	void rem_body(const Body& body) override;
 
-	void notify_move(const Body* from, Body* to) override;
+	// Moves the body's events to their places for its new radius, in one pass over each event list.
+	void notify_radius_changed(Body& body, float old_radius) override;
+
+	// Moves the events of every body to their places for their new radii, in one pass over each event list.
+	void notify_radii_changed(std::span<Body* const> bodies, std::span<const float> old_radii) override;
 
-	// Updates algorithm's entry and leave events.
+	// Chooses the sweep axis and updates algorithm's entry and leave events.
 	void update() override;
 
 	// Returns a pointer to the body that contains the point. If none do, returns nullptr.
 	Body* find_body(Vector2 point) const override;
 
+	// Returns every body that overlaps with the area, only checking bodies that overlap it on the sweep axis.
+	std::vector<Body*> query_rect(Rectangle area) const override;
+
+	// Returns the (up to) k bodies whose centers are nearest to the point, nearest first.
+	// Queries squares around the point, doubling their size until one holds the k nearest bodies.
+	std::vector<Body*> k_nearest(Vector2 point, int k) const override;
+
 	// Returns a visual representation of the algorithm's events.
 	std::vector<Rectangle> get_representation() const override;
 
-	// Attaches text indicating body's entry event index, leave event index to info.
+	// Attaches text indicating the sweep axis, body's entry event index, leave event index to info.
 	void get_info(const Body& body, DebugInfo& info) const override;
 
 
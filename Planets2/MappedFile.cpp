@@ -0,0 +1,143 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path)
+{
+    MappedFile file;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return std::nullopt;
+    }
+    file.file_handle = handle;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle, &file_size) or file_size.QuadPart == 0) {
+        return std::nullopt;
+    }
+    file.size = static_cast<size_t>(file_size.QuadPart);
+
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        return std::nullopt;
+    }
+    file.mapping_handle = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        return std::nullopt;
+    }
+    file.data = static_cast<const std::byte*>(view);
+#else
+    file.file_descriptor = ::open(path.c_str(), O_RDONLY);
+    if (file.file_descriptor == -1) {
+        return std::nullopt;
+    }
+
+    struct stat status;
+    if (fstat(file.file_descriptor, &status) != 0 or status.st_size == 0) {
+        return std::nullopt;
+    }
+    file.size = static_cast<size_t>(status.st_size);
+
+    void* view = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, file.file_descriptor, 0);
+    if (view == MAP_FAILED) {
+        return std::nullopt;
+    }
+    file.data = static_cast<const std::byte*>(view);
+#endif
+
+    return file;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        release();
+
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+#ifdef _WIN32
+        file_handle = std::exchange(other.file_handle, nullptr);
+        mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#else
+        file_descriptor = std::exchange(other.file_descriptor, -1);
+#endif
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    release();
+}
+
+void MappedFile::release()
+{
+#ifdef _WIN32
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+#else
+    if (data) {
+        munmap(const_cast<std::byte*>(data), size);
+    }
+    if (file_descriptor != -1) {
+        close(file_descriptor);
+    }
+    file_descriptor = -1;
+#endif
+
+    data = nullptr;
+    size = 0;
+}
+
+std::span<const std::byte> MappedFile::bytes() const
+{
+    return { data, size };
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const
+{
+    if (offset >= size) {
+        return;
+    }
+    length = std::min(length, size - offset);
+
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range { const_cast<std::byte*>(data) + offset, length };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // madvise needs a page aligned start.
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = offset / page * page;
+    madvise(const_cast<std::byte*>(data) + start, length + (offset - start), MADV_WILLNEED);
+#endif
+}
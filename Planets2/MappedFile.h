@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+/*
+* A file mapped read-only into memory, for reading large files without copying them into buffers first.
+* Pages are only read from disk once they are touched, and stay shared with the operating system's file cache.
+*
+* Move-only. The mapping is released when the object is destroyed.
+*/
+class MappedFile
+{
+	const std::byte* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	// File and file mapping handles. Kept as void* so windows.h isn't included everywhere this header is.
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#else
+	int file_descriptor = -1;
+#endif
+
+	MappedFile() = default;
+
+	void release();
+
+public:
+
+	// Maps the whole file, or returns nullopt if it can't be opened, is empty, or can't be mapped.
+	static std::optional<MappedFile> open(const std::filesystem::path& path);
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	// Returns the file's contents. The mapping starts on a page boundary.
+	std::span<const std::byte> bytes() const;
+
+	// Asks the operating system to start reading the range from disk, so later reads of it don't stall on page faults.
+	// Only a hint: does nothing where unsupported.
+	void prefetch(size_t offset, size_t length) const;
+};
@@ -1,12 +1,15 @@
 #include <random>
 #include "MyRandom.h"
 #include <numbers>
+#include <sstream>
 
-static std::default_random_engine engine;
+// Each thread has its own engine, so threads generating numbers at the same time don't race on its state.
+// set_seed only seeds the calling thread's engine.
+static thread_local std::default_random_engine engine;
 
 float Rand::real()
 {
-    static std::uniform_real_distribution<> real_dist(0, 1);
+    static thread_local std::uniform_real_distribution<> real_dist(0, 1);
     return real_dist(engine);
 }
 
@@ -39,3 +42,24 @@ void Rand::set_seed(int number)
 {
     engine.seed(number);
 }
+
+std::string Rand::get_state()
+{
+    std::ostringstream out;
+    out << engine;
+    return out.str();
+}
+
+bool Rand::set_state(std::string_view state)
+{
+    std::istringstream in { std::string(state) };
+    std::default_random_engine restored;
+    in >> restored;
+
+    if (in.fail()) {
+        return false;
+    }
+
+    engine = restored;
+    return true;
+}
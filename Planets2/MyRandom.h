@@ -1,6 +1,9 @@
 #ifndef MY_RANDOM_H
 #define MY_RANDOM_H
 
+#include <string>
+#include <string_view>
+
 // Methods for convenient uniform random number generation.
 namespace Rand {
 
@@ -19,9 +22,16 @@ namespace Rand {
 	// Returns true if an event with the given possibility occurred.
 	bool chance(float possibility);
 
-	// Sets the seed to be used for producing random numbers.
+	// Sets the seed to be used for producing random numbers on the calling thread.
 	void set_seed(int number);
 
+	// Returns the state of the calling thread's engine, so the same numbers can be produced again from this point on.
+	std::string get_state();
+
+	// Restores the calling thread's engine to a state returned by get_state.
+	// Returns false, leaving the engine as it was, if the state is not valid.
+	bool set_state(std::string_view state);
+
 }
 
 #endif
\ No newline at end of file
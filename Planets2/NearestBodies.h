@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "SimTypes.h"
+#include "Body.h"
+#include "Physics.h"
+
+// Keeps the k bodies whose centers are nearest to a point, out of all bodies offered to it.
+// Used by k-nearest-neighbour searches, which offer bodies in order of where they are likely to be nearest
+// and stop once no unvisited body can be nearer than the farthest one kept.
+class NearestBodies
+{
+	// A kept body and its center's squared distance to the point.
+	struct Candidate {
+		float dist_squared;
+		Body* body;
+
+		// Ties go to the lower id, so the result doesn't depend on the order bodies were offered in.
+		bool operator<(const Candidate& other) const
+		{
+			if (dist_squared != other.dist_squared)
+			{
+				return dist_squared < other.dist_squared;
+			}
+
+			return body->get_id() < other.body->get_id();
+		}
+	};
+
+	Vector2 point;
+	int k;
+
+	// Max-heap of the nearest bodies so far, farthest on top.
+	std::vector<Candidate> heap;
+
+public:
+
+	NearestBodies(Vector2 point, int k) : point(point), k(std::max(0, k))
+	{
+		heap.reserve(this->k);
+	}
+
+	// Keeps the body if it is among the k nearest offered so far.
+	void offer(Body& body)
+	{
+		if (k == 0)
+		{
+			return;
+		}
+
+		Candidate candidate { Physics::dist_squared(point, body.pos()), &body };
+
+		if (heap.size() < k)
+		{
+			heap.push_back(candidate);
+			std::push_heap(heap.begin(), heap.end());
+		}
+		else if (candidate < heap.front())
+		{
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = candidate;
+			std::push_heap(heap.begin(), heap.end());
+		}
+	}
+
+	// Returns true if k bodies are kept, so that only nearer bodies can still change the result.
+	bool is_full() const
+	{
+		return heap.size() == k;
+	}
+
+	// Returns true if no body at least dist_squared away can be kept.
+	bool excludes(float dist_squared) const
+	{
+		return is_full() and (k == 0 or heap.front().dist_squared < dist_squared);
+	}
+
+	// Returns the kept bodies, nearest first.
+	std::vector<Body*> take()
+	{
+		std::sort_heap(heap.begin(), heap.end());
+
+		std::vector<Body*> nearest;
+		nearest.reserve(heap.size());
+
+		for (const Candidate& candidate : heap)
+		{
+			nearest.push_back(candidate.body);
+		}
+
+		heap.clear();
+		return nearest;
+	}
+
+};
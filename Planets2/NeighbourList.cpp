@@ -0,0 +1,353 @@
+#include "NeighbourList.h"
+#include "Body.h"
+#include "Collision.h"
+#include "DebugInfo.h"
+#include "Physics.h"
+#include "CircleBatch.h"
+#include "SimTypes.h"
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <cstdio>
+
+NeighbourList::NeighbourList(std::unique_ptr<SpatialPartitioning>&& builder, float skin) : builder(std::move(builder)), skin(skin)
+{}
+
+void NeighbourList::add_body(Body& body)
+{
+    builder->add_body(body);
+    added.push_back(&body);
+}
+
+void NeighbourList::add_bodies(std::span<Body* const> bodies)
+{
+    builder->add_bodies(bodies);
+    added.insert(added.end(), bodies.begin(), bodies.end());
+}
+
+void NeighbourList::rem_body(const Body& body)
+{
+    const Body* removed = &body;
+    rem_bodies({ &removed, 1 });
+}
+
+void NeighbourList::rem_bodies(std::span<const Body* const> bodies)
+{
+    builder->rem_bodies(bodies);
+
+    // Listed bodies keep their entry until the next rebuild, so other entries' indices stay valid.
+    for (const Body* body : bodies) {
+        auto it = entry_indices.find(body);
+        if (it != entry_indices.end()) {
+            entries[it->second].body = nullptr;
+            entry_indices.erase(it);
+        }
+        else if (std::erase(roaming, body) == 0) {
+            std::erase(added, body);
+        }
+    }
+}
+
+void NeighbourList::notify_radius_changed(Body& body, float old_radius)
+{
+    builder->notify_radius_changed(body, old_radius);
+}
+
+void NeighbourList::notify_radii_changed(std::span<Body* const> bodies, std::span<const float> old_radii)
+{
+    builder->notify_radii_changed(bodies, old_radii);
+}
+
+void NeighbourList::update()
+{
+    builder->update();
+    refresh();
+}
+
+bool NeighbourList::uses_partition_bounds() const
+{
+    return builder->uses_partition_bounds();
+}
+
+void NeighbourList::update_moved(std::span<Body* const> moved)
+{
+    builder->update_moved(moved);
+    refresh();
+}
+
+float NeighbourList::max_drift() const
+{
+    // Two bodies that weren't listed were at least the skin further apart than touching.
+    // They can only touch once their movement and growth add up to more than the skin.
+    return std::transform_reduce(std::execution::par, entries.begin(), entries.end(), 0.0f,
+        [](float a, float b) { return std::max(a, b); },
+        [](const Entry& entry) {
+            if (!entry.body) {
+                return 0.0f;
+            }
+
+            return Physics::dist(entry.built_pos, entry.body->pos()) + entry.body->get_radius() - entry.built_radius;
+        });
+}
+
+void NeighbourList::refresh()
+{
+    num_updates++;
+    rebuilt_tick = !added.empty() or max_drift() > skin / 2;
+
+    if (rebuilt_tick) {
+        rebuild();
+    }
+}
+
+void NeighbourList::rebuild()
+{
+    std::vector<Body*> bodies;
+    bodies.reserve(entries.size() + roaming.size() + added.size());
+
+    for (const Entry& entry : entries) {
+        if (entry.body) {
+            bodies.push_back(entry.body);
+        }
+    }
+
+    bodies.insert(bodies.end(), roaming.begin(), roaming.end());
+    bodies.insert(bodies.end(), added.begin(), added.end());
+    added.clear();
+
+    entries.clear();
+    roaming.clear();
+
+    for (Body* body : bodies) {
+        if (Vector2Length(body->vel()) * MIN_TICKS_LISTED > skin / 2) {
+            roaming.push_back(body);
+        }
+        else {
+            entries.push_back({ body, body->pos(), body->get_radius() });
+        }
+    }
+
+    entry_indices.clear();
+    entry_indices.reserve(entries.size());
+    for (int i = 0; i < entries.size(); i++) {
+        entry_indices[entries[i].body] = i;
+    }
+
+    // Each body's neighbours are found concurrently, then laid out one list after another in entry order.
+    std::vector<std::vector<int>> found(entries.size());
+    std::vector<int> indices(entries.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [this, &found](int i) {
+        const Body& body = *entries[i].body;
+
+        // Bodies overlapping the body's radius plus the skin are within the skin of touching it.
+        // Roaming bodies find their own collisions.
+        for (const Body* other : builder->query_radius(body.pos(), body.get_radius() + skin)) {
+            if (other->get_id() <= body.get_id()) {
+                continue;
+            }
+
+            auto it = entry_indices.find(other);
+            if (it != entry_indices.end()) {
+                found[i].push_back(it->second);
+            }
+        }
+
+        std::ranges::sort(found[i]);
+    });
+
+    neighbours.clear();
+    neighbour_starts.clear();
+    neighbour_starts.push_back(0);
+
+    for (const std::vector<int>& list : found) {
+        neighbours.insert(neighbours.end(), list.begin(), list.end());
+        neighbour_starts.push_back(neighbours.size());
+    }
+
+    num_rebuilds++;
+}
+
+int NeighbourList::check_listed(int first, int last, std::vector<Collision>& collisions) const
+{
+    int checks = 0;
+    CircleBatch candidates;
+
+    for (int i = first; i < last; i++) {
+        Body* body = entries[i].body;
+        if (!body) {
+            continue;
+        }
+
+        candidates.clear();
+        for (int k = neighbour_starts[i]; k < neighbour_starts[i + 1]; k++) {
+            if (Body* neighbour = entries[neighbours[k]].body) {
+                candidates.add(*neighbour);
+            }
+        }
+
+        checks += candidates.collide(*body, 0, collisions);
+    }
+
+    return checks;
+}
+
+int NeighbourList::check_roaming(Body& body, std::vector<Collision>& collisions) const
+{
+    int checks = 0;
+
+    for (Body* other : builder->query_radius(body.pos(), body.get_radius())) {
+        // A pair of roaming bodies is found by both, so only the lower id adds it.
+        bool other_roaming = !entry_indices.contains(other);
+        if (other == &body or (other_roaming and other->get_id() < body.get_id())) {
+            continue;
+        }
+
+        checks++;
+
+        if (body.collided_with(*other)) {
+            collisions.emplace_back(Body::get_sorted_pair(body, *other));
+        }
+    }
+
+    return checks;
+}
+
+std::vector<Collision> NeighbourList::get_collisions_impl()
+{
+    // Bodies added since the last update aren't listed yet.
+    if (!added.empty()) {
+        rebuild();
+    }
+
+    std::vector<Collision> collisions;
+
+    // Blocks of listed pairs are split so that each holds about the same number of pairs.
+    int num_entries = entries.size();
+    int num_pairs = neighbours.size();
+    int num_listed_blocks = num_entries > 0 ? std::clamp(num_pairs / MIN_PAIRS_PER_BLOCK, 1, MAX_BLOCKS) : 0;
+    int num_roaming_blocks = (static_cast<int>(roaming.size()) + ROAMING_PER_BLOCK - 1) / ROAMING_PER_BLOCK;
+
+    auto block_start = [this, num_entries, num_pairs, num_listed_blocks](int block) {
+        if (block == num_listed_blocks) {
+            return num_entries;
+        }
+
+        int first_pair = static_cast<long long>(num_pairs) * block / num_listed_blocks;
+        return static_cast<int>(std::lower_bound(neighbour_starts.begin(), neighbour_starts.end() - 1, first_pair) - neighbour_starts.begin());
+    };
+
+    // Roaming bodies are checked in blocks after the listed pairs.
+    num_collision_checks_tick = gather_parallel(num_listed_blocks + num_roaming_blocks,
+        [this, &block_start, num_listed_blocks](int block, std::vector<Collision>& block_collisions) {
+            if (block < num_listed_blocks) {
+                return check_listed(block_start(block), block_start(block + 1), block_collisions);
+            }
+
+            int first = (block - num_listed_blocks) * ROAMING_PER_BLOCK;
+            int last = std::min(first + ROAMING_PER_BLOCK, static_cast<int>(roaming.size()));
+
+            int checks = 0;
+            for (int i = first; i < last; i++) {
+                checks += check_roaming(*roaming[i], block_collisions);
+            }
+
+            return checks;
+        }, collisions);
+
+    return collisions;
+}
+
+Body* NeighbourList::find_body(Vector2 point) const
+{
+    return builder->find_body(point);
+}
+
+std::vector<Body*> NeighbourList::query_rect(Rectangle area) const
+{
+    return builder->query_rect(area);
+}
+
+std::vector<Body*> NeighbourList::query_radius(Vector2 center, float radius) const
+{
+    return builder->query_radius(center, radius);
+}
+
+std::vector<Body*> NeighbourList::k_nearest(Vector2 point, int k) const
+{
+    return builder->k_nearest(point, k);
+}
+
+std::vector<Rectangle> NeighbourList::get_representation() const
+{
+    return builder->get_representation();
+}
+
+void NeighbourList::get_info(const Body& body, DebugInfo& info) const
+{
+    auto it = entry_indices.find(&body);
+    if (it != entry_indices.end()) {
+        int index = it->second;
+        info.add("Listed neighbours: " + std::to_string(neighbour_starts[index + 1] - neighbour_starts[index]));
+    }
+    else if (std::ranges::find(roaming, &body) != roaming.end()) {
+        info.add("Listed neighbours: roaming, queried each tick");
+    }
+    else {
+        info.add("Listed neighbours: not listed yet");
+    }
+
+    char rebuilds[64];
+    std::snprintf(rebuilds, sizeof(rebuilds), "List rebuilds: %d (every %.1f ticks)", num_rebuilds, get_updates_per_rebuild());
+    info.add(rebuilds);
+    info.add("List memory: " + std::to_string(get_memory_bytes() / 1024) + " KiB");
+
+    builder->get_info(body, info);
+}
+
+const BarnesHut* NeighbourList::get_gravity_tree() const
+{
+    return builder->get_gravity_tree();
+}
+
+const SpatialPartitioning& NeighbourList::get_builder() const
+{
+    return *builder;
+}
+
+float NeighbourList::get_skin() const
+{
+    return skin;
+}
+
+int NeighbourList::get_num_rebuilds() const
+{
+    return num_rebuilds;
+}
+
+float NeighbourList::get_updates_per_rebuild() const
+{
+    return num_rebuilds > 0 ? static_cast<float>(num_updates) / num_rebuilds : 0.0f;
+}
+
+bool NeighbourList::was_rebuilt_tick() const
+{
+    return rebuilt_tick;
+}
+
+int NeighbourList::get_num_pairs() const
+{
+    return neighbours.size();
+}
+
+int NeighbourList::get_num_roaming() const
+{
+    return roaming.size();
+}
+
+size_t NeighbourList::get_memory_bytes() const
+{
+    return entries.capacity() * sizeof(Entry) + neighbours.capacity() * sizeof(int) + neighbour_starts.capacity() * sizeof(int)
+        + (added.capacity() + roaming.capacity()) * sizeof(Body*);
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "SpatialPartitioning.h"
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "SimTypes.h"
+
+// Verlet neighbour lists for collision detection.
+// Each body keeps a list of the bodies that were within its radius, their radius and a skin distance of it when the lists were built.
+// Lists are built with queries to another partitioning, and reused until some body has moved or grown by more than half the skin.
+// Until then no body outside a body's list can have reached it, so collision checks only run over the lists.
+// Bodies moving too fast to stay listed for long would cause a rebuild every few ticks, so they are instead left out
+// of the lists and queried for each tick.
+class NeighbourList : public SpatialPartitioning
+{
+
+	// A body as it was when the lists were built.
+	struct Entry {
+		// Nullptr if the body was removed since.
+		Body* body;
+		Vector2 built_pos;
+		float built_radius;
+	};
+
+	// Maximum number of blocks that list checks are split into.
+	static constexpr int MAX_BLOCKS = 64;
+
+	// Minimum number of listed pairs in a block, so small universes aren't split into blocks of little work.
+	static constexpr int MIN_PAIRS_PER_BLOCK = 4096;
+
+	// Number of roaming bodies checked by each unit of work.
+	static constexpr int ROAMING_PER_BLOCK = 32;
+
+	// Bodies that would drift by half the skin in fewer ticks than this aren't listed, and are queried for each tick instead.
+	static constexpr int MIN_TICKS_LISTED = 4;
+
+	// Partitioning that keeps every body, and finds each body's neighbours when the lists are rebuilt.
+	// Also answers all queries, since it is kept up to date every tick.
+	std::unique_ptr<SpatialPartitioning> builder;
+
+	// Distance beyond touching within which bodies are listed as neighbours.
+	float skin;
+
+	// Every listed body, as it was when the lists were built.
+	std::vector<Entry> entries;
+
+	// Index of each listed body's entry.
+	std::unordered_map<const Body*, int> entry_indices;
+
+	// Bodies added since the lists were built.
+	std::vector<Body*> added;
+
+	// Bodies that were moving too fast to be listed when the lists were built.
+	std::vector<Body*> roaming;
+
+	// Neighbours of entry i are the entries indexed by neighbours[neighbour_starts[i]] up to neighbours[neighbour_starts[i + 1]].
+	// Only neighbours with a higher id are listed, so each pair is checked once.
+	std::vector<int> neighbours;
+	std::vector<int> neighbour_starts { 0 };
+
+	// Number of times the lists were built, and number of updates since the partitioning was created.
+	int num_rebuilds = 0;
+	int num_updates = 0;
+
+	// Whether the lists were rebuilt on the latest update.
+	bool rebuilt_tick = false;
+
+	// Returns the furthest any listed body has moved, plus how much it has grown, since the lists were built.
+	float max_drift() const;
+
+	// Rebuilds the lists if bodies were added or any body drifted by more than half the skin.
+	void refresh();
+
+	// Lists the current bodies that aren't roaming, and queries the builder for each one's neighbours.
+	void rebuild();
+
+	// Checks the listed pairs in entries [first, last) for collision.
+	// Returns number of collision checks performed.
+	int check_listed(int first, int last, std::vector<Collision>& collisions) const;
+
+	// Checks the roaming body against every body the builder finds overlapping it.
+	// Returns number of collision checks performed.
+	int check_roaming(Body& body, std::vector<Collision>& collisions) const;
+
+	// Checks every listed pair of bodies and every roaming body for collision.
+	std::vector<Collision> get_collisions_impl() override;
+
+public:
+
+	// Constructs neighbour lists that are built by the given partitioning, listing bodies within skin of touching.
+	NeighbourList(std::unique_ptr<SpatialPartitioning>&& builder, float skin);
+
+	void add_body(Body& body) override;
+	void add_bodies(std::span<Body* const> bodies) override;
+	void rem_body(const Body& body) override;
+	void rem_bodies(std::span<const Body* const> bodies) override;
+
+	// Informs the builder. The lists account for the growth when they check for drift.
+	void notify_radius_changed(Body& body, float old_radius) override;
+	void notify_radii_changed(std::span<Body* const> bodies, std::span<const float> old_radii) override;
+
+	// Updates the builder, then rebuilds the lists if they may be missing a pair that could be colliding.
+	void update() override;
+
+	// Uses the builder's partition bounds, if it has any.
+	bool uses_partition_bounds() const override;
+	void update_moved(std::span<Body* const> moved) override;
+
+	// Queries are answered by the builder.
+	Body* find_body(Vector2 point) const override;
+	std::vector<Body*> query_rect(Rectangle area) const override;
+	std::vector<Body*> query_radius(Vector2 center, float radius) const override;
+	std::vector<Body*> k_nearest(Vector2 point, int k) const override;
+
+	// Returns the builder's representation.
+	std::vector<Rectangle> get_representation() const override;
+
+	// Attaches the body's number of listed neighbours, the rebuild frequency and the list memory, followed by the builder's info.
+	void get_info(const Body& body, DebugInfo& info) const override;
+
+	const BarnesHut* get_gravity_tree() const override;
+
+	// Returns the partitioning that builds the lists.
+	const SpatialPartitioning& get_builder() const;
+
+	// Returns the skin distance.
+	float get_skin() const;
+
+	// Returns the number of times the lists were built.
+	int get_num_rebuilds() const;
+
+	// Returns the average number of updates between rebuilds.
+	float get_updates_per_rebuild() const;
+
+	// Returns true if the lists were rebuilt on the latest update.
+	bool was_rebuilt_tick() const;
+
+	// Returns the number of listed pairs.
+	int get_num_pairs() const;
+
+	// Returns the number of bodies that are queried for each tick instead of listed.
+	int get_num_roaming() const;
+
+	// Returns the number of bytes allocated for the lists.
+	size_t get_memory_bytes() const;
+
+};
@@ -1,6 +1,34 @@
 #include "NullPartitioning.h"
 #include "Body.h"
 #include "Collision.h"
+#include "CircleBatch.h"
+#include <algorithm>
+#include <iterator>
+
+std::vector<int> NullPartitioning::make_blocks() const
+{
+	long long num_bodies = bodies.size();
+	long long total_pairs = num_bodies * (num_bodies - 1) / 2;
+	long long num_blocks = std::clamp(total_pairs / MIN_PAIRS_PER_BLOCK, 1ll, static_cast<long long>(MAX_BLOCKS));
+	long long pairs_per_block = (total_pairs + num_blocks - 1) / num_blocks;
+
+	std::vector<int> starts { 0 };
+
+	long long block_pairs = 0;
+	for (int i = 0; i < num_bodies; i++)
+	{
+		block_pairs += num_bodies - 1 - i;
+
+		if (block_pairs >= pairs_per_block and i + 1 < num_bodies)
+		{
+			starts.push_back(i + 1);
+			block_pairs = 0;
+		}
+	}
+
+	starts.push_back(num_bodies);
+	return starts;
+}
 
 std::vector<Collision> NullPartitioning::get_collisions_impl()
 {
@@ -9,42 +37,45 @@ std::vector<Collision> NullPartitioning::get_collisions_impl()
 
 	collisions.reserve(bodies.size()); // could reserve on start, and on create_body resize it (after done handling).
 
-	for (auto it1 = bodies.begin(); it1 != bodies.end() - 1; it1++)
-	{
-		Body& body1 = **it1;
-		for (auto it2 = it1 + 1; it2 != bodies.end(); it2++)
-		{
-			Body& body2 = **it2;
+	std::vector<int> starts = make_blocks();
 
-			num_collision_checks_tick++;
+	// Every body is a candidate of every body before it, so they're all gathered once.
+	CircleBatch candidates { bodies };
 
-			if (body1.collided_with(body2))
-			{
-				collisions.emplace_back(Body::get_sorted_pair(body1, body2));
-			}
+	// Each block checks its bodies against every later body.
+	num_collision_checks_tick = gather_parallel(starts.size() - 1, [this, &starts, &candidates](int block, std::vector<Collision>& block_collisions)
+	{
+		int checks = 0;
 
+		for (int i = starts[block]; i < starts[block + 1]; i++)
+		{
+			checks += candidates.collide(*bodies[i], i + 1, block_collisions);
 		}
-	}
+
+		return checks;
+	}, collisions);
 
 	return collisions;
 }
 
 void NullPartitioning::add_body(Body& body)
 {
+	body_indices[&body] = bodies.size();
 	bodies.push_back(&body);
 }
 
 void NullPartitioning::rem_body(const Body& body)
 {
-	auto it = std::find(bodies.begin(), bodies.end(), &body);
-	std::swap(*it, bodies.back());
-	bodies.pop_back();
-}
+	auto it = body_indices.find(&body);
+	int index = it->second;
+	body_indices.erase(it);
 
-void NullPartitioning::notify_move(const Body* from, Body* to)
-{
-	auto it1 = std::find(bodies.begin(), bodies.end(), from);
-	*it1 = to;
+	if (index != bodies.size() - 1)
+	{
+		bodies[index] = bodies.back();
+		body_indices[bodies[index]] = index;
+	}
+	bodies.pop_back();
 }
 
 void NullPartitioning::update()
@@ -67,6 +98,17 @@ Body* NullPartitioning::find_body(Vector2 point) const
 	}
 }
 
+std::vector<Body*> NullPartitioning::query_rect(Rectangle area) const
+{
+	std::vector<Body*> found;
+	std::ranges::copy_if(bodies, std::back_inserter(found), [area](const Body* body)
+	{
+		return body->intersects_rect(area);
+	});
+
+	return found;
+}
+
 std::vector<Rectangle> NullPartitioning::get_representation() const
 {
 	return {};
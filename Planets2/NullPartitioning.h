@@ -1,6 +1,7 @@
 #pragma once
 #include "SpatialPartitioning.h"
 #include <vector>
+#include <unordered_map>
 
 class Body;
 
@@ -9,14 +10,27 @@ class NullPartitioning : public SpatialPartitioning
 
 	std::vector<Body*> bodies;
 
+	// Index of each body in bodies, so removal doesn't search for it.
+	std::unordered_map<const Body*, int> body_indices;
+
+	// Maximum number of blocks that pair checks are split into.
+	static constexpr int MAX_BLOCKS = 64;
+
+	// Minimum number of pairs in a block, so small universes aren't split into blocks of little work.
+	static constexpr long long MIN_PAIRS_PER_BLOCK = 4096;
+
+	// Returns the first body index of each block of pairs, followed by the number of bodies.
+	// Body i is checked with every body after it, so blocks are sized by their number of pairs rather than bodies.
+	std::vector<int> make_blocks() const;
+
 	// Inherited via SpatialPartitioning
 	std::vector<Collision> get_collisions_impl() override;
 
 	void add_body(Body& body) override;
 	void rem_body(const Body& body) override;
-	void notify_move(const Body* from, Body* to) override;
 	void update() override;
 	Body* find_body(Vector2 point) const override;
+	std::vector<Body*> query_rect(Rectangle area) const override;
 	std::vector<Rectangle> get_representation() const override;
 	void get_info(const Body& body, DebugInfo& info) const override;
 };
@@ -1,10 +1,9 @@
 #include "Orbit.h"
 
-#include "raylib.h"
+#include "SimTypes.h"
 #include "Body.h"
 #include <numbers>
 #include <cmath>
-#include <raymath.h>
 
 Orbit::Orbit(const Body& orbited) 
     : orbited(&orbited)
@@ -0,0 +1,215 @@
+#include "PartitioningTuner.h"
+#include "SpatialPartitioning.h"
+#include "QuadTree.h"
+#include "Grid.h"
+#include "LineSweep.h"
+
+#include "Collision.h"
+#include "Body.h"
+#include "BodyList.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+std::string PartitioningTuner::Config::name() const
+{
+    switch (method) {
+    case Method::QuadTree:
+        return "Quad tree (" + std::to_string(param) + ")";
+    case Method::Grid:
+        return "Grid (" + std::to_string(param) + ")";
+    default:
+        return "Line sweep";
+    }
+}
+
+PartitioningTuner::PartitioningTuner(float universe_size) : universe_size(universe_size)
+{}
+
+std::unique_ptr<SpatialPartitioning> PartitioningTuner::make(const Config& config, float universe_size)
+{
+    switch (config.method) {
+    case Config::Method::QuadTree:
+        return std::make_unique<QuadTree>(universe_size, config.param, QUAD_MAX_DEPTH);
+    case Config::Method::Grid:
+        return std::make_unique<Grid>(universe_size, config.param);
+    default:
+        return std::make_unique<LineSweep>();
+    }
+}
+
+std::vector<PartitioningTuner::Config> PartitioningTuner::candidates() const
+{
+    std::vector<Config> configs;
+
+    auto add = [&configs](Config config) {
+        if (std::find(configs.begin(), configs.end(), config) == configs.end()) {
+            configs.push_back(config);
+        }
+    };
+
+    for (int param : { quad_max_bodies / 2, quad_max_bodies, quad_max_bodies * 2 }) {
+        add({ Config::Method::QuadTree, std::clamp(param, MIN_QUAD_BODIES, MAX_QUAD_BODIES) });
+    }
+
+    for (int param : { grid_nodes_per_row / 2, grid_nodes_per_row, grid_nodes_per_row * 2 }) {
+        add({ Config::Method::Grid, std::clamp(param, MIN_GRID_NODES, MAX_GRID_NODES) });
+    }
+
+    add({ Config::Method::LineSweep });
+
+    // The active config is always measured, so the others are compared against it under the same conditions.
+    if (active) {
+        add(*active);
+    }
+
+    return configs;
+}
+
+PartitioningTuner::Measurement PartitioningTuner::measure(const Config& config, BodyList& bodies) const
+{
+    using Clock = std::chrono::steady_clock;
+    auto elapsed_ms = [](Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    std::unique_ptr<SpatialPartitioning> partitioning = make(config, universe_size);
+
+    std::vector<Body*> adding;
+    adding.reserve(bodies.size());
+    for (Body& body : bodies) {
+        adding.push_back(&body);
+    }
+    partitioning->add_bodies(adding);
+
+    Measurement best { config, 0.0, 0.0, 0 };
+    for (int run = 0; run < TRIAL_RUNS; run++) {
+        auto start = Clock::now();
+        partitioning->update();
+        auto updated = Clock::now();
+        std::vector<Collision> collisions = partitioning->get_collisions();
+        auto detected = Clock::now();
+
+        Measurement measurement { config, elapsed_ms(start, updated), elapsed_ms(updated, detected), partitioning->get_collision_checks_this_tick() };
+        if (run == 0 or measurement.total_ms() < best.total_ms()) {
+            best = measurement;
+        }
+    }
+
+    return best;
+}
+
+bool PartitioningTuner::is_due(int tick) const
+{
+    return tick >= next_trial_tick;
+}
+
+std::unique_ptr<SpatialPartitioning> PartitioningTuner::run_trial(int tick, BodyList& bodies)
+{
+    next_trial_tick = tick + TRIAL_INTERVAL_TICKS;
+
+    // Candidates that use partition bounds set them on every body they are built with.
+    // The universe's partitioning may rely on the bounds it set, so they are put back afterwards.
+    std::vector<Rectangle> partition_bounds;
+    partition_bounds.reserve(bodies.size());
+    for (const Body& body : bodies) {
+        partition_bounds.push_back(body.get_partition_bounds());
+    }
+
+    last_trial.clear();
+    for (const Config& config : candidates()) {
+        last_trial.push_back(measure(config, bodies));
+    }
+
+    for (int i = 0; i < bodies.size(); i++) {
+        bodies[i].set_partition_bounds(partition_bounds[i]);
+    }
+
+    std::stable_sort(last_trial.begin(), last_trial.end(), [](const Measurement& a, const Measurement& b) {
+        return a.total_ms() < b.total_ms();
+    });
+
+    // Each method keeps the parameter it was fastest with.
+    for (const Measurement& measurement : last_trial) {
+        if (measurement.config.method == Config::Method::QuadTree) {
+            quad_max_bodies = measurement.config.param;
+            break;
+        }
+    }
+    for (const Measurement& measurement : last_trial) {
+        if (measurement.config.method == Config::Method::Grid) {
+            grid_nodes_per_row = measurement.config.param;
+            break;
+        }
+    }
+
+    std::string summary = "trial with " + std::to_string(bodies.size()) + " bodies:";
+    for (const Measurement& measurement : last_trial) {
+        char times[64];
+        std::snprintf(times, sizeof(times), " %.3f + %.3f ms, ", measurement.update_ms, measurement.collisions_ms);
+        summary += "\n  " + measurement.config.name() + ":" + times + std::to_string(measurement.checks) + " checks";
+    }
+    add_log(tick, summary);
+
+    const Measurement& fastest = last_trial.front();
+
+    if (!active) {
+        // Nothing to compare against yet, so take the fastest right away.
+        active = fastest.config;
+        add_log(tick, "chose " + active->name());
+        return make(*active, universe_size);
+    }
+
+    auto active_it = std::find_if(last_trial.begin(), last_trial.end(), [this](const Measurement& measurement) {
+        return measurement.config == *active;
+    });
+
+    if (fastest.config == *active or fastest.total_ms() > SWITCH_RATIO * active_it->total_ms()) {
+        challenger.reset();
+        challenger_wins = 0;
+        return nullptr;
+    }
+
+    if (challenger and *challenger == fastest.config) {
+        challenger_wins++;
+    }
+    else {
+        challenger = fastest.config;
+        challenger_wins = 1;
+    }
+
+    if (challenger_wins < CONSISTENT_TRIALS) {
+        add_log(tick, fastest.config.name() + " is faster than " + active->name() + " (" + std::to_string(challenger_wins) + "/" + std::to_string(CONSISTENT_TRIALS) + " trials)");
+        return nullptr;
+    }
+
+    char times[64];
+    std::snprintf(times, sizeof(times), " (%.3f ms -> %.3f ms)", active_it->total_ms(), fastest.total_ms());
+    add_log(tick, "swapped " + active->name() + " for " + fastest.config.name() + times);
+
+    active = fastest.config;
+    challenger.reset();
+    challenger_wins = 0;
+
+    return make(*active, universe_size);
+}
+
+void PartitioningTuner::add_log(int tick, const std::string& entry)
+{
+    log.push_back("Tick " + std::to_string(tick) + ": " + entry);
+}
+
+std::string PartitioningTuner::get_active_name() const
+{
+    return active ? active->name() : "";
+}
+
+const std::vector<PartitioningTuner::Measurement>& PartitioningTuner::get_last_trial() const
+{
+    return last_trial;
+}
+
+const std::vector<std::string>& PartitioningTuner::get_log() const
+{
+    return log;
+}
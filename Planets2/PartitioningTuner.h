@@ -0,0 +1,126 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class SpatialPartitioning;
+class BodyList;
+
+// Picks the spatial partitioning for a universe while it runs.
+// Every so often, it builds each candidate configuration on the live bodies and times its update and collision detection.
+// Each method's parameter (quad capacity, grid resolution) is tuned towards whichever value measured fastest,
+// and the universe's partitioning is swapped out when another configuration is consistently faster.
+// Every trial and swap is logged.
+class PartitioningTuner
+{
+public:
+
+	// A partitioning method and its tuned parameter.
+	struct Config {
+		enum class Method {
+			QuadTree,
+			Grid,
+			LineSweep
+		};
+
+		Method method;
+
+		// Max bodies per quad for a quad tree, nodes per row for a grid. Unused for line sweep.
+		int param = 0;
+
+		// Returns a name for the config, such as "Grid (64)".
+		std::string name() const;
+
+		bool operator==(const Config& other) const = default;
+	};
+
+	// Time and number of collision checks that a config took on the live bodies.
+	struct Measurement {
+		Config config;
+		double update_ms;
+		double collisions_ms;
+		int checks;
+
+		double total_ms() const { return update_ms + collisions_ms; }
+	};
+
+private:
+
+	// Ticks between trials.
+	static constexpr int TRIAL_INTERVAL_TICKS = 600;
+
+	// Times each config is run in a trial. The fastest run is kept, to filter out noise.
+	static constexpr int TRIAL_RUNS = 3;
+
+	// Another config must take at most this fraction of the active config's time to be considered faster.
+	static constexpr double SWITCH_RATIO = 0.8;
+
+	// Number of trials in a row another config must be the faster one in before swapping to it.
+	static constexpr int CONSISTENT_TRIALS = 2;
+
+	// Max depth of candidate quad trees.
+	static constexpr int QUAD_MAX_DEPTH = 12;
+
+	// Range of tuned parameters.
+	static constexpr int MIN_QUAD_BODIES = 2;
+	static constexpr int MAX_QUAD_BODIES = 256;
+	static constexpr int MIN_GRID_NODES = 8;
+	static constexpr int MAX_GRID_NODES = 512;
+
+	// Size of the universe, which quad trees and grids cover.
+	float universe_size;
+
+	// Best parameters found so far for each method.
+	int quad_max_bodies = 8;
+	int grid_nodes_per_row = 64;
+
+	// Config of the universe's partitioning. Empty until the tuner has chosen one.
+	std::optional<Config> active;
+
+	// Config that has been faster than the active one, and in how many trials in a row.
+	std::optional<Config> challenger;
+	int challenger_wins = 0;
+
+	// Tick at which the next trial is run.
+	int next_trial_tick = 0;
+
+	// Measurements of the most recent trial, fastest first.
+	std::vector<Measurement> last_trial;
+
+	// Description of every trial and swap.
+	std::vector<std::string> log;
+
+	// Returns the configs to measure: each method at its best parameter and at half and double it, and the active config.
+	std::vector<Config> candidates() const;
+
+	// Builds the config's partitioning on the bodies, then times its update and collision detection.
+	Measurement measure(const Config& config, BodyList& bodies) const;
+
+	// Adds an entry to the log, prefixed with the tick.
+	void add_log(int tick, const std::string& entry);
+
+public:
+
+	explicit PartitioningTuner(float universe_size);
+
+	// Returns true if a trial should be run at the tick.
+	bool is_due(int tick) const;
+
+	// Measures every candidate config on the bodies, which must all be in the universe's partitioning.
+	// Returns a new partitioning (without any bodies) to swap to, or nullptr to keep the current one.
+	std::unique_ptr<SpatialPartitioning> run_trial(int tick, BodyList& bodies);
+
+	// Returns the name of the active config, or an empty string if the tuner hasn't chosen one yet.
+	std::string get_active_name() const;
+
+	// Returns the measurements of the most recent trial, fastest first.
+	const std::vector<Measurement>& get_last_trial() const;
+
+	// Returns every logged trial and swap, oldest first.
+	const std::vector<std::string>& get_log() const;
+
+	// Creates a partitioning for the config, covering a universe of the given size.
+	static std::unique_ptr<SpatialPartitioning> make(const Config& config, float universe_size);
+
+};
@@ -1,6 +1,6 @@
 #include "Physics.h"
 #include "Circle.h"
-#include <raymath.h>
+#include "SimTypes.h"
 #include <cmath>
 #include <algorithm>
 
@@ -26,7 +26,46 @@ bool Physics::circles_intersect(Circle c1, Circle c2)
 {
 	float dist_squared = Physics::dist_squared(c1.center, c2.center);
 	float combined_radius = c1.radius + c2.radius;
-	return dist_squared < std::pow(combined_radius, 2);
+
+	// Same float operations as CircleBatch, so batched and single tests agree exactly.
+	return dist_squared < combined_radius * combined_radius;
+}
+
+std::optional<float> Physics::time_of_impact(Circle c1, Vector2 motion1, Circle c2, Vector2 motion2)
+{
+	Vector2 offset = Physics::distv(c1.center, c2.center);
+	Vector2 relative_motion = Vector2Subtract(motion2, motion1);
+	float combined_radius = c1.radius + c2.radius;
+
+	// Solves |offset + relative_motion * t| = combined_radius for the earliest t.
+	float c = Vector2DotProduct(offset, offset) - combined_radius * combined_radius;
+	if (c < 0)
+	{
+		return 0.0f;
+	}
+
+	float a = Vector2DotProduct(relative_motion, relative_motion);
+	float b = 2 * Vector2DotProduct(offset, relative_motion);
+
+	// Circles that aren't approaching each other can't start overlapping.
+	if (a == 0 or b >= 0)
+	{
+		return std::nullopt;
+	}
+
+	float discriminant = b * b - 4 * a * c;
+	if (discriminant < 0)
+	{
+		return std::nullopt;
+	}
+
+	float t = (-b - std::sqrt(discriminant)) / (2 * a);
+	if (t > 1)
+	{
+		return std::nullopt;
+	}
+
+	return t;
 }
 
 bool Physics::circle_inside_rect(Circle circle, Rectangle rect)
@@ -38,15 +77,22 @@ bool Physics::circle_inside_rect(Circle circle, Rectangle rect)
 bool Physics::circle_intersects_rect(Circle circle, Rectangle rect)
 {
 	float radius = circle.radius;
+	return Physics::dist_squared_to_rect(circle.center, rect) < (radius * radius);
+}
 
-	float right = rect.x + rect.width;
-	float bottom = rect.y + rect.height;
-
-	float closest_x = std::clamp(circle.center.x, rect.x, right);
-	float closest_y = std::clamp(circle.center.y, rect.y, bottom);
+bool Physics::rects_intersect(Rectangle rect1, Rectangle rect2)
+{
+	return rect1.x < rect2.x + rect2.width and rect2.x < rect1.x + rect1.width and
+		rect1.y < rect2.y + rect2.height and rect2.y < rect1.y + rect1.height;
+}
 
-	float dist_squared = Physics::dist_squared(circle.center, { closest_x, closest_y });
-	return dist_squared < (radius * radius);
+Rectangle Physics::rects_union(Rectangle rect1, Rectangle rect2)
+{
+	float left = std::min(rect1.x, rect2.x);
+	float top = std::min(rect1.y, rect2.y);
+	float right = std::max(rect1.x + rect1.width, rect2.x + rect2.width);
+	float bottom = std::max(rect1.y + rect1.height, rect2.y + rect2.height);
+	return { left, top, right - left, bottom - top };
 }
 
 float Physics::dist(Vector2 point1, Vector2 point2)
@@ -61,6 +107,14 @@ float Physics::dist_squared(Vector2 point1, Vector2 point2)
 	return c_squared;
 }
 
+float Physics::dist_squared_to_rect(Vector2 point, Rectangle rect)
+{
+	float closest_x = std::clamp(point.x, rect.x, rect.x + rect.width);
+	float closest_y = std::clamp(point.y, rect.y, rect.y + rect.height);
+
+	return Physics::dist_squared(point, { closest_x, closest_y });
+}
+
 Vector2 Physics::distv(Vector2 point1, Vector2 point2)
 {
 	return Vector2Subtract(point2, point1);
@@ -1,5 +1,6 @@
 #pragma once
-#include <raylib.h>
+#include "SimTypes.h"
+#include <optional>
 
 struct Rectangle;
 struct Circle;
@@ -17,12 +18,22 @@ namespace Physics {
 	// Returns true if a circle intersects another circle.
 	bool circles_intersect(Circle c1, Circle c2);
 
+	// Returns the earliest time in [0, 1] at which two circles overlap, as each moves in a straight line by its motion over that time.
+	// 0 if they already overlap at the start. Empty if they don't overlap within that time.
+	std::optional<float> time_of_impact(Circle c1, Vector2 motion1, Circle c2, Vector2 motion2);
+
 	// Returns true if a circle is completely inside a rectangle.
 	bool circle_inside_rect(Circle circle, Rectangle rect);
 
 	// Returns true if a circle intersects a rectangle.
 	bool circle_intersects_rect(Circle circle, Rectangle rect);
 
+	// Returns true if two rectangles overlap.
+	bool rects_intersect(Rectangle rect1, Rectangle rect2);
+
+	// Returns the smallest rectangle that contains both rectangles.
+	Rectangle rects_union(Rectangle rect1, Rectangle rect2);
+
 	// Returns the scalar distance between two points.
 	float dist(Vector2 point1, Vector2 point2);
 
@@ -30,6 +41,9 @@ namespace Physics {
 	// Can be used to avoid sqrt call in places where you don't need the actual distance.
 	float dist_squared(Vector2 point1, Vector2 point2);
 
+	// Returns the (scalar distance)^2 between a point and the nearest point of a rectangle. 0 if the point is inside it.
+	float dist_squared_to_rect(Vector2 point, Rectangle rect);
+
 	// Returns the distance vector between two points in terms of (x,y) directions.
 	Vector2 distv(Vector2 point1, Vector2 point2);
 
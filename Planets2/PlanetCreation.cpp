@@ -1,6 +1,6 @@
 #include "PlanetCreation.h"
 
-#include "Universe.h"
+#include "SimulationThread.h"
 #include "CameraState.h"
 #include "Physics.h"
 
@@ -20,8 +20,9 @@ PlanetCreation::PlanetCreation(Vector2 mouse_pos) // universe point of mouse par
 	: creating(create_default_body(mouse_pos))
 {}
 
-InteractionState* PlanetCreation::process_input(const CameraState& camera_state, Universe& universe)
+InteractionState* PlanetCreation::process_input(const CameraState& camera_state, SimulationThread& simulation)
 {
+	const UniverseSnapshot& universe = simulation.get_snapshot();
 	Vector2 screen_point = GetMousePosition();
 	Vector2 universe_point = GetScreenToWorld2D(screen_point, camera_state.get_raylib_camera());
 
@@ -36,19 +37,19 @@ InteractionState* PlanetCreation::process_input(const CameraState& camera_state,
 
 		if (mouse_overlapped)
 		{
-			return new SatelliteCreation{ *mouse_overlapped, creating, universe };
+			return new SatelliteCreation{ *mouse_overlapped, creating, simulation };
 		}
 	}
 	else if (IsKeyPressed(KEY_ENTER)) {
 		// Add user body to universe, and end creation mode. 
-		universe.add_body(std::move(creating));
+		simulation.add_body(std::move(creating));
 		return new DefaultInteraction;
 	}
 	else if (IsKeyPressed(KEY_ONE)) {
 		return new DefaultInteraction;
 	}
 	else if (IsKeyPressed(KEY_THREE)) {
-		return new SystemCreation{ universe_point, universe };
+		return new SystemCreation{ universe_point, simulation };
 	}
 
 	return this;
@@ -71,7 +72,7 @@ std::string_view PlanetCreation::get_help_text() const
 		"[3] to go to system generator\n";
 
 }
-void PlanetCreation::render_world(const AdvCamera& camera, const Universe& universe)
+void PlanetCreation::render_world(const AdvCamera& camera, const UniverseSnapshot& universe)
 {
 	if (camera.in_view(creating))
 	{
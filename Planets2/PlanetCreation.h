@@ -21,7 +21,7 @@ public:
 	PlanetCreation(Vector2 mouse_pos);
 
 	// Processes all relevant state input for creating a body and returns the next interaction state.
-	InteractionState* process_input(const CameraState& camera_state, Universe& universe) override;
+	InteractionState* process_input(const CameraState& camera_state, SimulationThread& simulation) override;
 
 	std::string_view get_name() const override;
 
@@ -29,6 +29,6 @@ public:
 	std::string_view get_help_text() const override;
 
 	// Renders the current body.
-	void render_world(const AdvCamera& camera, const Universe& universe) override;
+	void render_world(const AdvCamera& camera, const UniverseSnapshot& universe) override;
 };
 
@@ -1,10 +1,10 @@
 #include "PlanetMouseModifier.h"
 #include <raylib.h>
 #include "AdvCamera.h"
-#include "universe.h"
+#include "UniverseSnapshot.h"
 #include "Physics.h"
 
-bool PlanetMouseModifier::process_input(Body& modifying, const AdvCamera& camera, const Universe& universe)
+bool PlanetMouseModifier::process_input(Body& modifying, const AdvCamera& camera, const UniverseSnapshot& universe)
 {
 	Vector2 screen_point = GetMousePosition();
 	Vector2 universe_point = GetScreenToWorld2D(screen_point, camera.get_raylib_camera());
@@ -2,7 +2,7 @@
 
 class Body;
 class AdvCamera;
-class Universe;
+class UniverseSnapshot;
 
 // Handles mouse input state for modifying a planet.
 class PlanetMouseModifier
@@ -23,7 +23,7 @@ public:
 	// If mouse drags inner radius, changes body velocity.
 	// If mouse drags outer radius, changes body mass.
 	// Returns true if body was modified.
-	bool process_input(Body& modifying, const AdvCamera& camera, const Universe& universe);
+	bool process_input(Body& modifying, const AdvCamera& camera, const UniverseSnapshot& universe);
 
 };
 
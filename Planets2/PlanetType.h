@@ -1,6 +1,6 @@
 #pragma once
 
-#include <raylib.h>
+#include "SimTypes.h"
 #include <utility>
 
 // Represents a type of planetary body.
@@ -40,11 +40,11 @@ class QuadChildren
 public:
 
 	template <class... ArgTypes>
-	QuadChildren<T>(float x, float y, float parent_size, ArgTypes&&... additional_args)
+	QuadChildren(float x, float y, float parent_size, ArgTypes&&... additional_args)
 		: children(construct_array(x, y, parent_size, std::forward<ArgTypes>(additional_args)...))
 	{}
 
-	QuadChildren<T>() = default;
+	QuadChildren() = default;
 
 	// Returns the upper left child node.
 	T& UL() { return children[0]; }
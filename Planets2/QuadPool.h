@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <deque>
+#include <span>
+#include <vector>
+#include "QuadChildren.h"
+
+class Body;
+
+// A node's slice of the body array in a QuadPool.
+struct BodyRange
+{
+	// Index of the range's first body.
+	int first = 0;
+
+	// Number of bodies in the range.
+	int size = 0;
+
+	// Number of slots reserved for the range. 0 if none have been reserved yet.
+	int capacity = 0;
+};
+
+// Recycled storage for the nodes of a quadtree, and the bodies they hold.
+// Child nodes are allocated 4 at a time, and returned to a free list when concatenated.
+// Each node's bodies lie in one contiguous range of a shared array, instead of in a vector of their own.
+template <typename Node>
+class QuadPool
+{
+	// Capacity of the smallest range. Each size class doubles it.
+	static constexpr int MIN_CAPACITY = 4;
+
+	// Allocated child nodes. A deque does not move its elements when it grows,
+	// so nodes can keep pointers to their children and parents.
+	std::deque<QuadChildren<Node>> children;
+
+	// Children that have been concatenated, and can be handed out again.
+	std::vector<QuadChildren<Node>*> free_children;
+
+	// Bodies of every node, each node's in its own range.
+	std::vector<Body*> bodies;
+
+	// Start indices of unused ranges, by size class.
+	std::vector<std::vector<int>> free_ranges;
+
+	// Returns the size class of a range with the given capacity.
+	static int size_class(int capacity)
+	{
+		return std::countr_zero(static_cast<unsigned>(capacity / MIN_CAPACITY));
+	}
+
+	// Returns the start index of an unused range of the size class.
+	int take_range(int size_class)
+	{
+		if (size_class >= free_ranges.size())
+		{
+			free_ranges.resize(size_class + 1);
+		}
+
+		std::vector<int>& free = free_ranges[size_class];
+		if (!free.empty())
+		{
+			int first = free.back();
+			free.pop_back();
+			return first;
+		}
+
+		int first = bodies.size();
+		bodies.resize(bodies.size() + (MIN_CAPACITY << size_class));
+		return first;
+	}
+
+	// Moves the range into one with double the capacity.
+	void grow(BodyRange& range)
+	{
+		int new_class = range.capacity == 0 ? 0 : size_class(range.capacity) + 1;
+
+		// Taking a new range may reallocate the array, so only index into it afterwards.
+		int new_first = take_range(new_class);
+		std::copy_n(bodies.begin() + range.first, range.size, bodies.begin() + new_first);
+
+		if (range.capacity != 0)
+		{
+			free_ranges[size_class(range.capacity)].push_back(range.first);
+		}
+
+		range.first = new_first;
+		range.capacity = MIN_CAPACITY << new_class;
+	}
+
+public:
+
+	// Returns 4 child nodes constructed with the given arguments, reusing freed ones if there are any.
+	template <class... ArgTypes>
+	QuadChildren<Node>* alloc_children(ArgTypes&&... args)
+	{
+		if (free_children.empty())
+		{
+			return &children.emplace_back(std::forward<ArgTypes>(args)...);
+		}
+
+		QuadChildren<Node>* recycled = free_children.back();
+		free_children.pop_back();
+		*recycled = QuadChildren<Node>(std::forward<ArgTypes>(args)...);
+		return recycled;
+	}
+
+	// Returns child nodes to the pool. Their body ranges should already have been released.
+	void free(QuadChildren<Node>* freed)
+	{
+		free_children.push_back(freed);
+	}
+
+	// Returns the bodies in the range.
+	std::span<Body*> get(BodyRange range)
+	{
+		return { bodies.data() + range.first, static_cast<std::size_t>(range.size) };
+	}
+
+	// Returns the bodies in the range.
+	std::span<Body* const> get(BodyRange range) const
+	{
+		return { bodies.data() + range.first, static_cast<std::size_t>(range.size) };
+	}
+
+	// Returns the body at an index of the range.
+	// Unlike a span, stays valid to call while other ranges grow.
+	Body*& at(BodyRange range, int index)
+	{
+		return bodies[range.first + index];
+	}
+
+	// Returns the index of the body in the range, or -1 if it is not in it.
+	int find(BodyRange range, const Body* body) const
+	{
+		std::span<Body* const> range_bodies = get(range);
+		auto it = std::ranges::find(range_bodies, body);
+		return it == range_bodies.end() ? -1 : it - range_bodies.begin();
+	}
+
+	// Adds a body to the end of the range, moving the range if it is full.
+	void push(BodyRange& range, Body* body)
+	{
+		if (range.size == range.capacity)
+		{
+			grow(range);
+		}
+
+		bodies[range.first + range.size] = body;
+		++range.size;
+	}
+
+	// Removes the body at an index of the range, keeping the order of the rest.
+	void erase(BodyRange& range, int index)
+	{
+		auto range_begin = bodies.begin() + range.first;
+		std::copy(range_begin + index + 1, range_begin + range.size, range_begin + index);
+		--range.size;
+	}
+
+	// Returns the range's slots to the pool, leaving it empty.
+	void release(BodyRange& range)
+	{
+		if (range.capacity != 0)
+		{
+			free_ranges[size_class(range.capacity)].push_back(range.first);
+		}
+
+		range = {};
+	}
+
+	// Returns the number of child node groups ever allocated, including freed ones.
+	int num_children_allocated() const
+	{
+		return children.size();
+	}
+
+	// Returns the number of body slots ever allocated, including unused ones.
+	int num_body_slots() const
+	{
+		return bodies.size();
+	}
+
+};
@@ -5,86 +5,232 @@
 
 #include "Collision.h"
 #include "DebugInfo.h"
+#include "NearestBodies.h"
+#include "CircleBatch.h"
 #include <algorithm>
+#include <utility>
+#include <queue>
 
-QuadNode::QuadNode(float x, float y, float size, QuadNode* parent, int depth, int max_bodies) :
-	dimensions { x, y, size, size }, depth(depth), parent(parent)
+QuadNode::QuadNode(float x, float y, float size, QuadNode* parent, int depth, QuadPool<QuadNode>* pool, float looseness) :
+	dimensions { x, y, size, size }, depth(depth), looseness(looseness), parent(parent), pool(pool)
 {
-	quad_bodies.reserve(max_bodies);
+	if (is_loose())
+	{
+		// Loose bounds are the node's dimensions scaled by looseness around the same center.
+		// Any body whose center is in the node and whose radius is at most the added margin lies within them.
+		max_radius = (looseness - 1.0f) * size / 2.0f;
+		loose_dimensions = { x - max_radius, y - max_radius, size + 2 * max_radius, size + 2 * max_radius };
+	}
+	else
+	{
+		loose_dimensions = dimensions;
+	}
 }
 
-int QuadNode::get_collisions(std::vector<Collision>& collisions)
+std::span<Body*> QuadNode::bodies()
 {
-	int checks = 0;
+	return pool->get(quad_bodies);
+}
+
+std::span<Body* const> QuadNode::bodies() const
+{
+	return std::as_const(*pool).get(quad_bodies);
+}
 
-	Body** end = quad_bodies.data() + quad_bodies.size();
-	for (Body** it = quad_bodies.data(); it < end - 1; ++it)
+void QuadNode::update_bounds()
+{
+	// A node's bounds only matter if it holds bodies, so empty nodes keep whatever they had.
+	std::span<Body* const> own = bodies();
+	for (int i = 0; i < own.size(); ++i)
 	{
-		Body& body = **it;
-		checks += get_collisions_internal(body, it + 1, end, collisions);
+		Rectangle box = own[i]->get_bounding_box();
+		bodies_bounds = i == 0 ? box : Physics::rects_union(bodies_bounds, box);
 	}
 
+	subtree_bounds = bodies_bounds;
+	bool any_bounds = !own.empty();
+
 	if (!is_leaf())
 	{
-		// Need to do a collision check with bodies in child nodes.
-		for (Body* body : quad_bodies)
+		for (QuadNode& node : *children)
 		{
-			checks += get_collisions_child(*body, collisions);
+			node.update_bounds();
+
+			if (!node.is_empty())
+			{
+				subtree_bounds = any_bounds ? Physics::rects_union(subtree_bounds, node.subtree_bounds) : node.subtree_bounds;
+				any_bounds = true;
+			}
 		}
+	}
+}
 
-		// Can come before or after earlier checks.
-		for (QuadNode& node : *children)
+int QuadNode::get_collisions(std::vector<Collision>& collisions) const
+{
+	int checks = 0;
+
+	std::span<Body* const> own = bodies();
+	if (own.size() > 1)
+	{
+		CircleBatch candidates { own };
+		for (int i = 0; i + 1 < own.size(); ++i)
 		{
-			checks += node.get_collisions(collisions);
+			checks += candidates.collide(*own[i], i + 1, collisions);
+		}
+	}
+
+	if (is_leaf())
+	{
+		return checks;
+	}
+
+	if (cur_size >= PARALLEL_MIN_BODIES)
+	{
+		return checks + get_collisions_children_parallel(collisions);
+	}
+
+	// Need to do a collision check between this node's bodies, as a group, and the bodies in child nodes.
+	if (!own.empty())
+	{
+		for (const QuadNode& node : children->data())
+		{
+			checks += node.get_collisions_group(own, bodies_bounds, collisions);
+		}
+	}
+
+	// Can come before or after earlier checks.
+	for (const QuadNode& node : children->data())
+	{
+		checks += node.get_collisions(collisions);
+	}
+
+	if (is_loose())
+	{
+		// Loose child nodes overlap each other, so bodies in different children can collide.
+		std::span<const QuadNode, 4> nodes = children->data();
+		for (auto it1 = nodes.begin(); it1 != nodes.end(); ++it1)
+		{
+			for (auto it2 = it1 + 1; it2 != nodes.end(); ++it2)
+			{
+				checks += it1->get_collisions_between(*it2, collisions);
+			}
 		}
 	}
 
 	return checks;
 }
 
-int QuadNode::get_collisions_child(Body& checking, std::vector<Collision>& collisions)
+int QuadNode::get_collisions_children_parallel(std::vector<Collision>& collisions) const
 {
-	/*
-	*
-	* For each child quad which contains partially the body:
-	*	handle_collision body with all in that node
-	*
-	*/
+	// Either a child's whole subtree (second == nullptr), or a pair of sibling subtrees.
+	struct SubtreeWork
+	{
+		const QuadNode* first;
+		const QuadNode* second;
+	};
 
-	int checks = 0;
+	std::span<const QuadNode, 4> nodes = children->data();
 
-	// Check for collisions between the given body and the bodies of relevant child nodes.
-	for (QuadNode& quad : *children)
+	std::vector<SubtreeWork> work;
+	work.reserve(10);
+
+	for (const QuadNode& node : nodes)
 	{
-		if (quad.contains_partially(checking))
-		{
-			// get_collisions_internal can be static, and renamed.
-			checks += quad.get_collisions_internal(checking, quad.quad_bodies.data(), quad.quad_bodies.data() + quad.quad_bodies.size(), collisions);
+		work.push_back({ &node, nullptr });
+	}
 
-			if (!quad.is_leaf())
+	if (is_loose())
+	{
+		for (auto it1 = nodes.begin(); it1 != nodes.end(); ++it1)
+		{
+			for (auto it2 = it1 + 1; it2 != nodes.end(); ++it2)
 			{
-				checks += quad.get_collisions_child(checking, collisions);
+				work.push_back({ &*it1, &*it2 });
 			}
 		}
 	}
 
-	return checks;
+	std::span<Body* const> own = bodies();
+	return SpatialPartitioning::gather_parallel(work.size(), [this, own, &work](int unit, std::vector<Collision>& unit_collisions)
+	{
+		const SubtreeWork& subtrees = work[unit];
+		if (subtrees.second)
+		{
+			return subtrees.first->get_collisions_between(*subtrees.second, unit_collisions);
+		}
+
+		int checks = 0;
+		if (!own.empty())
+		{
+			checks += subtrees.first->get_collisions_group(own, bodies_bounds, unit_collisions);
+		}
+
+		return checks + subtrees.first->get_collisions(unit_collisions);
+	}, collisions);
+}
+
+int QuadNode::get_collisions_between(const QuadNode& other, std::vector<Collision>& collisions) const
+{
+	// Nothing in either subtree can collide if their bounds do not overlap.
+	if (is_empty() or other.is_empty() or !Physics::rects_intersect(subtree_bounds, other.subtree_bounds))
+	{
+		return 0;
+	}
+
+	int checks = 0;
+
+	// Check this node's bodies, as a group, against the other node's subtree.
+	std::span<Body* const> own = bodies();
+	if (!own.empty())
+	{
+		checks += other.get_collisions_group(own, bodies_bounds, collisions);
+	}
 
+	// Then check this node's child nodes against the other node's subtree.
+	if (!is_leaf())
+	{
+		for (const QuadNode& node : children->data())
+		{
+			checks += node.get_collisions_between(other, collisions);
+		}
+	}
+
+	return checks;
 }
 
-int QuadNode::get_collisions_internal(Body& checking, Body** start, Body** end, std::vector<Collision>& collisions)
+int QuadNode::get_collisions_group(std::span<Body* const> group, Rectangle group_bounds, std::vector<Collision>& collisions) const
 {
-	for (Body** it = start; it < end; ++it)
+	// Skip the whole subtree if the group can't reach any of its bodies.
+	if (is_empty() or !Physics::rects_intersect(group_bounds, subtree_bounds))
 	{
-		Body& body = **it;
+		return 0;
+	}
+
+	int checks = 0;
 
-		if (checking.collided_with(body))
+	std::span<Body* const> own = bodies();
+	if (!own.empty() and Physics::rects_intersect(group_bounds, bodies_bounds))
+	{
+		CircleBatch candidates { own };
+		for (Body* body : group)
+		{
+			// Only bodies of the group that reach this node's bodies need to be checked against them.
+			if (Physics::rects_intersect(body->get_bounding_box(), bodies_bounds))
+			{
+				checks += candidates.collide(*body, 0, collisions);
+			}
+		}
+	}
+
+	if (!is_leaf())
+	{
+		for (const QuadNode& node : children->data())
 		{
-			collisions.emplace_back(Body::get_sorted_pair(checking, body));
+			checks += node.get_collisions_group(group, group_bounds, collisions);
 		}
 	}
 
-	return end - start;
+	return checks;
 }
 
 void QuadNode::add_body(Body& new_body, int max_bodies, int max_depth)
@@ -93,12 +239,12 @@ void QuadNode::add_body(Body& new_body, int max_bodies, int max_depth)
 
 	if (is_leaf())
 	{
-		quad_bodies.push_back(&new_body);
+		pool->push(quad_bodies, &new_body);
 		leaf_split_check(max_bodies, max_depth);
 	}
 	else
 	{
-		QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(new_body);
+		QuadNode* contained_in = children->get_quad<&QuadNode::fits>(new_body);
 
 		if (contained_in)
 		{
@@ -106,7 +252,7 @@ void QuadNode::add_body(Body& new_body, int max_bodies, int max_depth)
 		}
 		else
 		{
-			quad_bodies.push_back(&new_body);
+			pool->push(quad_bodies, &new_body);
 		}
 	}
 }
@@ -115,7 +261,7 @@ void QuadNode::rem_body(const Body& body, int max_bodies)
 {
 	--cur_size;
 
-	QuadNode* contained_in = is_leaf() ? nullptr : children->get_quad<&QuadNode::contains_fully>(body);
+	QuadNode* contained_in = is_leaf() ? nullptr : children->get_quad<&QuadNode::fits>(body);
 	// If a child node fully contains the body we are looking for, then recurse into it.
 	if (contained_in)
 	{
@@ -123,33 +269,49 @@ void QuadNode::rem_body(const Body& body, int max_bodies)
 	}
 	else
 	{
-		auto it = std::ranges::find(quad_bodies, &body);
-		quad_bodies.erase(it);
+		pool->erase(quad_bodies, pool->find(quad_bodies, &body));
 		concat_check(max_bodies);
 	}
 }
 
-void QuadNode::notify_move(const Body* from, Body* to)
+void QuadNode::notify_radius_changed(const Body& body)
+{
+	int index;
+	QuadNode* holder = find_holder(body, index);
+
+	// Bodies only grow by absorbing others, so a body never needs to move down to a child.
+	if (holder and !holder->fits(body) and !holder->is_root())
+	{
+		holder->move_up(index);
+	}
+}
+
+QuadNode* QuadNode::find_holder(const Body& body, int& index)
 {
+	index = pool->find(quad_bodies, &body);
+	if (index != -1)
+	{
+		return this;
+	}
+
 	if (is_leaf())
 	{
-		auto it = std::ranges::find(quad_bodies, from);
-		*it = to;
+		return nullptr;
 	}
-	else
+
+	// A body is always held by a node containing its center, whatever its radius.
+	for (QuadNode& child : *children)
 	{
-		QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(*from);
-		if (contained_in)
-		{
-			contained_in->notify_move(from, to);
-		}
-		else
+		if (child.contains_point(body.pos()))
 		{
-			auto it = std::ranges::find(quad_bodies, from);
-			*it = to;
+			if (QuadNode* holder = child.find_holder(body, index))
+			{
+				return holder;
+			}
 		}
 	}
 
+	return nullptr;
 }
 
 bool QuadNode::is_leaf() const
@@ -185,14 +347,32 @@ bool QuadNode::should_concatenate(int max_bodies) const
 Body* QuadNode::find_body(Vector2 point) const
 {
 	// Because bodies can be in branch nodes too, can't just go to the leaf node and search.
-	auto found = std::ranges::find_if(quad_bodies, [point](const Body* body) { return body->contains_point(point); });
+	std::span<Body* const> own = bodies();
+	auto found = std::ranges::find_if(own, [point](const Body* body) { return body->contains_point(point); });
 
-	if (found != quad_bodies.end())
+	if (found != own.end())
 	{
 		return *found;
 	}
 	else if (!is_leaf())
 	{
+		if (is_loose())
+		{
+			// Child nodes overlap, so the body may be in any child whose loose bounds contain the point.
+			for (const QuadNode& node : children->data())
+			{
+				if (Physics::point_in_rect(point, node.loose_dimensions))
+				{
+					if (Body* body = node.find_body(point))
+					{
+						return body;
+					}
+				}
+			}
+
+			return nullptr;
+		}
+
 		// Find the quad that the (x,y) point should be in, then recurse into it.
 		QuadNode* quad = children->get_quad<&QuadNode::contains_point>(point);
 		return quad->find_body(point);
@@ -201,6 +381,75 @@ Body* QuadNode::find_body(Vector2 point) const
 	return nullptr;
 }
 
+void QuadNode::query_rect(Rectangle area, std::vector<Body*>& found) const
+{
+	for (Body* body : bodies())
+	{
+		if (body->intersects_rect(area))
+		{
+			found.push_back(body);
+		}
+	}
+
+	if (is_leaf())
+	{
+		return;
+	}
+
+	// Bodies in a child node lie within its loose bounds.
+	for (const QuadNode& node : children->data())
+	{
+		if (node.cur_size > 0 and Physics::rects_intersect(node.loose_dimensions, area))
+		{
+			node.query_rect(area, found);
+		}
+	}
+}
+
+std::vector<Body*> QuadNode::k_nearest(Vector2 point, int k) const
+{
+	NearestBodies nearest { point, k };
+
+	// Quads to visit, nearest first, by the squared distance to the nearest place a body's center in them could be.
+	// Centers of bodies in a child node are inside its dimensions. The root may also hold bodies outside of its own.
+	using QuadDistance = std::pair<float, const QuadNode*>;
+	auto farther = [](const QuadDistance& a, const QuadDistance& b) { return a.first > b.first; };
+	std::priority_queue<QuadDistance, std::vector<QuadDistance>, decltype(farther)> to_visit(farther);
+	to_visit.emplace(0.0f, this);
+
+	while (!to_visit.empty())
+	{
+		auto [dist_squared, quad] = to_visit.top();
+		to_visit.pop();
+
+		if (nearest.excludes(dist_squared))
+		{
+			// Every quad left is at least as far.
+			break;
+		}
+
+		for (Body* body : quad->bodies())
+		{
+			nearest.offer(*body);
+		}
+
+		if (quad->is_leaf())
+		{
+			continue;
+		}
+
+		for (const QuadNode& node : quad->children->data())
+		{
+			if (node.cur_size > 0)
+			{
+				to_visit.emplace(Physics::dist_squared_to_rect(point, node.dimensions), &node);
+			}
+		}
+	}
+
+	return nearest.take();
+}
+
 void QuadNode::update(int max_bodies, int max_depth)
 {
 	update_internal(max_bodies, max_depth);
@@ -210,28 +459,29 @@ void QuadNode::update(int max_bodies, int max_depth)
 void QuadNode::update_internal(int max_bodies, int max_depth)
 {
 	// After body position update tick, update the quad with new positions.
+	// Bodies are accessed by index, since moving bodies between nodes can move other nodes' ranges in the pool.
 	if (is_leaf())
 	{
-		auto it = quad_bodies.begin();
-		while (it != quad_bodies.end())
+		int i = 0;
+		while (i < quad_bodies.size)
 		{
-			Body& body = **it;
+			Body& body = *pool->at(quad_bodies, i);
 
-			if (contains_fully(body) or is_root())
+			if (fits(body) or is_root())
 			{
 				// still fully contains this body, no changes needed.
-				it++;
+				i++;
 			}
 			else
 			{
 				// body no longer completely inside this leaf node.
-				it = move_up(it);
+				move_up(i);
 			}
 		}
 	}
 	else
 	{
-		int to_check = quad_bodies.size();
+		int to_check = quad_bodies.size;
 
 		for (QuadNode& node : *children)
 		{
@@ -239,39 +489,39 @@ void QuadNode::update_internal(int max_bodies, int max_depth)
 		}
 
 		// only check bodies which child nodes have not just reinserted upwards to this node.
-		auto it = quad_bodies.begin();
+		int i = 0;
 		while (to_check != 0)
 		{
-			Body& body = **it;
+			Body& body = *pool->at(quad_bodies, i);
 
-			if (contains_fully(body))
+			if (fits(body))
 			{
 				// move to child node if body is fully contained by it.
 
 				// Get the child quad that fully contains the body, if any do.
-				QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(body);
+				QuadNode* contained_in = children->get_quad<&QuadNode::fits>(body);
 
 				// If the body is fully contained in a child quad, move it into that quad.
 				if (contained_in)
 				{
 					// all child nodes have already been updated, would be safe to call add_body (possible split) on them.
+					pool->erase(quad_bodies, i);
 					contained_in->add_no_split(body);
-					it = quad_bodies.erase(it);
 				}
 				else
 				{
 					// No child quad fully contains the body, so keep it in this node.
-					it++;
+					i++;
 				}
 			}
 			else if (is_root())
 			{
 				// wraparound or deletion is about to happen.
-				it++;
+				i++;
 			}
 			else
 			{
-				it = move_up(it);
+				move_up(i);
 			}
 			
 			--to_check;
@@ -295,19 +545,33 @@ bool QuadNode::contains_fully(const Body& body) const
 	return body.in_rect(dimensions);
 }
 
-bool QuadNode::contains_partially(const Body& body) const
+bool QuadNode::fits(const Body& body) const
+{
+	if (is_loose())
+	{
+		// The deepest node a body can go down to is limited by its size.
+		// Its center then decides which node at that depth it goes into.
+		return contains_point(body.pos()) and body.get_radius() <= max_radius;
+	}
+	else
+	{
+		return contains_fully(body);
+	}
+}
+
+bool QuadNode::is_loose() const
 {
-	return body.intersects_rect(dimensions);
+	return looseness > 1.0f;
 }
 
-std::vector<Body*>::iterator QuadNode::move_up(std::vector<Body*>::iterator it)
+void QuadNode::move_up(int index)
 {
 	// Body is leaving this quad entirely, so decrease size.
 	cur_size--;
-	parent->reinsert(**it);
-
-	return quad_bodies.erase(it);
 
+	Body& body = *pool->at(quad_bodies, index);
+	pool->erase(quad_bodies, index);
+	parent->reinsert(body);
 }
 
 void QuadNode::leaf_split_check(int max_bodies, int max_depth)
@@ -327,18 +591,19 @@ void QuadNode::concatenate()
 	// since we only split because we reached max capacity.
 	// And we are only concatenating because we are below max capacity.
 
-	// copy all body pointers from a quad, without erasing them in that quad.
-	auto copy_bodies = [](const QuadNode& quad, std::vector<Body*>& copy_to)
-	{
-		copy_to.insert(copy_to.end(), quad.quad_bodies.begin(), quad.quad_bodies.end());
-	};
-
 	for (QuadNode& node : *children)
 	{
-		copy_bodies(node, quad_bodies);
+		// Pushing can move this node's range, but never the child's.
+		for (int i = 0; i < node.quad_bodies.size; i++)
+		{
+			pool->push(quad_bodies, pool->at(node.quad_bodies, i));
+		}
+
+		pool->release(node.quad_bodies);
 	}
 
-	children.reset();
+	pool->free(children);
+	children = nullptr;
 }
 
 void QuadNode::split(int max_bodies, int max_depth)
@@ -349,27 +614,27 @@ void QuadNode::split(int max_bodies, int max_depth)
 	// Depth level of the child nodes.
 	int next_depth = depth + 1;
 
-	children = std::make_unique<QuadChildren<QuadNode>>(x, y, dimensions.width, this, next_depth, max_bodies);
+	children = pool->alloc_children(x, y, dimensions.width, this, next_depth, pool, looseness);
 
 	// add bodies to respective quads
 
-	auto it = quad_bodies.begin();
-	while (it != quad_bodies.end())
+	int i = 0;
+	while (i < quad_bodies.size)
 	{
-		Body& body = **it;
+		Body& body = *pool->at(quad_bodies, i);
 
-		QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(body);
+		QuadNode* contained_in = children->get_quad<&QuadNode::fits>(body);
 		if (contained_in)
 		{
 			// move to child
-			contained_in->quad_bodies.push_back(&body);
+			pool->push(contained_in->quad_bodies, &body);
 			++contained_in->cur_size;
-			it = quad_bodies.erase(it);
+			pool->erase(quad_bodies, i);
 		}
 		else
 		{
 			// stays in parent (here), since it is not unique to any child node.
-			it++;
+			i++;
 		}
 	}
 
@@ -386,15 +651,15 @@ void QuadNode::add_no_split(Body& body)
 
 	if (is_leaf())
 	{
-		quad_bodies.push_back(&body);
+		pool->push(quad_bodies, &body);
 	}
-	else if (QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(body))
+	else if (QuadNode* contained_in = children->get_quad<&QuadNode::fits>(body))
 	{
 		contained_in->add_no_split(body);
 	}
 	else
 	{
-		quad_bodies.push_back(&body);
+		pool->push(quad_bodies, &body);
 	}
 }
 
@@ -407,25 +672,25 @@ void QuadNode::reinsert(Body& body)
 	// We want to keep moving up the chain if the body is not fully contained in this node.
 	// We want to add the body to the current node if it is fully contained in it.
 	//  If the body is fully contained in one of our children, add it to there instead.
-	if (contains_fully(body))
+	if (fits(body))
 	{
 		// add to self. or add to child if fully fits in a child node.
 		// No need to increment cur_size, since the body is already counted (was in child node).
-		QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(body);
+		QuadNode* contained_in = children->get_quad<&QuadNode::fits>(body);
 		if (contained_in)
 		{
 			contained_in->add_no_split(body);
 		}
 		else
 		{
-			quad_bodies.push_back(&body);
+			pool->push(quad_bodies, &body);
 		}
 	}
 	else if (is_root())
 	{
 		// If body is not completely in the root quadtree, it is about to be wrapped around to the other side
 		//	since the quadtree root's size is the same size as the max universe size.
-		quad_bodies.push_back(&body);
+		pool->push(quad_bodies, &body);
 	}
 	else
 	{
@@ -447,7 +712,10 @@ void QuadNode::concat_check(int max_bodies)
 	if (is_leaf())
 	{
 		// leaves cannot concatenate, but check parent.
-		parent->concat_check(max_bodies);
+		if (!is_root())
+		{
+			parent->concat_check(max_bodies);
+		}
 	}
 	else if (should_concatenate(max_bodies))
 	{
@@ -517,7 +785,7 @@ QuadNode& QuadNode::find_quad(const Body& body)
 	// Is a parent node.
 
 	// Get the child quad that fully contains the body, if any do.
-	QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(body);
+	QuadNode* contained_in = children->get_quad<&QuadNode::fits>(body);
 
 	// If a child node fully contains the body we are looking for, then recurse into it.
 	if (contained_in)
@@ -540,7 +808,7 @@ const QuadNode& QuadNode::find_quad(const Body& body) const
 	// Is a parent node.
 
 	// Get the child quad that fully contains the body, if any do.
-	QuadNode* contained_in = children->get_quad<&QuadNode::contains_fully>(body);
+	QuadNode* contained_in = children->get_quad<&QuadNode::fits>(body);
 
 	// If a child node fully contains the body we are looking for, then recurse into it.
 	if (contained_in)
@@ -561,15 +829,24 @@ void QuadNode::get_info(const Body& body, DebugInfo& info) const
 
 }
 
-QuadTree::QuadTree(float size, int max_bodies_per_quad, int max_depth) :
-	root { -size / 2.0f, -size / 2.0f, size, nullptr, 0, max_bodies_per_quad },
+QuadTree::QuadTree(float size, int max_bodies_per_quad, int max_depth, float looseness) :
+	root { -size / 2.0f, -size / 2.0f, size, nullptr, 0, &pool, looseness },
 	max_bodies_per_quad(max_bodies_per_quad),
 	max_depth(max_depth)
 {}
 
+void QuadTree::get_info(const Body& body, DebugInfo& info) const
+{
+	root.get_info(body, info);
+
+	info.add("Pooled node groups: " + std::to_string(pool.num_children_allocated()));
+	info.add("Pooled body slots: " + std::to_string(pool.num_body_slots()));
+}
+
 std::vector<Collision> QuadTree::get_collisions_impl()
 {
 	std::vector<Collision> collisions;
+	root.update_bounds();
 	num_collision_checks_tick = root.get_collisions(collisions);
 	return collisions;
 }
@@ -1,41 +1,75 @@
 #pragma once
-#include <memory>
 #include "SpatialPartitioning.h"
-#include "raylib.h"
+#include "SimTypes.h"
 #include "QuadChildren.h"
+#include "QuadPool.h"
 
 class Body;
 
 class QuadNode
 {
+	// Nodes with at least this many bodies in their subtree check their child nodes in parallel.
+	static constexpr int PARALLEL_MIN_BODIES = 1024;
+
 	// The current quad's depth from the root.
 	int depth = 0;
 
 	// The dimensions of the quad node.
 	Rectangle dimensions {};
 
-	// List of body pointers to bodies that are fully contained in this quad.
-	// They do not overlap with any other non-child quad.
-	std::vector<Body*> quad_bodies;
+	// The area that bodies in this node and its children lie within.
+	// Same as dimensions, unless the tree is loose.
+	Rectangle loose_dimensions {};
+
+	// Factor that the node's dimensions are scaled by to get its loose dimensions.
+	// Above 1, bodies are placed by their center and size, instead of having to be fully inside a node's dimensions.
+	float looseness = 1.0f;
+
+	// Largest radius a body can have to be placed in this node, if the tree is loose.
+	float max_radius = 0.0f;
+
+	// Range of the pool's body array, holding bodies that fit in this quad, but in none of its children.
+	// They do not overlap with any other non-child quad's (loose) dimensions.
+	BodyRange quad_bodies;
 
 	// The number of bodies in this quad and all its children (max depth).
 	int cur_size = 0;
 
+	// Bounding box of the bodies in this quad, but in none of its children. Updated before detecting collisions.
+	Rectangle bodies_bounds {};
+
+	// Bounding box of the bodies in this quad and all its children. Updated before detecting collisions.
+	Rectangle subtree_bounds {};
+
 	// The node's parent node.
 	QuadNode* parent = nullptr;
 
-	// The node's 4 potential children.
-	std::unique_ptr<QuadChildren<QuadNode>> children;
+	// The node's 4 potential children, owned by the pool.
+	QuadChildren<QuadNode>* children = nullptr;
+
+	// Storage shared by all nodes of the tree.
+	QuadPool<QuadNode>* pool = nullptr;
+
+	// Returns the bodies that are in this quad, but in none of its children.
+	std::span<Body*> bodies();
+
+	// Returns the bodies that are in this quad, but in none of its children.
+	std::span<Body* const> bodies() const;
 
 	// Checks all bodies and reinserts bodies into the most fitting node.
 	void update_internal(int max_bodies, int max_depth);
 
-	// Performs a collision check between the body and all bodies starting at the given iterator until the end iterator.
-	// If a collision is detected, adds a Collision event to the collision vector.
-	int get_collisions_internal(Body& checking, Body** it, Body** end, std::vector<Collision>& collisions);
+	// Get collisions between a group of bodies from an ancestor or unrelated node, and all bodies in this node's subtree.
+	// Only descends into nodes whose bounds overlap the group's bounds.
+	int get_collisions_group(std::span<Body* const> group, Rectangle group_bounds, std::vector<Collision>& collisions) const;
+
+	// Get collisions between bodies in this node's subtree and bodies in another, unrelated node's subtree.
+	// Only needed for loose trees, since otherwise bodies in unrelated nodes can't overlap.
+	int get_collisions_between(const QuadNode& other, std::vector<Collision>& collisions) const;
 
-	// Get collisions between a body and all bodies in relevant child nodes.
-	int get_collisions_child(Body& checking, std::vector<Collision>& collisions);
+	// Gets collisions of the child nodes' subtrees, with each other and with this node's bodies.
+	// Independent subtrees (and pairs of subtrees) are checked in parallel, and their results merged in order.
+	int get_collisions_children_parallel(std::vector<Collision>& collisions) const;
 
 	// Returns whether the quad is the root.
 	bool is_root() const;
@@ -58,12 +92,16 @@ class QuadNode
 	// Returns true if the body is fully inside the quad's dimensions.
 	bool contains_fully(const Body& body) const;
 
-	// Returns true if at least part of the body is inside the quad's dimensions.
-	bool contains_partially(const Body& body) const;
+	// Returns true if the body belongs in this quad or one of its children.
+	// For a loose tree, the body's center must be inside the quad's dimensions and it must be small enough.
+	// Otherwise, the body must be fully inside the quad's dimensions.
+	bool fits(const Body& body) const;
 
-	// Moves body referenced by iterator upwards.
-	// Returns the next iterator.
-	std::vector<Body*>::iterator move_up(std::vector<Body*>::iterator it);
+	// Returns whether this node is part of a loose quadtree.
+	bool is_loose() const;
+
+	// Moves the body at the index of this quad's bodies upwards.
+	void move_up(int index);
 
 	// Handles recursive splitting of a leaf.
 	void leaf_split_check(int max_bodies, int max_depth);
@@ -71,7 +109,7 @@ class QuadNode
 	// Handles possible concatenation in this quad and all relevant parent quads.
 	void concat_check(int max_bodies);
 
-	// Moves all child nodes' bodies into this node, then resets their pointers to nullptr.
+	// Moves all child nodes' bodies into this node, then returns the child nodes to the pool.
 	void concatenate();
 
 	// Creates 4 new child nodes.
@@ -84,6 +122,10 @@ class QuadNode
 	// Reinserts a body from one node upwards into the smallest node that fully contains it.
 	void reinsert(Body& body);
 
+	// Returns the node holding the body, searching only nodes that contain its center, and sets index to its index there.
+	// Works even when the body's bounding box has changed since it was placed. Returns nullptr if not found.
+	QuadNode* find_holder(const Body& body, int& index);
+
 	// Returns the smallest quad that contains the entire body.
 	QuadNode& find_quad(const Body& body);
 
@@ -102,8 +144,8 @@ class QuadNode
 public:
 
 	QuadNode() = default;
-	// internal constructor. still needs to be public for make_unique.
-	QuadNode(float x, float y, float size, QuadNode* parent, int depth, int max_bodies);
+	// internal constructor. still needs to be public for QuadChildren.
+	QuadNode(float x, float y, float size, QuadNode* parent, int depth, QuadPool<QuadNode>* pool, float looseness);
 
 	// Will add a body to the most appropriate quad node. Potentially splits that node if it reached its capacity.
 	void add_body(Body& body, int max_bodies_per_quad, int max_depth);
@@ -111,17 +153,28 @@ public:
 	// Will remove the body from the quad node that it is in. Potentially concatenates that node or its parent.
 	void rem_body(const Body& body, int max_bodies_per_quad);
 
-	void notify_move(const Body* from, Body* to);
+	// Moves the body up to a node it fits in, if it no longer fits its own after its radius changed.
+	void notify_radius_changed(const Body& body);
 
 	// Returns a pointer to the body that overlaps with the point. Returns nullptr if no body found.
 	Body* find_body(Vector2 point) const;
 
+	// Adds every body in this quad and its children that overlaps with the area to found.
+	void query_rect(Rectangle area, std::vector<Body*>& found) const;
+
+	// Returns the (up to) k bodies in this quad and its children whose centers are nearest to the point, nearest first.
+	// Visits quads in order of distance, until no quad left can hold a nearer body.
+	std::vector<Body*> k_nearest(Vector2 point, int k) const;
+
 	// Checks all bodies and reinserts bodies into the most fitting node.
 	// Handles node splitting due to movement.
 	void update(int max_bodies, int max_depth);
 
-	// Adds all detected collisions to collisions vector.
-	int get_collisions(std::vector<Collision>& collisions);
+	// Recalculates the bounds of this node's bodies and subtree, and those of all child nodes.
+	void update_bounds();
+
+	// Adds all detected collisions to collisions vector. Bounds must be up to date.
+	int get_collisions(std::vector<Collision>& collisions) const;
 
 	// Returns a representation of the boundaries of the quad tree and all of its child nodes.
 	std::vector<Rectangle> get_representation() const;
@@ -141,6 +194,9 @@ class QuadTree : public SpatialPartitioning
 	// Number of possible subdivisions to be made. Root depth is 0, so 1 == only one subdivision from root.
 	int max_depth;
 
+	// Node and body storage. Declared before the root, since the root is constructed with a pointer to it.
+	QuadPool<QuadNode> pool;
+
 	QuadNode root;
 
 	// Performs a collision check, and returns all collision events.
@@ -148,7 +204,13 @@ class QuadTree : public SpatialPartitioning
 
 public:
 
-	QuadTree(float size, int max_bodies_per_quad, int max_depth);
+	// A looseness above 1 makes a loose quadtree, where each node's bounds are expanded by that factor.
+	// Bodies then stay in deep nodes even when they straddle a node boundary.
+	QuadTree(float size, int max_bodies_per_quad, int max_depth, float looseness = 1.0f);
+
+	// Nodes point to the tree's pool, so the tree can't be copied.
+	QuadTree(const QuadTree&) = delete;
+	QuadTree& operator=(const QuadTree&) = delete;
 
 	// Will add a body to the most appropriate quad node. Potentially splits that node if it reached its capacity.
 	void add_body(Body& body) override
@@ -162,9 +224,10 @@ public:
 		root.rem_body(body, max_bodies_per_quad);
 	}
 
-	void notify_move(const Body* from, Body* to) override
+	// Moves the body up to a node it fits in, if it no longer fits its own after its radius changed.
+	void notify_radius_changed(Body& body, [[maybe_unused]] float old_radius) override
 	{
-		root.notify_move(from, to);
+		root.notify_radius_changed(body);
 	}
 
 	// Returns a pointer to the body that overlaps with the point. Returns nullptr if no body found.
@@ -173,6 +236,20 @@ public:
 		return root.find_body(point);
 	}
 
+	// Returns every body that overlaps with the area, only descending into quads that overlap it.
+	std::vector<Body*> query_rect(Rectangle area) const override
+	{
+		std::vector<Body*> found;
+		root.query_rect(area, found);
+		return found;
+	}
+
+	// Returns the (up to) k bodies whose centers are nearest to the point, nearest first.
+	std::vector<Body*> k_nearest(Vector2 point, int k) const override
+	{
+		return root.k_nearest(point, k);
+	}
+
 	// Checks all bodies and reinserts bodies into the most fitting node.
 	// Handles node splitting due to movement.
 	void update() override
@@ -186,10 +263,7 @@ public:
 		return root.get_representation();
 	}
 
-	// Attaches text related to the quadtree node which contains the body to info.  
-	void get_info(const Body& body, DebugInfo& info) const override
-	{
-		root.get_info(body, info);
-	}
+	// Attaches text related to the quadtree node which contains the body, and the tree's storage, to info.
+	void get_info(const Body& body, DebugInfo& info) const override;
 
 };
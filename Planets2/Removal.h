@@ -1,4 +1,6 @@
 #pragma once
+#include <span>
+#include "SimTypes.h"
 
 class Body;
 
@@ -7,7 +9,7 @@ struct Removal {
 
 	/*
 	* Since removal event processing may invalidate iterators, we use ids instead of pointers.
-	* When processing events, this requires a map search to get a reference to the body with the matching id.
+	* When processing events, this requires a lookup to get a reference to the body with the matching id.
 	* 
 	* At least some issues with using pointers could be handled, but that would
 	* add its own overhead.
@@ -39,3 +41,33 @@ struct Removal {
 
 
 };
+
+// Removals that happened at the same time, such as every merge of a tick. Published together as one event.
+using RemovalBatch = std::span<const Removal>;
+
+// A removal along with the state of the bodies involved just before it, for logging and analysis.
+struct RemovalRecord {
+
+	// The universe's tick when the body was removed. Merges happen during the update from this tick.
+	int tick = 0;
+
+	int removed = -1;
+	int absorbed_by = -1;
+
+	long removed_mass = 0;
+	Vector2 removed_pos {};
+	Vector2 removed_vel {};
+
+	// The absorber's state before absorbing the removed body, after any bodies of its group absorbed before it. Zero if it was deleted.
+	long absorber_mass = 0;
+	Vector2 absorber_pos {};
+	Vector2 absorber_vel {};
+
+	bool was_absorbed() const
+	{
+		return absorbed_by != -1;
+	}
+};
+
+// Records of the removals in a RemovalBatch, in the same order.
+using RemovalRecordBatch = std::span<const RemovalRecord>;
@@ -0,0 +1,296 @@
+#include "RemovalLog.h"
+#include "Universe.h"
+#include "ByteStream.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+    constexpr std::array<char, 8> MAGIC { 'P', 'L', 'A', 'N', 'E', 'T', 'R', 'L' };
+    constexpr std::uint32_t VERSION = 1;
+
+    // Written as a native integer, so a file from a machine with another byte order reads it differently.
+    constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // Size of the header: magic, version and byte order mark.
+    constexpr size_t HEADER_SIZE = 8 + 4 + 4;
+
+    // Size of a record: tick, removed id and absorber id, then the mass, position and velocity of both bodies.
+    constexpr size_t RECORD_SIZE = 3 * 4 + 2 * (8 + 4 * 4);
+
+    void write_header(ByteWriter& writer)
+    {
+        writer.put(MAGIC);
+        writer.put<std::uint32_t>(VERSION);
+        writer.put<std::uint32_t>(BYTE_ORDER_MARK);
+    }
+
+    // Returns an error describing what is wrong with the header, or nullopt if it's valid.
+    std::optional<std::string> check_header(ByteReader& reader)
+    {
+        if (reader.get<std::array<char, 8>>() != MAGIC) {
+            return "Not a removal log";
+        }
+
+        std::uint32_t version = reader.get<std::uint32_t>();
+        if (version != VERSION) {
+            return "Unsupported removal log version " + std::to_string(version);
+        }
+
+        if (reader.get<std::uint32_t>() != BYTE_ORDER_MARK) {
+            return "Removal log was written on a machine with a different byte order";
+        }
+
+        return std::nullopt;
+    }
+
+    void write_record(ByteWriter& writer, const RemovalRecord& record)
+    {
+        writer.put<std::int32_t>(record.tick);
+        writer.put<std::int32_t>(record.removed);
+        writer.put<std::int32_t>(record.absorbed_by);
+        writer.put<std::int64_t>(record.removed_mass);
+        writer.put<Vector2>(record.removed_pos);
+        writer.put<Vector2>(record.removed_vel);
+        writer.put<std::int64_t>(record.absorber_mass);
+        writer.put<Vector2>(record.absorber_pos);
+        writer.put<Vector2>(record.absorber_vel);
+    }
+
+    RemovalRecord read_record(ByteReader& reader)
+    {
+        RemovalRecord record;
+        record.tick = reader.get<std::int32_t>();
+        record.removed = reader.get<std::int32_t>();
+        record.absorbed_by = reader.get<std::int32_t>();
+        record.removed_mass = static_cast<long>(reader.get<std::int64_t>());
+        record.removed_pos = reader.get<Vector2>();
+        record.removed_vel = reader.get<Vector2>();
+        record.absorber_mass = static_cast<long>(reader.get<std::int64_t>());
+        record.absorber_pos = reader.get<Vector2>();
+        record.absorber_vel = reader.get<Vector2>();
+        return record;
+    }
+
+}
+
+RemovalLogger::RemovalLogger(const std::filesystem::path& path, Universe& universe, const Settings& settings)
+    : queued_records(settings.queue_records)
+{
+    if (!open(path)) {
+        failed = true;
+    }
+
+    record_listener = universe.removal_record_event().add_observer([this](const RemovalRecordBatch& records) {
+        for (RemovalRecord record : records) {
+            if (!queued_records.try_push(std::move(record))) {
+                records_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    writer_thread = std::jthread([this](std::stop_token stop) { write_records(stop); });
+}
+
+RemovalLogger::~RemovalLogger()
+{
+    close();
+}
+
+bool RemovalLogger::open(const std::filesystem::path& path)
+{
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+
+    if (error or size == 0) {
+        out.open(path, std::ios::binary | std::ios::trunc);
+        ByteWriter writer(buffer);
+        write_header(writer);
+    }
+    else {
+        std::array<std::byte, HEADER_SIZE> header {};
+        std::ifstream in(path, std::ios::binary);
+        in.read(reinterpret_cast<char*>(header.data()), header.size());
+
+        ByteReader reader(header);
+        if (!in or check_header(reader)) {
+            return false;
+        }
+
+        // Records appended after part of one wouldn't line up, so the part is dropped.
+        std::uintmax_t whole_size = HEADER_SIZE + (size - HEADER_SIZE) / RECORD_SIZE * RECORD_SIZE;
+        if (whole_size != size) {
+            std::filesystem::resize_file(path, whole_size, error);
+            if (error) {
+                return false;
+            }
+        }
+
+        out.open(path, std::ios::binary | std::ios::app);
+    }
+
+    return static_cast<bool>(out);
+}
+
+void RemovalLogger::close()
+{
+    if (!writer_thread.joinable()) {
+        return;
+    }
+
+    record_listener.detach();
+    writer_thread.request_stop();
+    writer_thread.join();
+}
+
+RemovalLogger::Stats RemovalLogger::get_stats() const
+{
+    Stats stats;
+    stats.records_written = records_written.load(std::memory_order_relaxed);
+    stats.records_dropped = records_dropped.load(std::memory_order_relaxed);
+    stats.bytes_written = bytes_written.load(std::memory_order_relaxed);
+    stats.failed = failed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void RemovalLogger::write_records(std::stop_token stop)
+{
+    while (true) {
+        // Checked before draining, so records queued before the stop was requested are always written.
+        bool stopping = stop.stop_requested();
+
+        drain();
+
+        if (stopping) {
+            break;
+        }
+
+        std::this_thread::sleep_for(WRITER_POLL);
+    }
+
+    out.close();
+}
+
+void RemovalLogger::drain()
+{
+    // A new log's header is already in the buffer.
+    ByteWriter writer(buffer);
+    long long num_records = 0;
+    while (std::optional<RemovalRecord> record = queued_records.try_pop()) {
+        write_record(writer, *record);
+        num_records++;
+    }
+
+    if (buffer.empty()) {
+        return;
+    }
+
+    if (!failed and out) {
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        out.flush();
+    }
+
+    if (failed or !out) {
+        failed = true;
+    }
+    else {
+        records_written.fetch_add(num_records, std::memory_order_relaxed);
+        bytes_written.fetch_add(buffer.size(), std::memory_order_relaxed);
+    }
+
+    buffer.clear();
+}
+
+double RemovalLogFile::Totals::merges_per_tick() const
+{
+    return last_tick > first_tick ? static_cast<double>(merges) / (last_tick - first_tick) : 0.0;
+}
+
+double RemovalLogFile::Totals::mean_impact_speed() const
+{
+    return merges > 0 ? impact_speed_sum / merges : 0.0;
+}
+
+RemovalLogFile::RemovalLogFile(MappedFile&& file) : file(std::move(file))
+{
+}
+
+std::optional<RemovalLogFile> RemovalLogFile::open(const std::filesystem::path& path, std::string& error)
+{
+    std::optional<MappedFile> mapped = MappedFile::open(path);
+    if (!mapped) {
+        error = "Could not open " + path.string();
+        return std::nullopt;
+    }
+
+    RemovalLogFile log(std::move(*mapped));
+    if (log.file.bytes().size() < HEADER_SIZE) {
+        error = "Removal log header is truncated";
+        return std::nullopt;
+    }
+
+    ByteReader reader(log.file.bytes());
+    if (std::optional<std::string> header_error = check_header(reader)) {
+        error = *header_error;
+        return std::nullopt;
+    }
+
+    log.num_records = (log.file.bytes().size() - HEADER_SIZE) / RECORD_SIZE;
+    return log;
+}
+
+size_t RemovalLogFile::get_num_records() const
+{
+    return num_records;
+}
+
+RemovalRecord RemovalLogFile::get_record(size_t index) const
+{
+    ByteReader reader(file.bytes().subspan(HEADER_SIZE + index * RECORD_SIZE, RECORD_SIZE));
+    return read_record(reader);
+}
+
+RemovalLogFile::Totals RemovalLogFile::total(int first_tick, int last_tick) const
+{
+    std::vector<Totals> totals = total_by_span(first_tick, last_tick, std::max(1, last_tick - first_tick));
+    return totals.empty() ? Totals { first_tick, last_tick } : totals.front();
+}
+
+std::vector<RemovalLogFile::Totals> RemovalLogFile::total_by_span(int first_tick, int last_tick, int span_ticks) const
+{
+    std::vector<Totals> spans;
+    if (last_tick <= first_tick or span_ticks <= 0) {
+        return spans;
+    }
+
+    int num_spans = (last_tick - first_tick + span_ticks - 1) / span_ticks;
+    spans.reserve(num_spans);
+    for (int i = 0; i < num_spans; i++) {
+        int start = first_tick + i * span_ticks;
+        spans.push_back({ start, std::min(start + span_ticks, last_tick) });
+    }
+
+    // Records are read straight through the mapping, so the whole log is one pass from start to end.
+    ByteReader reader(file.bytes().subspan(HEADER_SIZE, num_records * RECORD_SIZE));
+    for (size_t i = 0; i < num_records; i++) {
+        RemovalRecord record = read_record(reader);
+        if (record.tick < first_tick or record.tick >= last_tick) {
+            continue;
+        }
+
+        Totals& span = spans[(record.tick - first_tick) / span_ticks];
+        if (record.was_absorbed()) {
+            span.merges++;
+            span.mass_absorbed += record.removed_mass;
+            span.impact_speed_sum += std::hypot(record.removed_vel.x - record.absorber_vel.x, record.removed_vel.y - record.absorber_vel.y);
+        }
+        else {
+            span.deletions++;
+            span.mass_deleted += record.removed_mass;
+        }
+    }
+
+    return spans;
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscQueue.h"
+#include "Event.h"
+#include "Removal.h"
+#include "MappedFile.h"
+
+class Universe;
+
+/*
+* Removal logs: an append-only binary record of every body merged into another or deleted, for analysing collisions after a run.
+*
+* A removal log is laid out as:
+*   header:  magic, format version and byte order mark.
+*   records: one after another, each the same size: tick, removed id, absorber id, then the removed body's mass, position
+*            and velocity, and the absorber's mass, position and velocity before absorbing it.
+* A log is only ever appended to, so a run resumed from a checkpoint adds to the log of the run it carries on from.
+* A log whose writer was cut short may end in part of a record, which is ignored when reading and dropped when appending.
+*/
+
+/*
+* Appends a record of every removal in a universe to a removal log.
+*
+* Records are copied into a lock-free queue as the universe publishes them, so the thread updating it never waits on the disk.
+* A writer thread drains the queue and appends the records, flushing after each batch so a run that crashes loses little.
+* If the writer falls behind and the queue fills up, records are dropped until there is room again, and counted.
+*
+* The logger has to be created and destroyed by the thread updating the universe.
+*/
+class RemovalLogger
+{
+public:
+
+	struct Settings
+	{
+		// Records that can wait for the writer before any are dropped.
+		int queue_records = 1 << 14;
+	};
+
+	struct Stats
+	{
+		long long records_written = 0;
+		long long records_dropped = 0;
+		long long bytes_written = 0;
+
+		// True if the log couldn't be opened or written to, or the file at the path isn't a removal log.
+		bool failed = false;
+	};
+
+private:
+
+	// How long the writer waits between checks while the queue is empty.
+	static constexpr std::chrono::milliseconds WRITER_POLL { 10 };
+
+	SpscQueue<RemovalRecord> queued_records;
+	EventHandle<RemovalRecordBatch> record_listener;
+
+	// Only touched by the writer once it has started.
+	std::ofstream out;
+	std::vector<std::byte> buffer;
+
+	std::atomic<long long> records_written = 0;
+	std::atomic<long long> records_dropped = 0;
+	std::atomic<long long> bytes_written = 0;
+	std::atomic<bool> failed = false;
+
+	// Declared last, so the writer is joined before anything it uses is destroyed.
+	std::jthread writer_thread;
+
+	// Opens the log at the path to append to, or creates it with a header if there isn't one. Returns false if neither works.
+	bool open(const std::filesystem::path& path);
+
+	// Appends queued records until asked to stop, then appends what is left.
+	void write_records(std::stop_token stop);
+
+	// Appends every queued record, and flushes them to the file.
+	void drain();
+
+public:
+
+	// Opens the log and starts the writer. Removals are listened for from now on.
+	RemovalLogger(const std::filesystem::path& path, Universe& universe, const Settings& settings);
+
+	// Finishes the log.
+	~RemovalLogger();
+
+	RemovalLogger(const RemovalLogger&) = delete;
+	RemovalLogger& operator=(const RemovalLogger&) = delete;
+
+	// Stops listening for removals, and waits until every queued record is written.
+	void close();
+
+	// Safe to call from any thread.
+	Stats get_stats() const;
+};
+
+// A removal log mapped into memory, with totals of its records for collision rate and mass accretion analysis.
+class RemovalLogFile
+{
+public:
+
+	// Totals of the removals in a span of ticks.
+	struct Totals
+	{
+		// Ticks the removals are from, up to but not including last_tick.
+		int first_tick = 0;
+		int last_tick = 0;
+
+		long long merges = 0;
+		long long deletions = 0;
+
+		// Mass absorbed by other bodies, and mass deleted.
+		long long mass_absorbed = 0;
+		long long mass_deleted = 0;
+
+		// Sum over merges of the speed the removed body hit its absorber at.
+		double impact_speed_sum = 0.0;
+
+		double merges_per_tick() const;
+		double mean_impact_speed() const;
+	};
+
+private:
+
+	MappedFile file;
+	size_t num_records = 0;
+
+	explicit RemovalLogFile(MappedFile&& file);
+
+public:
+
+	// Maps and validates the removal log at the path. A part of a record at the end is ignored.
+	// Returns nullopt, with error describing why, if it can't be read.
+	static std::optional<RemovalLogFile> open(const std::filesystem::path& path, std::string& error);
+
+	size_t get_num_records() const;
+
+	// Returns the record at the index, in the order they were logged.
+	RemovalRecord get_record(size_t index) const;
+
+	// Adds up the records of removals at ticks from first_tick up to, but not including, last_tick.
+	Totals total(int first_tick, int last_tick) const;
+
+	// Splits the ticks from first_tick up to last_tick into spans of span_ticks, the last possibly shorter, and adds up each.
+	std::vector<Totals> total_by_span(int first_tick, int last_tick, int span_ticks) const;
+};
@@ -0,0 +1,296 @@
+#include "ReplayScene.h"
+#include "Body.h"
+#include "CameraState.h"
+#include "FreeCamera.h"
+#include "SettingsScene.h"
+#include "RenderUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+	constexpr const char* HELP_TEXT =
+		"[H] to close help text\n"
+		"[M] to show tick # and playback info\n"
+		"[V] to show show velocity directions\n"
+		"[SPACE] to toggle pause\n"
+		"[T] to change playback speed\n"
+		"[R] to reverse playback\n"
+		"[LEFT] [RIGHT] to seek back or forward\n"
+		"Drag the bar at the bottom to seek\n"
+		"[W] [A] [S] [D] to move the camera\n"
+		"[-, +] to control the camera's speed\n"
+		"[COMMA] or scroll down to zoom out\n"
+		"[PERIOD] or scroll up to zoom in\n"
+		"[ESCAPE] to go back to settings\n"
+		"Right click to anchor camera to a planet\n";
+}
+
+ReplayScene::ReplayScene(const SettingsState& settings, TrajectoryFile&& trajectory)
+	: file(std::move(trajectory)), settings_state(settings),
+	ticks_per_second(settings.ticks_per_second > 0 ? settings.ticks_per_second : 60.0f),
+	playback_tick(file.get_first_tick())
+{
+	camera_state = std::make_unique<FreeCamera>(starting_config);
+
+	on_screen_bodies.reserve(file.get_settings().universe_capacity);
+
+	help_message.set_text(HELP_TEXT);
+	gui.hide(help_message);
+	reposition_elements(GetScreenWidth(), GetScreenHeight());
+
+	show_tick(file.get_first_tick(), true);
+}
+
+ReplayScene::~ReplayScene() = default;
+
+void ReplayScene::process_input()
+{
+	// The seek bar is the only gui element that takes input.
+	float seek_before = seek_bar.get_val();
+	if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+	{
+		gui.send_click(GetMousePosition());
+	}
+	else if (IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+	{
+		gui.notify_drag();
+	}
+
+	if (seek_bar.get_val() != seek_before)
+	{
+		jump_to(seek_bar.get_val());
+	}
+
+	if (IsKeyPressed(KEY_H))
+	{
+		gui.toggle_visibility(help_message);
+	}
+
+	if (IsKeyPressed(KEY_M))
+	{
+		gui.toggle_visibility(tick_info_label);
+	}
+
+	if (IsKeyPressed(KEY_V))
+	{
+		should_render_velocities = !should_render_velocities;
+	}
+
+	if (IsKeyPressed(KEY_SPACE))
+	{
+		playing = !playing;
+
+		// Playing from the end playback stopped at starts the recording over.
+		if (playing and !reverse and playback_tick >= file.get_last_tick())
+		{
+			jump_to(file.get_first_tick());
+		}
+		else if (playing and reverse and playback_tick <= file.get_first_tick())
+		{
+			jump_to(file.get_last_tick());
+		}
+	}
+
+	if (IsKeyPressed(KEY_T))
+	{
+		speed_index = (speed_index + 1) % SPEEDS.size();
+	}
+
+	if (IsKeyPressed(KEY_R))
+	{
+		reverse = !reverse;
+	}
+
+	double seek_ticks = SEEK_FRACTION * (file.get_last_tick() - file.get_first_tick());
+	if (IsKeyPressed(KEY_LEFT))
+	{
+		jump_to(playback_tick - seek_ticks);
+	}
+	else if (IsKeyPressed(KEY_RIGHT))
+	{
+		jump_to(playback_tick + seek_ticks);
+	}
+
+	if (IsKeyPressed(KEY_ESCAPE))
+	{
+		if (return_scene == this)
+		{
+			return_scene = new SettingsScene(settings_state);
+		}
+	}
+}
+
+void ReplayScene::show_tick(int tick, bool jumped)
+{
+	if (!reader.seek(tick))
+	{
+		corrupt = true;
+		playing = false;
+	}
+
+	if (!reader.has_current() or reader.get_frame().tick == shown_tick)
+	{
+		return;
+	}
+
+	const TrajectoryFrame& frame = reader.get_frame();
+	bool continuous = !jumped and reader.was_continuous();
+
+	// Bodies in the shown frame move to the new one over the time playback takes to get from one to the other.
+	std::chrono::nanoseconds interval { 0 };
+	if (continuous and playing)
+	{
+		std::chrono::duration<double> seconds { std::abs(frame.tick - shown_tick) / (SPEEDS[speed_index] * ticks_per_second) };
+		interval = std::chrono::duration_cast<std::chrono::nanoseconds>(seconds);
+	}
+	else
+	{
+		shown_positions.clear();
+	}
+
+	// Removals are only known between consecutive frames. A camera anchored to a body that vanished in a jump lets go of it.
+	removals.clear();
+	if (continuous)
+	{
+		for (const RemovedBody& removed : reader.get_passed_removals())
+		{
+			removals.push_back({ removed.id, removed.absorbed_by });
+		}
+	}
+
+	snapshot.capture(frame, file.get_settings());
+	snapshot.set_prev_positions(shown_positions, removals);
+	snapshot.set_published(std::chrono::steady_clock::now(), interval);
+	shown_tick = frame.tick;
+
+	if (!removals.empty())
+	{
+		on_removal_observers.notify_all(removals);
+	}
+}
+
+void ReplayScene::jump_to(double tick)
+{
+	playback_tick = std::clamp(tick, static_cast<double>(file.get_first_tick()), static_cast<double>(file.get_last_tick()));
+	show_tick(static_cast<int>(playback_tick), true);
+}
+
+void ReplayScene::render_universe() const
+{
+	for (const Body* body : on_screen_bodies)
+	{
+		RenderUtil::render_body(*body);
+	}
+}
+
+void ReplayScene::render_velocities() const
+{
+	for (const Body* body : on_screen_bodies)
+	{
+		RenderUtil::render_velocity(*body);
+	}
+}
+
+void ReplayScene::render_screen_info()
+{
+	DrawFPS(50, 50);
+
+	num_bodies_label.set_text("Bodies: " + std::to_string(snapshot.get_num_bodies()));
+
+	if (tick_info_label.is_visible())
+	{
+		char speed[64];
+		std::snprintf(speed, sizeof(speed), "%gx (%.0f ticks/s)", SPEEDS[speed_index], SPEEDS[speed_index] * ticks_per_second);
+
+		std::string tick_info = "Tick " + std::to_string(shown_tick) + " of " + std::to_string(file.get_first_tick())
+			+ " to " + std::to_string(file.get_last_tick()) + "\n";
+		tick_info += "Playback: " + std::string(speed) + (reverse ? ", reversed" : "") + (playing ? "" : ", paused") + "\n";
+		tick_info += "Frames decoded by last seek: " + std::to_string(reader.get_frames_decoded_by_seek()) + "\n";
+		tick_info += std::to_string(file.get_num_chunks()) + " chunks, " + (file.has_index() ? "indexed" : "unindexed (recording was cut short)");
+
+		if (corrupt)
+		{
+			tick_info += "\nTrajectory is corrupt after this tick";
+		}
+
+		tick_info_label.set_text(tick_info);
+	}
+
+	gui.render();
+}
+
+Scene* ReplayScene::update()
+{
+	auto now = std::chrono::steady_clock::now();
+	std::chrono::duration<double> frame_seconds = now - last_update;
+	last_update = now;
+
+	process_input();
+
+	if (playing)
+	{
+		double ticks = SPEEDS[speed_index] * ticks_per_second * frame_seconds.count();
+		playback_tick += reverse ? -ticks : ticks;
+
+		// Playback pauses at either end of the recording.
+		double first = file.get_first_tick();
+		double last = file.get_last_tick();
+		if (playback_tick <= first or playback_tick >= last)
+		{
+			playback_tick = std::clamp(playback_tick, first, last);
+			playing = false;
+		}
+
+		show_tick(static_cast<int>(playback_tick), false);
+	}
+
+	seek_bar.set_val(static_cast<float>(playback_tick));
+
+	// Bodies are moved between the previous and current frame before anything reads them.
+	snapshot.interpolate(now);
+
+	CameraState* next_camera_state = camera_state->update(snapshot, on_removal_observers);
+	if (camera_state.get() != next_camera_state)
+	{
+		camera_state.reset(next_camera_state);
+	}
+
+	on_screen_bodies = snapshot.get_bodies_in_area(camera_state->get_view());
+
+	BeginDrawing();
+		ClearBackground(BLACK);
+
+			BeginMode2D(camera_state->get_raylib_camera());
+
+				if (should_render_velocities)
+				{
+					render_velocities();
+				}
+
+				render_universe();
+
+			EndMode2D();
+
+		render_screen_info();
+
+	EndDrawing();
+
+	return return_scene;
+}
+
+void ReplayScene::notify_resize(int width, int height)
+{
+	reposition_elements(width, height);
+	camera_state->notify_resize(width, height);
+}
+
+void ReplayScene::reposition_elements(int screen_width, int screen_height)
+{
+	// Keep help message display on the upper right side of the screen.
+	help_message.set_pos({ 0.73f * screen_width, 100.0f });
+
+	// Keep the seek bar along the bottom of the screen.
+	seek_bar.set_rail(50.0f, 0.93f * screen_height, screen_width - 100.0f);
+}
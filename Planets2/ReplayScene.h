@@ -0,0 +1,121 @@
+#pragma once
+#include "Scene.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "AdvCamera.h"
+#include "Label.h"
+#include "Slider.h"
+#include "GuiComponentList.h"
+#include "SettingsState.h"
+#include "TrajectoryFile.h"
+#include "UniverseSnapshot.h"
+#include "Event.h"
+#include "Removal.h"
+
+class CameraState;
+class Body;
+
+// This scene plays back a recorded trajectory, rendering it like the simulation scene renders a running universe.
+// Playback can be paused, reversed, sped up or slowed down, and seeked to any tick.
+class ReplayScene : public Scene
+{
+
+	// Playback speeds, as multiples of the tick rate the settings ask for. Cycled through with T.
+	static constexpr std::array<float, 6> SPEEDS { 0.25f, 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f };
+
+	// Fraction of the recording the arrow keys seek by.
+	static constexpr double SEEK_FRACTION = 0.01;
+
+	TrajectoryFile file;
+
+	// Declared after the file it reads.
+	TrajectoryReader reader { file };
+
+	// The frame being shown, as bodies, so it can be rendered and picked from like the simulation's snapshots.
+	UniverseSnapshot snapshot;
+
+	// Position of each body in the previously shown frame, indexed by body id, to interpolate from.
+	std::vector<Vector2> shown_positions;
+
+	// Tick of the frame being shown.
+	int shown_tick = -1;
+
+	// Removals passed over by moving on to the frame being shown, to notify removal observers with.
+	std::vector<Removal> removals;
+
+	// Notified of the removals between consecutive frames. Declared before the camera, which observes it.
+	Event<RemovalBatch> on_removal_observers;
+
+	// Copy of settings state, to restore settings scene when transition.
+	SettingsState settings_state;
+
+	// Ticks per second at 1x speed.
+	float ticks_per_second;
+
+	// Where playback is, between frames, and how it moves.
+	double playback_tick;
+	int speed_index = 1;
+	bool playing = true;
+	bool reverse = false;
+
+	// True if a frame couldn't be decoded. Playback stops at the frame before it.
+	bool corrupt = false;
+
+	std::chrono::steady_clock::time_point last_update = std::chrono::steady_clock::now();
+
+	AdvCamera starting_config { Vector2{0,0}, Vector2{0,0} };
+	std::unique_ptr<CameraState> camera_state;
+
+	bool should_render_velocities = false;
+
+	std::vector<const Body*> on_screen_bodies;
+
+	GuiComponentList gui;
+
+	Label& tick_info_label = gui.add<Label>("_", 50.0f, 95.0f, 20, RAYWHITE);
+	Label& num_bodies_label = gui.add<Label>("_", 50.0f, 70.0f, 20, RAYWHITE);
+	Label& help_message = gui.add<Label>("_", 0.0f, 0.0f, 20, RAYWHITE);
+
+	// Seeks to the tick it is dragged to. Positioned along the bottom of the screen.
+	Slider& seek_bar = gui.add<Slider>(50.0f, 0.0f, 100.0f, static_cast<float>(file.get_first_tick()), static_cast<float>(std::max(file.get_last_tick(), file.get_first_tick() + 1)));
+
+	// Handles all user input except the camera's.
+	void process_input();
+
+	// Seeks the reader to the tick, and shows its frame if it isn't the one being shown.
+	// Bodies move smoothly from the frame shown before unless jumped is true, or the reader had to jump.
+	void show_tick(int tick, bool jumped);
+
+	// Moves playback to the tick and shows it, without interpolating from the frame shown before.
+	void jump_to(double tick);
+
+	void render_universe() const;
+	void render_velocities() const;
+
+	// Handles rendering of any information that has a simple screen position, as opposed to a place in the universe.
+	void render_screen_info();
+
+	// Moves elements that adjust to screen size to new positions.
+	void reposition_elements(int screen_width, int screen_height);
+
+	// Scene to return at the end of update.
+	Scene* return_scene = this;
+
+public:
+
+	// Plays back the trajectory from its first frame. Playback speeds are relative to the settings' tick rate.
+	ReplayScene(const SettingsState& settings, TrajectoryFile&& file);
+
+	~ReplayScene();
+
+	// Handles user input, moves playback on by the time since the last update, and renders the frame at the playback tick.
+	Scene* update() override;
+
+	// Adjusts any elements that rely on screensize.
+	void notify_resize(int width, int height) override;
+
+};
@@ -0,0 +1,165 @@
+#include "RewindBuffer.h"
+#include "Universe.h"
+#include "Body.h"
+#include "ByteStream.h"
+#include <algorithm>
+
+namespace {
+
+    // Size of a body stored as plain arrays, as in a checkpoint's columns: id, position, velocity and mass.
+    constexpr long long RAW_BODY_SIZE = sizeof(std::int32_t) + 4 * sizeof(float) + sizeof(std::int64_t);
+
+}
+
+double RewindBuffer::Stats::compression_ratio() const
+{
+    return compressed_bytes > 0 ? static_cast<double>(raw_bytes) / compressed_bytes : 0.0;
+}
+
+RewindBuffer::RewindBuffer(const Settings& settings) : settings(settings)
+{
+}
+
+void RewindBuffer::record(const Universe& universe)
+{
+    if (keyframes.empty() or universe.get_tick() % settings.keyframe_every == 0) {
+        capture(universe);
+    }
+}
+
+void RewindBuffer::edit(Universe& universe, const std::function<void(Universe&)>& change)
+{
+    // Every change is keyframed after, so a keyframe at the universe's tick has its current state.
+    if (keyframes.empty() or keyframes.back().tick != universe.get_tick()) {
+        capture(universe);
+    }
+
+    int next_id = universe.get_bodies().get_next_id();
+    int num_bodies = universe.get_num_bodies();
+
+    change(universe);
+
+    if (universe.get_bodies().get_next_id() != next_id or universe.get_num_bodies() != num_bodies) {
+        capture(universe);
+    }
+}
+
+bool RewindBuffer::rewind(Universe& universe, int tick)
+{
+    if (keyframes.empty()) {
+        return false;
+    }
+
+    tick = std::max(tick, keyframes.front().tick);
+    if (tick >= universe.get_tick()) {
+        return false;
+    }
+
+    auto after = std::ranges::upper_bound(keyframes, tick, {}, &Keyframe::tick);
+    truncate(after - keyframes.begin());
+    restore(universe, keyframes.back());
+
+    // Keyframes due on the way are taken again, as they were the first time.
+    while (universe.get_tick() < tick) {
+        universe.update();
+        record(universe);
+    }
+
+    return true;
+}
+
+bool RewindBuffer::step_back(Universe& universe)
+{
+    size_t to_keep = keyframes.size();
+    if (to_keep > 0 and keyframes.back().tick == universe.get_tick()) {
+        to_keep--;
+    }
+
+    if (to_keep == 0) {
+        return false;
+    }
+
+    truncate(to_keep);
+    restore(universe, keyframes.back());
+    return true;
+}
+
+void RewindBuffer::capture(const Universe& universe)
+{
+    encoded.clear();
+    ByteWriter writer(encoded);
+
+    int prev_id = 0;
+    for (const Body& body : universe.get_bodies()) {
+        writer.put_signed_varint(body.get_id() - prev_id);
+        writer.put_varint(static_cast<std::uint64_t>(body.get_mass()));
+        writer.put<float>(body.pos().x);
+        writer.put<float>(body.pos().y);
+        writer.put<float>(body.vel().x);
+        writer.put<float>(body.vel().y);
+        prev_id = body.get_id();
+    }
+
+    Keyframe& keyframe = keyframes.emplace_back();
+    keyframe.tick = universe.get_tick();
+    keyframe.next_id = universe.get_bodies().get_next_id();
+    keyframe.num_collision_checks = universe.get_num_collision_checks();
+    keyframe.num_swept_collisions = universe.get_num_swept_collisions();
+    keyframe.num_bodies = universe.get_num_bodies();
+    keyframe.bodies.assign(encoded.begin(), encoded.end());
+
+    raw_bytes += keyframe.num_bodies * RAW_BODY_SIZE;
+    compressed_bytes += keyframe.bodies.size();
+
+    while (static_cast<size_t>(compressed_bytes) > settings.memory_limit and keyframes.size() > 1) {
+        raw_bytes -= keyframes.front().num_bodies * RAW_BODY_SIZE;
+        compressed_bytes -= keyframes.front().bodies.size();
+        keyframes.pop_front();
+    }
+}
+
+void RewindBuffer::restore(Universe& universe, const Keyframe& keyframe) const
+{
+    std::vector<Body> bodies;
+    bodies.reserve(keyframe.num_bodies);
+
+    ByteReader reader(keyframe.bodies);
+    int id = 0;
+    for (int i = 0; i < keyframe.num_bodies; i++) {
+        id += static_cast<int>(reader.get_signed_varint());
+        long mass = static_cast<long>(reader.get_varint());
+        float x = reader.get<float>();
+        float y = reader.get<float>();
+        float vel_x = reader.get<float>();
+        float vel_y = reader.get<float>();
+
+        Body& body = bodies.emplace_back(x, y, mass);
+        body.set_vel({ vel_x, vel_y });
+        body.set_id(id);
+    }
+
+    universe.restore(std::move(bodies), keyframe.next_id, keyframe.tick, keyframe.num_collision_checks, keyframe.num_swept_collisions);
+}
+
+void RewindBuffer::truncate(size_t to_keep)
+{
+    while (keyframes.size() > to_keep) {
+        raw_bytes -= keyframes.back().num_bodies * RAW_BODY_SIZE;
+        compressed_bytes -= keyframes.back().bodies.size();
+        keyframes.pop_back();
+    }
+}
+
+RewindBuffer::Stats RewindBuffer::get_stats() const
+{
+    Stats stats;
+    stats.num_keyframes = keyframes.size();
+    if (!keyframes.empty()) {
+        stats.first_tick = keyframes.front().tick;
+        stats.last_tick = keyframes.back().tick;
+    }
+
+    stats.raw_bytes = raw_bytes;
+    stats.compressed_bytes = compressed_bytes;
+    return stats;
+}
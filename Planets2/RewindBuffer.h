@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+class Universe;
+
+/*
+* Recent states of a universe, kept in memory so it can be rewound to any tick they cover.
+*
+* A keyframe of the universe is taken every keyframe_every ticks, and on both sides of every change made to it between ticks.
+* Rewinding to a tick restores the last keyframe at or before it and re-simulates the ticks in between,
+* which ends in the state the universe had at that tick, since ticks are deterministic and no change is made between keyframes.
+* Keyframes after the tick are dropped, as the universe goes on from there.
+* Stepping back restores the keyframe before the universe's current state, which undoes the latest change without re-simulating.
+*
+* Keyframes are lossless: body ids are delta encoded and masses varint encoded, positions and velocities are kept bit for bit.
+* Once the keyframes take up more than the memory limit, the oldest are dropped.
+* The random engine isn't kept, since ticks don't use it, and undoing a placement of generated bodies shouldn't replay it.
+*
+* Every method has to be called by the thread updating the universe.
+*/
+class RewindBuffer
+{
+public:
+
+	struct Settings
+	{
+		// Ticks between keyframes. Rewinding re-simulates fewer ticks than this.
+		int keyframe_every = 60;
+
+		// Bytes the keyframes may take up.
+		size_t memory_limit = 64 << 20;
+	};
+
+	struct Stats
+	{
+		int num_keyframes = 0;
+
+		// Ticks of the oldest and newest keyframes.
+		int first_tick = 0;
+		int last_tick = 0;
+
+		// Size of the kept keyframes' bodies stored as plain arrays, and their size as kept.
+		long long raw_bytes = 0;
+		long long compressed_bytes = 0;
+
+		double compression_ratio() const;
+	};
+
+private:
+
+	struct Keyframe
+	{
+		int tick;
+		int next_id;
+		int num_collision_checks;
+		int num_swept_collisions;
+		int num_bodies;
+
+		// Every body in update order, encoded.
+		std::vector<std::byte> bodies;
+	};
+
+	const Settings settings;
+
+	// Oldest first. Ordered by tick, with keyframes taken around changes at the same tick in the order they were taken.
+	std::deque<Keyframe> keyframes;
+
+	long long raw_bytes = 0;
+	long long compressed_bytes = 0;
+
+	// Reused between captures, so each keyframe's bodies are allocated at their exact size.
+	std::vector<std::byte> encoded;
+
+	// Keyframes the universe, then drops the oldest keyframes while over the memory limit. The newest is always kept.
+	void capture(const Universe& universe);
+
+	// Puts the universe back to the keyframe's state.
+	void restore(Universe& universe, const Keyframe& keyframe) const;
+
+	// Drops every keyframe after the first to_keep.
+	void truncate(size_t to_keep);
+
+public:
+
+	explicit RewindBuffer(const Settings& settings);
+
+	// Keyframes the universe if a keyframe is due at its tick, or if it has no keyframe yet.
+	void record(const Universe& universe);
+
+	// Makes the change, keyframing the universe before it, unless the newest keyframe already has its state, and after it.
+	// A change that doesn't add or remove any body, such as a body placed out of bounds, isn't keyframed after.
+	void edit(Universe& universe, const std::function<void(Universe&)>& change);
+
+	// Rewinds the universe to the tick, or to the oldest keyframe if the tick is before it.
+	// Returns false, leaving the universe as it is, if the tick isn't before the universe's tick.
+	bool rewind(Universe& universe, int tick);
+
+	// Restores the newest keyframe whose state isn't the universe's current one, and drops the keyframes after it.
+	// Returns false if there is none.
+	bool step_back(Universe& universe);
+
+	Stats get_stats() const;
+};
@@ -1,7 +1,7 @@
 #include "SatelliteCreation.h"
 #include "Physics.h"
 #include "CameraState.h"
-#include "Universe.h"
+#include "SimulationThread.h"
 
 #include "SystemCreation.h"
 #include "DefaultInteraction.h"
@@ -12,57 +12,63 @@
 #include "PlanetMouseModifier.h"
 #include "Removal.h"
 
-SatelliteCreation::SatelliteCreation(const Body& parent, const Body& creating, Universe& universe)
-	: creating(creating), orbit_projection{ parent, creating, static_cast<float>(universe.get_settings().grav_const), 129}
+SatelliteCreation::SatelliteCreation(const Body& parent, const Body& creating, SimulationThread& simulation)
+	: creating(creating), orbit_projection{ parent, creating, static_cast<float>(simulation.get_settings().grav_const), 129}
 {
-	listener = universe.removal_event().add_observer([this, &universe](Removal e) 
+	listener = simulation.removal_event().add_observer([this, &simulation](RemovalBatch removals) 
 	{
-		if (e.removed == parent_id)
+		int prev_parent_id = parent_id;
+
+		// A snapshot can carry several ticks of removals, so an absorber may itself be absorbed later in the batch.
+		for (Removal e : removals)
 		{
-			if (e.was_absorbed())
-			{
-				const Body* absorber = universe.get_body(e.absorbed_by);
-				update_orbit(*absorber, static_cast<float>(universe.get_settings().grav_const), universe.get_tick());
-			}
-			else
+			if (e.removed == parent_id)
 			{
-				parent_id = -1;
+				parent_id = e.absorbed_by;
 			}
 		}
+
+		if (parent_id != -1 and parent_id != prev_parent_id)
+		{
+			const UniverseSnapshot& universe = simulation.get_snapshot();
+			const Body* absorber = universe.get_body(parent_id);
+			update_orbit(*absorber, static_cast<float>(universe.get_settings().grav_const));
+		}
 	});
 
-	update_orbit(parent, static_cast<float>(universe.get_settings().grav_const), universe.get_tick());
+	update_orbit(parent, static_cast<float>(simulation.get_settings().grav_const));
 }
 
-void SatelliteCreation::update_orbit(float grav_const, int tick_stamp)
+void SatelliteCreation::update_orbit(float grav_const)
 {
 	orbit_projection.update(grav_const);
-	prev_projection_tick = tick_stamp;
 }
 
 
-void SatelliteCreation::update_orbit(const Body& orbiting, float grav_const, int tick_stamp)
+void SatelliteCreation::update_orbit(const Body& orbiting, float grav_const)
 {
 	parent_id = orbiting.get_id();
 	creating.set_vel(orbiting.vel());
 	orbit_projection.update(orbiting, creating, grav_const);
-	prev_projection_tick = tick_stamp;
 }
 
-InteractionState* SatelliteCreation::process_input(const CameraState& camera_state, Universe& universe)
+InteractionState* SatelliteCreation::process_input(const CameraState& camera_state, SimulationThread& simulation)
 {
 	if (parent_id == -1) return new DefaultInteraction;
 
+	const UniverseSnapshot& universe = simulation.get_snapshot();
 	const Body& parent = *universe.get_body(parent_id);
 
 	Vector2 screen_point = GetMousePosition();
 	Vector2 universe_point = GetScreenToWorld2D(screen_point, camera_state.get_raylib_camera());
-	int cur_tick = universe.get_tick();
 	float grav_const = static_cast<float>(universe.get_settings().grav_const);
 
+	// The parent is read from the current snapshot, which replaces the one the projection was made from.
+	orbit_projection.update(parent, creating, grav_const);
+
 	if (satellite_modifier.process_input(creating, camera_state.get_camera(), universe))
 	{
-		update_orbit(grav_const, cur_tick);
+		update_orbit(grav_const);
 	}
 	else if (IsKeyPressed(KEY_R))
 	{
@@ -70,13 +76,13 @@ InteractionState* SatelliteCreation::process_input(const CameraState& camera_sta
 
 		if (mouse_overlapped)
 		{
-			update_orbit(*mouse_overlapped, grav_const, cur_tick);
+			update_orbit(*mouse_overlapped, grav_const);
 		}
 	}
 	else if (IsKeyPressed(KEY_ENTER))
 	{
 		// Add user body to universe, and end creation mode. 
-		universe.add_body(std::move(creating));
+		simulation.add_body(std::move(creating));
 		return new DefaultInteraction;
 	}
 	else if (IsKeyPressed(KEY_ONE))
@@ -89,7 +95,7 @@ InteractionState* SatelliteCreation::process_input(const CameraState& camera_sta
 	}
 	else if (IsKeyPressed(KEY_THREE))
 	{
-		return new SystemCreation{ universe_point, universe };
+		return new SystemCreation{ universe_point, simulation };
 	}
 	else
 	{
@@ -121,11 +127,7 @@ InteractionState* SatelliteCreation::process_input(const CameraState& camera_sta
 			// Apply transformations to satellite's relative velocity.
 			Vector2 new_rel_vel = Vector2Rotate(Vector2Scale(creating.vel_relative(parent), vel_scale), vel_rot);
 			creating.set_vel(Vector2Add(parent.vel(), new_rel_vel));
-			update_orbit(grav_const, cur_tick);
-		}
-		else if (cur_tick != prev_projection_tick)
-		{
-			update_orbit(grav_const, cur_tick);
+			update_orbit(grav_const);
 		}
 	}
 
@@ -153,7 +155,7 @@ std::string_view SatelliteCreation::get_help_text() const
 		"[3] to go to system generator\n";
 }
 
-void SatelliteCreation::render_world(const AdvCamera& camera, const Universe& universe)
+void SatelliteCreation::render_world(const AdvCamera& camera, const UniverseSnapshot& universe)
 {
 	orbit_projection.render_orbit(PURPLE);
 	orbit_projection.render_connecting_line(RED);
@@ -1,5 +1,6 @@
 #include "SettingsScene.h"
 #include "SimulationScene.h"
+#include "ReplayScene.h"
 
 #include "Button.h"
 #include "Label.h"
@@ -9,7 +10,11 @@
 #include "QuadTree.h"
 #include "Grid.h"
 #include "LineSweep.h"
+#include "SweepAndPrune.h"
+#include "DynamicAABBTree.h"
+#include "BarnesHutPartitioning.h"
 #include "NullPartitioning.h"
+#include "Checkpoint.h"
 #include "IntValidator.h"
 #include "FloatValidator.h"
 #include <optional>
@@ -27,7 +32,43 @@ void SettingsScene::setup()
 
 		if (return_scene == this)
 		{
-			return_scene = new SimulationScene(generate_settings(), gen_partitioning());
+			SettingsState settings = generate_settings();
+			return_scene = new SimulationScene(settings, gen_partitioning(settings.universe));
+		}
+	});
+
+	resume_button.set_on_action([this]()
+	{
+		std::string error;
+		std::optional<CheckpointFile> checkpoint = CheckpointFile::open(SettingsState::CHECKPOINT_PATH, error);
+		if (!checkpoint)
+		{
+			show_error(error);
+			return;
+		}
+
+		if (return_scene == this)
+		{
+			// The universe keeps the settings it was saved with, which the settings scene shows when returned to.
+			SettingsState settings = generate_settings();
+			settings.universe = checkpoint->get_settings();
+			return_scene = new SimulationScene(settings, *checkpoint, gen_partitioning(settings.universe));
+		}
+	});
+
+	replay_button.set_on_action([this]()
+	{
+		std::string error;
+		std::optional<TrajectoryFile> trajectory = TrajectoryFile::open(SettingsState::TRAJECTORY_PATH, error);
+		if (!trajectory)
+		{
+			show_error(error);
+			return;
+		}
+
+		if (return_scene == this)
+		{
+			return_scene = new ReplayScene(generate_settings(), std::move(*trajectory));
 		}
 	});
 
@@ -35,6 +76,8 @@ void SettingsScene::setup()
 
 	start_button.set_min_width(BUTTON_MIN_WIDTH);
 	exit_button.set_min_width(BUTTON_MIN_WIDTH);
+	resume_button.set_min_width(BUTTON_MIN_WIDTH);
+	replay_button.set_min_width(BUTTON_MIN_WIDTH);
 
 	num_planets_input.set_prompt_text("Number of random planets to generate");
 	num_systems_input.set_prompt_text("Number of random systems to generate");
@@ -43,6 +86,10 @@ void SettingsScene::setup()
 	partitioning_dropdown.add_choice("Quad tree");
 	partitioning_dropdown.add_choice("Grid");
 	partitioning_dropdown.add_choice("Line sweep");
+	partitioning_dropdown.add_choice("Sweep and prune");
+	partitioning_dropdown.add_choice("AABB tree");
+	partitioning_dropdown.add_choice("Barnes-Hut tree");
+	partitioning_dropdown.add_choice("Auto tuned");
 
 	partitioning_dropdown.set_on_selection([this](std::string_view selection)
 	{
@@ -54,6 +101,8 @@ void SettingsScene::setup()
 			gui.show(quad_max_bodies_input);
 			gui.show(quad_bodies_label);
 			gui.show(quad_depth_label);
+			gui.show(quad_looseness_input);
+			gui.show(quad_looseness_label);
 		}
 		else if (selection == "Grid")
 		{
@@ -63,8 +112,10 @@ void SettingsScene::setup()
 			gui.hide(quad_max_bodies_input);
 			gui.hide(quad_bodies_label);
 			gui.hide(quad_depth_label);
+			gui.hide(quad_looseness_input);
+			gui.hide(quad_looseness_label);
 		}
-		else if (selection == "Line sweep")
+		else if (selection == "Line sweep" or selection == "Sweep and prune" or selection == "AABB tree" or selection == "Barnes-Hut tree" or selection == "Auto tuned")
 		{
 			gui.hide(grid_nodes_per_row_input);
 			gui.hide(grid_label);
@@ -72,6 +123,8 @@ void SettingsScene::setup()
 			gui.hide(quad_max_bodies_input);
 			gui.hide(quad_bodies_label);
 			gui.hide(quad_depth_label);
+			gui.hide(quad_looseness_input);
+			gui.hide(quad_looseness_label);
 		}
 		else
 		{
@@ -81,6 +134,8 @@ void SettingsScene::setup()
 			gui.hide(quad_max_bodies_input);
 			gui.hide(quad_bodies_label);
 			gui.hide(quad_depth_label);
+			gui.hide(quad_looseness_input);
+			gui.hide(quad_looseness_label);
 		}
 	});
 
@@ -109,6 +164,26 @@ void SettingsScene::setup()
 		}
 	});
 
+	gui.hide(neighbour_skin_input);
+	gui.hide(neighbour_skin_label);
+
+	continuous_collisions_checkbox.set_desc_font_size(10);
+
+	neighbour_lists_checkbox.set_desc_font_size(10);
+	neighbour_lists_checkbox.set_on_click([this](bool checked)
+	{
+		if (checked)
+		{
+			gui.show(neighbour_skin_input);
+			gui.show(neighbour_skin_label);
+		}
+		else
+		{
+			gui.hide(neighbour_skin_input);
+			gui.hide(neighbour_skin_label);
+		}
+	});
+
 	background_color = SKYBLUE;
 
 	// Setting input validators.
@@ -118,6 +193,8 @@ void SettingsScene::setup()
 	num_planets_input.set_validator(std::make_unique<IntValidator>());
 	num_systems_input.set_validator(std::make_unique<IntValidator>());
 	grav_const_input.set_validator(std::make_unique<FloatValidator>(0.1f));
+	ticks_per_second_input.set_validator(std::make_unique<IntValidator>(0));
+	step_budget_input.set_validator(std::make_unique<FloatValidator>(0.1f));
 	sys_mass_ratio_input.set_validator(std::make_unique<FloatValidator>(0.1f));
 	sys_min_planets_input.set_validator(std::make_unique<IntValidator>(1));
 	sys_max_planets_input.set_validator(std::make_unique<IntValidator>(1));
@@ -128,7 +205,11 @@ void SettingsScene::setup()
 
 	quad_max_bodies_input.set_validator(std::make_unique<IntValidator>(1));
 	quadtree_max_depth_input.set_validator(std::make_unique<IntValidator>(0));
+	quad_looseness_input.set_validator(std::make_unique<FloatValidator>(1.0f));
 	grid_nodes_per_row_input.set_validator(std::make_unique<IntValidator>(1));
+	neighbour_skin_input.set_validator(std::make_unique<FloatValidator>(0.1f));
+	rewind_every_input.set_validator(std::make_unique<IntValidator>(1));
+	rewind_memory_input.set_validator(std::make_unique<IntValidator>(1));
 
 }
 
@@ -154,12 +235,17 @@ bool SettingsScene::handle_errors()
 	}
 	else
 	{
-		error_msg.set_text(error_text);
-		error_msg.center_on(BUTTON_X + BUTTON_MIN_WIDTH);
+		show_error(error_text);
 		return true;
 	}
 }
 
+void SettingsScene::show_error(const std::string& error_text)
+{
+	error_msg.set_text(error_text);
+	error_msg.center_on(BUTTON_X + BUTTON_MIN_WIDTH);
+}
+
 std::string SettingsScene::scan_semantic_errors() const
 {
 	if (start_size_input.get_float() > max_size_input.get_float()) {
@@ -187,6 +273,11 @@ SettingsState SettingsScene::generate_settings() const
 	settings.universe.grav_const = grav_const_input.get_double();
 	settings.universe.use_gravity_approximation = approximate_gravity_checkbox.is_checked();
 	settings.universe.grav_approximation_value = approximation_slider.get_val();
+	settings.universe.continuous_collisions = continuous_collisions_checkbox.is_checked();
+	settings.ticks_per_second = ticks_per_second_input.get_int();
+	settings.step_budget_ms = step_budget_input.get_float();
+	settings.rewind.keyframe_every = rewind_every_input.get_int();
+	settings.rewind.memory_limit = static_cast<size_t>(rewind_memory_input.get_int()) << 20;
 
 	settings.universe.system_mass_ratio = sys_mass_ratio_input.get_float();
 
@@ -198,8 +289,12 @@ SettingsState SettingsScene::generate_settings() const
 	settings.universe.retrograde_chance = sys_retrograde_input.get_double();
 
 	settings.partitioning_selected = partitioning_dropdown.get_selected();
+	settings.universe.auto_tune_partitioning = partitioning_dropdown.get_selected() == "Auto tuned";
+	settings.universe.use_neighbour_lists = neighbour_lists_checkbox.is_checked();
+	settings.universe.neighbour_list_skin = neighbour_skin_input.get_float();
 	settings.quadtree.max_bodies = quad_max_bodies_input.get_int();
 	settings.quadtree.max_depth = quadtree_max_depth_input.get_int();
+	settings.quadtree.looseness = quad_looseness_input.get_float();
 	settings.grid.nodes_per_row = grid_nodes_per_row_input.get_int();
 	return settings;
 }
@@ -214,6 +309,10 @@ void SettingsScene::read_settings_to_gui(const SettingsState& settings)
 	num_systems_input.set_text(std::to_string(settings.universe.num_rand_systems));
 
 	grav_const_input.set_text(std::to_string(settings.universe.grav_const).substr(0, rounding + 1));
+	ticks_per_second_input.set_text(std::to_string(settings.ticks_per_second));
+	step_budget_input.set_text(std::to_string(settings.step_budget_ms).substr(0, rounding + 1));
+	rewind_every_input.set_text(std::to_string(settings.rewind.keyframe_every));
+	rewind_memory_input.set_text(std::to_string(settings.rewind.memory_limit >> 20));
 
 	sys_mass_ratio_input.set_text(std::to_string(settings.universe.system_mass_ratio).substr(0, rounding + 1));
 	sys_min_planets_input.set_text(std::to_string(settings.universe.system_min_planets));
@@ -229,14 +328,26 @@ void SettingsScene::read_settings_to_gui(const SettingsState& settings)
 		approximation_slider.set_val(settings.universe.grav_approximation_value);
 	}
 
+	if (settings.universe.continuous_collisions)
+	{
+		continuous_collisions_checkbox.click();
+	}
+
 	partitioning_dropdown.set_selected(settings.partitioning_selected);
 	quad_max_bodies_input.set_text(std::to_string(settings.quadtree.max_bodies));
 	quadtree_max_depth_input.set_text(std::to_string(settings.quadtree.max_depth));
+	quad_looseness_input.set_text(std::to_string(settings.quadtree.looseness).substr(0, rounding + 1));
 	grid_nodes_per_row_input.set_text(std::to_string(settings.grid.nodes_per_row));
+
+	if (settings.universe.use_neighbour_lists)
+	{
+		neighbour_lists_checkbox.click();
+	}
+	neighbour_skin_input.set_text(std::to_string(settings.universe.neighbour_list_skin).substr(0, rounding + 1));
 }
 
 
-std::unique_ptr<SpatialPartitioning> SettingsScene::gen_partitioning()
+std::unique_ptr<SpatialPartitioning> SettingsScene::gen_partitioning(const UniverseSettings& universe)
 {
 	std::string_view name_method = partitioning_dropdown.get_selected();
 
@@ -245,18 +356,37 @@ std::unique_ptr<SpatialPartitioning> SettingsScene::gen_partitioning()
 		// validators already ensured these are ints.
 		int bodies_per_quad = *SimUtil::svtoi(quad_max_bodies_input.get_text());
 		int max_depth = *SimUtil::svtoi(quadtree_max_depth_input.get_text());
+		float looseness = quad_looseness_input.get_float();
 
-		return std::make_unique<QuadTree>(max_size_input.get_float(), bodies_per_quad, max_depth);
+		return std::make_unique<QuadTree>(universe.universe_size_max, bodies_per_quad, max_depth, looseness);
 	}
 	else if (name_method == "Grid")
 	{
 		int nodes_per_row = *SimUtil::svtoi(grid_nodes_per_row_input.get_text());
-		return std::make_unique<Grid>(max_size_input.get_float(), nodes_per_row);
+		return std::make_unique<Grid>(universe.universe_size_max, nodes_per_row);
 	}
 	else if (name_method == "Line sweep")
 	{
 		return std::make_unique<LineSweep>();
 	}
+	else if (name_method == "Sweep and prune")
+	{
+		return std::make_unique<SweepAndPrune>();
+	}
+	else if (name_method == "AABB tree")
+	{
+		return std::make_unique<DynamicAABBTree>();
+	}
+	else if (name_method == "Auto tuned")
+	{
+		// Needs no parameters. The universe's tuner swaps it for the fastest method after its first trial.
+		return std::make_unique<LineSweep>();
+	}
+	else if (name_method == "Barnes-Hut tree")
+	{
+		// Shares its tree with gravity approximation, so it uses the same approximation value.
+		return std::make_unique<BarnesHutPartitioning>(universe.universe_size_max, universe.grav_approximation_value);
+	}
 	else
 	{
 		return std::make_unique<NullPartitioning>();
@@ -30,6 +30,12 @@ class SettingsScene : public GuiScene
 	Button& start_button = gui.add<Button>("Start", BUTTON_X, BUTTON_Y);
 	Button& exit_button = gui.add<Button>("Exit", BUTTON_X + 100, BUTTON_Y);
 
+	// Resumes the universe saved in the checkpoint file, with the partitioning and thread settings entered here.
+	Button& resume_button = gui.add<Button>("Resume", BUTTON_X + 200, BUTTON_Y);
+
+	// Plays back the recorded trajectory file.
+	Button& replay_button = gui.add<Button>("Replay", BUTTON_X + 300, BUTTON_Y);
+
 
 	static constexpr float TEXTBOX_WIDTH = 400.0f;
 
@@ -75,6 +81,14 @@ class SettingsScene : public GuiScene
 	Label& approximation_description = gui.add<Label>("Increasing this value improves performance\nbut decreases accuracy",
 		PHYSICS_START_X, COLUMN_Y + 350, 20);
 
+	CheckBox& continuous_collisions_checkbox = gui.add<CheckBox>("Detect fast bodies passing through others within a tick", PHYSICS_START_X, COLUMN_Y + 450, 20.0f);
+
+	TextBox& ticks_per_second_input = gui.add<TextBox>(PHYSICS_START_X, COLUMN_Y + 550, TEXTBOX_WIDTH);
+	Label& ticks_per_second_label = gui.add<Label>("Ticks per second (0 = uncapped)", PHYSICS_START_X + LABEL_OFFSET, COLUMN_Y + 570, 12);
+
+	TextBox& step_budget_input = gui.add<TextBox>(PHYSICS_START_X, COLUMN_Y + 650, TEXTBOX_WIDTH);
+	Label& step_budget_label = gui.add<Label>("Step budget time warp (ms)", PHYSICS_START_X + LABEL_OFFSET, COLUMN_Y + 670, 12);
+
 	// System generation settings column
 	static constexpr float SYSTEMS_START_X = PHYSICS_START_X + LABEL_OFFSET + 200;
 	Label& systems_header = gui.add<Label>("System Generation", SYSTEMS_START_X + TEXTBOX_WIDTH / 3, COLUMN_Y, 12);
@@ -114,11 +128,26 @@ class SettingsScene : public GuiScene
 	TextBox& quadtree_max_depth_input = gui.add<TextBox>("10", PARAM_X + LABEL_OFFSET, PARTITIONING_Y, TEXTBOX_WIDTH);
 	Label& quad_bodies_label = gui.add<Label>("Max bodies before split", PARAM_X, PARTITIONING_Y - 50, 12);
 	Label& quad_depth_label = gui.add<Label>("Max depth", PARAM_X + LABEL_OFFSET, PARTITIONING_Y - 50, 12);
+	TextBox& quad_looseness_input = gui.add<TextBox>("1.0", PARAM_X + 2 * LABEL_OFFSET, PARTITIONING_Y, TEXTBOX_WIDTH);
+	Label& quad_looseness_label = gui.add<Label>("Looseness (1 = not loose)", PARAM_X + 2 * LABEL_OFFSET, PARTITIONING_Y - 50, 12);
 
 	// Grid settings
 	TextBox& grid_nodes_per_row_input = gui.add<TextBox>("10", PARAM_X, PARTITIONING_Y, TEXTBOX_WIDTH);
 	Label& grid_label = gui.add<Label>("Nodes per row", PARAM_X, PARTITIONING_Y - 50, 12);
 
+	// Neighbour list settings, which apply to any partitioning.
+	CheckBox& neighbour_lists_checkbox = gui.add<CheckBox>("Keep collision candidates between ticks (neighbour lists)", PARTITIONING_X, PARTITIONING_Y + 80, 20.0f);
+	TextBox& neighbour_skin_input = gui.add<TextBox>(PARAM_X + LABEL_OFFSET, PARTITIONING_Y + 80, TEXTBOX_WIDTH);
+	Label& neighbour_skin_label = gui.add<Label>("Skin distance", PARAM_X + LABEL_OFFSET, PARTITIONING_Y + 50, 12);
+
+	// Rewind buffer settings, in one row of half width boxes under the partitioning settings.
+	static constexpr float REWIND_Y = PARTITIONING_Y + 160;
+	static constexpr float REWIND_WIDTH = TEXTBOX_WIDTH / 2 - 10;
+	TextBox& rewind_every_input = gui.add<TextBox>(PARTITIONING_X, REWIND_Y, REWIND_WIDTH);
+	TextBox& rewind_memory_input = gui.add<TextBox>(PARTITIONING_X + TEXTBOX_WIDTH / 2, REWIND_Y, REWIND_WIDTH);
+	Label& rewind_every_label = gui.add<Label>("Rewind keyframe every (ticks)", PARTITIONING_X, REWIND_Y - 30, 12);
+	Label& rewind_memory_label = gui.add<Label>("Rewind memory (MiB)", PARTITIONING_X + TEXTBOX_WIDTH / 2, REWIND_Y - 30, 12);
+
 	Label& error_msg = gui.add<Label>("", BUTTON_X, BUTTON_Y - 30, 20, RED);
 
 
@@ -128,8 +157,11 @@ class SettingsScene : public GuiScene
 	// Set gui elements to reflect the current universe settings.
 	void read_settings_to_gui(const SettingsState& settings);
 
-	// Creates and returns the selected partitioning method.
-	std::unique_ptr<SpatialPartitioning> gen_partitioning();
+	// Creates and returns the selected partitioning method, sized for the universe settings.
+	std::unique_ptr<SpatialPartitioning> gen_partitioning(const UniverseSettings& universe);
+
+	// Shows the error message under the buttons.
+	void show_error(const std::string& error_text);
 
 	// Handles any semantic user input errors by setting the error message.
 	// Returns true if there was an error, else false.
@@ -1,17 +1,34 @@
 #pragma once
 #include "UniverseSettings.h"
+#include "RewindBuffer.h"
 
 // Universe settings as well as other settings needed to restore settings scene.
 struct SettingsState
 {
+	// File the simulation saves checkpoints to, and the settings scene resumes from.
+	static constexpr const char* CHECKPOINT_PATH = "checkpoint.planets";
+
+	// File the simulation records trajectories to.
+	static constexpr const char* TRAJECTORY_PATH = "trajectory.planets";
+
 	UniverseSettings universe;
 
+	// Rate the simulation thread updates the universe at, independent of the frame rate. 0 = as fast as possible.
+	int ticks_per_second = 60;
+
+	// Time each step of the simulation thread may tick for with the step budget time warp, in milliseconds.
+	float step_budget_ms = 12.0f;
+
+	// How often the simulation keyframes the universe to rewind to, and how much memory the keyframes may take up.
+	RewindBuffer::Settings rewind;
+
 	std::string partitioning_selected = "None";
 
 	struct
 	{
 		int max_bodies = 10;
 		int max_depth = 10;
+		float looseness = 1.0f;
 	} quadtree;
 
 	struct
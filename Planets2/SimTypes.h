@@ -0,0 +1,97 @@
+#pragma once
+
+// The plain data types and vector math the simulation core uses.
+//
+// In the windowed build these come from raylib, so bodies can be handed to its drawing functions as they are.
+// When PLANETS_HEADLESS is defined, the core is built without raylib: the types are defined here with the same layout,
+// along with the colors planet types use and the few raymath functions the core calls, with raymath's semantics.
+
+#ifndef PLANETS_HEADLESS
+
+#include <raylib.h>
+#include <raymath.h>
+
+#else
+
+#include <cmath>
+
+struct Vector2
+{
+	float x;
+	float y;
+};
+
+struct Rectangle
+{
+	float x;
+	float y;
+	float width;
+	float height;
+};
+
+struct Color
+{
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+#define LIGHTGRAY  Color{ 200, 200, 200, 255 }
+#define DARKGRAY   Color{ 80, 80, 80, 255 }
+#define GOLD       Color{ 255, 203, 0, 255 }
+#define ORANGE     Color{ 255, 161, 0, 255 }
+#define SKYBLUE    Color{ 102, 191, 255, 255 }
+#define BLUE       Color{ 0, 121, 241, 255 }
+#define DARKBLUE   Color{ 0, 82, 172, 255 }
+#define RAYWHITE   Color{ 245, 245, 245, 255 }
+
+inline Vector2 Vector2Zero()
+{
+	return Vector2{ 0.0f, 0.0f };
+}
+
+inline Vector2 Vector2Add(Vector2 v1, Vector2 v2)
+{
+	return Vector2{ v1.x + v2.x, v1.y + v2.y };
+}
+
+inline Vector2 Vector2Subtract(Vector2 v1, Vector2 v2)
+{
+	return Vector2{ v1.x - v2.x, v1.y - v2.y };
+}
+
+inline Vector2 Vector2Scale(Vector2 v, float scale)
+{
+	return Vector2{ v.x * scale, v.y * scale };
+}
+
+inline float Vector2Length(Vector2 v)
+{
+	return std::sqrt(v.x * v.x + v.y * v.y);
+}
+
+inline float Vector2LengthSqr(Vector2 v)
+{
+	return v.x * v.x + v.y * v.y;
+}
+
+inline float Vector2DotProduct(Vector2 v1, Vector2 v2)
+{
+	return v1.x * v2.x + v1.y * v2.y;
+}
+
+// Rotates the vector by the angle, in radians.
+inline Vector2 Vector2Rotate(Vector2 v, float angle)
+{
+	float cos_angle = std::cos(angle);
+	float sin_angle = std::sin(angle);
+	return Vector2{ v.x * cos_angle - v.y * sin_angle, v.x * sin_angle + v.y * cos_angle };
+}
+
+inline Vector2 Vector2Lerp(Vector2 v1, Vector2 v2, float amount)
+{
+	return Vector2{ v1.x + amount * (v2.x - v1.x), v1.y + amount * (v2.y - v1.y) };
+}
+
+#endif
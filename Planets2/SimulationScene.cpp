@@ -14,17 +14,29 @@
 #include "RenderUtil.h"
 #include "Removal.h"
 #include "Orbit.h"
+#include <cstdio>
 
 // enables using suffixes for seconds, milliseconds, etc.
 using namespace std::chrono_literals;
 
 SimulationScene::SimulationScene(const SettingsState& settings, std::unique_ptr<SpatialPartitioning>&& partitioning)
-	: universe(settings.universe, std::move(partitioning)), settings_state(settings)
+	: simulation(settings.universe, std::move(partitioning), settings.ticks_per_second, settings.step_budget_ms, settings.rewind), settings_state(settings)
+{
+	setup();
+}
+
+SimulationScene::SimulationScene(const SettingsState& settings, const CheckpointFile& checkpoint, std::unique_ptr<SpatialPartitioning>&& partitioning)
+	: simulation(checkpoint, std::move(partitioning), settings.ticks_per_second, settings.step_budget_ms, settings.rewind), settings_state(settings)
+{
+	setup();
+}
+
+void SimulationScene::setup()
 {
 	camera_state = std::make_unique<FreeCamera>(starting_config);
 	interaction_state = std::make_unique<DefaultInteraction>();
 
-	on_screen_bodies.reserve(universe.get_settings().universe_capacity);
+	on_screen_bodies.reserve(simulation.get_settings().universe_capacity);
 
 	gui.hide(help_message);
 	gui.hide(tick_info_label);
@@ -35,22 +47,25 @@ SimulationScene::SimulationScene(const SettingsState& settings, std::unique_ptr<
 
 	prompt_time = std::chrono::system_clock::now();
 
-	listener = universe.removal_event().add_observer([this](const Removal& e)
+	listener = simulation.removal_event().add_observer([this](RemovalBatch removals)
 	{
-		int removed_id = e.removed;
-		if (removed_id == orbit_central)
-		{
-			orbit_central = -1;
-			orbit_projections.clear();
-		}
-		else
+		for (const Removal& e : removals)
 		{
-			auto it = std::ranges::find_if(orbit_projections, [removed_id](const auto& p) { return p.first == removed_id; });
-
-			if (it != orbit_projections.end())
+			int removed_id = e.removed;
+			if (removed_id == orbit_central)
 			{
-				std::swap(*it, orbit_projections.back());
-				orbit_projections.pop_back();
+				orbit_central = -1;
+				orbit_projections.clear();
+			}
+			else
+			{
+				auto it = std::ranges::find_if(orbit_projections, [removed_id](const auto& p) { return p.first == removed_id; });
+
+				if (it != orbit_projections.end())
+				{
+					std::swap(*it, orbit_projections.back());
+					orbit_projections.pop_back();
+				}
 			}
 		}
 	});
@@ -64,7 +79,7 @@ void SimulationScene::process_input()
 	// So there can be input conflicts
 
 	// Basic user interaction handling (non-camera).
-	InteractionState* next_interaction_state = interaction_state->process_input(*camera_state, universe);
+	InteractionState* next_interaction_state = interaction_state->process_input(*camera_state, simulation);
 
 	// State change.
 	if (next_interaction_state != interaction_state.get()) {
@@ -75,6 +90,8 @@ void SimulationScene::process_input()
 		interaction_title.set_text(interaction_state->get_name());
 	}
 
+	const UniverseSnapshot& universe = simulation.get_snapshot();
+
 	if (IsKeyPressed(KEY_O))
 	{
 		Vector2 screen_pos = GetMousePosition();
@@ -115,6 +132,7 @@ void SimulationScene::process_input()
 	// Toggles
 	if (IsKeyPressed(KEY_B)) {
 		should_render_partitioning = !should_render_partitioning;
+		simulation.request_representation(should_render_partitioning);
 	}
 
 	if (IsKeyPressed(KEY_N))
@@ -154,7 +172,34 @@ void SimulationScene::process_input()
 	}
 
 	if (IsKeyPressed(KEY_SPACE)) {
-		running = !running;
+		simulation.set_running(!simulation.is_running());
+	}
+
+	if (IsKeyPressed(KEY_T)) {
+		int next_warp = (static_cast<int>(simulation.get_time_warp()) + 1) % SimulationThread::NUM_TIME_WARPS;
+		simulation.set_time_warp(static_cast<SimulationThread::TimeWarp>(next_warp));
+	}
+
+	if (IsKeyPressed(KEY_K)) {
+		simulation.save_checkpoint(SettingsState::CHECKPOINT_PATH);
+	}
+
+	if (IsKeyPressed(KEY_L)) {
+		if (simulation.is_recording()) {
+			simulation.stop_recording();
+		}
+		else {
+			simulation.start_recording(SettingsState::TRAJECTORY_PATH, {});
+		}
+	}
+
+	if (IsKeyPressed(KEY_Z)) {
+		simulation.step_back();
+	}
+
+	// Rewinds by a second of ticks at the tick rate the settings ask for.
+	if (IsKeyPressed(KEY_X)) {
+		simulation.rewind(settings_state.ticks_per_second > 0 ? settings_state.ticks_per_second : 60);
 	}
 
 	// Exiting to settings
@@ -170,6 +215,7 @@ void SimulationScene::process_input()
 
 void SimulationScene::update_orbit_projections()
 {
+	const UniverseSnapshot& universe = simulation.get_snapshot();
 	const Body& central = *universe.get_body(orbit_central);
 	for (auto& [sat_id, op] : orbit_projections)
 	{
@@ -194,14 +240,18 @@ void SimulationScene::attach_debug_info()
 	};
 
 	if (should_render_partitioning) {
-		const SpatialPartitioning& partitioning = universe.get_partitioning();
+		const UniverseSnapshot& universe = simulation.get_snapshot();
 
 		for (int i = 0; i < on_screen_bodies.size(); ++i) {
 			const Body& body = *on_screen_bodies[i];
 			DebugInfo& info = body_info[i];
 
 			attach_body_info(body, info);
-			partitioning.get_info(body, info);
+
+			// Info is captured by the simulation thread for bodies that were on screen, so a body that just came into view may have none yet.
+			if (const DebugInfo* partitioning_info = universe.get_partitioning_info(body.get_id())) {
+				info.add(partitioning_info->get());
+			}
 
 		}
 	}
@@ -226,6 +276,8 @@ void SimulationScene::render_debug_text() const {
 
 void SimulationScene::render_screen_info()
 {
+	const UniverseSnapshot& universe = simulation.get_snapshot();
+
 	// Draw fps approximation in the upper left corner.
 	DrawFPS(50, 50);
 
@@ -236,8 +288,58 @@ void SimulationScene::render_screen_info()
 	// Render the tick and collision statistics below the number bodies display.
 	if (tick_info_label.is_visible()) {
 		std::string tick_info = "Tick " + std::to_string(universe.get_tick()) + "\n";
+		tick_info += "Time warp: " + std::string(SimulationThread::get_name(simulation.get_time_warp()))
+			+ " (" + std::to_string(static_cast<int>(measured_ticks_per_second)) + " ticks/s)\n";
 		tick_info += "Collision checks (tick) : " + std::to_string(universe.get_num_collision_checks_tick()) + "\n";
 		tick_info += "Collision checks (total): " + std::to_string(universe.get_num_collision_checks());
+
+		switch (simulation.get_save_status()) {
+		case SimulationThread::SaveStatus::SAVING:
+			tick_info += "\nSaving checkpoint...";
+			break;
+		case SimulationThread::SaveStatus::SAVED:
+			tick_info += "\nCheckpoint saved to " + std::string(SettingsState::CHECKPOINT_PATH);
+			break;
+		case SimulationThread::SaveStatus::FAILED:
+			tick_info += "\nCheckpoint could not be saved";
+			break;
+		case SimulationThread::SaveStatus::NONE:
+			break;
+		}
+
+		if (const TrajectoryRecorder::Stats* recording = universe.get_recording()) {
+			char recording_info[128];
+			if (recording->failed) {
+				std::snprintf(recording_info, sizeof(recording_info), "\nRecording could not be written to %s", SettingsState::TRAJECTORY_PATH);
+			}
+			else {
+				std::snprintf(recording_info, sizeof(recording_info), "\nRecording: %lld frames (%lld dropped), %.1fx compression, %.0f frames/s",
+					recording->frames_written, recording->frames_dropped, recording->compression_ratio(), recording->frames_per_second());
+			}
+			tick_info += recording_info;
+		}
+
+		if (const RewindBuffer::Stats* rewind = universe.get_rewind()) {
+			char rewind_info[128];
+			std::snprintf(rewind_info, sizeof(rewind_info), "\nRewind: %d keyframes from tick %d to %d, %.1f MiB, %.1fx compression",
+				rewind->num_keyframes, rewind->first_tick, rewind->last_tick, rewind->compressed_bytes / (1024.0 * 1024.0), rewind->compression_ratio());
+			tick_info += rewind_info;
+		}
+
+		if (universe.get_settings().continuous_collisions) {
+			tick_info += "\nSwept collisions (total): " + std::to_string(universe.get_num_swept_collisions());
+		}
+
+		if (const std::string* tuned = universe.get_tuned_partitioning()) {
+			tick_info += "\nPartitioning (auto tuned): " + *tuned;
+		}
+
+		if (const UniverseSnapshot::NeighbourListStats* lists = universe.get_neighbour_lists()) {
+			char list_info[96];
+			std::snprintf(list_info, sizeof(list_info), "\nNeighbour lists: %d pairs, %zu KiB, rebuilt every %.1f ticks",
+				lists->num_pairs, lists->memory_bytes / 1024, lists->updates_per_rebuild);
+			tick_info += list_info;
+		}
 		
 		tick_info_label.set_text(tick_info);
 	}
@@ -259,10 +361,17 @@ void SimulationScene::render_screen_info()
 	gui.render();
 }
 
+void SimulationScene::log_tuning()
+{
+	for (const std::string& entry : simulation.get_new_tuning_log())
+	{
+		TraceLog(LOG_INFO, "PARTITIONING: %s", entry.c_str());
+	}
+}
+
 void SimulationScene::render_partitioning() const
 {
-	const SpatialPartitioning& partitioning = universe.get_partitioning();
-	std::vector<Rectangle> rep = partitioning.get_representation();
+	const std::vector<Rectangle>& rep = simulation.get_snapshot().get_partitioning_representation();
 
 	// When zoomed out, there is often a visual glitch, especially when line thickness is lowered.
 	// I'm not sure how to fix it.
@@ -324,19 +433,38 @@ void SimulationScene::render_orbit_projections()
 
 Scene* SimulationScene::update()
 {
+	// The universe updates on its own thread, so there may be zero or several new ticks since the last frame.
+	// Removal observers are notified here, before anything reads the new snapshot.
+	if (simulation.acquire_snapshot())
+	{
+		log_tuning();
+	}
+
+	// Bodies are moved between the last two published snapshots before anything reads them, so rendering, picking,
+	// orbit projections and the anchored camera all see the same positions.
+	simulation.interpolate_snapshot();
+
+	// The tick rate is sampled about once a second, since with time warp a frame can see anywhere from zero to thousands of ticks.
+	auto cur_time = std::chrono::steady_clock::now();
+	std::chrono::duration<float> sample_seconds = cur_time - tick_rate_sample_time;
+	if (sample_seconds > 1s)
+	{
+		int cur_tick = simulation.get_snapshot().get_tick();
+		measured_ticks_per_second = (cur_tick - tick_rate_sample_tick) / sample_seconds.count();
+		tick_rate_sample_tick = cur_tick;
+		tick_rate_sample_time = cur_time;
+	}
+
 	process_input();
 
-	if (running)
+	// Orbit projections point into the snapshot they were made from, so they are remade from the current one every frame.
+	if (orbit_central != -1)
 	{
-		universe.update();
-		if (orbit_central != -1)
-		{
-			update_orbit_projections();
-		}
+		update_orbit_projections();
 	}
 
 	// Handle input related to the camera.
-	CameraState* next_camera_state = camera_state->update(universe);
+	CameraState* next_camera_state = camera_state->update(simulation.get_snapshot(), simulation.removal_event());
 	if (camera_state.get() != next_camera_state)
 	{
 		camera_state.reset(next_camera_state);
@@ -344,7 +472,17 @@ Scene* SimulationScene::update()
 
 	// Camera may have moved, or universe updated.
 	// Need to get a new list of bodies that are on screen.
-	on_screen_bodies = universe.get_bodies_in_area(camera_state->get_view());
+	on_screen_bodies = simulation.get_snapshot().get_bodies_in_area(camera_state->get_view());
+
+	// Partitioning info is only captured for the bodies that are likely to still be on screen when the next snapshot is read.
+	if (should_render_debug_text and should_render_partitioning)
+	{
+		simulation.request_partitioning_info(camera_state->get_view());
+	}
+	else
+	{
+		simulation.request_partitioning_info(std::nullopt);
+	}
 
 	BeginDrawing();
 		ClearBackground(BLACK);
@@ -387,7 +525,7 @@ Scene* SimulationScene::update()
 				}
 
 				// Allow interaction state to render any state-specific world elements.
-				interaction_state->render_world(camera_state->get_camera(), universe);
+				interaction_state->render_world(camera_state->get_camera(), simulation.get_snapshot());
 
 			EndMode2D();
 
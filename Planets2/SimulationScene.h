@@ -1,7 +1,7 @@
 #pragma once
 #include "Scene.h"
 
-#include "Universe.h"
+#include "SimulationThread.h"
 #include "AdvCamera.h"
 #include <span>
 #include <chrono>
@@ -13,19 +13,20 @@
 #include "SettingsState.h"
 #include "Event.h"
 #include "OrbitProjection.h"
-
-struct Removal;
+#include "Removal.h"
 
 class CameraState;
 class Body;
+class CheckpointFile;
 class InteractionState;
 
 // This scene handles user interaction during the simulation and rendering of the simulation universe.
 class SimulationScene : public Scene
 {
 
-	// The universe being simulated.
-	Universe universe;
+	// Updates the universe being simulated on its own thread.
+	// Declared first, so everything observing it is destroyed before it is.
+	SimulationThread simulation;
 
 	// Copy of settings state, to restore settings scene when transition.
 	SettingsState settings_state;
@@ -40,13 +41,10 @@ class SimulationScene : public Scene
 	std::unique_ptr<InteractionState> interaction_state;
 
 	// User-toggleable variables.
-	
-	// Whether the simulation is currently running.
-	bool running = false;
 
 	GuiComponentList gui;
 
-	// Whether to render the tick number and collision statistics.
+	// Whether to render the tick number, time warp, collision statistics, swept collisions, the auto tuned partitioning and neighbour list statistics.
 	Label& tick_info_label = gui.add<Label>("_", 50.0f, 95.0f, 20, RAYWHITE);
 	Label& num_bodies_label = gui.add<Label>("_", 50.0f, 70.0f, 20, RAYWHITE);
 
@@ -63,7 +61,7 @@ class SimulationScene : public Scene
 	// Default help text.
 	const std::string default_help_text = "[H] to close help text\n";
 
-	EventHandle<Removal> listener;
+	EventHandle<RemovalBatch> listener;
 	int orbit_central = -1;
 
 	std::vector<std::pair<int, OrbitProjection>> orbit_projections;
@@ -73,8 +71,13 @@ class SimulationScene : public Scene
 	// Time when help prompt text was first displayed.
 	std::chrono::system_clock::time_point prompt_time;
 
+	// Ticks per second the simulation thread reached over the last sample, and the tick and time the sample started at.
+	float measured_ticks_per_second = 0.0f;
+	int tick_rate_sample_tick = 0;
+	std::chrono::steady_clock::time_point tick_rate_sample_time = std::chrono::steady_clock::now();
+
 	// A vector of pointers to all bodies that are currently on screen.
-	std::vector<Body*> on_screen_bodies;
+	std::vector<const Body*> on_screen_bodies;
 
 	// Information about all on screen bodies.
 	std::vector<DebugInfo> body_info;
@@ -86,6 +89,9 @@ class SimulationScene : public Scene
 	Label& interaction_title = gui.add<Label>( "_", 0.0f, 0.0f, 20, RAYWHITE );
 	Label& help_message = gui.add<Label>( default_help_text, 0.0f, 0.0f, 20, RAYWHITE);
 
+	// Sets up cameras, labels and removal handling. Shared by the constructors.
+	void setup();
+
 	// Handles all user input.
 	void process_input();
 
@@ -103,6 +109,9 @@ class SimulationScene : public Scene
 	// Handles rendering of universe's collision detection partitioning method.
 	void render_partitioning() const;
 
+	// Writes the trials and swaps of the universe's partitioning tuner that the latest snapshot brought to the console.
+	void log_tuning();
+
 	// Handles rendering of any information that has a simple screen position, as opposed to a place in the universe.
 	void render_screen_info();
 
@@ -121,7 +130,10 @@ public:
 
 	SimulationScene(const SettingsState& settings, std::unique_ptr<SpatialPartitioning>&& partitioning);
 
-	// Handles all user input, updates and renders the universe, and then renders any additional scene items.
+	// Resumes the universe saved in the checkpoint, which settings.universe should match.
+	SimulationScene(const SettingsState& settings, const CheckpointFile& checkpoint, std::unique_ptr<SpatialPartitioning>&& partitioning);
+
+	// Handles all user input, takes the latest snapshot of the universe and renders it, and then renders any additional scene items.
 	Scene* update() override;
 	
 	// Adjusts any elements that rely on screensize.
@@ -0,0 +1,381 @@
+#include "SimulationThread.h"
+#include "MyRandom.h"
+#include <iterator>
+
+using namespace std::chrono_literals;
+
+SimulationThread::SimulationThread(const UniverseSettings& settings, std::unique_ptr<SpatialPartitioning>&& partitioning, int ticks_per_second, float step_budget_ms,
+    const RewindBuffer::Settings& rewind_settings)
+    : universe(settings, std::move(partitioning)),
+    step_interval(ticks_per_second > 0 ? std::chrono::nanoseconds(1s) / ticks_per_second : 0ns),
+    step_budget(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<float, std::milli>(step_budget_ms))),
+    rewind_buffer(rewind_settings)
+{
+    start();
+}
+
+SimulationThread::SimulationThread(const CheckpointFile& checkpoint, std::unique_ptr<SpatialPartitioning>&& partitioning, int ticks_per_second, float step_budget_ms,
+    const RewindBuffer::Settings& rewind_settings)
+    : universe(checkpoint, std::move(partitioning)),
+    step_interval(ticks_per_second > 0 ? std::chrono::nanoseconds(1s) / ticks_per_second : 0ns),
+    step_budget(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<float, std::milli>(step_budget_ms))),
+    rewind_buffer(rewind_settings)
+{
+    start();
+}
+
+void SimulationThread::start()
+{
+    universe_listener = universe.removal_event().add_observer([this](RemovalBatch removals) {
+        std::ranges::copy(removals, std::back_inserter(undelivered_removals));
+    });
+
+    rewind_buffer.record(universe);
+
+    // The render thread has something to read before the first tick is published.
+    snapshots[front].capture(universe, false, std::nullopt);
+
+    thread = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+void SimulationThread::run(std::stop_token stop)
+{
+    auto next_step = std::chrono::steady_clock::now();
+
+    while (!stop.stop_requested()) {
+        apply_commands();
+
+        if (running.load(std::memory_order_relaxed)) {
+            step(stop);
+            publish();
+
+            if (step_interval > 0ns) {
+                // A step that ran late isn't caught up on, so a slow stretch doesn't end with a burst of steps.
+                next_step = std::max(next_step + step_interval, std::chrono::steady_clock::now());
+                std::this_thread::sleep_until(next_step);
+            }
+        }
+        else {
+            // Commands and capture requests still show up while paused.
+            publish();
+            std::this_thread::sleep_for(PAUSED_POLL);
+            next_step = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void SimulationThread::step(std::stop_token stop)
+{
+    auto should_stop = [this, &stop]() {
+        return stop.stop_requested() or !running.load(std::memory_order_relaxed);
+    };
+
+    TimeWarp warp = time_warp.load(std::memory_order_relaxed);
+
+    if (warp == TimeWarp::MAX or warp == TimeWarp::BUDGET) {
+        std::chrono::nanoseconds budget = step_budget;
+        if (warp == TimeWarp::MAX) {
+            budget = step_interval > 0ns ? step_interval : std::chrono::nanoseconds(MAX_STEP_TIME);
+        }
+
+        // At least one tick runs, even if a single tick takes longer than the budget.
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        do {
+            tick();
+        } while (std::chrono::steady_clock::now() < deadline and !should_stop());
+
+        return;
+    }
+
+    int num_ticks = warp == TimeWarp::X100 ? 100 : warp == TimeWarp::X10 ? 10 : 1;
+    for (int i = 0; i < num_ticks and (i == 0 or !should_stop()); i++) {
+        tick();
+    }
+}
+
+void SimulationThread::tick()
+{
+    universe.update();
+    rewind_buffer.record(universe);
+
+    if (recorder) {
+        recorder->record(universe);
+    }
+}
+
+void SimulationThread::apply_commands()
+{
+    while (std::optional<Command> command = commands.try_pop()) {
+        (*command)(universe);
+    }
+}
+
+void SimulationThread::publish()
+{
+    UniverseSnapshot& snapshot = snapshots[back];
+
+    std::optional<Rectangle> area;
+    if (capture_info.load(std::memory_order_relaxed)) {
+        area = info_area.load(std::memory_order_relaxed);
+    }
+
+    snapshot.capture(universe, capture_representation.load(std::memory_order_relaxed), area);
+
+    auto now = std::chrono::steady_clock::now();
+    snapshot.set_published(now, now - last_published);
+    last_published = now;
+
+    // Removals the render thread has been given are no longer needed.
+    // Any given after this load are carried again, and skipped by the render thread.
+    long long delivered = removals_delivered.load(std::memory_order_acquire);
+    for (; first_undelivered < delivered; first_undelivered++) {
+        undelivered_removals.pop_front();
+    }
+
+    snapshot.set_removals(undelivered_removals, first_undelivered);
+    snapshot.set_prev_positions(published_positions, snapshot.get_removals_since(removals_published));
+    removals_published = snapshot.get_removals_end();
+
+    if (pending_save.valid() and pending_save.wait_for(0s) == std::future_status::ready) {
+        save_status.store(pending_save.get() ? SaveStatus::SAVED : SaveStatus::FAILED, std::memory_order_relaxed);
+    }
+
+    snapshot.set_recording(recorder ? std::optional(recorder->get_stats()) : std::nullopt);
+    snapshot.set_rewind(rewind_buffer.get_stats());
+
+    // The tuner keeps its whole log, so only the position of the first undelivered entry is needed.
+    if (const PartitioningTuner* tuner = universe.get_tuner()) {
+        int first_entry = tuning_entries_delivered.load(std::memory_order_acquire);
+        snapshot.set_tuning_log(std::span(tuner->get_log()).subspan(first_entry), first_entry);
+    }
+
+    back = latest.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+bool SimulationThread::acquire_snapshot()
+{
+    if (!(latest.load(std::memory_order_acquire) & FRESH)) {
+        return false;
+    }
+
+    front = latest.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+    const UniverseSnapshot& snapshot = snapshots[front];
+
+    new_tuning_entries = snapshot.get_tuning_log_since(tuning_entries_delivered.load(std::memory_order_relaxed));
+    tuning_entries_delivered.store(snapshot.get_tuning_log_end(), std::memory_order_release);
+
+    RemovalBatch removals = snapshot.get_removals_since(removals_delivered.load(std::memory_order_relaxed));
+    removals_delivered.store(snapshot.get_removals_end(), std::memory_order_release);
+
+    if (!removals.empty()) {
+        on_removal_observers.notify_all(removals);
+    }
+
+    return true;
+}
+
+const UniverseSnapshot& SimulationThread::get_snapshot() const
+{
+    return snapshots[front];
+}
+
+void SimulationThread::interpolate_snapshot()
+{
+    snapshots[front].interpolate(std::chrono::steady_clock::now());
+}
+
+std::span<const std::string> SimulationThread::get_new_tuning_log() const
+{
+    return new_tuning_entries;
+}
+
+Event<RemovalBatch>& SimulationThread::removal_event()
+{
+    return on_removal_observers;
+}
+
+bool SimulationThread::submit(Command command)
+{
+    return commands.try_push(std::move(command));
+}
+
+bool SimulationThread::edit(Command change)
+{
+    return submit([this, change = std::move(change)](Universe& universe) {
+        rewind_buffer.edit(universe, change);
+    });
+}
+
+void SimulationThread::add_body(Body&& body)
+{
+    edit([body = std::move(body)](Universe& universe) mutable {
+        universe.add_body(std::move(body));
+    });
+}
+
+void SimulationThread::add_bodies(std::vector<Body>&& bodies)
+{
+    edit([bodies = std::move(bodies)](Universe& universe) mutable {
+        universe.add_bodies(std::move(bodies));
+    });
+}
+
+void SimulationThread::rem_body(int id)
+{
+    edit([id](Universe& universe) {
+        if (Body* body = universe.get_body(id)) {
+            universe.rem_body(*body);
+        }
+    });
+}
+
+std::vector<Body> SimulationThread::generate_rand_system(float x, float y)
+{
+    return universe.generate_rand_system(x, y);
+}
+
+void SimulationThread::set_running(bool to_set)
+{
+    running.store(to_set, std::memory_order_relaxed);
+}
+
+bool SimulationThread::is_running() const
+{
+    return running.load(std::memory_order_relaxed);
+}
+
+void SimulationThread::set_time_warp(TimeWarp to_set)
+{
+    time_warp.store(to_set, std::memory_order_relaxed);
+}
+
+SimulationThread::TimeWarp SimulationThread::get_time_warp() const
+{
+    return time_warp.load(std::memory_order_relaxed);
+}
+
+std::string_view SimulationThread::get_name(TimeWarp warp)
+{
+    switch (warp) {
+    case TimeWarp::X1:
+        return "1x";
+    case TimeWarp::X10:
+        return "10x";
+    case TimeWarp::X100:
+        return "100x";
+    case TimeWarp::MAX:
+        return "max";
+    case TimeWarp::BUDGET:
+        return "step budget";
+    }
+
+    return "";
+}
+
+bool SimulationThread::save_checkpoint(std::filesystem::path path)
+{
+    if (save_status.load(std::memory_order_relaxed) == SaveStatus::SAVING) {
+        return false;
+    }
+
+    save_status.store(SaveStatus::SAVING, std::memory_order_relaxed);
+
+    // Systems are generated with the render thread's random engine, so its state is the one saved.
+    // The simulation thread's engine is never drawn from, since ticks don't use random numbers.
+    bool submitted = submit([this, path = std::move(path), rng_state = Rand::get_state()](Universe& universe) mutable {
+        pending_save = Checkpoint::save_async(Checkpoint::capture(universe, std::move(rng_state)), std::move(path));
+    });
+
+    if (!submitted) {
+        save_status.store(SaveStatus::FAILED, std::memory_order_relaxed);
+    }
+
+    return submitted;
+}
+
+SimulationThread::SaveStatus SimulationThread::get_save_status() const
+{
+    return save_status.load(std::memory_order_relaxed);
+}
+
+bool SimulationThread::start_recording(std::filesystem::path path, const TrajectoryRecorder::Settings& settings)
+{
+    // The recorder is created on the simulation thread, which records to it and listens for removals through it.
+    bool submitted = submit([this, path = std::move(path), settings](Universe& universe) {
+        recorder.reset();
+        recorder = std::make_unique<TrajectoryRecorder>(path, universe, settings);
+        recorder->record(universe);
+    });
+
+    if (submitted) {
+        recording.store(true, std::memory_order_relaxed);
+    }
+
+    return submitted;
+}
+
+bool SimulationThread::stop_recording()
+{
+    // Finishing the file waits for the writer to catch up, which only holds up ticks when it was already behind.
+    bool submitted = submit([this](Universe&) {
+        recorder.reset();
+    });
+
+    if (submitted) {
+        recording.store(false, std::memory_order_relaxed);
+    }
+
+    return submitted;
+}
+
+bool SimulationThread::is_recording() const
+{
+    return recording.load(std::memory_order_relaxed);
+}
+
+bool SimulationThread::submit_rewind(Command rewind)
+{
+    if (is_recording() and !stop_recording()) {
+        return false;
+    }
+
+    return submit([this, rewind = std::move(rewind)](Universe& universe) {
+        rewind(universe);
+
+        // Positions published before the rewind aren't where bodies are coming from.
+        published_positions.clear();
+    });
+}
+
+bool SimulationThread::rewind(int ticks)
+{
+    return submit_rewind([this, ticks](Universe& universe) {
+        rewind_buffer.rewind(universe, universe.get_tick() - ticks);
+    });
+}
+
+bool SimulationThread::step_back()
+{
+    return submit_rewind([this](Universe& universe) {
+        rewind_buffer.step_back(universe);
+    });
+}
+
+void SimulationThread::request_representation(bool to_capture)
+{
+    capture_representation.store(to_capture, std::memory_order_relaxed);
+}
+
+void SimulationThread::request_partitioning_info(std::optional<Rectangle> area)
+{
+    if (area) {
+        info_area.store(*area, std::memory_order_relaxed);
+    }
+
+    capture_info.store(area.has_value(), std::memory_order_relaxed);
+}
+
+const UniverseSettings& SimulationThread::get_settings() const
+{
+    return universe.get_settings();
+}
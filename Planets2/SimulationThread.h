@@ -0,0 +1,280 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <span>
+#include <string_view>
+#include "Universe.h"
+#include "UniverseSnapshot.h"
+#include "SpscQueue.h"
+#include "Event.h"
+#include "Removal.h"
+#include "Checkpoint.h"
+#include "TrajectoryRecorder.h"
+#include "RewindBuffer.h"
+
+/*
+* Updates a universe on its own thread, so ticks don't wait on rendering and rendering doesn't wait on ticks.
+*
+* The simulation thread updates the universe in steps of one or more ticks, set by the time warp,
+* and publishes a snapshot of the universe after every step. Ticks in between aren't captured.
+* The render thread interpolates body positions between the last two published snapshots, so it can render smoothly between steps.
+* Snapshots are triple buffered: the simulation thread captures into one, the render thread reads another,
+* and the third holds the latest published snapshot, which the render thread swaps for its own when it wants a newer one.
+* Neither thread ever waits on the other.
+*
+* Removals and tuner log entries are kept by the simulation thread until the render thread reports it has been given them,
+* so every snapshot carries all the events that led to its state, even if the render thread skipped the snapshots before it.
+*
+* Anything that changes the universe is submitted as a command through a lock-free queue,
+* and the simulation thread applies the commands between ticks.
+* Keyframes of the universe are kept in a rewind buffer, so it can be rewound, and bodies added or removed can be undone.
+*
+* Every method except the constructor is called by the render thread.
+*/
+class SimulationThread
+{
+
+public:
+
+	// A change to the universe, applied between ticks.
+	using Command = std::function<void(Universe&)>;
+
+	// Number of ticks per step.
+	enum class TimeWarp
+	{
+		X1,
+		X10,
+		X100,
+		// As many ticks as fit in the time until the next step, or in MAX_STEP_TIME if the tick rate is uncapped.
+		MAX,
+		// As many ticks as fit in the step budget, leaving the rest of the time until the next step idle.
+		BUDGET
+	};
+
+	// Number of time warp modes, for cycling through them.
+	static constexpr int NUM_TIME_WARPS = 5;
+
+	// Progress of the latest checkpoint save.
+	enum class SaveStatus
+	{
+		NONE,
+		SAVING,
+		SAVED,
+		FAILED
+	};
+
+private:
+
+	// Maximum number of commands waiting to be applied.
+	static constexpr size_t COMMAND_CAPACITY = 1024;
+
+	// How long the simulation thread waits between checking for commands while paused.
+	static constexpr std::chrono::milliseconds PAUSED_POLL { 10 };
+
+	// Length of a step at maximum time warp when the tick rate is uncapped, so snapshots still come about once a frame.
+	static constexpr std::chrono::milliseconds MAX_STEP_TIME { 16 };
+
+	// Index bits of latest, and the bit set while the latest snapshot hasn't been taken by the render thread.
+	static constexpr int INDEX_MASK = 0b011;
+	static constexpr int FRESH = 0b100;
+
+	// Only touched by the simulation thread once it has started.
+	Universe universe;
+
+	// Time between steps, or zero to step as fast as possible.
+	std::chrono::nanoseconds step_interval;
+
+	// Time a step may tick for with the BUDGET time warp.
+	std::chrono::nanoseconds step_budget;
+
+	std::atomic<bool> running = false;
+	std::atomic<TimeWarp> time_warp = TimeWarp::X1;
+
+	SpscQueue<Command> commands { COMMAND_CAPACITY };
+
+	std::array<UniverseSnapshot, 3> snapshots;
+
+	// Index of the latest published snapshot, with FRESH set if it hasn't been taken yet.
+	std::atomic<int> latest = 2;
+
+	// Snapshot being captured by the simulation thread.
+	int back = 1;
+
+	// Snapshot being read by the render thread.
+	int front = 0;
+
+	// What the render thread wants captured besides bodies and statistics.
+	std::atomic<bool> capture_representation = false;
+	std::atomic<bool> capture_info = false;
+	std::atomic<Rectangle> info_area = Rectangle{};
+
+	// Position of each body in the latest published snapshot, indexed by body id, and when it was published.
+	// Only touched by the simulation thread.
+	std::vector<Vector2> published_positions;
+	std::chrono::steady_clock::time_point last_published = std::chrono::steady_clock::now();
+
+	std::atomic<SaveStatus> save_status = SaveStatus::NONE;
+
+	// Checkpoint being written on another thread, if any. Only touched by the simulation thread.
+	// Declared after save_status, so destroying it waits for the write to finish before anything it reports to is gone.
+	std::future<bool> pending_save;
+
+	// Records every tick while recording. Only touched by the simulation thread.
+	std::unique_ptr<TrajectoryRecorder> recorder;
+
+	// Whether the render thread last asked to start or stop recording. Only written by the render thread.
+	std::atomic<bool> recording = false;
+
+	// Keyframes of the universe to rewind to. Only touched by the simulation thread once it has started.
+	RewindBuffer rewind_buffer;
+
+	// Removals the render thread hasn't been given yet, and the number of the first one.
+	// Only touched by the simulation thread.
+	std::deque<Removal> undelivered_removals;
+	long long first_undelivered = 0;
+
+	// Number of removals carried by snapshots published so far. Only touched by the simulation thread.
+	long long removals_published = 0;
+	EventHandle<RemovalBatch> universe_listener;
+
+	// Number of removals and tuner log entries the render thread has been given.
+	// Only written by the render thread.
+	std::atomic<long long> removals_delivered = 0;
+	std::atomic<int> tuning_entries_delivered = 0;
+
+	// Tuner log entries given to the render thread by the latest call to acquire_snapshot.
+	std::span<const std::string> new_tuning_entries;
+
+	// Notified by the render thread, with the removals carried by each snapshot it takes that it hadn't been given yet.
+	Event<RemovalBatch> on_removal_observers;
+
+	// Declared last, so the thread is joined before anything it uses is destroyed.
+	std::jthread thread;
+
+	// Applies commands and steps the universe until asked to stop.
+	void run(std::stop_token stop);
+
+	// Updates the universe by as many ticks as the time warp asks for, stopping early if paused or asked to stop.
+	void step(std::stop_token stop);
+
+	// Updates the universe by one tick, keyframes it if one is due, and records it if recording.
+	void tick();
+
+	// Queues the change, keyframing the universe around it so it can be undone.
+	bool edit(Command change);
+
+	// Queues the rewind, which finishes any recording first, since a trajectory only goes forward.
+	// Bodies jump to where they were rather than moving there, and the render thread is told about the bodies that vanished.
+	bool submit_rewind(Command rewind);
+
+	// Applies every command waiting in the queue.
+	void apply_commands();
+
+	// Captures the universe into the back snapshot along with any undelivered events, then makes it the latest.
+	void publish();
+
+	// Listens for removals, keyframes the universe, captures the first snapshot and starts the thread. Shared by the constructors.
+	void start();
+
+public:
+
+	// Creates the universe and starts updating it on a new thread, paused.
+	// Bodies are generated with the calling thread's random engine, as are systems from generate_rand_system; ticks don't use one.
+	// Steps run ticks_per_second times a second, or as fast as possible if it is 0. At 1x time warp a step is one tick.
+	// step_budget_ms is how long each step may tick for with the BUDGET time warp.
+	SimulationThread(const UniverseSettings& settings, std::unique_ptr<SpatialPartitioning>&& partitioning, int ticks_per_second, float step_budget_ms,
+		const RewindBuffer::Settings& rewind_settings);
+
+	// Restores the universe saved in the checkpoint instead of generating one, and starts updating it on a new thread, paused.
+	// The saved random engine state is restored to the calling thread's engine, which goes on generating systems.
+	SimulationThread(const CheckpointFile& checkpoint, std::unique_ptr<SpatialPartitioning>&& partitioning, int ticks_per_second, float step_budget_ms,
+		const RewindBuffer::Settings& rewind_settings);
+
+	// Swaps the current snapshot for the latest one if it is newer, and notifies removal observers of the removals that led to it.
+	// Returns true if the snapshot changed, in which case references into the previous one are no longer valid.
+	bool acquire_snapshot();
+
+	// Returns the snapshot taken by the latest call to acquire_snapshot.
+	const UniverseSnapshot& get_snapshot() const;
+
+	// Moves the current snapshot's bodies to where they would be now, between the previously published snapshot and it.
+	// Anything reading body positions from the snapshot afterwards sees the interpolated positions.
+	void interpolate_snapshot();
+
+	// Returns the tuner log entries first given by the latest call to acquire_snapshot that changed the snapshot.
+	std::span<const std::string> get_new_tuning_log() const;
+
+	// Returns the observer list for removals of bodies, which is notified by acquire_snapshot.
+	Event<RemovalBatch>& removal_event();
+
+	// Queues the command to be applied before the next tick. Returns false if the queue is full, and the command was dropped.
+	bool submit(Command command);
+
+	// Queues adding the body to the universe.
+	void add_body(Body&& body);
+
+	// Queues adding the bodies to the universe.
+	void add_bodies(std::vector<Body>&& bodies);
+
+	// Queues removing the body with the id from the universe, if it still exists.
+	void rem_body(int id);
+
+	// Generates a system where the central body is at (x,y), using the universe's settings.
+	// Only reads the settings, which never change, so it is safe while the universe updates.
+	std::vector<Body> generate_rand_system(float x, float y);
+
+	// Pauses or resumes ticking. Commands are still applied while paused.
+	void set_running(bool to_set);
+	bool is_running() const;
+
+	// Sets the number of ticks per step, from the next step on.
+	void set_time_warp(TimeWarp to_set);
+	TimeWarp get_time_warp() const;
+
+	// Returns the time warp's name for display.
+	static std::string_view get_name(TimeWarp warp);
+
+	// Saves a checkpoint of the universe to the path. The universe is copied between ticks and written on another thread,
+	// so ticks carry on while the file is written. Returns false without saving if an earlier save hasn't finished.
+	// Saves the calling thread's random engine, the one that generates systems, so it has to be the thread that constructed this.
+	bool save_checkpoint(std::filesystem::path path);
+
+	// Returns the progress of the latest checkpoint save.
+	SaveStatus get_save_status() const;
+
+	// Starts recording the universe's trajectory to the path, from the tick the command is applied on.
+	// Ticks are recorded on the simulation thread and written on another, so recording doesn't hold up ticks.
+	// Returns false if the command queue is full.
+	bool start_recording(std::filesystem::path path, const TrajectoryRecorder::Settings& settings);
+
+	// Stops recording, finishing the file. Returns false if the command queue is full.
+	bool stop_recording();
+
+	// Returns true if recording was started, and not stopped since.
+	bool is_recording() const;
+
+	// Rewinds the universe by the number of ticks, or as far back as the rewind buffer goes.
+	// Returns false if the command queue is full.
+	bool rewind(int ticks);
+
+	// Steps back to the keyframe before the universe's current state, undoing the latest bodies added or removed,
+	// or the ticks since the latest keyframe. Returns false if the command queue is full.
+	bool step_back();
+
+	// Asks for the partitioning representation to be captured in later snapshots.
+	void request_representation(bool to_capture);
+
+	// Asks for the partitioning's info about bodies in the area to be captured in later snapshots, or for none if nullopt.
+	void request_partitioning_info(std::optional<Rectangle> area);
+
+	const UniverseSettings& get_settings() const;
+};
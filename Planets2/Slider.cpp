@@ -44,6 +44,13 @@ void Slider::set_val(float val)
 	move_slider();
 }
 
+void Slider::set_rail(float x, float y, float width)
+{
+	rail = { x, y, width, RAIL_HEIGHT };
+	slider_node.center.y = y + RAIL_HEIGHT / 2;
+	move_slider();
+}
+
 void Slider::click()
 {
 	float percent_point = get_percentage(GetMouseX());
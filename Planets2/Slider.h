@@ -39,6 +39,9 @@ public:
 	float get_val() const;
 	void set_val(float val);
 
+	// Moves the rail to start at (x, y) with the width, keeping the value.
+	void set_rail(float x, float y, float width);
+
 	void click() override;
 	void notify_drag() override;
 	bool contains_point(Vector2 point) const override;
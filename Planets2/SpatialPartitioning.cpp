@@ -1,8 +1,107 @@
 #include "SpatialPartitioning.h"
 #include "Collision.h"
+#include "Body.h"
+#include "Physics.h"
+#include "NearestBodies.h"
+#include <algorithm>
+#include <limits>
+#include <execution>
+#include <numeric>
+
+void SpatialPartitioning::add_bodies(std::span<Body* const> bodies)
+{
+	for (Body* body : bodies)
+	{
+		add_body(*body);
+	}
+}
+
+void SpatialPartitioning::rem_bodies(std::span<const Body* const> bodies)
+{
+	for (const Body* body : bodies)
+	{
+		rem_body(*body);
+	}
+}
+
+void SpatialPartitioning::notify_radius_changed(Body& body, [[maybe_unused]] float old_radius)
+{
+	rem_body(body);
+	add_body(body);
+}
+
+void SpatialPartitioning::notify_radii_changed(std::span<Body* const> bodies, std::span<const float> old_radii)
+{
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		notify_radius_changed(*bodies[i], old_radii[i]);
+	}
+}
+
+std::vector<Body*> SpatialPartitioning::query_radius(Vector2 center, float radius) const
+{
+	std::vector<Body*> found = query_rect({ center.x - radius, center.y - radius, 2 * radius, 2 * radius });
+
+	std::erase_if(found, [center, radius](const Body* body)
+	{
+		float reach = radius + body->get_radius();
+		return Physics::dist_squared(center, body->pos()) >= reach * reach;
+	});
+
+	return found;
+}
+
+std::vector<Body*> SpatialPartitioning::k_nearest(Vector2 point, int k) const
+{
+	// Large enough to cover any universe, small enough that its far corner doesn't overflow.
+	constexpr float unbounded = std::numeric_limits<float>::max() / 4;
+
+	NearestBodies nearest { point, k };
+	for (Body* body : query_rect({ -unbounded, -unbounded, 2 * unbounded, 2 * unbounded }))
+	{
+		nearest.offer(*body);
+	}
+
+	return nearest.take();
+}
 
 std::vector<Collision> SpatialPartitioning::get_collisions()
 {
 	num_collision_checks_tick = 0;
 	return get_collisions_impl();
+}
+
+int SpatialPartitioning::gather_parallel(int num_units, const CollisionUnit& check_unit, std::vector<Collision>& collisions)
+{
+	struct UnitResult
+	{
+		std::vector<Collision> collisions;
+		int checks = 0;
+	};
+
+	std::vector<UnitResult> results(num_units);
+
+	std::for_each(std::execution::par, results.begin(), results.end(), [&results, &check_unit](UnitResult& result)
+	{
+		int unit = &result - results.data();
+		result.checks = check_unit(unit, result.collisions);
+	});
+
+	std::size_t total = collisions.size();
+	for (const UnitResult& result : results)
+	{
+		total += result.collisions.size();
+	}
+
+	collisions.reserve(total);
+	for (const UnitResult& result : results)
+	{
+		for (const Collision& collision : result.collisions)
+		{
+			collisions.push_back(collision);
+		}
+	}
+
+	return std::transform_reduce(std::execution::par, results.begin(), results.end(), 0, std::plus<>(),
+		[](const UnitResult& result) { return result.checks; });
 }
\ No newline at end of file
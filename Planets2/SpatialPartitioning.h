@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <functional>
+#include <span>
 
 
 struct Rectangle;
@@ -9,6 +11,7 @@ class Body;
 struct Collision;
 
 class DebugInfo;
+class BarnesHut;
 
 // An interface for spatial partitionings that can be used for collision detection.
 // Supports implementations that rebuild on tick as well as those that update theirselves.
@@ -35,16 +38,49 @@ public:
 	virtual void add_body(Body& body) = 0;
 
 	// Removes a body from the partitioning.
+	// Bodies never move in memory while they are in the universe, so other bodies' pointers stay valid.
 	virtual void rem_body(const Body& body) = 0;
-	
-	virtual void notify_move(const Body* from, Body* to) = 0;
+
+	// Adds several bodies at once. Implementations that can insert in bulk more cheaply should override this.
+	virtual void add_bodies(std::span<Body* const> bodies);
+
+	// Removes several bodies at once, such as all bodies merged in a tick.
+	// Implementations that can remove in a single pass should override this.
+	virtual void rem_bodies(std::span<const Body* const> bodies);
+
+	// Informs the partitioning that the body's radius changed from old_radius, such as when it absorbed another body.
+	// By default removes and re-adds the body, which suits partitionings that find bodies without their bounding box.
+	virtual void notify_radius_changed(Body& body, float old_radius);
+
+	// Informs the partitioning that every body's radius changed from its old radius, such as all absorbers of a tick.
+	// Bodies are all grown before any is notified about. By default notifies about each body in turn.
+	virtual void notify_radii_changed(std::span<Body* const> bodies, std::span<const float> old_radii);
 
 	// Updates the partitioning to reflect new positions.
 	virtual void update() = 0;
 
+	// Returns true if the partitioning sets each body's partition bounds,
+	// so that it only has to be told about bodies which left them, through update_moved.
+	virtual bool uses_partition_bounds() const { return false; }
+
+	// Updates the partitioning, given every body whose center left its partition bounds since the last update.
+	// All other bodies are still where the partitioning placed them. By default updates everything.
+	virtual void update_moved([[maybe_unused]] std::span<Body* const> moved) { update(); }
+
 	// Tries to find and return the body that overlaps with the point, returns nullptr if none found.
 	virtual Body* find_body(Vector2 point) const = 0;
 
+	// Returns every body that overlaps with the area.
+	virtual std::vector<Body*> query_rect(Rectangle area) const = 0;
+
+	// Returns every body that overlaps with the circle.
+	// By default filters the bodies overlapping the circle's bounding box.
+	virtual std::vector<Body*> query_radius(Vector2 center, float radius) const;
+
+	// Returns the (up to) k bodies whose centers are nearest to the point, nearest first. Ties go to the lower id.
+	// By default checks every body.
+	virtual std::vector<Body*> k_nearest(Vector2 point, int k) const;
+
 	// Returns a representation of the partitioning method.
 	virtual std::vector<Rectangle> get_representation() const = 0;
 
@@ -57,6 +93,19 @@ public:
 	// Returns the number of collision checks performed after previous call to get_collisions.
 	int get_collision_checks_this_tick() const { return num_collision_checks_tick; }
 
+	// A unit of collision detection work, such as a grid cell or a subtree.
+	// Adds the collisions it finds to the vector, and returns the number of collision checks it performed.
+	using CollisionUnit = std::function<int(int unit, std::vector<Collision>& collisions)>;
+
+	// Runs num_units independent units of work in parallel, each adding to its own collision buffer.
+	// Buffers are merged in unit order, so the result doesn't depend on scheduling.
+	// Returns the total number of collision checks performed.
+	static int gather_parallel(int num_units, const CollisionUnit& check_unit, std::vector<Collision>& collisions);
+
+	// Returns a Barnes-Hut tree that the partitioning keeps up to date with all bodies, or nullptr if it has none.
+	// If it has one, the universe approximates gravity with it instead of building its own.
+	virtual const BarnesHut* get_gravity_tree() const { return nullptr; }
+
 	virtual ~SpatialPartitioning() = default;
 };
 
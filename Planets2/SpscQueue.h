@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <optional>
+#include <utility>
+#include <cstddef>
+
+/*
+* A bounded lock-free queue with one producer thread and one consumer thread.
+* Elements live in a ring of slots that is allocated once, so pushing and popping never allocate or block.
+*
+* The producer only writes tail and the consumer only writes head,
+* so each index is published with a release store and read with an acquire load by the other thread.
+*/
+template <class T>
+class SpscQueue
+{
+	// Indices are kept on separate cache lines, so the two threads don't invalidate each other's line on every operation.
+	static constexpr size_t CACHE_LINE = 64;
+
+	// Capacity rounded up to a power of two, so indices wrap with a mask.
+	std::vector<T> slots;
+	size_t mask;
+
+	// Index of the next element to pop. Only written by the consumer.
+	alignas(CACHE_LINE) std::atomic<size_t> head = 0;
+
+	// Index of the next free slot. Only written by the producer.
+	alignas(CACHE_LINE) std::atomic<size_t> tail = 0;
+
+public:
+
+	// Creates a queue that holds at least the given number of elements.
+	explicit SpscQueue(size_t capacity);
+
+	// Moves the element into the queue. Returns false if the queue is full.
+	// Only called by the producer.
+	bool try_push(T&& element);
+
+	// Moves the oldest element out of the queue, or returns nullopt if it is empty.
+	// Only called by the consumer.
+	std::optional<T> try_pop();
+
+	// Returns the number of elements in the queue. May be outdated as soon as it returns.
+	size_t size() const;
+
+	// Returns the number of elements the queue can hold.
+	size_t capacity() const;
+};
+
+template<class T>
+inline SpscQueue<T>::SpscQueue(size_t capacity)
+{
+	size_t rounded = 1;
+	while (rounded < capacity)
+	{
+		rounded *= 2;
+	}
+
+	slots.resize(rounded);
+	mask = rounded - 1;
+}
+
+template<class T>
+inline bool SpscQueue<T>::try_push(T&& element)
+{
+	size_t cur_tail = tail.load(std::memory_order_relaxed);
+	if (cur_tail - head.load(std::memory_order_acquire) == slots.size())
+	{
+		return false;
+	}
+
+	slots[cur_tail & mask] = std::move(element);
+	tail.store(cur_tail + 1, std::memory_order_release);
+	return true;
+}
+
+template<class T>
+inline std::optional<T> SpscQueue<T>::try_pop()
+{
+	size_t cur_head = head.load(std::memory_order_relaxed);
+	if (cur_head == tail.load(std::memory_order_acquire))
+	{
+		return std::nullopt;
+	}
+
+	std::optional<T> element = std::move(slots[cur_head & mask]);
+	head.store(cur_head + 1, std::memory_order_release);
+	return element;
+}
+
+template<class T>
+inline size_t SpscQueue<T>::size() const
+{
+	return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
+
+template<class T>
+inline size_t SpscQueue<T>::capacity() const
+{
+	return slots.size();
+}
@@ -0,0 +1,305 @@
+#include "SweepAndPrune.h"
+#include "SimTypes.h"
+
+#include "Collision.h"
+#include "Body.h"
+
+#include "DebugInfo.h"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <unordered_set>
+
+void SweepAndPrune::Endpoint::refresh()
+{
+    value = is_min ? body->left() : body->right();
+}
+
+std::size_t SweepAndPrune::BodyPairHash::operator()(const BodyPair& pair) const
+{
+    std::size_t h1 = std::hash<Body*>{}(pair.first);
+    std::size_t h2 = std::hash<Body*>{}(pair.second);
+    return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+}
+
+SweepAndPrune::BodyPair SweepAndPrune::make_pair(Body* body1, Body* body2)
+{
+    if (std::less<Body*>{}(body1, body2)) {
+        return { body1, body2 };
+    }
+    else {
+        return { body2, body1 };
+    }
+}
+
+void SweepAndPrune::on_swap(const Endpoint& moving_left, const Endpoint& passed)
+{
+    if (moving_left.is_min and !passed.is_min) {
+        // A body's left side moved before another's right side, so their intervals now overlap.
+        overlapping.insert(make_pair(moving_left.body, passed.body));
+    }
+    else if (!moving_left.is_min and passed.is_min) {
+        // A body's right side moved before another's left side, so their intervals no longer overlap.
+        overlapping.erase(make_pair(moving_left.body, passed.body));
+    }
+
+    // Swapping two endpoints of the same kind does not change any overlaps.
+}
+
+void SweepAndPrune::add_body(Body& body)
+{
+    Body* const adding[] { &body };
+    add_bodies(adding);
+}
+
+void SweepAndPrune::add_bodies(std::span<Body* const> bodies)
+{
+    std::vector<Endpoint> added;
+    added.reserve(2 * bodies.size());
+    for (Body* body : bodies) {
+        added.push_back({ body, true, body->left() });
+        added.push_back({ body, false, body->right() });
+    }
+
+    // Mins go before maxes of the same value, so that bodies which only touch are still treated as overlapping.
+    std::ranges::sort(added, [](const Endpoint& e1, const Endpoint& e2) {
+        return e1.value < e2.value or (e1.value == e2.value and e1.is_min and !e2.is_min);
+    });
+
+    // Added mins go before existing endpoints of equal value, and added maxes after them, for the same reason.
+    std::vector<Endpoint> merged;
+    std::vector<bool> was_added;
+    merged.reserve(endpoints.size() + added.size());
+    was_added.reserve(endpoints.size() + added.size());
+
+    auto existing_it = endpoints.begin();
+    for (const Endpoint& endpoint : added) {
+        while (existing_it != endpoints.end() and (existing_it->value < endpoint.value or (existing_it->value == endpoint.value and !endpoint.is_min))) {
+            merged.push_back(*existing_it++);
+            was_added.push_back(false);
+        }
+
+        merged.push_back(endpoint);
+        was_added.push_back(true);
+    }
+
+    merged.insert(merged.end(), existing_it, endpoints.end());
+    was_added.resize(merged.size(), false);
+    endpoints = std::move(merged);
+
+    // Pairs between existing bodies are already known, so only pairs with an added body are looked for.
+    std::unordered_set<Body*> open_existing;
+    std::unordered_set<Body*> open_added;
+
+    for (int i = 0; i < endpoints.size(); i++) {
+        const Endpoint& endpoint = endpoints[i];
+        std::unordered_set<Body*>& open = was_added[i] ? open_added : open_existing;
+
+        if (!endpoint.is_min) {
+            open.erase(endpoint.body);
+            continue;
+        }
+
+        for (Body* other : open_added) {
+            overlapping.insert(make_pair(other, endpoint.body));
+        }
+
+        if (was_added[i]) {
+            for (Body* other : open_existing) {
+                overlapping.insert(make_pair(other, endpoint.body));
+            }
+        }
+
+        open.insert(endpoint.body);
+    }
+}
+
+void SweepAndPrune::rem_body(const Body& body)
+{
+    int max_index = find_endpoint(body, false, body.right());
+    assert(max_index < endpoints.size());
+    endpoints.erase(endpoints.begin() + max_index);
+
+    int min_index = find_endpoint(body, true, body.left());
+    assert(min_index < endpoints.size());
+    endpoints.erase(endpoints.begin() + min_index);
+
+    std::erase_if(overlapping, [&body](const BodyPair& pair) {
+        return pair.first == &body or pair.second == &body;
+    });
+}
+
+void SweepAndPrune::rem_bodies(std::span<const Body* const> bodies)
+{
+    std::unordered_set<const Body*> removing(bodies.begin(), bodies.end());
+
+    std::erase_if(endpoints, [&removing](const Endpoint& endpoint) {
+        return removing.contains(endpoint.body);
+    });
+
+    std::erase_if(overlapping, [&removing](const BodyPair& pair) {
+        return removing.contains(pair.first) or removing.contains(pair.second);
+    });
+}
+
+void SweepAndPrune::resettle_endpoint(int index)
+{
+    endpoints[index].refresh();
+
+    int j = index;
+    while (j > 0 and endpoints[j - 1].value > endpoints[j].value) {
+        on_swap(endpoints[j], endpoints[j - 1]);
+        std::swap(endpoints[j], endpoints[j - 1]);
+        j--;
+    }
+
+    while (j + 1 < endpoints.size() and endpoints[j].value > endpoints[j + 1].value) {
+        on_swap(endpoints[j + 1], endpoints[j]);
+        std::swap(endpoints[j], endpoints[j + 1]);
+        j++;
+    }
+}
+
+void SweepAndPrune::notify_radius_changed(Body& body, float old_radius)
+{
+    // Endpoints are still sorted by their values for the old radius, so look them up by those.
+    Vector2 pos = body.pos();
+
+    int min_index = find_endpoint(body, true, pos.x - old_radius);
+    assert(min_index < endpoints.size());
+    resettle_endpoint(min_index);
+
+    int max_index = find_endpoint(body, false, pos.x + old_radius);
+    assert(max_index < endpoints.size());
+    resettle_endpoint(max_index);
+}
+
+void SweepAndPrune::update()
+{
+    for (Endpoint& endpoint : endpoints) {
+        endpoint.refresh();
+    }
+
+    // Insertion sort over the previous tick's order.
+    // With little movement between ticks, each endpoint only moves a few places (if any).
+    for (int i = 1; i < endpoints.size(); i++) {
+        int j = i;
+        while (j > 0 and endpoints[j - 1].value > endpoints[j].value) {
+            on_swap(endpoints[j], endpoints[j - 1]);
+            std::swap(endpoints[j], endpoints[j - 1]);
+            j--;
+        }
+    }
+}
+
+Body* SweepAndPrune::find_body(Vector2 point) const
+{
+    // Only bodies whose left side is at or before the point can contain it.
+    for (const Endpoint& endpoint : endpoints) {
+        if (endpoint.value > point.x) {
+            break;
+        }
+
+        if (endpoint.is_min and endpoint.body->contains_point(point)) {
+            return endpoint.body;
+        }
+    }
+
+    return nullptr;
+}
+
+std::vector<Body*> SweepAndPrune::query_rect(Rectangle area) const
+{
+    std::vector<Body*> found;
+    float right = area.x + area.width;
+
+    for (const Endpoint& endpoint : endpoints) {
+        if (endpoint.value > right) {
+            break;
+        }
+
+        if (endpoint.is_min and endpoint.body->intersects_rect(area)) {
+            found.push_back(endpoint.body);
+        }
+    }
+
+    return found;
+}
+
+std::vector<Rectangle> SweepAndPrune::get_representation() const
+{
+    std::vector<Rectangle> rep;
+    rep.reserve(endpoints.size());
+
+    for (const Endpoint& endpoint : endpoints) {
+        const Body& body = *endpoint.body;
+        rep.emplace_back(endpoint.value, body.top(), 2.0f, body.diameter());
+    }
+
+    return rep;
+}
+
+void SweepAndPrune::get_info(const Body& body, DebugInfo& info) const
+{
+    int min_index = find_endpoint(body, true, body.left());
+    int max_index = find_endpoint(body, false, body.right());
+
+    int num_pairs = std::count_if(overlapping.begin(), overlapping.end(), [&body](const BodyPair& pair) {
+        return pair.first == &body or pair.second == &body;
+    });
+
+    info.add("Min endpoint index: " + std::to_string(min_index));
+    info.add("Max endpoint index: " + std::to_string(max_index));
+    info.add("Overlapping pairs: " + std::to_string(num_pairs));
+}
+
+std::vector<Collision> SweepAndPrune::get_collisions_impl()
+{
+    std::vector<Collision> collisions;
+
+    // Blocks are runs of the overlap set's buckets, which hold about the same number of pairs each.
+    int num_pairs = overlapping.size();
+    int num_blocks = num_pairs > 0 ? std::clamp(num_pairs / MIN_PAIRS_PER_BLOCK, 1, MAX_BLOCKS) : 0;
+    std::size_t num_buckets = overlapping.bucket_count();
+
+    // Only pairs that overlap on the x-axis are checked.
+    num_collision_checks_tick = gather_parallel(num_blocks, [this, num_blocks, num_buckets](int block, std::vector<Collision>& block_collisions) {
+        std::size_t first = num_buckets * block / num_blocks;
+        std::size_t last = num_buckets * (block + 1) / num_blocks;
+
+        int checks = 0;
+        for (std::size_t bucket = first; bucket < last; bucket++) {
+            for (auto it = overlapping.begin(bucket); it != overlapping.end(bucket); ++it) {
+                const auto& [body1, body2] = *it;
+                if (body1->collided_with(*body2)) {
+                    block_collisions.emplace_back(Body::get_sorted_pair(*body1, *body2));
+                }
+
+                checks++;
+            }
+        }
+
+        return checks;
+    }, collisions);
+
+    return collisions;
+}
+
+int SweepAndPrune::find_endpoint(const Body& body, bool is_min, float value) const
+{
+    auto is_endpoint = [&body, is_min](const Endpoint& e) { return e.body == &body and e.is_min == is_min; };
+
+    auto it = std::lower_bound(endpoints.begin(), endpoints.end(), value,
+        [](const Endpoint& e, float value) { return e.value < value; });
+
+    // Might be multiple endpoints with the same value.
+    while (it != endpoints.end() and it->value == value and !is_endpoint(*it)) {
+        it++;
+    }
+
+    if (it == endpoints.end() or !is_endpoint(*it)) {
+        it = std::find_if(endpoints.begin(), endpoints.end(), is_endpoint);
+    }
+
+    return static_cast<int>(it - endpoints.begin());
+}
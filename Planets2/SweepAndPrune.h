@@ -0,0 +1,94 @@
+#pragma once
+#include "SpatialPartitioning.h"
+#include <unordered_set>
+#include <utility>
+
+// Persistent sweep and prune for collision detection.
+// Keeps the x-axis endpoints of every body sorted across ticks, and a set of body pairs whose x-intervals overlap.
+// Since bodies barely move between ticks, the endpoints are re-sorted with an insertion sort over the previous order,
+// and the overlap set only changes where two endpoints swap.
+class SweepAndPrune : public SpatialPartitioning
+{
+
+	// A body's leftmost (min) or rightmost (max) x-coordinate.
+	struct Endpoint {
+		Body* body;
+		bool is_min;
+
+		// Cached coordinate of the endpoint as of the last update.
+		float value;
+
+		// Recalculates the endpoint's coordinate from its body.
+		void refresh();
+	};
+
+	// Pair of bodies, ordered by address so that (a, b) and (b, a) are the same pair.
+	using BodyPair = std::pair<Body*, Body*>;
+
+	struct BodyPairHash {
+		std::size_t operator()(const BodyPair& pair) const;
+	};
+
+	// All endpoints, sorted in ascending order of value.
+	std::vector<Endpoint> endpoints;
+
+	// Pairs of bodies whose endpoints currently overlap on the x-axis.
+	std::unordered_set<BodyPair, BodyPairHash> overlapping;
+
+	// Maximum number of blocks that the overlap set is split into when checking for collisions.
+	static constexpr int MAX_BLOCKS = 64;
+
+	// Minimum number of pairs in a block, so small universes aren't split into blocks of little work.
+	static constexpr int MIN_PAIRS_PER_BLOCK = 4096;
+
+	// Returns the pair (body1, body2) in its canonical order.
+	static BodyPair make_pair(Body* body1, Body* body2);
+
+	// Updates the overlap set after endpoint moving_left has been swapped below endpoint passed.
+	void on_swap(const Endpoint& moving_left, const Endpoint& passed);
+
+	// Refreshes the endpoint's value and moves it to its sorted place, updating overlapping pairs on each swap.
+	void resettle_endpoint(int index);
+
+	// Returns the index of one of the body's endpoints, looking first where an endpoint with the value would be.
+	// Endpoints are sorted by their values as of the last update, so a body that moved since is searched for in all of them.
+	// Returns the number of endpoints if the body has none.
+	int find_endpoint(const Body& body, bool is_min, float value) const;
+
+	// Returns collision events between all overlapping pairs that are actually touching.
+	std::vector<Collision> get_collisions_impl() override;
+
+public:
+
+	// Adds a body and every pair it overlaps with.
+	void add_body(Body& body) override;
+
+	// Sorts the bodies' endpoints on their own and merges them into the rest,
+	// then finds the pairs they overlap with in one sweep over all endpoints.
+	void add_bodies(std::span<Body* const> bodies) override;
+
+	// Removes the body's endpoints and every pair it is a part of.
+	void rem_body(const Body& body) override;
+
+	// Removes the bodies' endpoints and pairs in a single pass over each.
+	void rem_bodies(std::span<const Body* const> bodies) override;
+
+	// Moves the body's endpoints to their places for its new radius.
+	void notify_radius_changed(Body& body, float old_radius) override;
+
+	// Re-sorts endpoints using their previous order, updating overlapping pairs on each swap.
+	void update() override;
+
+	// Returns a pointer to the body that contains the point. If none do, returns nullptr.
+	Body* find_body(Vector2 point) const override;
+
+	// Returns every body that overlaps with the area, only checking bodies whose left side is at or before its right side.
+	std::vector<Body*> query_rect(Rectangle area) const override;
+
+	// Returns a visual representation of the endpoints.
+	std::vector<Rectangle> get_representation() const override;
+
+	// Attaches text indicating body's endpoint indices and its number of overlapping pairs to info.
+	void get_info(const Body& body, DebugInfo& info) const override;
+
+};
@@ -0,0 +1,117 @@
+#include "SweptCollisions.h"
+#include "Body.h"
+#include "BodyList.h"
+#include "SpatialPartitioning.h"
+#include "Physics.h"
+#include "Circle.h"
+#include "SimTypes.h"
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <iterator>
+
+std::optional<float> SweptCollisions::time_of_impact(const Body& body1, const Body& body2)
+{
+    Circle start1 { Vector2Subtract(body1.pos(), body1.vel()), body1.get_radius() };
+    Circle start2 { Vector2Subtract(body2.pos(), body2.vel()), body2.get_radius() };
+
+    return Physics::time_of_impact(start1, body1.vel(), start2, body2.vel());
+}
+
+bool SweptCollisions::is_fast(const Body& body)
+{
+    Vector2 vel = body.vel();
+    float radius = body.get_radius();
+    return vel.x * vel.x + vel.y * vel.y > radius * radius;
+}
+
+Rectangle SweptCollisions::swept_box(const Body& body)
+{
+    Rectangle end = body.get_bounding_box();
+    Rectangle start = end;
+    start.x -= body.vel().x;
+    start.y -= body.vel().y;
+
+    return Physics::rects_union(start, end);
+}
+
+void SweptCollisions::add_if_missed(Body& body1, Body& body2, std::vector<Impact>& impacts)
+{
+    // Bodies still touching at the end of the tick are already found by the partitioning.
+    if (body1.collided_with(body2)) {
+        return;
+    }
+
+    if (std::optional<float> time = time_of_impact(body1, body2)) {
+        impacts.push_back({ Collision { Body::get_sorted_pair(body1, body2) }, *time });
+    }
+}
+
+std::vector<SweptCollisions::Impact> SweptCollisions::find_missed(BodyList& bodies, const SpatialPartitioning& partitioning)
+{
+    std::vector<Body*> fast;
+    float max_slow_motion = 0.0f;
+
+    for (Body& body : bodies) {
+        if (is_fast(body)) {
+            fast.push_back(&body);
+        }
+        else {
+            max_slow_motion = std::max(max_slow_motion, std::max(std::abs(body.vel().x), std::abs(body.vel().y)));
+        }
+    }
+
+    if (fast.empty()) {
+        return {};
+    }
+
+    // Each fast body queries for slow bodies concurrently, and the results are merged in order.
+    // A slow body's swept box is inside its current box grown by its motion, so growing the query by the most any slow body moved finds all of them.
+    std::vector<std::vector<Impact>> found(fast.size());
+    std::vector<int> indices(fast.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&fast, &found, &partitioning, max_slow_motion](int i) {
+        Body& body = *fast[i];
+
+        Rectangle area = swept_box(body);
+        area.x -= max_slow_motion;
+        area.y -= max_slow_motion;
+        area.width += 2 * max_slow_motion;
+        area.height += 2 * max_slow_motion;
+
+        for (Body* other : partitioning.query_rect(area)) {
+            if (!is_fast(*other)) {
+                add_if_missed(body, *other, found[i]);
+            }
+        }
+    });
+
+    std::vector<Impact> impacts;
+    for (const std::vector<Impact>& body_impacts : found) {
+        std::ranges::copy(body_impacts, std::back_inserter(impacts));
+    }
+
+    // Fast bodies are checked against each other by sweeping their swept boxes along x.
+    std::vector<Rectangle> boxes;
+    boxes.reserve(fast.size());
+    for (const Body* body : fast) {
+        boxes.push_back(swept_box(*body));
+    }
+
+    std::ranges::sort(indices, [&boxes, &fast](int i, int j) {
+        return boxes[i].x != boxes[j].x ? boxes[i].x < boxes[j].x : fast[i]->get_id() < fast[j]->get_id();
+    });
+
+    for (auto it1 = indices.begin(); it1 != indices.end(); it1++) {
+        const Rectangle& box1 = boxes[*it1];
+
+        for (auto it2 = it1 + 1; it2 != indices.end() and boxes[*it2].x <= box1.x + box1.width; it2++) {
+            if (Physics::rects_intersect(box1, boxes[*it2])) {
+                add_if_missed(*fast[*it1], *fast[*it2], impacts);
+            }
+        }
+    }
+
+    return impacts;
+}
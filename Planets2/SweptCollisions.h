@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <optional>
+#include "SimTypes.h"
+#include "Collision.h"
+
+class Body;
+class BodyList;
+class SpatialPartitioning;
+
+// Continuous collision detection, for collisions that checking overlaps at the end of each tick misses
+// because a fast body passed through another within the tick.
+// Every body moves in a straight line over a tick, from its position minus its velocity to its position.
+// Bodies that move further than their own radius are swept along that line, and their time of impact with each candidate is solved.
+class SweptCollisions
+{
+public:
+
+	// A collision, and the fraction of the tick at which the bodies first touched.
+	struct Impact {
+		Collision collision;
+		float time;
+	};
+
+	// Returns the fraction of the tick at which the bodies first touched, or empty if they didn't touch during it.
+	static std::optional<float> time_of_impact(const Body& body1, const Body& body2);
+
+	// Returns every collision during the last tick between bodies that are no longer touching at its end.
+	// Candidates are found by motion-expanded bounding boxes: slow bodies through the partitioning,
+	// which is queried with each fast body's swept box grown by the fastest slow body's motion,
+	// and other fast bodies by sweeping along x.
+	static std::vector<Impact> find_missed(BodyList& bodies, const SpatialPartitioning& partitioning);
+
+private:
+
+	// Returns true if the body moved further than its radius in the last tick, so it could have passed through another body.
+	static bool is_fast(const Body& body);
+
+	// Returns the box that the body's circle covered during the last tick.
+	static Rectangle swept_box(const Body& body);
+
+	// Adds an impact to impacts if the bodies touched during the tick but no longer do at its end.
+	static void add_if_missed(Body& body1, Body& body2, std::vector<Impact>& impacts);
+
+};
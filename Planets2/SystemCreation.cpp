@@ -1,7 +1,7 @@
 #include "SystemCreation.h"
 
 #include "Body.h"
-#include "Universe.h"
+#include "SimulationThread.h"
 #include "CameraState.h"
 
 #include "DefaultInteraction.h"
@@ -10,7 +10,7 @@
 #include "DebugInfo.h"
 #include <raymath.h>
 
-void SystemCreation::add_system_to_universe(Universe& universe)
+void SystemCreation::add_system_to_universe(SimulationThread& simulation)
 {
 	// Add user-defined velocity to bodies.
 	for (Body& body : system)
@@ -18,15 +18,15 @@ void SystemCreation::add_system_to_universe(Universe& universe)
 		body.change_vel(initial_velocity);
 	}
 
-	universe.add_bodies(std::move(system));
+	simulation.add_bodies(std::move(system));
 	initial_velocity = Vector2Zero();
 }
 
-SystemCreation::SystemCreation(Vector2 mouse_pos, Universe& universe)
-	: system(universe.generate_rand_system(mouse_pos.x, mouse_pos.y))
+SystemCreation::SystemCreation(Vector2 mouse_pos, SimulationThread& simulation)
+	: system(simulation.generate_rand_system(mouse_pos.x, mouse_pos.y))
 {}
 
-InteractionState* SystemCreation::process_input(const CameraState& camera_state, Universe& universe)
+InteractionState* SystemCreation::process_input(const CameraState& camera_state, SimulationThread& simulation)
 {
 	Vector2 screen_point = GetMousePosition();
 	Vector2 universe_point = GetScreenToWorld2D(screen_point, camera_state.get_raylib_camera());
@@ -48,8 +48,8 @@ InteractionState* SystemCreation::process_input(const CameraState& camera_state,
 		else
 		{
 			// User has finished velocity customization.
-			add_system_to_universe(universe);
-			system = universe.generate_rand_system(universe_point.x, universe_point.y);
+			add_system_to_universe(simulation);
+			system = simulation.generate_rand_system(universe_point.x, universe_point.y);
 
 			// System added and new one generated = click processed.
 			// Reset click state.
@@ -87,7 +87,7 @@ InteractionState* SystemCreation::process_input(const CameraState& camera_state,
 	if (IsKeyPressed(KEY_ENTER))
 	{
 		// Add the current planetary system to the universe and goto default interaction.
-		add_system_to_universe(universe);
+		add_system_to_universe(simulation);
 		return new DefaultInteraction;
 	}
 	else if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT) or IsKeyPressed(KEY_ONE))
@@ -103,7 +103,7 @@ InteractionState* SystemCreation::process_input(const CameraState& camera_state,
 	else if (IsKeyPressed(KEY_THREE))
 	{
 		// Generate a new system, but don't add the current one to the universe.
-		system = universe.generate_rand_system(universe_point.x, universe_point.y);
+		system = simulation.generate_rand_system(universe_point.x, universe_point.y);
 		user_clicked = false;
 		return this;
 	}
@@ -128,7 +128,7 @@ std::string_view SystemCreation::get_help_text() const
 
 }
 
-void SystemCreation::render_world(const AdvCamera& camera, const Universe& universe)
+void SystemCreation::render_world(const AdvCamera& camera, const UniverseSnapshot& universe)
 {
 	for (const Body& body : system)
 	{
@@ -15,15 +15,15 @@ class SystemCreation : public InteractionState
 
 	// Converts satellite velocities to absolute velocities.
 	// Then adds all bodies in the system to the universe.
-	void add_system_to_universe(Universe& universe);
+	void add_system_to_universe(SimulationThread& simulation);
 
 public:
 
 	// Enters system generation state by generating a system at the current mouse position.
-	SystemCreation(Vector2 mouse_pos, Universe& universe);
+	SystemCreation(Vector2 mouse_pos, SimulationThread& simulation);
 
 	// Handles user input related to generating a system.
-	InteractionState* process_input(const CameraState& camera_state, Universe& universe) override;
+	InteractionState* process_input(const CameraState& camera_state, SimulationThread& simulation) override;
 
 	std::string_view get_name() const override;
 
@@ -31,7 +31,7 @@ public:
 	std::string_view get_help_text() const override;
 
 	// Renders the currently generated system.
-	void render_world(const AdvCamera& camera_state, const Universe& universe) override;
+	void render_world(const AdvCamera& camera_state, const UniverseSnapshot& universe) override;
 
 };
 
@@ -0,0 +1,303 @@
+#include "TrajectoryFile.h"
+#include "Checkpoint.h"
+#include <algorithm>
+#include <array>
+
+using namespace TrajectoryFormat;
+
+TrajectoryFile::TrajectoryFile(MappedFile&& file) : file(std::move(file))
+{
+}
+
+std::optional<TrajectoryFile> TrajectoryFile::open(const std::filesystem::path& path, std::string& error)
+{
+    std::optional<MappedFile> mapped = MappedFile::open(path);
+    if (!mapped) {
+        error = "Could not open " + path.string();
+        return std::nullopt;
+    }
+
+    TrajectoryFile trajectory(std::move(*mapped));
+    ByteReader reader(trajectory.file.bytes());
+
+    if (reader.get<std::array<char, 8>>() != MAGIC) {
+        error = "Not a trajectory file";
+        return std::nullopt;
+    }
+
+    std::uint32_t version = reader.get<std::uint32_t>();
+    if (version != VERSION) {
+        error = "Unsupported trajectory version " + std::to_string(version);
+        return std::nullopt;
+    }
+
+    if (reader.get<std::uint32_t>() != BYTE_ORDER_MARK) {
+        error = "Trajectory was recorded on a machine with a different byte order";
+        return std::nullopt;
+    }
+
+    trajectory.step = reader.get<float>();
+    trajectory.record_every = reader.get<std::int32_t>();
+    trajectory.frames_per_chunk = reader.get<std::int32_t>();
+
+    ByteReader settings_reader(reader.get_bytes(reader.get<std::uint32_t>()));
+    trajectory.settings = Checkpoint::read_settings(settings_reader);
+
+    if (!reader.ok() or !settings_reader.ok() or !(trajectory.step > 0.0f)) {
+        error = "Trajectory header is truncated or corrupt";
+        return std::nullopt;
+    }
+
+    // A recording that was cut short has no index, but every chunk written before then is whole.
+    trajectory.indexed = trajectory.read_index(reader.position());
+    if (!trajectory.indexed) {
+        trajectory.scan_chunks(reader.position());
+    }
+
+    if (trajectory.chunks.empty()) {
+        error = "Trajectory has no frames";
+        return std::nullopt;
+    }
+
+    return trajectory;
+}
+
+std::optional<TrajectoryFile::Chunk> TrajectoryFile::read_chunk(size_t offset, size_t end) const
+{
+    if (offset > end or end - offset < CHUNK_HEADER_SIZE) {
+        return std::nullopt;
+    }
+
+    ByteReader reader(file.bytes().subspan(offset, end - offset));
+    if (reader.get<std::uint32_t>() != CHUNK_MARKER) {
+        return std::nullopt;
+    }
+
+    Chunk chunk;
+    chunk.payload_size = reader.get<std::uint32_t>();
+    chunk.first_tick = reader.get<std::int32_t>();
+    chunk.last_tick = reader.get<std::int32_t>();
+    chunk.num_frames = reader.get<std::int32_t>();
+    chunk.payload_offset = offset + CHUNK_HEADER_SIZE;
+
+    if (chunk.payload_size > end - chunk.payload_offset or chunk.num_frames <= 0 or chunk.last_tick < chunk.first_tick) {
+        return std::nullopt;
+    }
+
+    return chunk;
+}
+
+bool TrajectoryFile::read_index(size_t chunks_start)
+{
+    std::span<const std::byte> bytes = file.bytes();
+    if (bytes.size() < chunks_start + FOOTER_SIZE) {
+        return false;
+    }
+
+    size_t footer_offset = bytes.size() - FOOTER_SIZE;
+    ByteReader footer(bytes.subspan(footer_offset));
+    std::uint64_t index_offset = footer.get<std::uint64_t>();
+    if (footer.get<std::array<char, 8>>() != INDEX_MAGIC or index_offset < chunks_start or index_offset > footer_offset
+        or (footer_offset - index_offset) % INDEX_ENTRY_SIZE != 0) {
+        return false;
+    }
+
+    ByteReader index(bytes.subspan(index_offset, footer_offset - index_offset));
+    size_t num_entries = (footer_offset - index_offset) / INDEX_ENTRY_SIZE;
+    chunks.clear();
+    chunks.reserve(num_entries);
+
+    for (size_t i = 0; i < num_entries; i++) {
+        std::uint64_t offset = index.get<std::uint64_t>();
+        int first_tick = index.get<std::int32_t>();
+        int last_tick = index.get<std::int32_t>();
+        int num_frames = index.get<std::int32_t>();
+
+        // The entry has to agree with the chunk header it points to, and chunks have to be in tick order.
+        std::optional<Chunk> chunk = read_chunk(offset, index_offset);
+        if (!chunk or chunk->first_tick != first_tick or chunk->last_tick != last_tick or chunk->num_frames != num_frames
+            or (!chunks.empty() and chunks.back().last_tick >= first_tick)) {
+            chunks.clear();
+            return false;
+        }
+
+        chunks.push_back(*chunk);
+    }
+
+    return true;
+}
+
+void TrajectoryFile::scan_chunks(size_t chunks_start)
+{
+    chunks.clear();
+
+    size_t offset = chunks_start;
+    while (std::optional<Chunk> chunk = read_chunk(offset, file.bytes().size())) {
+        if (!chunks.empty() and chunks.back().last_tick >= chunk->first_tick) {
+            break;
+        }
+
+        chunks.push_back(*chunk);
+        offset = chunk->payload_offset + chunk->payload_size;
+    }
+}
+
+int TrajectoryFile::find_chunk(int tick) const
+{
+    auto after = std::ranges::upper_bound(chunks, tick, {}, &Chunk::first_tick);
+    return std::max(0, static_cast<int>(after - chunks.begin()) - 1);
+}
+
+std::span<const std::byte> TrajectoryFile::get_payload(int chunk) const
+{
+    return file.bytes().subspan(chunks[chunk].payload_offset, chunks[chunk].payload_size);
+}
+
+void TrajectoryFile::prefetch(int first_chunk, int num_chunks) const
+{
+    int last_chunk = std::min(first_chunk + num_chunks, get_num_chunks()) - 1;
+    if (first_chunk < 0 or first_chunk > last_chunk) {
+        return;
+    }
+
+    size_t start = chunks[first_chunk].payload_offset;
+    size_t end = chunks[last_chunk].payload_offset + chunks[last_chunk].payload_size;
+    file.prefetch(start, end - start);
+}
+
+std::span<const TrajectoryFile::Chunk> TrajectoryFile::get_chunks() const
+{
+    return chunks;
+}
+
+int TrajectoryFile::get_num_chunks() const
+{
+    return chunks.size();
+}
+
+int TrajectoryFile::get_first_tick() const
+{
+    return chunks.front().first_tick;
+}
+
+int TrajectoryFile::get_last_tick() const
+{
+    return chunks.back().last_tick;
+}
+
+const UniverseSettings& TrajectoryFile::get_settings() const
+{
+    return settings;
+}
+
+float TrajectoryFile::get_step() const
+{
+    return step;
+}
+
+int TrajectoryFile::get_record_every() const
+{
+    return record_every;
+}
+
+bool TrajectoryFile::has_index() const
+{
+    return indexed;
+}
+
+TrajectoryReader::TrajectoryReader(const TrajectoryFile& file) : file(file), decoder(file.get_step())
+{
+    start_chunk(0);
+    has_frame = decode_next(frame);
+    has_upcoming = has_frame and decode_next(upcoming);
+}
+
+void TrajectoryReader::start_chunk(int to_start)
+{
+    chunk = to_start;
+    chunk_frames_decoded = 0;
+    in = ByteReader(file.get_payload(chunk));
+    decoder.reset();
+
+    file.prefetch(chunk + 1, PREFETCH_CHUNKS);
+}
+
+bool TrajectoryReader::decode_next(TrajectoryFrame& out)
+{
+    if (chunk_frames_decoded == file.get_chunks()[chunk].num_frames) {
+        if (chunk + 1 == file.get_num_chunks()) {
+            return false;
+        }
+
+        // Chunks start with a keyframe, so carrying on into the next one decodes the same as starting it fresh.
+        start_chunk(chunk + 1);
+    }
+
+    if (!decoder.decode(in, out)) {
+        return false;
+    }
+
+    chunk_frames_decoded++;
+    frames_decoded_by_seek++;
+    return true;
+}
+
+void TrajectoryReader::advance()
+{
+    std::swap(frame, upcoming);
+    passed_removals.insert(passed_removals.end(), frame.removed.begin(), frame.removed.end());
+    has_upcoming = decode_next(upcoming);
+}
+
+bool TrajectoryReader::seek(int tick)
+{
+    passed_removals.clear();
+    frames_decoded_by_seek = 0;
+
+    // The upcoming frame may already be in the next chunk, so the current frame is either in the chunk being decoded or the one before.
+    int target_chunk = file.find_chunk(tick);
+    continued = has_frame and frame.tick <= tick and target_chunk <= chunk;
+
+    if (!continued) {
+        start_chunk(target_chunk);
+        has_frame = decode_next(frame);
+        has_upcoming = has_frame and decode_next(upcoming);
+
+        if (!has_frame) {
+            return false;
+        }
+    }
+
+    while (has_upcoming and upcoming.tick <= tick) {
+        advance();
+    }
+
+    // The upcoming frame failing to decode before the end of the file means it is corrupt.
+    bool at_end = chunk + 1 == file.get_num_chunks() and chunk_frames_decoded == file.get_chunks()[chunk].num_frames;
+    return has_upcoming or at_end;
+}
+
+const TrajectoryFrame& TrajectoryReader::get_frame() const
+{
+    return frame;
+}
+
+bool TrajectoryReader::has_current() const
+{
+    return has_frame;
+}
+
+std::span<const RemovedBody> TrajectoryReader::get_passed_removals() const
+{
+    return passed_removals;
+}
+
+bool TrajectoryReader::was_continuous() const
+{
+    return continued;
+}
+
+int TrajectoryReader::get_frames_decoded_by_seek() const
+{
+    return frames_decoded_by_seek;
+}
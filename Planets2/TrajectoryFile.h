@@ -0,0 +1,137 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "UniverseSettings.h"
+#include "MappedFile.h"
+#include "ByteStream.h"
+#include "TrajectoryFormat.h"
+
+// A trajectory file mapped into memory, along with where each of its chunks is. Laid out as described in TrajectoryFormat.h.
+class TrajectoryFile
+{
+public:
+
+	// Where a chunk's frames are, and the ticks of its first and last frame.
+	struct Chunk
+	{
+		size_t payload_offset;
+		size_t payload_size;
+		int first_tick;
+		int last_tick;
+		int num_frames;
+	};
+
+private:
+
+	MappedFile file;
+
+	UniverseSettings settings;
+	float step = 0.0f;
+	int record_every = 1;
+	int frames_per_chunk = 0;
+
+	// Ordered by tick.
+	std::vector<Chunk> chunks;
+
+	// False if the file had no index, and the chunks were found by scanning it.
+	bool indexed = false;
+
+	explicit TrajectoryFile(MappedFile&& file);
+
+	// Reads the chunk header at the offset. Returns nullopt if there isn't a whole chunk there.
+	std::optional<Chunk> read_chunk(size_t offset, size_t end) const;
+
+	// Reads the index the footer points to. Returns false if there is no footer, or the index is corrupt.
+	bool read_index(size_t chunks_start);
+
+	// Finds the chunks by walking from one chunk header to the next, stopping at the first incomplete chunk.
+	void scan_chunks(size_t chunks_start);
+
+public:
+
+	// Maps and validates the trajectory file at the path, and finds its chunks.
+	// A file whose recording was cut short is read up to its last complete chunk.
+	// Returns nullopt, with error describing why, if it can't be read or has no frames.
+	static std::optional<TrajectoryFile> open(const std::filesystem::path& path, std::string& error);
+
+	// Returns the index of the last chunk starting at or before the tick, or the first chunk if the tick is before all of them.
+	int find_chunk(int tick) const;
+
+	// Returns the encoded frames of the chunk.
+	std::span<const std::byte> get_payload(int chunk) const;
+
+	// Asks for the chunks from first_chunk on, up to num_chunks of them, to be read from disk ahead of being decoded.
+	void prefetch(int first_chunk, int num_chunks) const;
+
+	std::span<const Chunk> get_chunks() const;
+	int get_num_chunks() const;
+	int get_first_tick() const;
+	int get_last_tick() const;
+
+	const UniverseSettings& get_settings() const;
+	float get_step() const;
+	int get_record_every() const;
+	bool has_index() const;
+};
+
+// Decodes the frames of a trajectory file, in order or by seeking to any tick.
+// A seek only decodes from the keyframe starting the chunk the tick is in, or from the current frame if the tick is just ahead of it.
+class TrajectoryReader
+{
+	// Number of chunks past the one being decoded that are prefetched.
+	static constexpr int PREFETCH_CHUNKS = 4;
+
+	const TrajectoryFile& file;
+	TrajectoryDecoder decoder;
+
+	// Chunk being decoded, the frames of it decoded so far, and what is left of its payload.
+	int chunk = -1;
+	int chunk_frames_decoded = 0;
+	ByteReader in { {} };
+
+	// The current frame, and the frame after it, which is decoded ahead so seeking knows when to stop.
+	TrajectoryFrame frame;
+	TrajectoryFrame upcoming;
+	bool has_frame = false;
+	bool has_upcoming = false;
+
+	// Removals passed over by the latest seek, and whether it moved forward from the frame before it without jumping.
+	std::vector<RemovedBody> passed_removals;
+	bool continued = false;
+
+	int frames_decoded_by_seek = 0;
+
+	// Starts decoding the chunk from its keyframe, and prefetches the chunks after it.
+	void start_chunk(int to_start);
+
+	// Decodes the frame after the last decoded one, moving on to the next chunk if needed. Returns false at the end or on corrupt data.
+	bool decode_next(TrajectoryFrame& out);
+
+	// Makes the upcoming frame the current one, and decodes the one after it.
+	void advance();
+
+public:
+
+	// The file has to outlive the reader. Decodes the first frame.
+	explicit TrajectoryReader(const TrajectoryFile& file);
+
+	// Makes the current frame the last frame at or before the tick, or the first frame if the tick is before it.
+	// Returns false if a frame on the way is corrupt, in which case the current frame is the last one decoded before it.
+	bool seek(int tick);
+
+	// Returns the current frame. Only valid if has_current is true.
+	const TrajectoryFrame& get_frame() const;
+	bool has_current() const;
+
+	// Returns the bodies removed between the frame before the latest seek and the current frame.
+	// Only complete if was_continuous is true. Otherwise the seek jumped, and the removals before the chunk it jumped to aren't known.
+	std::span<const RemovedBody> get_passed_removals() const;
+	bool was_continuous() const;
+
+	// Returns the number of frames the latest seek decoded.
+	int get_frames_decoded_by_seek() const;
+};
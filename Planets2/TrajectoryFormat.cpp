@@ -0,0 +1,264 @@
+#include "TrajectoryFormat.h"
+#include "ByteStream.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    std::int64_t quantize(float value, float step)
+    {
+        return std::llround(static_cast<double>(value) / step);
+    }
+
+    float dequantize(std::int64_t value, float step)
+    {
+        return static_cast<float>(value * static_cast<double>(step));
+    }
+
+    // Writes sorted ids as the gaps between them, which are small when ids are close together.
+    template <class Range, class Projection>
+    void put_ids(ByteWriter& out, const Range& range, Projection id_of)
+    {
+        out.put_varint(std::size(range));
+        int prev_id = -1;
+        for (const auto& element : range) {
+            int id = id_of(element);
+            out.put_varint(static_cast<std::uint64_t>(id - prev_id - 1));
+            prev_id = id;
+        }
+    }
+
+    void get_ids(ByteReader& in, std::vector<int>& ids)
+    {
+        ids.clear();
+        std::uint64_t count = in.get_varint();
+        int prev_id = -1;
+        for (std::uint64_t i = 0; i < count and in.ok(); i++) {
+            prev_id += static_cast<int>(in.get_varint()) + 1;
+            ids.push_back(prev_id);
+        }
+    }
+
+    void put_absolute(ByteWriter& out, const QuantizedBody& body)
+    {
+        out.put_signed_varint(body.pos_x);
+        out.put_signed_varint(body.pos_y);
+        out.put_signed_varint(body.vel_x);
+        out.put_signed_varint(body.vel_y);
+        out.put_varint(static_cast<std::uint64_t>(body.mass));
+    }
+
+    QuantizedBody get_absolute(ByteReader& in, int id)
+    {
+        QuantizedBody body {};
+        body.id = id;
+        body.pos_x = in.get_signed_varint();
+        body.pos_y = in.get_signed_varint();
+        body.vel_x = in.get_signed_varint();
+        body.vel_y = in.get_signed_varint();
+        body.mass = static_cast<std::int64_t>(in.get_varint());
+        return body;
+    }
+
+}
+
+void TrajectoryFrame::clear()
+{
+    ids.clear();
+    positions.clear();
+    velocities.clear();
+    masses.clear();
+    removed.clear();
+    created.clear();
+}
+
+int TrajectoryFrame::get_num_bodies() const
+{
+    return ids.size();
+}
+
+TrajectoryEncoder::TrajectoryEncoder(float step) : step(step)
+{
+}
+
+void TrajectoryEncoder::encode(const TrajectoryFrame& frame, bool keyframe, ByteWriter& out)
+{
+    keyframe = keyframe or !has_prev;
+    std::int64_t ticks_since_prev = frame.tick - prev_tick;
+
+    current.clear();
+    for (int i = 0; i < frame.get_num_bodies(); i++) {
+        current.push_back({
+            frame.ids[i],
+            quantize(frame.positions[i].x, step),
+            quantize(frame.positions[i].y, step),
+            quantize(frame.velocities[i].x, step),
+            quantize(frame.velocities[i].y, step),
+            frame.masses[i]
+        });
+    }
+    std::ranges::sort(current, {}, &QuantizedBody::id);
+
+    removals.assign(frame.removed.begin(), frame.removed.end());
+    std::ranges::sort(removals, {}, &RemovedBody::id);
+
+    // Bodies in the previous frame that aren't in this one were removed, and bodies in this one that weren't in the previous were created.
+    std::vector<RemovedBody> removed;
+    std::vector<int> created;
+    if (has_prev) {
+        auto prev_it = prev.begin();
+        for (const QuantizedBody& body : current) {
+            for (; prev_it != prev.end() and prev_it->id < body.id; ++prev_it) {
+                auto removal = std::ranges::lower_bound(removals, prev_it->id, {}, &RemovedBody::id);
+                int absorbed_by = removal != removals.end() and removal->id == prev_it->id ? removal->absorbed_by : -1;
+                removed.push_back({ prev_it->id, absorbed_by });
+            }
+
+            if (prev_it != prev.end() and prev_it->id == body.id) {
+                ++prev_it;
+            }
+            else {
+                created.push_back(body.id);
+            }
+        }
+
+        for (; prev_it != prev.end(); ++prev_it) {
+            auto removal = std::ranges::lower_bound(removals, prev_it->id, {}, &RemovedBody::id);
+            int absorbed_by = removal != removals.end() and removal->id == prev_it->id ? removal->absorbed_by : -1;
+            removed.push_back({ prev_it->id, absorbed_by });
+        }
+    }
+
+    out.put_varint(frame.tick);
+    out.put<std::uint8_t>(keyframe);
+
+    put_ids(out, removed, [](const RemovedBody& removal) { return removal.id; });
+    for (const RemovedBody& removal : removed) {
+        out.put_varint(static_cast<std::uint64_t>(removal.absorbed_by + 1));
+    }
+
+    put_ids(out, created, [](int id) { return id; });
+
+    if (keyframe) {
+        put_ids(out, current, [](const QuantizedBody& body) { return body.id; });
+        for (const QuantizedBody& body : current) {
+            put_absolute(out, body);
+        }
+    }
+    else {
+        auto prev_it = prev.begin();
+        for (const QuantizedBody& body : current) {
+            while (prev_it != prev.end() and prev_it->id < body.id) {
+                ++prev_it;
+            }
+
+            if (prev_it == prev.end() or prev_it->id != body.id) {
+                put_absolute(out, body);
+                continue;
+            }
+
+            // Velocity first, since a body moves by its new velocity each tick.
+            const QuantizedBody& before = *prev_it;
+            out.put_signed_varint(body.vel_x - before.vel_x);
+            out.put_signed_varint(body.vel_y - before.vel_y);
+            out.put_signed_varint(body.pos_x - (before.pos_x + body.vel_x * ticks_since_prev));
+            out.put_signed_varint(body.pos_y - (before.pos_y + body.vel_y * ticks_since_prev));
+            out.put_signed_varint(body.mass - before.mass);
+        }
+    }
+
+    std::swap(prev, current);
+    prev_tick = frame.tick;
+    has_prev = true;
+}
+
+TrajectoryDecoder::TrajectoryDecoder(float step) : step(step)
+{
+}
+
+bool TrajectoryDecoder::decode(ByteReader& in, TrajectoryFrame& out)
+{
+    out.clear();
+
+    int tick = static_cast<int>(in.get_varint());
+    bool keyframe = in.get<std::uint8_t>() != 0;
+
+    std::vector<int> removed_ids;
+    get_ids(in, removed_ids);
+    for (int id : removed_ids) {
+        out.removed.push_back({ id, static_cast<int>(in.get_varint()) - 1 });
+    }
+
+    get_ids(in, out.created);
+
+    if (!in.ok() or (!keyframe and !has_prev)) {
+        reset();
+        return false;
+    }
+
+    std::int64_t ticks_since_prev = tick - prev_tick;
+    current.clear();
+
+    if (keyframe) {
+        std::vector<int> ids;
+        get_ids(in, ids);
+        for (int id : ids) {
+            current.push_back(get_absolute(in, id));
+        }
+    }
+    else {
+        // This frame's bodies are the previous frame's, less those removed, merged with those created, all ordered by id.
+        auto prev_it = prev.begin();
+        auto removed_it = removed_ids.begin();
+        auto created_it = out.created.begin();
+
+        while (in.ok() and (prev_it != prev.end() or created_it != out.created.end())) {
+            if (prev_it != prev.end() and removed_it != removed_ids.end() and *removed_it == prev_it->id) {
+                ++prev_it;
+                ++removed_it;
+                continue;
+            }
+
+            if (created_it != out.created.end() and (prev_it == prev.end() or *created_it < prev_it->id)) {
+                current.push_back(get_absolute(in, *created_it));
+                ++created_it;
+                continue;
+            }
+
+            const QuantizedBody& before = *prev_it;
+            QuantizedBody body {};
+            body.id = before.id;
+            body.vel_x = before.vel_x + in.get_signed_varint();
+            body.vel_y = before.vel_y + in.get_signed_varint();
+            body.pos_x = before.pos_x + body.vel_x * ticks_since_prev + in.get_signed_varint();
+            body.pos_y = before.pos_y + body.vel_y * ticks_since_prev + in.get_signed_varint();
+            body.mass = before.mass + in.get_signed_varint();
+            current.push_back(body);
+            ++prev_it;
+        }
+    }
+
+    if (!in.ok()) {
+        reset();
+        return false;
+    }
+
+    out.tick = tick;
+    for (const QuantizedBody& body : current) {
+        out.ids.push_back(body.id);
+        out.positions.push_back({ dequantize(body.pos_x, step), dequantize(body.pos_y, step) });
+        out.velocities.push_back({ dequantize(body.vel_x, step), dequantize(body.vel_y, step) });
+        out.masses.push_back(static_cast<long>(body.mass));
+    }
+
+    std::swap(prev, current);
+    prev_tick = tick;
+    has_prev = true;
+    return true;
+}
+
+void TrajectoryDecoder::reset()
+{
+    prev.clear();
+    has_prev = false;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "SimTypes.h"
+
+class ByteWriter;
+class ByteReader;
+
+/*
+* The format of recorded trajectories: the state of every body at a series of recorded ticks.
+*
+* A trajectory file is laid out as:
+*   header: magic, format version, byte order mark, quantization step, ticks between frames, frames per chunk,
+*           and the settings of the recorded universe.
+*   chunks: a chunk header (marker, payload size, first and last tick, number of frames), then the frames' payload.
+*           The first frame of every chunk is a keyframe, so a chunk can be decoded without any chunk before it.
+*   index:  where each chunk starts along with its ticks, then a footer with the index's offset and an index marker.
+*           Written when recording ends. A file whose recording was cut short has no index, and is read by scanning its chunks.
+*
+* Positions and velocities are quantized to multiples of the quantization step. Each frame stores the bodies ordered by id, and
+*   keyframes: every body's id, quantized position and velocity, and mass.
+*   other frames: for bodies in the previous frame, the difference between the quantized position and where the previous
+*                 frame's position and velocity predict it, the change in quantized velocity, and the change in mass.
+*                 Bodies that are new since the previous frame are stored as in a keyframe.
+* Differences are taken from the previous frame's quantized values, not its exact ones, so rounding errors don't add up.
+* Bodies mostly move as their velocity says and rarely change mass, so most differences fit in a byte.
+* Every frame also lists the bodies removed since the previous frame, with the body that absorbed each, and the bodies created.
+*/
+namespace TrajectoryFormat
+{
+	constexpr std::array<char, 8> MAGIC { 'P', 'L', 'A', 'N', 'E', 'T', 'T', 'R' };
+	constexpr std::array<char, 8> INDEX_MAGIC { 'P', 'L', 'T', 'R', 'I', 'N', 'D', 'X' };
+	constexpr std::uint32_t CHUNK_MARKER = 0x4b4e4843; // "CHNK"
+	constexpr std::uint32_t VERSION = 1;
+
+	// Written as a native integer, so a file from a machine with another byte order reads it differently.
+	constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	// Size of a chunk header: marker, payload size, first tick, last tick and number of frames.
+	constexpr size_t CHUNK_HEADER_SIZE = 4 + 4 + 4 + 4 + 4;
+
+	// Size of an index entry: offset of the chunk header, first tick, last tick and number of frames.
+	constexpr size_t INDEX_ENTRY_SIZE = 8 + 4 + 4 + 4;
+
+	// Size of the footer after the index: offset of the index and the index marker.
+	constexpr size_t FOOTER_SIZE = 8 + 8;
+
+	// Size a frame would take stored as plain arrays, for measuring compression.
+	constexpr size_t RAW_BODY_SIZE = sizeof(std::int32_t) + 4 * sizeof(float) + sizeof(std::int64_t);
+	constexpr size_t RAW_EVENT_SIZE = 2 * sizeof(std::int32_t);
+}
+
+// A body removed between two recorded ticks, and the body that absorbed it, or -1 if it was deleted.
+struct RemovedBody
+{
+	int id = -1;
+	int absorbed_by = -1;
+};
+
+// The state of every body at one recorded tick.
+struct TrajectoryFrame
+{
+	int tick = 0;
+
+	// Body state, with a body's fields at the same index in each. Ordered by id when decoded, in any order when recorded.
+	std::vector<int> ids;
+	std::vector<Vector2> positions;
+	std::vector<Vector2> velocities;
+	std::vector<long> masses;
+
+	// Bodies removed since the previous recorded tick. When recording, may also list bodies removed before they were ever recorded.
+	std::vector<RemovedBody> removed;
+
+	// Ids of the bodies created since the previous recorded tick. Only set when decoded.
+	std::vector<int> created;
+
+	// Empties the frame, keeping its storage.
+	void clear();
+
+	int get_num_bodies() const;
+};
+
+// Quantized state of the bodies in the previous frame, ordered by id. What deltas are taken from and applied to.
+struct QuantizedBody
+{
+	int id;
+	std::int64_t pos_x;
+	std::int64_t pos_y;
+	std::int64_t vel_x;
+	std::int64_t vel_y;
+	std::int64_t mass;
+};
+
+// Encodes frames, each as a keyframe or as changes from the frame encoded before it.
+class TrajectoryEncoder
+{
+	float step;
+	int prev_tick = 0;
+	bool has_prev = false;
+
+	std::vector<QuantizedBody> prev;
+	std::vector<QuantizedBody> current;
+
+	// Removals of the frame being encoded, sorted by id.
+	std::vector<RemovedBody> removals;
+
+public:
+
+	// Positions and velocities are quantized to multiples of step.
+	explicit TrajectoryEncoder(float step);
+
+	// Appends the frame to out. The first frame encoded is always a keyframe.
+	void encode(const TrajectoryFrame& frame, bool keyframe, ByteWriter& out);
+};
+
+// Decodes frames in the order they were encoded, from a keyframe on.
+class TrajectoryDecoder
+{
+	float step;
+	int prev_tick = 0;
+	bool has_prev = false;
+
+	std::vector<QuantizedBody> prev;
+	std::vector<QuantizedBody> current;
+
+public:
+
+	explicit TrajectoryDecoder(float step);
+
+	// Decodes the next frame into out. Returns false if the data is corrupt, or the frame isn't a keyframe and
+	// the frame before it wasn't decoded. The decoder is then reset, and has to start again from a keyframe.
+	bool decode(ByteReader& in, TrajectoryFrame& out);
+
+	// Forgets the previous frame, so the next frame decoded has to be a keyframe.
+	void reset();
+};
@@ -0,0 +1,239 @@
+#include "TrajectoryRecorder.h"
+#include "Universe.h"
+#include "Checkpoint.h"
+#include "ByteStream.h"
+
+using namespace TrajectoryFormat;
+
+double TrajectoryRecorder::Stats::compression_ratio() const
+{
+    return compressed_bytes > 0 ? static_cast<double>(raw_bytes) / compressed_bytes : 0.0;
+}
+
+double TrajectoryRecorder::Stats::frames_per_second() const
+{
+    return seconds > 0.0 ? frames_written / seconds : 0.0;
+}
+
+double TrajectoryRecorder::Stats::raw_megabytes_per_second() const
+{
+    return seconds > 0.0 ? raw_bytes / seconds / (1024.0 * 1024.0) : 0.0;
+}
+
+TrajectoryRecorder::TrajectoryRecorder(const std::filesystem::path& path, Universe& universe, const Settings& settings)
+    : settings(settings),
+      pool(settings.queue_frames),
+      queued_frames(settings.queue_frames),
+      free_frames(settings.queue_frames),
+      next_tick(universe.get_tick()),
+      out(path, std::ios::binary | std::ios::trunc),
+      encoder(settings.step)
+{
+    for (TrajectoryFrame& frame : pool) {
+        free_frames.try_push(&frame);
+    }
+
+    removal_listener = universe.removal_event().add_observer([this](const RemovalBatch& removals) {
+        for (const Removal& removal : removals) {
+            pending_removals.push_back({ removal.removed, removal.absorbed_by });
+        }
+    });
+
+    std::vector<std::byte> header;
+    ByteWriter writer(header);
+    writer.put(MAGIC);
+    writer.put<std::uint32_t>(VERSION);
+    writer.put<std::uint32_t>(BYTE_ORDER_MARK);
+    writer.put<float>(settings.step);
+    writer.put<std::int32_t>(settings.record_every);
+    writer.put<std::int32_t>(settings.frames_per_chunk);
+
+    std::vector<std::byte> settings_record;
+    ByteWriter settings_writer(settings_record);
+    Checkpoint::write_settings(settings_writer, universe.get_settings());
+    writer.put<std::uint32_t>(settings_record.size());
+    writer.put_bytes(settings_record);
+
+    write(header);
+
+    writer_thread = std::jthread([this](std::stop_token stop) { write_frames(stop); });
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    close();
+}
+
+void TrajectoryRecorder::record(const Universe& universe)
+{
+    if (universe.get_tick() < next_tick or writer_thread.get_stop_token().stop_requested()) {
+        return;
+    }
+
+    std::optional<TrajectoryFrame*> popped = free_frames.try_pop();
+    if (!popped) {
+        // The writer is behind. Try again next tick, keeping the removals for whichever frame is recorded next.
+        frames_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TrajectoryFrame& frame = **popped;
+    frame.clear();
+    frame.tick = universe.get_tick();
+
+    const BodyList& bodies = universe.get_bodies();
+    frame.ids.reserve(bodies.size());
+    frame.positions.reserve(bodies.size());
+    frame.velocities.reserve(bodies.size());
+    frame.masses.reserve(bodies.size());
+
+    for (const Body& body : bodies) {
+        frame.ids.push_back(body.get_id());
+        frame.positions.push_back(body.pos());
+        frame.velocities.push_back(body.vel());
+        frame.masses.push_back(body.get_mass());
+    }
+
+    // The frame's emptied removals become the next pending ones, so their storage is reused too.
+    std::swap(frame.removed, pending_removals);
+
+    // Can't fail: there are no more frames than the queue holds.
+    queued_frames.try_push(&frame);
+    next_tick = frame.tick + settings.record_every;
+}
+
+void TrajectoryRecorder::close()
+{
+    if (!writer_thread.joinable()) {
+        return;
+    }
+
+    writer_thread.request_stop();
+    writer_thread.join();
+    removal_listener.detach();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    closed_after.store(elapsed.count());
+}
+
+TrajectoryRecorder::Stats TrajectoryRecorder::get_stats() const
+{
+    Stats stats;
+    stats.frames_written = frames_written.load(std::memory_order_relaxed);
+    stats.frames_dropped = frames_dropped.load(std::memory_order_relaxed);
+    stats.raw_bytes = raw_bytes.load(std::memory_order_relaxed);
+    stats.compressed_bytes = compressed_bytes.load(std::memory_order_relaxed);
+    stats.failed = failed.load(std::memory_order_relaxed);
+
+    stats.seconds = closed_after.load();
+    if (stats.seconds < 0.0) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        stats.seconds = elapsed.count();
+    }
+
+    return stats;
+}
+
+void TrajectoryRecorder::write_frames(std::stop_token stop)
+{
+    while (true) {
+        // Checked before draining, so frames queued before the stop was requested are always written.
+        bool stopping = stop.stop_requested();
+
+        while (std::optional<TrajectoryFrame*> frame = queued_frames.try_pop()) {
+            encode(**frame);
+            free_frames.try_push(std::move(*frame));
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        std::this_thread::sleep_for(WRITER_POLL);
+    }
+
+    write_chunk();
+    write_index();
+    out.close();
+}
+
+void TrajectoryRecorder::encode(const TrajectoryFrame& frame)
+{
+    if (chunk_entry.num_frames == 0) {
+        chunk_entry.first_tick = frame.tick;
+    }
+
+    size_t size_before = chunk.size();
+    ByteWriter writer(chunk);
+    encoder.encode(frame, chunk_entry.num_frames == 0, writer);
+
+    chunk_entry.last_tick = frame.tick;
+    chunk_entry.num_frames++;
+
+    raw_bytes.fetch_add(sizeof(std::int32_t) + frame.get_num_bodies() * RAW_BODY_SIZE + frame.removed.size() * RAW_EVENT_SIZE,
+        std::memory_order_relaxed);
+    compressed_bytes.fetch_add(chunk.size() - size_before, std::memory_order_relaxed);
+    frames_written.fetch_add(1, std::memory_order_relaxed);
+
+    if (chunk_entry.num_frames == settings.frames_per_chunk) {
+        write_chunk();
+    }
+}
+
+void TrajectoryRecorder::write_chunk()
+{
+    if (chunk_entry.num_frames == 0) {
+        return;
+    }
+
+    chunk_entry.offset = file_size;
+    chunk_index.push_back(chunk_entry);
+
+    std::vector<std::byte> header;
+    header.reserve(CHUNK_HEADER_SIZE);
+    ByteWriter writer(header);
+    writer.put<std::uint32_t>(CHUNK_MARKER);
+    writer.put<std::uint32_t>(chunk.size());
+    writer.put<std::int32_t>(chunk_entry.first_tick);
+    writer.put<std::int32_t>(chunk_entry.last_tick);
+    writer.put<std::int32_t>(chunk_entry.num_frames);
+
+    write(header);
+    write(chunk);
+    compressed_bytes.fetch_add(CHUNK_HEADER_SIZE, std::memory_order_relaxed);
+
+    chunk.clear();
+    chunk_entry = {};
+}
+
+void TrajectoryRecorder::write_index()
+{
+    std::vector<std::byte> index;
+    ByteWriter writer(index);
+    for (const ChunkEntry& entry : chunk_index) {
+        writer.put<std::uint64_t>(entry.offset);
+        writer.put<std::int32_t>(entry.first_tick);
+        writer.put<std::int32_t>(entry.last_tick);
+        writer.put<std::int32_t>(entry.num_frames);
+    }
+
+    writer.put<std::uint64_t>(file_size);
+    writer.put(INDEX_MAGIC);
+    write(index);
+    out.flush();
+
+    if (!out) {
+        failed = true;
+    }
+}
+
+void TrajectoryRecorder::write(std::span<const std::byte> bytes)
+{
+    if (failed or !out) {
+        failed = true;
+        return;
+    }
+
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    file_size += bytes.size();
+}
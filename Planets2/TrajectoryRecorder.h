@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "SpscQueue.h"
+#include "Event.h"
+#include "Removal.h"
+#include "TrajectoryFormat.h"
+
+class Universe;
+
+/*
+* Records the bodies of a universe at every recorded tick to a trajectory file, as laid out in TrajectoryFormat.h.
+*
+* Recording a tick only copies the bodies into a frame from a fixed pool and queues it, so it never waits on the disk.
+* A writer thread encodes the queued frames and writes them out a chunk at a time, then returns the frames to the pool.
+* If the writer falls behind and the pool runs out, ticks aren't recorded until a frame is returned, and are counted as dropped.
+* Removals in dropped ticks are carried to the next recorded frame, so no removal is lost.
+*
+* record is called by the thread updating the universe, after every tick. The recorder has to be destroyed on that thread too.
+*/
+class TrajectoryRecorder
+{
+public:
+
+	struct Settings
+	{
+		// Ticks between recorded frames.
+		int record_every = 1;
+
+		// Positions and velocities are recorded as multiples of this.
+		float step = 1.0f / 256.0f;
+
+		// Frames in each chunk. The first is a keyframe, so seeking decodes at most this many frames.
+		int frames_per_chunk = 64;
+
+		// Frames that can wait for the writer before ticks are dropped.
+		int queue_frames = 64;
+	};
+
+	struct Stats
+	{
+		long long frames_written = 0;
+		long long frames_dropped = 0;
+
+		// Size of the written frames stored as plain arrays, and their size as written.
+		long long raw_bytes = 0;
+		long long compressed_bytes = 0;
+
+		// Time since recording started, or how long it lasted once closed.
+		double seconds = 0.0;
+
+		// True if the file couldn't be created or written to. Frames are still taken, but nothing more is written.
+		bool failed = false;
+
+		double compression_ratio() const;
+		double frames_per_second() const;
+		double raw_megabytes_per_second() const;
+	};
+
+private:
+
+	// How long the writer waits between checks while the queue is empty.
+	static constexpr std::chrono::milliseconds WRITER_POLL { 2 };
+
+	struct ChunkEntry
+	{
+		std::uint64_t offset;
+		int first_tick;
+		int last_tick;
+		int num_frames;
+	};
+
+	const Settings settings;
+
+	// Frames, and the queues passing them to the writer and back. Pool frames keep their storage, so a steady universe doesn't allocate.
+	std::vector<TrajectoryFrame> pool;
+	SpscQueue<TrajectoryFrame*> queued_frames;
+	SpscQueue<TrajectoryFrame*> free_frames;
+
+	// Only touched by the recording thread.
+	std::vector<RemovedBody> pending_removals;
+	EventHandle<RemovalBatch> removal_listener;
+	int next_tick = 0;
+
+	// Only touched by the writer once it has started.
+	std::ofstream out;
+	std::uint64_t file_size = 0;
+	TrajectoryEncoder encoder;
+	std::vector<std::byte> chunk;
+	ChunkEntry chunk_entry {};
+	std::vector<ChunkEntry> chunk_index;
+
+	std::atomic<long long> frames_written = 0;
+	std::atomic<long long> frames_dropped = 0;
+	std::atomic<long long> raw_bytes = 0;
+	std::atomic<long long> compressed_bytes = 0;
+	std::atomic<bool> failed = false;
+
+	std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+	std::atomic<double> closed_after = -1.0;
+
+	// Declared last, so the writer is joined before anything it uses is destroyed.
+	std::jthread writer_thread;
+
+	// Encodes queued frames until asked to stop, then writes what is left of the last chunk and the index.
+	void write_frames(std::stop_token stop);
+
+	void encode(const TrajectoryFrame& frame);
+
+	// Writes the chunk being encoded, if it has any frames.
+	void write_chunk();
+
+	void write_index();
+
+	void write(std::span<const std::byte> bytes);
+
+public:
+
+	// Creates the file and writes its header, then starts the writer. Removals are listened for from now on.
+	TrajectoryRecorder(const std::filesystem::path& path, Universe& universe, const Settings& settings);
+
+	// Finishes the file.
+	~TrajectoryRecorder();
+
+	TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+	TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+	// Queues a frame of the universe if a frame is due at its tick. The first call always records.
+	void record(const Universe& universe);
+
+	// Stops recording, waiting until every queued frame and the index are written.
+	void close();
+
+	// Safe to call from any thread.
+	Stats get_stats() const;
+};
@@ -0,0 +1,895 @@
+#include "Universe.h"
+#include "MyRandom.h"
+#include "SimTypes.h"
+#include "Physics.h"
+#include <algorithm>
+#include <execution>
+#include <unordered_map>
+#include <iterator>
+#include <chrono>
+#include <utility>
+
+#include "Collision.h"
+#include "Removal.h"
+#include "Checkpoint.h"
+
+#include "Orbit.h"
+#include <numbers>
+
+Universe::Universe(const UniverseSettings& to_set, std::unique_ptr<SpatialPartitioning>&& partitioning, Empty)
+	: settings(to_set),
+	dimensions { -settings.universe_size_max / 2.0f, -settings.universe_size_max / 2.0f, settings.universe_size_max , settings.universe_size_max },
+	barnes_quad { settings.universe_size_max, settings.grav_approximation_value }
+{
+	adopt_partitioning(std::move(partitioning));
+
+	if (settings.auto_tune_partitioning)
+	{
+		tuner = std::make_unique<PartitioningTuner>(settings.universe_size_max);
+	}
+
+	active_bodies.reserve(settings.universe_capacity);
+}
+
+Universe::Universe(const UniverseSettings& to_set, std::unique_ptr<SpatialPartitioning>&& partitioning)
+	: Universe(to_set, std::move(partitioning), Empty {})
+{
+	// Every generated body is added at once, so the partitioning can insert them in bulk.
+	std::vector<Body> generated;
+	for (int i = 0; i < settings.num_rand_systems; ++i)
+	{
+		std::ranges::move(create_rand_system(), std::back_inserter(generated));
+	}
+
+	for (int i = 0; i < settings.num_rand_planets; ++i)
+	{
+		long planet_mass = Rand::num(1, settings.RAND_MASS * 50); // rand_mass is max mass of random planet
+
+		float x = Rand::real(-settings.universe_size_start, settings.universe_size_start);
+		float y = Rand::real(-settings.universe_size_start, settings.universe_size_start);
+
+		generated.emplace_back(x, y, planet_mass);
+	}
+
+	add_bodies(std::move(generated));
+}
+
+Universe::Universe(const CheckpointFile& checkpoint, std::unique_ptr<SpatialPartitioning>&& partitioning)
+	: Universe(checkpoint.get_settings(), std::move(partitioning), Empty {})
+{
+	active_bodies.restore(checkpoint.make_bodies(), checkpoint.get_next_id());
+	partition_all_bodies();
+
+	tick = checkpoint.get_tick();
+	num_collision_checks = checkpoint.get_num_collision_checks();
+	num_swept_collisions = checkpoint.get_num_swept_collisions();
+
+	Rand::set_state(checkpoint.get_rng_state());
+}
+
+void Universe::restore(std::vector<Body>&& bodies, int next_id, int to_tick, int collision_checks, int swept_collisions)
+{
+	// The earlier state is in the universe's past, so a current body whose id is in it is the same body.
+	std::vector<bool> kept(std::max(active_bodies.get_next_id(), next_id), false);
+	for (const Body& body : bodies)
+	{
+		kept[body.get_id()] = true;
+	}
+
+	std::vector<const Body*> current;
+	std::vector<Removal> vanished;
+	current.reserve(active_bodies.size());
+	for (const Body& body : active_bodies)
+	{
+		current.push_back(&body);
+		if (!kept[body.get_id()])
+		{
+			vanished.push_back({ body.get_id() });
+		}
+	}
+
+	// The partitioning lets go of every body before their storage is reused.
+	partitioning_method->rem_bodies(current);
+	active_bodies.restore(std::move(bodies), next_id);
+	partition_all_bodies();
+
+	tick = to_tick;
+	num_collision_checks = collision_checks;
+	num_swept_collisions = swept_collisions;
+
+	if (!vanished.empty())
+	{
+		on_removal_observers.notify_all(vanished);
+	}
+}
+
+void Universe::add_body(Body&& body)
+{
+	if (!can_create_body())
+	{
+		return;
+	}
+
+	if (!in_bounds(body.pos()))
+	{
+		return;
+	}
+
+	partitioning_method->add_body(active_bodies.add(std::move(body)));
+	partitioning_changed = true;
+}
+
+void Universe::add_bodies(std::vector<Body>&& bodies)
+{
+	int prev_size = active_bodies.size();
+
+	int remaining_space = settings.universe_capacity - prev_size;
+
+	// Enforce that adding bodies doesnt go over capacity.
+	int adding = std::min(static_cast<int>(bodies.size()), remaining_space);
+
+	// The partitioning is given them all at once, so it can insert them in bulk.
+	std::vector<Body*> added;
+	added.reserve(adding);
+	for (auto it = bodies.begin(); it != bodies.begin() + adding; it++)
+	{
+		if (in_bounds(it->pos()))
+		{
+			added.push_back(&active_bodies.add(std::move(*it)));
+		}
+	}
+
+	bodies.clear();
+
+	if (!added.empty())
+	{
+		partitioning_method->add_bodies(added);
+		partitioning_changed = true;
+	}
+
+}
+
+bool Universe::can_create_body() const
+{
+	return active_bodies.size() < settings.universe_capacity;
+}
+
+void Universe::handle_wraparound(Body& body)
+{
+	Vector2 pos = body.pos();
+	float wraparound_val = settings.universe_size_max / 2;
+	float reset_val = 2 * wraparound_val;
+
+	if (pos.x > wraparound_val)
+	{
+		pos.x = -reset_val + pos.x;
+	}
+	else if (pos.x < -wraparound_val)
+	{
+		pos.x = reset_val + pos.x;
+	}
+
+	if (pos.y > wraparound_val)
+	{
+		pos.y = -reset_val + pos.y;
+	}
+	else if (pos.y < -wraparound_val)
+	{
+		pos.y = reset_val + pos.y;
+	}
+
+	body.set_pos(pos);
+}
+
+void Universe::handle_gravity()
+{
+	std::for_each(std::execution::par_unseq, active_bodies.begin(), active_bodies.end(), [this](Body& body1)
+	{
+		Vector2 net_force = { 0, 0 };
+
+		for (const Body& body2 : active_bodies)
+		{
+			net_force = Vector2Add(net_force, body1.force_applied_by(body2));
+		}
+
+		net_force = Vector2Scale(net_force, settings.grav_const);
+		body1.apply_force(net_force);
+	});
+}
+
+void Universe::handle_gravity_approximation()
+{
+	const BarnesHut& tree = shared_gravity_tree ? *shared_gravity_tree : barnes_quad;
+
+	std::for_each(std::execution::par_unseq, active_bodies.begin(), active_bodies.end(), [this, &tree](Body& body)
+	{
+		Vector2 net_force = tree.force_applied_to(body);
+		body.apply_force(Vector2Scale(net_force, settings.grav_const));
+	});
+
+}
+
+void Universe::handle_removals(RemovalBatch removals)
+{
+	std::vector<const Body*> removed;
+	removed.reserve(removals.size());
+
+	std::vector<Body*> absorbers;
+	std::vector<float> old_radii;
+
+	for (Removal removal : removals)
+	{
+		removed.push_back(active_bodies.get(removal.removed));
+
+		if (removal.was_absorbed())
+		{
+			Body* absorber = active_bodies.get(removal.absorbed_by);
+
+			// Bodies of a group are listed together, so an absorber repeats only within its run.
+			if (absorbers.empty() or absorbers.back() != absorber)
+			{
+				absorbers.push_back(absorber);
+				old_radii.push_back(absorber->get_radius());
+			}
+		}
+	}
+
+	partitioning_method->rem_bodies(removed);
+
+	// The state of the bodies is taken as each is absorbed, since it's gone once it has been.
+	std::vector<RemovalRecord> records;
+	bool recording = on_removal_record_observers.has_observers();
+	if (recording)
+	{
+		records.reserve(removals.size());
+	}
+
+	for (int i = 0; i < removals.size(); ++i)
+	{
+		Removal removal = removals[i];
+		Body* absorber = removal.was_absorbed() ? active_bodies.get(removal.absorbed_by) : nullptr;
+
+		if (recording)
+		{
+			RemovalRecord& record = records.emplace_back();
+			record.tick = tick;
+			record.removed = removal.removed;
+			record.absorbed_by = removal.absorbed_by;
+			record.removed_mass = removed[i]->get_mass();
+			record.removed_pos = removed[i]->pos();
+			record.removed_vel = removed[i]->vel();
+
+			if (absorber)
+			{
+				record.absorber_mass = absorber->get_mass();
+				record.absorber_pos = absorber->pos();
+				record.absorber_vel = absorber->vel();
+			}
+		}
+
+		if (absorber)
+		{
+			absorber->absorb(*removed[i]);
+		}
+	}
+
+	// Absorbers grow in place, so the partitioning only has to fit their new radius.
+	partitioning_method->notify_radii_changed(absorbers, old_radii);
+
+	for (int i = 0; i < removals.size(); ++i)
+	{
+		active_bodies.rem(*removed[i]);
+	}
+
+	partitioning_changed = true;
+	on_removal_observers.notify_all(removals);
+
+	if (recording)
+	{
+		on_removal_record_observers.notify_all(records);
+	}
+}
+
+std::vector<Body*> Universe::update_pos()
+{
+	std::for_each(std::execution::par_unseq, active_bodies.begin(), active_bodies.end(), [this](Body& body)
+	{
+		body.pos_update();
+		handle_wraparound(body);
+	});
+
+	std::vector<Body*> moved;
+	if (partitioning_uses_bounds)
+	{
+		// Scanned in list order, so the partitioning sees the same order every run.
+		for (Body& body : active_bodies)
+		{
+			if (body.left_partition_bounds())
+			{
+				moved.push_back(&body);
+			}
+		}
+	}
+
+	return moved;
+}
+
+std::vector<float> Universe::gen_rand_portions(int num_slots) const
+{
+	std::vector<float> slots;
+	slots.reserve(num_slots);
+
+	float sum = 0.0f;
+	for (int i = 0; i < num_slots; ++i)
+	{
+		float lot = Rand::real();
+		slots.emplace_back(lot);
+		sum += lot;
+	}
+
+	// map from [0:1] of total sum.
+	for (int i = 0; i < num_slots; ++i)
+	{
+		slots[i] /= sum;
+	}
+
+	return slots;
+}
+
+bool Universe::in_bounds(Vector2 point) const
+{
+	return Physics::point_in_rect(point, dimensions);
+}
+
+std::vector<Removal> Universe::group_merges(std::span<const Collision> collisions) const
+{
+	/*
+	* A simple handling of collisions. The bigger object completely absorbs the smaller object.
+	* Bodies in a chain of collisions (A touches B, B touches C) all merge into the most massive one in the same tick.
+	*
+	* However, since this method is in charge of what happens when a collision occurs (spatial partitionings and physics delegate that decision making to here),
+	* it should be easy to add more complex and customizable collision mechanics later if wanted.
+	*
+	*/
+
+	// Union-find over every body that is part of a collision.
+	std::vector<Body*> members;
+	std::vector<int> parent;
+	std::unordered_map<const Body*, int> member_index;
+
+	auto index_of = [&](Body& body)
+	{
+		auto [it, inserted] = member_index.try_emplace(&body, members.size());
+		if (inserted)
+		{
+			members.push_back(&body);
+			parent.push_back(it->second);
+		}
+
+		return it->second;
+	};
+
+	auto find_root = [&parent](int index)
+	{
+		while (parent[index] != index)
+		{
+			// Path halving.
+			parent[index] = parent[parent[index]];
+			index = parent[index];
+		}
+
+		return index;
+	};
+
+	// The root of a group is always its most massive body. Ties go to the lower id, so merges don't depend on collision order.
+	auto heavier = [&members](int index1, int index2)
+	{
+		const Body& body1 = *members[index1];
+		const Body& body2 = *members[index2];
+		return body1.get_mass() != body2.get_mass() ? body1.get_mass() > body2.get_mass() : body1.get_id() < body2.get_id();
+	};
+
+	for (const Collision& collision : collisions)
+	{
+		int root1 = find_root(index_of(collision.bigger));
+		int root2 = find_root(index_of(collision.smaller));
+
+		if (root1 != root2)
+		{
+			if (heavier(root1, root2))
+			{
+				parent[root2] = root1;
+			}
+			else
+			{
+				parent[root1] = root2;
+			}
+		}
+	}
+
+	// List each group's removals together, ordered by the ids of absorbers and then of removed bodies.
+	// So the order bodies merge and leave the body list in doesn't depend on the order collisions were found in,
+	// and the universe evolves the same whichever partitioning method finds them, including after being restored from a checkpoint.
+	std::vector<std::pair<int, int>> merges;
+	merges.reserve(members.size());
+	for (int i = 0; i < members.size(); ++i)
+	{
+		int root = find_root(i);
+		if (root != i)
+		{
+			merges.emplace_back(members[root]->get_id(), members[i]->get_id());
+		}
+	}
+
+	std::ranges::sort(merges);
+
+	std::vector<Removal> removals;
+	removals.reserve(merges.size());
+
+	for (auto [absorber, removed] : merges)
+	{
+		removals.emplace_back(removed, absorber);
+	}
+
+	return removals;
+}
+
+void Universe::handle_collisions(std::span<const Collision> collisions)
+{
+	if (collisions.empty())
+	{
+		return;
+	}
+
+	std::vector<Removal> removals = group_merges(collisions);
+	handle_removals(removals);
+}
+
+void Universe::handle_collisions_continuous(std::span<const Collision> collisions)
+{
+	std::vector<SweptCollisions::Impact> missed = SweptCollisions::find_missed(active_bodies, *partitioning_method);
+	num_swept_collisions += missed.size();
+
+	if (collisions.empty() and missed.empty())
+	{
+		return;
+	}
+
+	std::vector<SweptCollisions::Impact> impacts;
+	impacts.reserve(collisions.size() + missed.size());
+
+	for (const Collision& collision : collisions)
+	{
+		// Bodies touching at the end of the tick touched by then at the latest.
+		float time = SweptCollisions::time_of_impact(collision.bigger, collision.smaller).value_or(1.0f);
+		impacts.push_back({ collision, time });
+	}
+
+	std::ranges::copy(missed, std::back_inserter(impacts));
+
+	std::vector<Collision> all;
+	all.reserve(impacts.size());
+	for (const SweptCollisions::Impact& impact : impacts)
+	{
+		all.push_back(impact.collision);
+	}
+
+	std::vector<Removal> removals = group_merges(all);
+
+	std::unordered_map<int, int> absorbed_by;
+	for (Removal removal : removals)
+	{
+		absorbed_by[removal.removed] = removal.absorbed_by;
+	}
+
+	// Earliest impact of each group, by the id of the group's absorber.
+	std::unordered_map<int, float> earliest;
+	for (const SweptCollisions::Impact& impact : impacts)
+	{
+		int id = impact.collision.bigger.get_id();
+		auto it = absorbed_by.find(id);
+		int absorber = it != absorbed_by.end() ? it->second : id;
+
+		auto [earliest_it, inserted] = earliest.try_emplace(absorber, impact.time);
+		earliest_it->second = std::min(earliest_it->second, impact.time);
+	}
+
+	// Where each absorber was at its group's impact, found before absorbing changes its velocity.
+	struct Rewind {
+		Body* absorber;
+		Vector2 impact_pos;
+		float time_left;
+	};
+
+	std::vector<Rewind> rewinds;
+	rewinds.reserve(earliest.size());
+	for (auto [id, time] : earliest)
+	{
+		Body* absorber = active_bodies.get(id);
+		float time_left = 1.0f - time;
+		rewinds.push_back({ absorber, Vector2Subtract(absorber->pos(), Vector2Scale(absorber->vel(), time_left)), time_left });
+	}
+
+	handle_removals(removals);
+
+	// The partitioning files absorbers by where they are, so they're taken out before moving and put back after.
+	std::vector<const Body*> moving;
+	std::vector<Body*> moved;
+	moving.reserve(rewinds.size());
+	moved.reserve(rewinds.size());
+
+	for (const Rewind& rewind : rewinds)
+	{
+		moving.push_back(rewind.absorber);
+		moved.push_back(rewind.absorber);
+	}
+
+	partitioning_method->rem_bodies(moving);
+
+	// The merged body moves on from the impact with its new velocity, wrapping around as any other move does.
+	for (const Rewind& rewind : rewinds)
+	{
+		rewind.absorber->set_pos(Vector2Add(rewind.impact_pos, Vector2Scale(rewind.absorber->vel(), rewind.time_left)));
+		handle_wraparound(*rewind.absorber);
+	}
+
+	partitioning_method->add_bodies(moved);
+}
+
+void Universe::update()
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Each phase is timed from the end of the one before it.
+	Clock::time_point phase_start = Clock::now();
+	auto end_phase = [&phase_start](double& total_ms)
+	{
+		Clock::time_point now = Clock::now();
+		total_ms += std::chrono::duration<double, std::milli>(now - phase_start).count();
+		phase_start = now;
+	};
+
+	std::for_each(std::execution::par_unseq, active_bodies.begin(), active_bodies.end(), [](Body& body)
+	{
+		body.reset_forces();
+	});
+
+	// do grav pulls (update acceleration)
+	if (settings.use_gravity_approximation)
+	{
+		// A shared tree was already rebuilt by the partitioning method after bodies last moved.
+		// Bodies added or removed since then changed its centers of mass in place, so it is rebuilt again,
+		// which gives the same tree a universe restored with the same bodies has. Ticks then don't depend on how the bodies got there.
+		if (!shared_gravity_tree)
+		{
+			barnes_quad.update(active_bodies.cbegin(), active_bodies.cend());
+		}
+		else if (partitioning_changed)
+		{
+			partitioning_method->update();
+		}
+
+		handle_gravity_approximation();
+	}
+	else
+	{
+		handle_gravity();
+	}
+
+	end_phase(phase_times.gravity_ms);
+
+	std::vector<Body*> moved = update_pos(); // update velocities and positions
+	end_phase(phase_times.positions_ms);
+
+	if (partitioning_uses_bounds)
+	{
+		partitioning_method->update_moved(moved);
+	}
+	else
+	{
+		partitioning_method->update();
+	}
+
+	partitioning_changed = false;
+	end_phase(phase_times.partitioning_ms);
+
+	std::vector<Collision> collisions = partitioning_method->get_collisions();
+	num_collision_checks += partitioning_method->get_collision_checks_this_tick();
+	end_phase(phase_times.collision_detection_ms);
+
+	if (settings.continuous_collisions)
+	{
+		handle_collisions_continuous(collisions);
+	}
+	else
+	{
+		handle_collisions(collisions);
+	}
+
+	end_phase(phase_times.collision_handling_ms);
+
+	tick++;
+
+	if (tuner and tuner->is_due(tick))
+	{
+		if (std::unique_ptr<SpatialPartitioning> faster = tuner->run_trial(tick, active_bodies))
+		{
+			set_partitioning(std::move(faster));
+		}
+	}
+
+	end_phase(phase_times.tuning_ms);
+}
+
+std::vector<Body> Universe::create_rand_system()
+{
+	float star_x = Rand::num(-settings.universe_size_start, settings.universe_size_start);
+	float star_y = Rand::num(-settings.universe_size_start, settings.universe_size_start);
+	return generate_rand_system(star_x, star_y);
+}
+
+void Universe::generate_rand_planets(std::vector<Body>& system, const Body& to_orbit, int num_planets, long total_mass) const
+{
+	std::vector<float> mass_ratios = gen_rand_portions(num_planets);
+
+	// Compress the maximum possible distance of a moon to its planet.
+	float moon_max_dist = std::max(settings.satellite_min_dist, settings.satellite_max_dist / 10);
+
+	for (int i = 0; i < num_planets; ++i)
+	{
+		long planet_mass = mass_ratios[i] * total_mass;
+
+		Body& planet = system.emplace_back(0.0f, 0.0f, planet_mass);
+		Orbit planet_orbit = generate_rand_orbit(to_orbit, planet);
+		planet.set_orbit(planet_orbit, Rand::real());
+
+		if (Rand::chance(settings.moon_chance))
+		{
+			// Currently only one moon can be generated per planet.
+			// Can have this eat into planet's mass instead of just adding mass (currently actual mass > system_mass with moon generation).
+			long moon_mass = Rand::real(0.01f, 0.1f) * planet.get_mass();
+
+			Body& moon = system.emplace_back(0.0f, 0.0f, moon_mass);
+			Orbit moon_orbit = generate_rand_orbit(planet, moon);
+			moon_orbit.set_periapsis(planet, Rand::real(settings.satellite_min_dist, moon_max_dist));
+			moon.set_orbit(moon_orbit, Rand::real());
+		}
+	}
+}
+
+std::vector<Body> Universe::generate_rand_system(float x, float y)
+{
+	int num_planets = Rand::num(settings.system_min_planets, settings.system_max_planets);
+
+	long system_mass = Rand::num(1, settings.RAND_MASS) * 5000; // rand_mass is max mass of random planet
+	long star_mass = settings.system_mass_ratio * system_mass;
+	long remaining_mass = system_mass * (1 - settings.system_mass_ratio);
+
+	if (Rand::chance(0.2f))
+	{
+		return generate_binary_system(x, y, num_planets, star_mass, remaining_mass);
+	}
+	else
+	{
+		return generate_unary_system(x, y, num_planets, star_mass, remaining_mass);
+	}
+}
+
+std::vector<Body> Universe::generate_binary_system(float x, float y, int num_planets, long star_mass, long remaining_mass)
+{
+	// Each planet has at most one moon. Reserving room for all of them keeps the references to the stars valid while planets are added.
+	std::vector<Body> system;
+	system.reserve(2 + num_planets * 2);
+
+	float star_mass_variance = Rand::real(0.0, 0.1);
+	Body& star1 = system.emplace_back(x, y, star_mass * (.5f + star_mass_variance));
+	Body& star2 = system.emplace_back(x, y, star_mass * (.5f - star_mass_variance));
+
+	float combined_radius = star1.get_radius() + star2.get_radius();
+
+	float dist_between_periapsis = Rand::real(15.0f, 40.0f) * combined_radius;
+	float r_primary = (dist_between_periapsis * star2.get_mass()) / star_mass;
+	float r_secondary = dist_between_periapsis - r_primary;
+
+	float angle_to_bary = Rand::radian();
+	Vector2 unit_pos { cos(angle_to_bary), sin(angle_to_bary) };
+
+	Body star1_copy = star1;
+	star1_copy.set_pos(Vector2Add({ x, y }, Vector2Scale(unit_pos, r_primary)));
+	star1_copy.set_mass(star_mass);
+	Body star2_copy = star2;
+	star2_copy.set_pos(Vector2Add({ x, y }, Vector2Scale(unit_pos, -r_secondary)));
+	star2_copy.set_mass(star_mass);
+
+	Orbit bin_orbit1 { star2_copy };
+	bin_orbit1.periapsis = dist_between_periapsis;
+	bin_orbit1.eccentricity = Rand::real(0.0f, 0.75f);
+	bin_orbit1.grav_const = settings.grav_const;
+	bin_orbit1.prograde = Rand::chance(0.5f);
+	bin_orbit1.periapsis_angle = angle_to_bary;
+
+	Orbit bin_orbit2 { star1_copy };
+	bin_orbit2.periapsis = dist_between_periapsis;
+	bin_orbit2.eccentricity = bin_orbit1.eccentricity;
+	bin_orbit2.grav_const = settings.grav_const;
+	bin_orbit2.prograde = bin_orbit1.prograde;
+	bin_orbit2.periapsis_angle = angle_to_bary - std::numbers::pi;
+
+	star1.set_orbit(bin_orbit1, 0.0);
+	star2.set_orbit(bin_orbit2, 0.0);
+	star1.set_vel(Vector2Scale(star1.vel(), (float)star2.get_mass() / star_mass));
+	star2.set_vel(Vector2Scale(star2.vel(), (float)star1.get_mass() / star_mass));
+
+	// Generate inner planets that orbit one of the stars.
+	int num_planets_split = num_planets / 2;
+	long mass_split = remaining_mass / 2;
+	generate_rand_planets(system, star1, num_planets_split, mass_split);
+	generate_rand_planets(system, star2, num_planets_split, mass_split);
+
+	return system;
+}
+
+std::vector<Body> Universe::generate_unary_system(float x, float y, int num_planets, long star_mass, long remaining_mass) const
+{
+	// Each planet has at most one moon. Reserving room for all of them keeps the reference to the star valid while planets are added.
+	std::vector<Body> system;
+	system.reserve(1 + num_planets * 2);
+
+	Body& star = system.emplace_back(x, y, star_mass);
+	generate_rand_planets(system, star, num_planets, remaining_mass);
+	return system;
+}
+
+Body* Universe::get_body(Vector2 point)
+{
+	if (!in_bounds(point))
+	{
+		return nullptr;
+	}
+
+	return partitioning_method->find_body(point);
+}
+
+Body* Universe::get_body(int search_id)
+{
+	return active_bodies.get(search_id);
+}
+
+Orbit Universe::generate_rand_orbit(const Body& orbited, const Body& orbiter) const
+{
+	Orbit orbit { orbited };
+
+	orbit.set_periapsis(orbiter, Rand::real(settings.satellite_min_dist, settings.satellite_max_dist));
+	orbit.grav_const = settings.grav_const;
+	orbit.periapsis_angle = Rand::radian();
+	orbit.eccentricity = Rand::real();
+	orbit.prograde = Rand::chance(settings.retrograde_chance) ? false : true;
+
+	return orbit;
+}
+
+
+void Universe::rem_body(Body& body)
+{
+	Removal removal { body.get_id() };
+	handle_removals({ &removal, 1 });
+}
+
+const SpatialPartitioning& Universe::get_partitioning() const
+{
+	return *partitioning_method;
+}
+
+void Universe::adopt_partitioning(std::unique_ptr<SpatialPartitioning>&& partitioning)
+{
+	if (settings.use_neighbour_lists)
+	{
+		auto lists = std::make_unique<NeighbourList>(std::move(partitioning), settings.neighbour_list_skin);
+		neighbour_lists = lists.get();
+		partitioning = std::move(lists);
+	}
+
+	partitioning_method = std::move(partitioning);
+	shared_gravity_tree = partitioning_method->get_gravity_tree();
+	partitioning_uses_bounds = partitioning_method->uses_partition_bounds();
+}
+
+void Universe::set_partitioning(std::unique_ptr<SpatialPartitioning>&& partitioning)
+{
+	adopt_partitioning(std::move(partitioning));
+	partition_all_bodies();
+}
+
+void Universe::partition_all_bodies()
+{
+	std::vector<Body*> bodies;
+	bodies.reserve(active_bodies.size());
+	for (Body& body : active_bodies)
+	{
+		bodies.push_back(&body);
+	}
+
+	partitioning_method->add_bodies(bodies);
+	partitioning_method->update();
+	partitioning_changed = false;
+}
+
+const PartitioningTuner* Universe::get_tuner() const
+{
+	return tuner.get();
+}
+
+const NeighbourList* Universe::get_neighbour_lists() const
+{
+	return neighbour_lists;
+}
+
+const UniverseSettings& Universe::get_settings() const
+{
+	return settings;
+}
+
+const BodyList& Universe::get_bodies() const
+{
+	return active_bodies;
+}
+
+std::vector<Body*> Universe::get_bodies_in_area(Rectangle area)
+{
+	return partitioning_method->query_rect(area);
+}
+
+std::vector<Body*> Universe::get_bodies_in_radius(Vector2 center, float radius)
+{
+	return partitioning_method->query_radius(center, radius);
+}
+
+std::vector<Body*> Universe::get_nearest_bodies(Vector2 point, int k)
+{
+	return partitioning_method->k_nearest(point, k);
+}
+
+BodyList& Universe::get_bodies()
+{
+	return active_bodies;
+}
+
+int Universe::get_num_bodies() const
+{
+	return active_bodies.size();
+}
+
+int Universe::get_num_collision_checks() const
+{
+	return num_collision_checks;
+}
+
+int Universe::get_num_swept_collisions() const
+{
+	return num_swept_collisions;
+}
+
+int Universe::get_num_collision_checks_tick() const
+{
+	return partitioning_method->get_collision_checks_this_tick();
+}
+
+int Universe::get_tick() const
+{
+	return tick;
+}
+
+const Universe::PhaseTimes& Universe::get_phase_times() const
+{
+	return phase_times;
+}
+
+Event<RemovalBatch>& Universe::removal_event()
+{
+	return on_removal_observers;
+}
+
+Event<RemovalRecordBatch>& Universe::removal_record_event()
+{
+	return on_removal_record_observers;
+}
@@ -0,0 +1,234 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <span>
+#include "Body.h"
+#include "UniverseSettings.h"
+#include "BarnesHut.h"
+
+#include "SpatialPartitioning.h"
+#include "Event.h"
+#include "BodyList.h"
+#include "Removal.h"
+#include "PartitioningTuner.h"
+#include "NeighbourList.h"
+#include "SweptCollisions.h"
+
+struct Collision;
+struct Vector2;
+class CheckpointFile;
+
+class Universe
+{
+public:
+
+	// Time spent in each phase of update, summed over every tick since the universe was created.
+	struct PhaseTimes
+	{
+		double gravity_ms = 0.0;
+		double positions_ms = 0.0;
+		double partitioning_ms = 0.0;
+		double collision_detection_ms = 0.0;
+		double collision_handling_ms = 0.0;
+		double tuning_ms = 0.0;
+
+		double total_ms() const { return gravity_ms + positions_ms + partitioning_ms + collision_detection_ms + collision_handling_ms + tuning_ms; }
+	};
+
+private:
+
+	// Settings that define universe generation, physics, system generation, etc.
+	UniverseSettings settings {};
+
+	// A possible partitioning method to be used in collision detection.
+	std::unique_ptr<SpatialPartitioning> partitioning_method;
+
+	// Swaps the partitioning method for whichever is fastest, if auto tuning is enabled.
+	std::unique_ptr<PartitioningTuner> tuner;
+
+	// The partitioning method, if it is wrapped in neighbour lists. Else nullptr.
+	const NeighbourList* neighbour_lists = nullptr;
+
+	// Gravity approximation method.
+	BarnesHut barnes_quad;
+
+	// True if the partitioning method sets each body's partition bounds, so only bodies that leave them need updating.
+	bool partitioning_uses_bounds = false;
+
+	// Tree kept by the partitioning method, used for gravity approximation instead of barnes_quad if not nullptr.
+	const BarnesHut* shared_gravity_tree = nullptr;
+
+	// True if bodies were added to or removed from the partitioning method since it was last updated.
+	bool partitioning_changed = false;
+
+	// Bodies being updated every tick.
+	BodyList active_bodies;
+
+	// Bounds of the universe. Bodies that go outside this rectangle wraparound.
+	Rectangle dimensions;
+
+	// Current update tick.
+	int tick = 0;
+
+	// Number of collision checks that have occurred.
+	int num_collision_checks = 0;
+
+	// Number of collisions that sweeping fast bodies found, which checking overlaps at the end of each tick missed.
+	int num_swept_collisions = 0;
+
+	PhaseTimes phase_times;
+
+	// Handles all collision events.
+	void handle_collisions(std::span<const Collision> collisions);
+
+	// Handles the tick's collisions along with any that sweeping fast bodies finds.
+	// Each group merges where its absorber was at the group's earliest impact, then moves on for the rest of the tick.
+	void handle_collisions_continuous(std::span<const Collision> collisions);
+
+	// Groups bodies that are touching, directly or through a chain of collisions.
+	// Returns a removal for every body of a group except its most massive one, which absorbs the rest.
+	std::vector<Removal> group_merges(std::span<const Collision> collisions) const;
+
+	// Applies the removals as a batch: absorbs bodies, updates the partitioning, compacts the body list, then notifies observers once.
+	void handle_removals(RemovalBatch removals);
+
+	// Updates all bodies' accelerations by applying forces to each body by each body.
+	void handle_gravity();
+
+	// Updates all bodies' accelerations by using Barnes-Hut to approximate gravitational forces.
+	void handle_gravity_approximation();
+
+	// Updates all bodies' positions accordint to their velocities and velocities according to their accelerations.
+	// Returns the bodies that left their partition bounds, if the partitioning method uses them.
+	std::vector<Body*> update_pos();
+
+	// Handles body wraparound if body has gone out of bounds.
+	void handle_wraparound(Body& body);
+
+	// Generates random portions [0, 1] between num_slots objects. Sum of all portions == 1.
+	std::vector<float> gen_rand_portions(int num_slots) const;
+
+	// Returns true if a point is within the universe's area, else false.
+	bool in_bounds(Vector2 point) const;
+
+	// Wraps the partitioning in neighbour lists if they are enabled, and keeps whatever it owns as the partitioning method.
+	void adopt_partitioning(std::unique_ptr<SpatialPartitioning>&& partitioning);
+
+	// Adds every body to the partitioning method at once, and updates it.
+	void partition_all_bodies();
+
+	// Tag for the constructor that leaves the universe without any bodies.
+	struct Empty {};
+
+	Universe(const UniverseSettings& to_set, std::unique_ptr<SpatialPartitioning>&& partitioning, Empty);
+
+	// Observers to notify when bodies have been removed.
+	Event<RemovalBatch> on_removal_observers;
+
+	// Observers to notify with the state of removed bodies and their absorbers, after the removals are published.
+	Event<RemovalRecordBatch> on_removal_record_observers;
+
+	void generate_rand_planets(std::vector<Body>& system, const Body& to_orbit, int num_planets, long total_mass) const;
+
+public:
+
+	Universe(const UniverseSettings& to_set, std::unique_ptr<SpatialPartitioning>&& partitioning);
+
+	// Restores the universe saved in the checkpoint, with its settings, bodies, tick and statistics.
+	// Bodies are put in place all at once and handed to the partitioning in bulk, rather than added one by one.
+	// Also restores the calling thread's random engine, which generates bodies for the universe.
+	Universe(const CheckpointFile& checkpoint, std::unique_ptr<SpatialPartitioning>&& partitioning);
+
+	// Puts the universe back to an earlier state of itself, given its bodies in update order and the id the next body gets.
+	// Ids given out since the earlier state aren't given out again, so the next body may get a higher id than it did then.
+	// Settings, partitioning method and phase times are kept. Bodies that aren't in the earlier state are reported to removal observers as deleted.
+	void restore(std::vector<Body>&& bodies, int next_id, int to_tick, int collision_checks, int swept_collisions);
+
+	// Returns true if the universe is not already at capacity, else false.
+	bool can_create_body() const;
+
+	// Generates a system where the central body is at (x,y), using the current settings.
+	std::vector<Body> generate_rand_system(float x, float y);
+	std::vector<Body> generate_binary_system(float x, float y, int num_planets, long star_mass, long remaining_mass);
+	std::vector<Body> generate_unary_system(float x, float y, int num_planets, long star_mass, long remaining_mass) const;
+
+	// Command to add the body to the universe.
+	void add_body(Body&& body);
+
+	// Transfers all bodies from the vector and then clears the vector.
+	void add_bodies(std::vector<Body>&& bodies);
+
+	// Returns a random orbit
+	Orbit generate_rand_orbit(const Body& orbited, const Body& orbiter) const;
+
+	// Creates a random system somewhere in the universe's starting area, for the caller to add.
+	std::vector<Body> create_rand_system();
+
+	// Returns a pointer to the partitioning method.
+	const SpatialPartitioning& get_partitioning() const;
+
+	// Replaces the partitioning method, adding every body to the new one.
+	void set_partitioning(std::unique_ptr<SpatialPartitioning>&& partitioning);
+
+	// Returns the partitioning tuner, or nullptr if auto tuning is disabled.
+	const PartitioningTuner* get_tuner() const;
+
+	// Returns the neighbour lists wrapping the partitioning method, or nullptr if they are disabled.
+	const NeighbourList* get_neighbour_lists() const;
+
+	// Returns the universe's current settings.
+	const UniverseSettings& get_settings() const;
+
+	// Removes a body from the universe.
+	void rem_body(Body& body);
+
+	// Returns the body at the coordinate, or nullptr if not found.
+	Body* get_body(Vector2 point);
+
+	// Returns the body whose id matches the given id, or nullptr if invalid id.
+	Body* get_body(int search_id);
+
+	// Returns a reference to all bodies in the universe
+	const BodyList& get_bodies() const;
+
+	// Returns all bodies at least partially in the given area.
+	std::vector<Body*> get_bodies_in_area(Rectangle area);
+
+	// Returns all bodies at least partially in the circle.
+	std::vector<Body*> get_bodies_in_radius(Vector2 center, float radius);
+
+	// Returns the (up to) k bodies whose centers are nearest to the point, nearest first.
+	std::vector<Body*> get_nearest_bodies(Vector2 point, int k);
+
+	// Returns a reference to all bodies in the universe
+	BodyList& get_bodies();
+
+	// Returns number of bodies currently in the universe.
+	int get_num_bodies() const;
+
+	// Updates the universe by 1 tick.
+	// Doesn't use random numbers, so a restored universe ticks the same whichever thread updates it.
+	void update();
+
+	// Returns the total number of collision checks that occurred since the universe was created.
+	int get_num_collision_checks() const;
+
+	// Returns the number of collisions found by continuous collision detection that overlap checks missed.
+	int get_num_swept_collisions() const;
+
+	// Returns the total number of collision checks that occurred last tick.
+	int get_num_collision_checks_tick() const;
+
+	// Returns the current tick.
+	int get_tick() const;
+
+	// Returns the time spent in each phase of update since the universe was created.
+	const PhaseTimes& get_phase_times() const;
+
+	// Returns the observer list for removals of bodies. Each tick's removals are published as one batch.
+	Event<RemovalBatch>& removal_event();
+
+	// Returns the observer list for records of removals, published right after each batch of removals.
+	// Records are only put together while there are observers. Bodies vanishing when the universe is restored aren't recorded.
+	Event<RemovalRecordBatch>& removal_record_event();
+};
@@ -30,6 +30,17 @@ struct UniverseSettings {
 	// Chance a satellite's orbit will be retrograde.
 	double retrograde_chance = 0.12;
 
+	// Also finds collisions of bodies that moved through each other within a tick, and merges bodies where they first touched.
+	bool continuous_collisions = false;
+
+	// Periodically measures other partitioning methods on the live bodies, and swaps to one that is consistently faster.
+	bool auto_tune_partitioning = false;
+
+	// Wraps the partitioning method in neighbour lists, which keep each body's collision candidates between ticks.
+	// Bodies within the skin distance of touching are listed, and the lists are rebuilt once any body moves or grows by half the skin.
+	bool use_neighbour_lists = false;
+	float neighbour_list_skin = 20.0f;
+
 	// Start generation settings
 	int num_rand_planets = 0;
 	int num_rand_systems = 1;
@@ -0,0 +1,385 @@
+#include "UniverseSnapshot.h"
+#include "Universe.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include "SimTypes.h"
+
+void UniverseSnapshot::capture(const Universe& universe, bool with_representation, std::optional<Rectangle> info_area)
+{
+    settings = &universe.get_settings();
+
+    // Storage is reused between captures, so a steady universe doesn't allocate.
+    bodies.clear();
+    for (const Body& body : universe.get_bodies()) {
+        bodies.push_back(body);
+    }
+
+    index_bodies();
+
+    tick = universe.get_tick();
+    num_collision_checks = universe.get_num_collision_checks();
+    num_collision_checks_tick = universe.get_num_collision_checks_tick();
+    num_swept_collisions = universe.get_num_swept_collisions();
+
+    tuned_partitioning.reset();
+    if (const PartitioningTuner* tuner = universe.get_tuner()) {
+        tuned_partitioning = tuner->get_active_name();
+    }
+
+    neighbour_lists.reset();
+    if (const NeighbourList* lists = universe.get_neighbour_lists()) {
+        neighbour_lists = NeighbourListStats{ lists->get_num_pairs(), lists->get_memory_bytes(), lists->get_updates_per_rebuild() };
+    }
+
+    const SpatialPartitioning& partitioning = universe.get_partitioning();
+
+    partitioning_representation.clear();
+    if (with_representation) {
+        partitioning_representation = partitioning.get_representation();
+    }
+
+    partitioning_info.clear();
+    if (info_area) {
+        for (const Body* body : partitioning.query_rect(*info_area)) {
+            partitioning.get_info(*body, partitioning_info[body->get_id()]);
+        }
+    }
+}
+
+void UniverseSnapshot::capture(const TrajectoryFrame& frame, const UniverseSettings& universe_settings)
+{
+    settings = &universe_settings;
+
+    bodies.clear();
+    for (int i = 0; i < frame.get_num_bodies(); i++) {
+        Body& body = bodies.emplace_back(frame.positions[i].x, frame.positions[i].y, frame.masses[i]);
+        body.set_vel(frame.velocities[i]);
+        body.set_id(frame.ids[i]);
+    }
+
+    index_bodies();
+
+    tick = frame.tick;
+    num_collision_checks = 0;
+    num_collision_checks_tick = 0;
+    num_swept_collisions = 0;
+
+    tuned_partitioning.reset();
+    neighbour_lists.reset();
+    recording.reset();
+    rewind.reset();
+    partitioning_representation.clear();
+    partitioning_info.clear();
+    removals.clear();
+    first_removal = 0;
+    tuning_log.clear();
+    first_tuning_entry = 0;
+}
+
+void UniverseSnapshot::index_bodies()
+{
+    positions.clear();
+    int max_id = -1;
+    for (const Body& body : bodies) {
+        positions.push_back(body.pos());
+        max_id = std::max(max_id, body.get_id());
+    }
+
+    // Until previous positions are set, bodies stay where they were captured.
+    prev_positions = positions;
+
+    id_indices.assign(max_id + 1, -1);
+    for (int i = 0; i < bodies.size(); i++) {
+        id_indices[bodies[i].get_id()] = i;
+    }
+
+    index_cells();
+}
+
+void UniverseSnapshot::index_cells()
+{
+    // Bodies wrap around once past half the universe's size from its center, so that is the grid's extent.
+    // About a few bodies to a cell, if they were spread evenly.
+    float size = settings->universe_size_max;
+    cells_per_row = std::clamp(static_cast<int>(std::sqrt(bodies.size() / 4.0)), 1, MAX_CELLS_PER_ROW);
+    cell_size = std::max(size / cells_per_row, 1.0f);
+    grid_origin = { -size / 2, -size / 2 };
+
+    body_cells.clear();
+    for (int i = 0; i < bodies.size(); i++) {
+        float radius = bodies[i].get_radius();
+        Vector2 min { std::min(prev_positions[i].x, positions[i].x) - radius, std::min(prev_positions[i].y, positions[i].y) - radius };
+        Vector2 max { std::max(prev_positions[i].x, positions[i].x) + radius, std::max(prev_positions[i].y, positions[i].y) + radius };
+        body_cells.push_back(cells_overlapping({ min.x, min.y, max.x - min.x, max.y - min.y }));
+    }
+
+    // Counted first, so each cell's bodies are laid out together, in the order of bodies.
+    cell_starts.assign(cells_per_row * cells_per_row + 1, 0);
+    for (const CellRange& cells : body_cells) {
+        for (int row = cells.first_row; row <= cells.last_row; row++) {
+            for (int col = cells.first_col; col <= cells.last_col; col++) {
+                cell_starts[row * cells_per_row + col + 1]++;
+            }
+        }
+    }
+
+    for (int cell = 1; cell < cell_starts.size(); cell++) {
+        cell_starts[cell] += cell_starts[cell - 1];
+    }
+
+    std::vector<int> filled(cell_starts.begin(), cell_starts.end() - 1);
+    cell_bodies.resize(cell_starts.back());
+    for (int i = 0; i < body_cells.size(); i++) {
+        const CellRange& cells = body_cells[i];
+        for (int row = cells.first_row; row <= cells.last_row; row++) {
+            for (int col = cells.first_col; col <= cells.last_col; col++) {
+                cell_bodies[filled[row * cells_per_row + col]++] = i;
+            }
+        }
+    }
+}
+
+UniverseSnapshot::CellRange UniverseSnapshot::cells_overlapping(Rectangle area) const
+{
+    auto cell_of = [this](float coord, float origin) {
+        return static_cast<int>(std::clamp(std::floor((coord - origin) / cell_size), 0.0f, static_cast<float>(cells_per_row - 1)));
+    };
+
+    return {
+        cell_of(area.x, grid_origin.x),
+        cell_of(area.y, grid_origin.y),
+        cell_of(area.x + area.width, grid_origin.x),
+        cell_of(area.y + area.height, grid_origin.y)
+    };
+}
+
+void UniverseSnapshot::set_removals(const std::deque<Removal>& undelivered, long long first)
+{
+    // Removals can't be assigned, so they are appended one by one.
+    removals.clear();
+    std::ranges::copy(undelivered, std::back_inserter(removals));
+    first_removal = first;
+}
+
+void UniverseSnapshot::set_tuning_log(std::span<const std::string> undelivered, int first)
+{
+    tuning_log.assign(undelivered.begin(), undelivered.end());
+    first_tuning_entry = first;
+}
+
+void UniverseSnapshot::set_prev_positions(std::vector<Vector2>& published_positions, std::span<const Removal> removals_since)
+{
+    float max_step = settings->universe_size_max / 2;
+    for (int i = 0; i < bodies.size(); i++) {
+        int id = bodies[i].get_id();
+        prev_positions[i] = id < published_positions.size() ? published_positions[id] : positions[i];
+
+        // A body that wrapped around the universe would be drawn crossing all of it.
+        Vector2 step = Vector2Subtract(positions[i], prev_positions[i]);
+        if (std::abs(step.x) > max_step or std::abs(step.y) > max_step) {
+            prev_positions[i] = positions[i];
+        }
+    }
+
+    // An absorber may have been moved back to where it hit the body it absorbed, so it isn't drawn sliding there.
+    for (const Removal& removal : removals_since) {
+        int id = removal.absorbed_by;
+        if (removal.was_absorbed() and id < id_indices.size() and id_indices[id] != -1) {
+            prev_positions[id_indices[id]] = positions[id_indices[id]];
+        }
+    }
+
+    // Removed bodies keep their last position, but nothing with their id will ever look it up.
+    published_positions.resize(id_indices.size());
+    for (int i = 0; i < bodies.size(); i++) {
+        published_positions[bodies[i].get_id()] = positions[i];
+    }
+
+    // Bodies now cover the way from their previous positions.
+    index_cells();
+}
+
+void UniverseSnapshot::set_published(std::chrono::steady_clock::time_point at, std::chrono::nanoseconds since_prev)
+{
+    published_at = at;
+    publish_interval = since_prev;
+}
+
+void UniverseSnapshot::set_recording(std::optional<TrajectoryRecorder::Stats> stats)
+{
+    recording = stats;
+}
+
+void UniverseSnapshot::set_rewind(const RewindBuffer::Stats& stats)
+{
+    rewind = stats;
+}
+
+void UniverseSnapshot::interpolate(std::chrono::steady_clock::time_point now)
+{
+    float amount = 1.0f;
+    if (publish_interval.count() > 0) {
+        amount = std::chrono::duration<float>(now - published_at) / publish_interval;
+        amount = std::clamp(amount, 0.0f, 1.0f);
+    }
+
+    for (int i = 0; i < bodies.size(); i++) {
+        bodies[i].set_pos(Vector2Lerp(prev_positions[i], positions[i], amount));
+    }
+}
+
+const UniverseSettings& UniverseSnapshot::get_settings() const
+{
+    return *settings;
+}
+
+std::span<const Body> UniverseSnapshot::get_bodies() const
+{
+    return bodies;
+}
+
+int UniverseSnapshot::get_num_bodies() const
+{
+    return bodies.size();
+}
+
+const Body* UniverseSnapshot::get_body(int search_id) const
+{
+    if (search_id < 0 or search_id >= id_indices.size() or id_indices[search_id] == -1) {
+        return nullptr;
+    }
+
+    return &bodies[id_indices[search_id]];
+}
+
+const Body* UniverseSnapshot::get_body(Vector2 point) const
+{
+    if (bodies.empty()) {
+        return nullptr;
+    }
+
+    // A cell's bodies are in the order of bodies, so the first found is the same as a scan of every body would find.
+    CellRange cells = cells_overlapping({ point.x, point.y, 0.0f, 0.0f });
+    int cell = cells.first_row * cells_per_row + cells.first_col;
+    for (int at = cell_starts[cell]; at < cell_starts[cell + 1]; at++) {
+        const Body& body = bodies[cell_bodies[at]];
+        if (body.contains_point(point)) {
+            return &body;
+        }
+    }
+
+    return nullptr;
+}
+
+std::vector<const Body*> UniverseSnapshot::get_bodies_in_area(Rectangle area) const
+{
+    if (bodies.empty()) {
+        return {};
+    }
+
+    std::vector<int> found;
+    CellRange area_cells = cells_overlapping(area);
+    for (int row = area_cells.first_row; row <= area_cells.last_row; row++) {
+        for (int col = area_cells.first_col; col <= area_cells.last_col; col++) {
+            int cell = row * cells_per_row + col;
+            for (int at = cell_starts[cell]; at < cell_starts[cell + 1]; at++) {
+                int i = cell_bodies[at];
+
+                // A body in several of the area's cells is only checked in the first of them.
+                const CellRange& cells = body_cells[i];
+                if (col != std::max(cells.first_col, area_cells.first_col) or row != std::max(cells.first_row, area_cells.first_row)) {
+                    continue;
+                }
+
+                if (bodies[i].intersects_rect(area)) {
+                    found.push_back(i);
+                }
+            }
+        }
+    }
+
+    // Drawn in the same order every frame, so overlapping bodies don't flicker as the view moves.
+    std::ranges::sort(found);
+
+    std::vector<const Body*> in_area;
+    in_area.reserve(found.size());
+    for (int i : found) {
+        in_area.push_back(&bodies[i]);
+    }
+
+    return in_area;
+}
+
+int UniverseSnapshot::get_tick() const
+{
+    return tick;
+}
+
+int UniverseSnapshot::get_num_collision_checks() const
+{
+    return num_collision_checks;
+}
+
+int UniverseSnapshot::get_num_collision_checks_tick() const
+{
+    return num_collision_checks_tick;
+}
+
+int UniverseSnapshot::get_num_swept_collisions() const
+{
+    return num_swept_collisions;
+}
+
+const std::string* UniverseSnapshot::get_tuned_partitioning() const
+{
+    return tuned_partitioning ? &*tuned_partitioning : nullptr;
+}
+
+const UniverseSnapshot::NeighbourListStats* UniverseSnapshot::get_neighbour_lists() const
+{
+    return neighbour_lists ? &*neighbour_lists : nullptr;
+}
+
+const TrajectoryRecorder::Stats* UniverseSnapshot::get_recording() const
+{
+    return recording ? &*recording : nullptr;
+}
+
+const RewindBuffer::Stats* UniverseSnapshot::get_rewind() const
+{
+    return rewind ? &*rewind : nullptr;
+}
+
+const std::vector<Rectangle>& UniverseSnapshot::get_partitioning_representation() const
+{
+    return partitioning_representation;
+}
+
+const DebugInfo* UniverseSnapshot::get_partitioning_info(int id) const
+{
+    auto it = partitioning_info.find(id);
+    return it != partitioning_info.end() ? &it->second : nullptr;
+}
+
+RemovalBatch UniverseSnapshot::get_removals_since(long long from) const
+{
+    size_t skipped = std::clamp(from - first_removal, 0ll, static_cast<long long>(removals.size()));
+    return RemovalBatch(removals).subspan(skipped);
+}
+
+long long UniverseSnapshot::get_removals_end() const
+{
+    return first_removal + static_cast<long long>(removals.size());
+}
+
+std::span<const std::string> UniverseSnapshot::get_tuning_log_since(int from) const
+{
+    size_t skipped = std::clamp(from - first_tuning_entry, 0, static_cast<int>(tuning_log.size()));
+    return std::span<const std::string>(tuning_log).subspan(skipped);
+}
+
+int UniverseSnapshot::get_tuning_log_end() const
+{
+    return first_tuning_entry + static_cast<int>(tuning_log.size());
+}
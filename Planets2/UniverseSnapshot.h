@@ -0,0 +1,208 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <span>
+#include <optional>
+#include <unordered_map>
+#include <deque>
+#include <chrono>
+#include "SimTypes.h"
+#include "Body.h"
+#include "Removal.h"
+#include "DebugInfo.h"
+#include "TrajectoryRecorder.h"
+#include "RewindBuffer.h"
+
+class Universe;
+struct UniverseSettings;
+
+// A copy of the universe's bodies and statistics as they were after some tick.
+// Lets other threads read the universe while it keeps updating, without sharing any of its state.
+//
+// Also keeps where each body was in the snapshot published before it, so the reader can move the bodies
+// part of the way from there as time passes until the next snapshot, and rendering stays smooth at low tick rates.
+//
+// Also carries events, which are numbered in the order they happened since the universe was created.
+// A snapshot carries every event that hadn't been delivered to its reader when it was captured,
+// so a reader that skips snapshots still sees every event, and readers skip events they were already given.
+class UniverseSnapshot
+{
+public:
+
+	// Statistics of the neighbour lists wrapping the partitioning method.
+	struct NeighbourListStats {
+		int num_pairs = 0;
+		size_t memory_bytes = 0;
+		float updates_per_rebuild = 0.0f;
+	};
+
+private:
+
+	// Cells a body or an area covers, as the first and last column and row of each.
+	struct CellRange {
+		int first_col;
+		int first_row;
+		int last_col;
+		int last_row;
+	};
+
+	// Most cells per row of the grid indexing the bodies.
+	static constexpr int MAX_CELLS_PER_ROW = 128;
+
+	// The universe's settings, which never change after it is created.
+	const UniverseSettings* settings = nullptr;
+
+	// Copies of every body, in no particular order.
+	std::vector<Body> bodies;
+
+	// Index in bodies of each body id, or -1 if there is no body with that id.
+	std::vector<int> id_indices;
+
+	// Position of each body when captured, and in the previously published snapshot, in the same order as bodies.
+	std::vector<Vector2> positions;
+	std::vector<Vector2> prev_positions;
+
+	// A grid over the universe of the bodies overlapping each cell, so an area is searched without scanning every body.
+	// A body is listed in every cell overlapped by its bounds around both its previous and captured position,
+	// so it is found wherever it is interpolated to. Positions past the universe's edges go in the cells along them.
+	Vector2 grid_origin {};
+	float cell_size = 1.0f;
+	int cells_per_row = 1;
+
+	// Index in cell_bodies of each cell's first body, row by row, and one past the last cell's last body.
+	// Each cell's bodies are indices in bodies, in ascending order.
+	std::vector<int> cell_starts;
+	std::vector<int> cell_bodies;
+
+	// Cells each body is listed in, in the same order as bodies.
+	std::vector<CellRange> body_cells;
+
+	// When the snapshot was published, and how long after the previously published one.
+	std::chrono::steady_clock::time_point published_at;
+	std::chrono::nanoseconds publish_interval { 0 };
+
+	int tick = 0;
+	int num_collision_checks = 0;
+	int num_collision_checks_tick = 0;
+	int num_swept_collisions = 0;
+
+	// Name of the partitioning method the tuner picked, if auto tuning is enabled.
+	std::optional<std::string> tuned_partitioning;
+
+	std::optional<NeighbourListStats> neighbour_lists;
+
+	// Statistics of the trajectory recording, if one is running.
+	std::optional<TrajectoryRecorder::Stats> recording;
+
+	// Statistics of the rewind buffer, if the universe has one.
+	std::optional<RewindBuffer::Stats> rewind;
+
+	// Representation of the partitioning method, if it was captured.
+	std::vector<Rectangle> partitioning_representation;
+
+	// The partitioning method's info about each body it was captured for, keyed by body id.
+	std::unordered_map<int, DebugInfo> partitioning_info;
+
+	// Undelivered removals, in the order they happened, and the number of the first one.
+	std::vector<Removal> removals;
+	long long first_removal = 0;
+
+	// Undelivered entries of the partitioning tuner's log, and the index of the first one.
+	std::vector<std::string> tuning_log;
+	int first_tuning_entry = 0;
+
+	// Records each body's captured position and indexes the bodies by id and by area.
+	void index_bodies();
+
+	// Lists every body in the cells it covers between its previous and captured position.
+	void index_cells();
+
+	// Returns the cells the area overlaps, counting those along the universe's edges as going on past them.
+	CellRange cells_overlapping(Rectangle area) const;
+
+public:
+
+	// Copies the universe's bodies and statistics, replacing whatever was captured before.
+	// The partitioning representation is only captured if asked for, and partitioning info only for bodies in info_area.
+	// Info is asked of the partitioning about the universe's own bodies, since partitionings may know bodies by address.
+	void capture(const Universe& universe, bool with_representation, std::optional<Rectangle> info_area);
+
+	// Copies the bodies of a recorded frame of a universe with the settings, replacing whatever was captured before.
+	// Nothing but the bodies and tick is recorded, so statistics are zero and nothing else is carried.
+	void capture(const TrajectoryFrame& frame, const UniverseSettings& universe_settings);
+
+	// Replaces the carried removals with the undelivered ones, the first of which is numbered first.
+	void set_removals(const std::deque<Removal>& undelivered, long long first);
+
+	// Replaces the carried tuner log entries with the undelivered ones, the first of which has the index first.
+	void set_tuning_log(std::span<const std::string> undelivered, int first);
+
+	// Takes each body's previous position from published_positions, indexed by body id, then replaces them with the captured positions.
+	// Ids are never reused, not even by rewinds, so bodies with ids past the end of published_positions are new, and start where they were captured.
+	// Bodies that wrapped around the universe, and absorbers of removals_since, the removals since then, start there too.
+	void set_prev_positions(std::vector<Vector2>& published_positions, std::span<const Removal> removals_since);
+
+	// Records when the snapshot was published, and how long after the previously published one.
+	void set_published(std::chrono::steady_clock::time_point at, std::chrono::nanoseconds since_prev);
+
+	// Sets the statistics of the trajectory recording, or nullopt if nothing is being recorded.
+	void set_recording(std::optional<TrajectoryRecorder::Stats> stats);
+
+	// Sets the statistics of the rewind buffer.
+	void set_rewind(const RewindBuffer::Stats& stats);
+
+	// Moves every body between its previous and captured position, by the fraction of the publish interval that has passed since the snapshot was published.
+	// Bodies reach their captured positions when the next snapshot is due, and stay there if it is late.
+	void interpolate(std::chrono::steady_clock::time_point now);
+
+	const UniverseSettings& get_settings() const;
+
+	// Returns every body in the snapshot.
+	std::span<const Body> get_bodies() const;
+
+	int get_num_bodies() const;
+
+	// Returns the body whose id matches the given id, or nullptr if there is none.
+	const Body* get_body(int search_id) const;
+
+	// Returns a body containing the point, or nullptr if there is none. Only checks the bodies in the point's cell.
+	const Body* get_body(Vector2 point) const;
+
+	// Returns all bodies at least partially in the given area, in the order of get_bodies. Only checks the bodies in the cells it overlaps.
+	std::vector<const Body*> get_bodies_in_area(Rectangle area) const;
+
+	int get_tick() const;
+	int get_num_collision_checks() const;
+	int get_num_collision_checks_tick() const;
+	int get_num_swept_collisions() const;
+
+	// Returns the name of the partitioning method picked by the tuner, or nullptr if auto tuning is disabled.
+	const std::string* get_tuned_partitioning() const;
+
+	// Returns the neighbour list statistics, or nullptr if neighbour lists are disabled.
+	const NeighbourListStats* get_neighbour_lists() const;
+
+	// Returns the trajectory recording statistics, or nullptr if nothing is being recorded.
+	const TrajectoryRecorder::Stats* get_recording() const;
+
+	// Returns the rewind buffer statistics, or nullptr if the universe has no rewind buffer, as in a replay.
+	const RewindBuffer::Stats* get_rewind() const;
+
+	// Returns the partitioning representation, which is empty if it wasn't captured.
+	const std::vector<Rectangle>& get_partitioning_representation() const;
+
+	// Returns the partitioning method's info about the body, or nullptr if it wasn't captured.
+	const DebugInfo* get_partitioning_info(int id) const;
+
+	// Returns the carried removals numbered from the given number onwards.
+	RemovalBatch get_removals_since(long long from) const;
+
+	// Returns the number after the last carried removal.
+	long long get_removals_end() const;
+
+	// Returns the carried tuner log entries from the given index onwards.
+	std::span<const std::string> get_tuning_log_since(int from) const;
+
+	// Returns the index after the last carried tuner log entry.
+	int get_tuning_log_end() const;
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "BarnesHut.h"
 #include "Body.h"
+#include "MyRandom.h"
 
 TEST(BarnesHut, Empty)
 {
@@ -99,3 +100,69 @@ TEST(BarnesHut, MultApproxSamePos)
 	EXPECT_FLOAT_EQ(forces.y, 0.0f);
 }
 
+TEST(BarnesHut, SamePosLeavesRandomEngine)
+{
+	BarnesHut barnes{ 2000, 1 };
+
+	std::vector<Body> bodies(20, Body{ 500,500,100 });
+	bodies.push_back({ -1000,500,100 });
+
+	// Bodies that can't be told apart are placed without random numbers, so rewinds re-simulate ticks exactly.
+	std::string state = Rand::get_state();
+	barnes.update(bodies);
+	EXPECT_EQ(Rand::get_state(), state);
+}
+
+TEST(BarnesHut, TrackedSameForces)
+{
+	BarnesHut built{ 2000, 1 };
+	BarnesHut tracked{ 2000, 1 };
+
+	std::vector<Body> bodies
+	{
+		{ -1000,500,100 },
+		{ 1,1,100 },
+		{ 999,999,100 },
+		{ 500,500,100 },
+		{ -300,-200,400 },
+		{ 20,700,50 },
+	};
+
+	built.update(bodies);
+	for (Body& body : bodies)
+	{
+		tracked.add_body(body);
+	}
+
+	for (const Body& body : bodies)
+	{
+		Vector2 expected = built.force_applied_to(body);
+		Vector2 forces = tracked.force_applied_to(body);
+		EXPECT_FLOAT_EQ(forces.x, expected.x);
+		EXPECT_FLOAT_EQ(forces.y, expected.y);
+	}
+}
+
+TEST(BarnesHut, TrackedRemoval)
+{
+	BarnesHut barnes{ 2000, 0 };
+
+	std::vector<Body> bodies
+	{
+		{ 0,0,100 },
+		{ 500,0,100 },
+		{ -500,0,100 },
+	};
+
+	for (Body& body : bodies)
+	{
+		barnes.add_body(body);
+	}
+
+	// Without the third body, forces are the same as in TwoNoApprox.
+	barnes.rem_body(bodies[2]);
+
+	Vector2 forces = barnes.force_applied_to(bodies[0]);
+	EXPECT_FLOAT_EQ(forces.x, 0.04f);
+	EXPECT_FLOAT_EQ(forces.y, 0.0f);
+}
@@ -0,0 +1,222 @@
+#include "pch.h"
+
+#include "Checkpoint.h"
+#include "Universe.h"
+#include "QuadTree.h"
+#include "ByteStream.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	constexpr float UNIVERSE_SIZE = 2000.0f;
+
+	// Index of the masses column, the last one written.
+	constexpr int MASSES_COLUMN = 5;
+
+	// Position, velocity and mass of a body.
+	using BodyState = std::tuple<float, float, float, float, long>;
+
+	std::map<int, BodyState> state_of(Universe& universe)
+	{
+		std::map<int, BodyState> state;
+		for (const Body& body : universe.get_bodies())
+		{
+			state[body.get_id()] = { body.pos().x, body.pos().y, body.vel().x, body.vel().y, body.get_mass() };
+		}
+
+		return state;
+	}
+
+	UniverseSettings make_settings()
+	{
+		UniverseSettings settings;
+		settings.universe_size_max = UNIVERSE_SIZE;
+		settings.num_rand_systems = 0;
+		settings.continuous_collisions = true;
+		return settings;
+	}
+
+	// Bodies spread out far enough apart that none merge, with one removed so ids have a gap, ticked a few times.
+	void fill(Universe& universe)
+	{
+		std::vector<Body> bodies;
+		for (int i = 0; i < 20; i++)
+		{
+			Body& body = bodies.emplace_back(-600.0f + 60.0f * i, 50.0f * (i % 5), 100 + 7 * i);
+			body.set_vel({ 0.5f * (i % 3), -0.25f * (i % 4) });
+		}
+
+		universe.add_bodies(std::move(bodies));
+		universe.rem_body(*universe.get_body(3));
+
+		for (int i = 0; i < 5; i++)
+		{
+			universe.update();
+		}
+	}
+
+	std::vector<std::byte> read_file(const std::filesystem::path& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		std::vector<char> chars { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+
+		std::vector<std::byte> bytes(chars.size());
+		std::memcpy(bytes.data(), chars.data(), chars.size());
+		return bytes;
+	}
+
+	void write_file(const std::filesystem::path& path, const std::vector<std::byte>& bytes)
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	// Skips the header's fixed fields, settings and random state, and returns where the column table's entries start.
+	size_t column_table_start(const std::vector<std::byte>& bytes)
+	{
+		ByteReader reader { bytes };
+		reader.get_bytes(8 + 4 + 4 + 5 * 8);
+		reader.get_bytes(reader.get<std::uint32_t>());
+		reader.get_bytes(reader.get<std::uint32_t>());
+		reader.get<std::uint32_t>();
+		return reader.position();
+	}
+
+	template <class T>
+	T read_at(const std::vector<std::byte>& bytes, size_t at)
+	{
+		T value;
+		std::memcpy(&value, bytes.data() + at, sizeof(T));
+		return value;
+	}
+
+	template <class T>
+	void write_at(std::vector<std::byte>& bytes, size_t at, T value)
+	{
+		std::memcpy(bytes.data() + at, &value, sizeof(T));
+	}
+}
+
+class CheckpointTest : public testing::Test
+{
+protected:
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "planets_checkpoint_test.ckpt";
+	std::filesystem::path modified_path = std::filesystem::temp_directory_path() / "planets_checkpoint_test_modified.ckpt";
+
+	std::unique_ptr<Universe> universe;
+
+	void SetUp() override
+	{
+		universe = std::make_unique<Universe>(make_settings(), std::make_unique<QuadTree>(UNIVERSE_SIZE, 4, 10));
+		fill(*universe);
+		ASSERT_TRUE(Checkpoint::capture(*universe, "rng state").save(path));
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove(path);
+		std::filesystem::remove(modified_path);
+	}
+
+	// Writes the bytes as a checkpoint file and tries opening it. Returns the error, or an empty string if it opened.
+	std::string open_modified(const std::vector<std::byte>& bytes)
+	{
+		write_file(modified_path, bytes);
+
+		std::string error;
+		std::optional<CheckpointFile> opened = CheckpointFile::open(modified_path, error);
+		return opened ? "" : error;
+	}
+};
+
+TEST_F(CheckpointTest, RoundTrip)
+{
+	std::string error;
+	std::optional<CheckpointFile> checkpoint = CheckpointFile::open(path, error);
+	ASSERT_TRUE(checkpoint) << error;
+
+	EXPECT_EQ(checkpoint->get_tick(), universe->get_tick());
+	EXPECT_EQ(checkpoint->get_next_id(), universe->get_bodies().get_next_id());
+	EXPECT_EQ(checkpoint->get_num_collision_checks(), universe->get_num_collision_checks());
+	EXPECT_EQ(checkpoint->get_rng_state(), "rng state");
+	EXPECT_EQ(checkpoint->get_settings().universe_size_max, UNIVERSE_SIZE);
+	EXPECT_TRUE(checkpoint->get_settings().continuous_collisions);
+	EXPECT_EQ(checkpoint->get_num_bodies(), universe->get_num_bodies());
+
+	// Bodies are stored in update order.
+	int i = 0;
+	for (const Body& body : universe->get_bodies())
+	{
+		EXPECT_EQ(checkpoint->get_columns().ids[i], body.get_id());
+		i++;
+	}
+
+	// A universe restored from the file has every body as it was, and goes on the same way.
+	Universe restored { *checkpoint, std::make_unique<QuadTree>(UNIVERSE_SIZE, 4, 10) };
+	EXPECT_EQ(restored.get_tick(), universe->get_tick());
+	EXPECT_EQ(state_of(restored), state_of(*universe));
+
+	universe->update();
+	restored.update();
+	EXPECT_EQ(state_of(restored), state_of(*universe));
+}
+
+TEST_F(CheckpointTest, RejectsBadMagic)
+{
+	std::vector<std::byte> bytes = read_file(path);
+	bytes[0] = std::byte { 'X' };
+
+	EXPECT_EQ(open_modified(bytes), "Not a checkpoint file");
+}
+
+TEST_F(CheckpointTest, RejectsMisalignedColumn)
+{
+	std::vector<std::byte> bytes = read_file(path);
+	size_t offset_at = column_table_start(bytes) + 8;
+	write_at(bytes, offset_at, read_at<std::uint64_t>(bytes, offset_at) + 4);
+
+	EXPECT_EQ(open_modified(bytes), "Checkpoint column 0 is corrupt");
+}
+
+TEST_F(CheckpointTest, RejectsShortColumn)
+{
+	// The masses column is last, so cutting the file short cuts it short.
+	std::vector<std::byte> bytes = read_file(path);
+	bytes.resize(bytes.size() - 8);
+
+	EXPECT_EQ(open_modified(bytes), "Checkpoint column " + std::to_string(MASSES_COLUMN) + " is corrupt");
+}
+
+TEST_F(CheckpointTest, RejectsDuplicateId)
+{
+	std::vector<std::byte> bytes = read_file(path);
+	size_t ids_at = read_at<std::uint64_t>(bytes, column_table_start(bytes) + 8);
+	std::int32_t first_id = read_at<std::int32_t>(bytes, ids_at);
+	write_at(bytes, ids_at + sizeof(std::int32_t), first_id);
+
+	EXPECT_EQ(open_modified(bytes), "Checkpoint has an invalid body id " + std::to_string(first_id));
+}
+
+TEST_F(CheckpointTest, RejectsOutOfRangeId)
+{
+	std::vector<std::byte> bytes = read_file(path);
+	size_t ids_at = read_at<std::uint64_t>(bytes, column_table_start(bytes) + 8);
+	std::int32_t next_id = universe->get_bodies().get_next_id();
+	write_at(bytes, ids_at, next_id);
+
+	EXPECT_EQ(open_modified(bytes), "Checkpoint has an invalid body id " + std::to_string(next_id));
+
+	write_at<std::int32_t>(bytes, ids_at, -1);
+	EXPECT_EQ(open_modified(bytes), "Checkpoint has an invalid body id -1");
+}
@@ -4,6 +4,9 @@
 #include "Circle.h"
 #include "raylib.h"
 #include "raymath.h"
+#include "CircleBatch.h"
+#include "Body.h"
+#include <vector>
 
 TEST(Physics, PointInCircle)
 {
@@ -118,6 +121,41 @@ TEST(Physics, CircleIntersectsRect)
 	EXPECT_FALSE(Physics::circle_intersects_rect(c6, r));
 }
 
+TEST(Physics, RectsIntersect)
+{
+	Rectangle r{ 0, 0, 10, 10 };
+
+	Rectangle inside{ 2, 2, 5, 5 };
+	Rectangle overlapping{ 5, 5, 10, 10 };
+	Rectangle adjacent{ 10, 0, 10, 10 };
+	Rectangle apart{ 20, 20, 5, 5 };
+
+	EXPECT_TRUE(Physics::rects_intersect(r, inside));
+	EXPECT_TRUE(Physics::rects_intersect(r, overlapping));
+	EXPECT_TRUE(Physics::rects_intersect(overlapping, r));
+	EXPECT_FALSE(Physics::rects_intersect(r, adjacent));
+	EXPECT_FALSE(Physics::rects_intersect(r, apart));
+}
+
+TEST(Physics, RectsUnion)
+{
+	Rectangle r{ 0, 0, 10, 10 };
+	Rectangle inside{ 2, 2, 5, 5 };
+	Rectangle apart{ 20, -5, 5, 5 };
+
+	Rectangle same = Physics::rects_union(r, inside);
+	EXPECT_FLOAT_EQ(same.x, 0);
+	EXPECT_FLOAT_EQ(same.y, 0);
+	EXPECT_FLOAT_EQ(same.width, 10);
+	EXPECT_FLOAT_EQ(same.height, 10);
+
+	Rectangle both = Physics::rects_union(r, apart);
+	EXPECT_FLOAT_EQ(both.x, 0);
+	EXPECT_FLOAT_EQ(both.y, -5);
+	EXPECT_FLOAT_EQ(both.width, 25);
+	EXPECT_FLOAT_EQ(both.height, 15);
+}
+
 
 TEST(Physics, Dist)
 {
@@ -265,3 +303,64 @@ TEST(Physics, Moment)
 
 	EXPECT_TRUE(Vector2Eq(moment, Physics::moment(pos, mass), 0.01f));
 }
+
+TEST(Physics, CircleBatchMatchesCirclesIntersect)
+{
+	// More bodies than a hit mask covers, and not a multiple of the SIMD width, so partial masks are tested too.
+	std::vector<Body> bodies;
+	for (int i = 0; i < 150; i++)
+	{
+		bodies.emplace_back((i % 13) * 7.0f, (i / 13) * 5.0f, 10 + (i * 37) % 400);
+		bodies.back().set_id(i);
+	}
+
+	CircleBatch batch;
+	for (Body& body : bodies)
+	{
+		batch.add(body);
+	}
+
+	for (int first : { 0, 3, 64, 149 })
+	{
+		const Body& checking = bodies[first];
+		CircleBatch::HitMask mask = batch.hits(checking.pos(), checking.get_radius(), first);
+
+		for (int i = first; i < std::min<int>(first + CircleBatch::MASK_WIDTH, bodies.size()); i++)
+		{
+			bool expected = Physics::circles_intersect({ checking.pos(), checking.get_radius() }, { bodies[i].pos(), bodies[i].get_radius() });
+			EXPECT_EQ(((mask >> (i - first)) & 1) != 0, expected) << "first = " << first << ", i = " << i;
+		}
+	}
+
+	// Bodies exactly touching don't collide, whether tested alone or batched.
+	Body left { 0, 0, 500 };
+	Body right { 2 * left.get_radius(), 0, 500 };
+	CircleBatch touching;
+	touching.add(right);
+	EXPECT_EQ(touching.hits(left.pos(), left.get_radius(), 0), 0);
+	EXPECT_FALSE(left.collided_with(right));
+}
+
+TEST(Physics, TimeOfImpact)
+{
+	Circle still { { 0, 0 }, 1.0f };
+
+	// Passes straight through the still circle, first touching it at x = -2.
+	Circle passing { { -10, 0 }, 1.0f };
+	auto time = Physics::time_of_impact(still, Vector2Zero(), passing, { 20, 0 });
+	ASSERT_TRUE(time.has_value());
+	EXPECT_NEAR(*time, 8.0f / 20, 0.0001f);
+
+	// Same relative motion with both circles moving.
+	time = Physics::time_of_impact(still, { -10, 0 }, passing, { 10, 0 });
+	ASSERT_TRUE(time.has_value());
+	EXPECT_NEAR(*time, 8.0f / 20, 0.0001f);
+
+	// Already overlapping.
+	EXPECT_EQ(Physics::time_of_impact(still, Vector2Zero(), { { 1, 0 }, 1.0f }, { 5, 0 }), 0.0f);
+
+	// Misses to the side, stops short, and moves away.
+	EXPECT_FALSE(Physics::time_of_impact(still, Vector2Zero(), { { -10, 3 }, 1.0f }, { 20, 0 }).has_value());
+	EXPECT_FALSE(Physics::time_of_impact(still, Vector2Zero(), passing, { 5, 0 }).has_value());
+	EXPECT_FALSE(Physics::time_of_impact(still, Vector2Zero(), passing, { -20, 0 }).has_value());
+}
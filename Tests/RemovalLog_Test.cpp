@@ -0,0 +1,166 @@
+#include "pch.h"
+
+#include "RemovalLog.h"
+#include "Universe.h"
+#include "QuadTree.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr float UNIVERSE_SIZE = 2000.0f;
+
+	// Size of the header and of each record, as laid out in a removal log.
+	constexpr size_t HEADER_SIZE = 8 + 4 + 4;
+	constexpr size_t RECORD_SIZE = 3 * 4 + 2 * (8 + 4 * 4);
+
+	std::unique_ptr<Universe> make_universe()
+	{
+		UniverseSettings settings;
+		settings.universe_size_max = UNIVERSE_SIZE;
+		settings.num_rand_systems = 0;
+		settings.grav_const = 0.0;
+
+		return std::make_unique<Universe>(settings, std::make_unique<QuadTree>(UNIVERSE_SIZE, 4, 10));
+	}
+
+	void update(Universe& universe, int ticks)
+	{
+		for (int i = 0; i < ticks; i++)
+		{
+			universe.update();
+		}
+	}
+
+	// Adds a body on top of the one at the point, so it merges into it in the next update.
+	void add_merging(Universe& universe, Vector2 at, long mass, Vector2 vel)
+	{
+		Body body { at.x, at.y, mass };
+		body.set_vel(vel);
+		universe.add_body(std::move(body));
+	}
+}
+
+class RemovalLogTest : public testing::Test
+{
+protected:
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "planets_removal_log_test.log";
+
+	std::unique_ptr<Universe> universe;
+
+	void SetUp() override
+	{
+		std::filesystem::remove(path);
+
+		// Bodies 0 and 1 absorb what is added on top of them, body 2 is deleted.
+		universe = make_universe();
+		universe->add_bodies({ { 0, 0, 500 }, { 600, 0, 300 }, { -600, 0, 100 } });
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove(path);
+	}
+
+	// Logs a deletion at tick 0, merges at ticks 3 and 5, and a deletion at tick 9.
+	void log_removals()
+	{
+		RemovalLogger logger { path, *universe, {} };
+
+		universe->rem_body(*universe->get_body(2));
+		update(*universe, 3);
+
+		add_merging(*universe, { 0, 0 }, 50, { 3, 4 });
+		update(*universe, 2);
+
+		add_merging(*universe, { 600, 0 }, 40, { -6, 8 });
+		update(*universe, 4);
+
+		universe->rem_body(*universe->get_body(1));
+
+		logger.close();
+		EXPECT_EQ(logger.get_stats().records_written, 4);
+		EXPECT_FALSE(logger.get_stats().failed);
+	}
+};
+
+TEST_F(RemovalLogTest, TotalBySpan)
+{
+	log_removals();
+
+	std::string error;
+	std::optional<RemovalLogFile> log = RemovalLogFile::open(path, error);
+	ASSERT_TRUE(log) << error;
+	ASSERT_EQ(log->get_num_records(), 4);
+
+	std::vector<RemovalLogFile::Totals> spans = log->total_by_span(0, 10, 4);
+	ASSERT_EQ(spans.size(), 3);
+
+	EXPECT_EQ(spans[0].first_tick, 0);
+	EXPECT_EQ(spans[0].last_tick, 4);
+	EXPECT_EQ(spans[0].merges, 1);
+	EXPECT_EQ(spans[0].deletions, 1);
+	EXPECT_EQ(spans[0].mass_absorbed, 50);
+	EXPECT_EQ(spans[0].mass_deleted, 100);
+	EXPECT_FLOAT_EQ(spans[0].mean_impact_speed(), 5.0);
+
+	EXPECT_EQ(spans[1].merges, 1);
+	EXPECT_EQ(spans[1].deletions, 0);
+	EXPECT_EQ(spans[1].mass_absorbed, 40);
+	EXPECT_FLOAT_EQ(spans[1].mean_impact_speed(), 10.0);
+	EXPECT_FLOAT_EQ(spans[1].merges_per_tick(), 0.25);
+
+	// The last span is cut short by last_tick.
+	EXPECT_EQ(spans[2].first_tick, 8);
+	EXPECT_EQ(spans[2].last_tick, 10);
+	EXPECT_EQ(spans[2].merges, 0);
+	EXPECT_EQ(spans[2].deletions, 1);
+	EXPECT_EQ(spans[2].mass_deleted, 340);
+
+	// Removals outside the ticks asked for aren't counted.
+	std::vector<RemovalLogFile::Totals> middle = log->total_by_span(1, 9, 4);
+	ASSERT_EQ(middle.size(), 2);
+	EXPECT_EQ(middle[0].merges, 1);
+	EXPECT_EQ(middle[0].deletions, 0);
+	EXPECT_EQ(middle[1].merges, 1);
+	EXPECT_EQ(middle[1].deletions, 0);
+
+	EXPECT_TRUE(log->total_by_span(5, 5, 4).empty());
+}
+
+TEST_F(RemovalLogTest, AppendDropsPartialRecord)
+{
+	log_removals();
+
+	// A writer cut short in the middle of a record.
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::app);
+		out.write("partial", 7);
+	}
+
+	{
+		RemovalLogger logger { path, *universe, {} };
+		universe->rem_body(*universe->get_body(0));
+		logger.close();
+		EXPECT_FALSE(logger.get_stats().failed);
+	}
+
+	EXPECT_EQ(std::filesystem::file_size(path), HEADER_SIZE + 5 * RECORD_SIZE);
+
+	std::string error;
+	std::optional<RemovalLogFile> log = RemovalLogFile::open(path, error);
+	ASSERT_TRUE(log) << error;
+	ASSERT_EQ(log->get_num_records(), 5);
+
+	// The new record lines up after the old ones.
+	RemovalRecord record = log->get_record(4);
+	EXPECT_EQ(record.tick, 9);
+	EXPECT_EQ(record.removed, 0);
+	EXPECT_FALSE(record.was_absorbed());
+	EXPECT_EQ(record.removed_mass, 550);
+}
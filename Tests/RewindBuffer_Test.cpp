@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include "RewindBuffer.h"
+#include "Universe.h"
+#include "QuadTree.h"
+#include "MyRandom.h"
+#include <map>
+#include <memory>
+#include <tuple>
+
+namespace
+{
+	constexpr float UNIVERSE_SIZE = 4000.0f;
+
+	// Position, velocity and mass of a body.
+	using BodyState = std::tuple<float, float, float, float, long>;
+
+	// Every body's state, by id.
+	std::map<int, BodyState> state_of(Universe& universe)
+	{
+		std::map<int, BodyState> state;
+		for (const Body& body : universe.get_bodies())
+		{
+			state[body.get_id()] = { body.pos().x, body.pos().y, body.vel().x, body.vel().y, body.get_mass() };
+		}
+
+		return state;
+	}
+
+	// A few random systems close together, so bodies move, pull on each other and merge.
+	std::unique_ptr<Universe> make_universe()
+	{
+		Rand::set_seed(7);
+
+		UniverseSettings settings;
+		settings.universe_size_max = UNIVERSE_SIZE;
+		settings.universe_size_start = 600.0f;
+		settings.num_rand_systems = 4;
+		settings.num_rand_planets = 0;
+
+		return std::make_unique<Universe>(settings, std::make_unique<QuadTree>(UNIVERSE_SIZE, 10, 10));
+	}
+}
+
+TEST(RewindBuffer, RewindBetweenKeyframes)
+{
+	std::unique_ptr<Universe> universe = make_universe();
+
+	RewindBuffer::Settings settings;
+	settings.keyframe_every = 25;
+	RewindBuffer rewind { settings };
+
+	std::map<int, std::map<int, BodyState>> states;
+	rewind.record(*universe);
+	states[universe->get_tick()] = state_of(*universe);
+
+	for (int i = 0; i < 120; i++)
+	{
+		universe->update();
+		rewind.record(*universe);
+		states[universe->get_tick()] = state_of(*universe);
+	}
+
+	int end_tick = universe->get_tick();
+
+	// Between the keyframes at 50 and 75, so the ticks after 50 are re-simulated.
+	ASSERT_TRUE(rewind.rewind(*universe, 63));
+	EXPECT_EQ(universe->get_tick(), 63);
+	EXPECT_EQ(state_of(*universe), states[63]);
+
+	// Going on from there ends where the first run did.
+	while (universe->get_tick() < end_tick)
+	{
+		universe->update();
+		rewind.record(*universe);
+	}
+
+	EXPECT_EQ(state_of(*universe), states[end_tick]);
+
+	// Rewinding isn't possible to the current tick or after it.
+	EXPECT_FALSE(rewind.rewind(*universe, end_tick));
+}
+
+TEST(RewindBuffer, StepBackAfterEdit)
+{
+	std::unique_ptr<Universe> universe = make_universe();
+
+	RewindBuffer::Settings settings;
+	settings.keyframe_every = 25;
+	RewindBuffer rewind { settings };
+
+	rewind.record(*universe);
+	for (int i = 0; i < 40; i++)
+	{
+		universe->update();
+		rewind.record(*universe);
+	}
+
+	int edit_tick = universe->get_tick();
+	std::map<int, BodyState> before = state_of(*universe);
+
+	// Far from every system, so the added body can't merge with anything before stepping back.
+	rewind.edit(*universe, [](Universe& edited)
+	{
+		edited.add_body(Body { 1500.0f, 1500.0f, 500 });
+	});
+
+	std::map<int, BodyState> after = state_of(*universe);
+	ASSERT_EQ(after.size(), before.size() + 1);
+
+	for (int i = 0; i < 10; i++)
+	{
+		universe->update();
+		rewind.record(*universe);
+	}
+
+	// The first step back goes to just after the edit, the second to just before it.
+	ASSERT_TRUE(rewind.step_back(*universe));
+	EXPECT_EQ(universe->get_tick(), edit_tick);
+	EXPECT_EQ(state_of(*universe), after);
+
+	ASSERT_TRUE(rewind.step_back(*universe));
+	EXPECT_EQ(universe->get_tick(), edit_tick);
+	EXPECT_EQ(state_of(*universe), before);
+}
@@ -4,8 +4,17 @@
 #include "QuadTree.h"
 #include "Grid.h"
 #include "LineSweep.h"
+#include "SweepAndPrune.h"
+#include "DynamicAABBTree.h"
+#include "BarnesHutPartitioning.h"
+#include "NeighbourList.h"
+#include "SweptCollisions.h"
+#include "BodyList.h"
+#include "Universe.h"
 #include "Body.h"
+#include "Physics.h"
 #include <Collision.h>
+#include <algorithm>
 
 using SPFactory = SpatialPartitioning*(*)();
 
@@ -35,10 +44,10 @@ protected:
 
 };
 
-template<float size, int max_bodies, int max_depth>
+template<float size, int max_bodies, int max_depth, float looseness = 1.0f>
 SpatialPartitioning* CreateQuadTree()
 {
-	return new QuadTree{ size, max_bodies, max_depth };
+	return new QuadTree{ size, max_bodies, max_depth, looseness };
 }
 
 template<float grid_size, int nodes_per_row>
@@ -47,9 +56,32 @@ SpatialPartitioning* CreateGrid()
 	return new Grid{ grid_size, nodes_per_row };
 }
 
+template<int min_bodies_per_strip>
 SpatialPartitioning* CreateLineSweep()
 {
-	return new LineSweep;
+	return new LineSweep{ min_bodies_per_strip };
+}
+
+SpatialPartitioning* CreateSweepAndPrune()
+{
+	return new SweepAndPrune;
+}
+
+SpatialPartitioning* CreateDynamicAABBTree()
+{
+	return new DynamicAABBTree;
+}
+
+template <float size>
+SpatialPartitioning* CreateBarnesHutPartitioning()
+{
+	return new BarnesHutPartitioning(size, 1.0f);
+}
+
+template <float skin>
+SpatialPartitioning* CreateNeighbourList()
+{
+	return new NeighbourList(std::make_unique<LineSweep>(), skin);
 }
 
 TEST_P(SPTestFixture, CollisionsEmpty)
@@ -121,6 +153,44 @@ TEST_P(SPTestFixture, CollisionsMultiple)
 	}
 }
 
+TEST_P(SPTestFixture, CollisionsAfterMove)
+{
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ 10 * radius, 0, mass },
+		{ -10 * radius, 0, mass },
+		{ 0, 10 * radius, mass },
+	};
+
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		partitioning->add_body(bodies[i]);
+	}
+
+	partitioning->update();
+	EXPECT_EQ(partitioning->get_collisions().size(), 0);
+
+	// Move bodies 1 and 2 past each other, so that body 2 ends up touching body 0.
+	bodies[1].set_pos({ -10 * radius, 0 });
+	bodies[2].set_pos({ radius, 0 });
+	partitioning->update();
+
+	auto collisions = partitioning->get_collisions();
+	ASSERT_EQ(collisions.size(), 1);
+	EXPECT_EQ(collisions[0].bigger.get_id() + collisions[0].smaller.get_id(), 2);
+	EXPECT_NE(collisions[0].bigger, collisions[0].smaller);
+
+	// Move body 2 away again.
+	bodies[2].set_pos({ 10 * radius, 0 });
+	partitioning->update();
+	EXPECT_EQ(partitioning->get_collisions().size(), 0);
+}
+
 TEST_P(SPTestFixture, FindBody)
 {
 	constexpr int mass = 500;
@@ -158,7 +228,560 @@ TEST_P(SPTestFixture, FindBody)
 
 }
 
+TEST_P(SPTestFixture, RemBodies)
+{
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ radius / 2, 0, mass },
+		{ radius, 0, mass },
+		{ 10 * radius, 0, mass },
+		{ 11 * radius, 0, mass },
+	};
+
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		partitioning->add_body(bodies[i]);
+	}
+
+	partitioning->update();
+	EXPECT_EQ(partitioning->get_collisions().size(), 4);
+
+	// Removing bodies 1 and 4 leaves only the pair (0, 2) touching.
+	std::vector<const Body*> removing { &bodies[1], &bodies[4] };
+	partitioning->rem_bodies(removing);
+
+	// Only body 4 covers this point. It's gone straight away, without an update.
+	Vector2 point_in_4 { 11.5f * radius, 0 };
+	EXPECT_EQ(partitioning->find_body(point_in_4), nullptr);
+	EXPECT_EQ(partitioning->query_rect({ -radius, -radius, 13 * radius, 2 * radius }).size(), 3);
+
+	partitioning->update();
+
+	auto collisions = partitioning->get_collisions();
+	ASSERT_EQ(collisions.size(), 1);
+	EXPECT_EQ(collisions[0].bigger.get_id() + collisions[0].smaller.get_id(), 2);
+	EXPECT_EQ(partitioning->find_body(point_in_4), nullptr);
+
+	// Bodies added back in bulk are found again.
+	std::vector<Body*> adding { &bodies[1], &bodies[4] };
+	partitioning->add_bodies(adding);
+	partitioning->update();
+
+	EXPECT_EQ(partitioning->get_collisions().size(), 4);
+	EXPECT_EQ(partitioning->find_body(point_in_4), &bodies[4]);
+}
+
+TEST_P(SPTestFixture, NotifyRadiusChanged)
+{
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ 3 * radius, 0, mass },
+		{ -10 * radius, 0, mass },
+	};
+
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		partitioning->add_body(bodies[i]);
+	}
+
+	partitioning->update();
+	EXPECT_EQ(partitioning->get_collisions().size(), 0);
+
+	long grown_mass = mass;
+	while (Body{ 0, 0, grown_mass }.get_radius() < 2.5f * radius)
+	{
+		grown_mass *= 2;
+	}
+
+	// Body 0 grows in place until it reaches body 1.
+	float old_radius = bodies[0].get_radius();
+	bodies[0].set_mass(grown_mass);
+	partitioning->notify_radius_changed(bodies[0], old_radius);
+	partitioning->update();
+
+	auto collisions = partitioning->get_collisions();
+	ASSERT_EQ(collisions.size(), 1);
+	EXPECT_EQ(collisions[0].bigger.get_id() + collisions[0].smaller.get_id(), 1);
+	EXPECT_EQ(partitioning->find_body(Vector2{ 0, 2 * radius }), &bodies[0]);
+
+	// And shrinks back.
+	old_radius = bodies[0].get_radius();
+	bodies[0].set_mass(mass);
+	partitioning->notify_radius_changed(bodies[0], old_radius);
+	partitioning->update();
+
+	EXPECT_EQ(partitioning->get_collisions().size(), 0);
+	EXPECT_EQ(partitioning->find_body(Vector2{ 0, 2 * radius }), nullptr);
+}
+
+TEST_P(SPTestFixture, NotifyRadiiChanged)
+{
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	// Two pairs of bodies, each a gap apart, and a body far from both.
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ 3 * radius, 0, mass },
+		{ 0, 20 * radius, mass },
+		{ 3 * radius, 20 * radius, mass },
+		{ -20 * radius, 0, mass },
+	};
+
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		partitioning->add_body(bodies[i]);
+	}
+
+	partitioning->update();
+	EXPECT_EQ(partitioning->get_collisions().size(), 0);
+
+	long grown_mass = mass;
+	while (Body{ 0, 0, grown_mass }.get_radius() < 2.5f * radius)
+	{
+		grown_mass *= 2;
+	}
+
+	// Both bodies grow before the partitioning is told about either, as absorbers of a tick do.
+	std::vector<Body*> grown { &bodies[0], &bodies[2] };
+	std::vector<float> old_radii { bodies[0].get_radius(), bodies[2].get_radius() };
+	bodies[0].set_mass(grown_mass);
+	bodies[2].set_mass(grown_mass);
+	partitioning->notify_radii_changed(grown, old_radii);
+	partitioning->update();
+
+	EXPECT_EQ(partitioning->get_collisions().size(), 2);
+	EXPECT_EQ(partitioning->find_body(Vector2{ 0, 2 * radius }), &bodies[0]);
+	EXPECT_EQ(partitioning->find_body(Vector2{ 0, 22 * radius }), &bodies[2]);
+}
+
+TEST_P(SPTestFixture, UpdateMoved)
+{
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ 10 * radius, 0, mass },
+		{ 0, 500, mass },
+	};
+
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		partitioning->add_body(bodies[i]);
+	}
+
+	// Updates the way the universe does, only passing bodies that left their partition bounds if they are used.
+	auto update = [this, &bodies]()
+	{
+		if (!partitioning->uses_partition_bounds())
+		{
+			partitioning->update();
+			return;
+		}
+
+		std::vector<Body*> moved;
+		for (Body& body : bodies)
+		{
+			if (body.left_partition_bounds())
+			{
+				moved.push_back(&body);
+			}
+		}
+
+		partitioning->update_moved(moved);
+	};
+
+	// A small step stays within body 1's bounds, a far one leaves them.
+	bodies[1].set_pos({ 10 * radius - radius / 100, 0 });
+	update();
+	EXPECT_EQ(partitioning->get_collisions().size(), 0);
+
+	bodies[1].set_pos({ radius, 0 });
+	update();
+
+	auto collisions = partitioning->get_collisions();
+	ASSERT_EQ(collisions.size(), 1);
+	EXPECT_EQ(collisions[0].bigger.get_id() + collisions[0].smaller.get_id(), 1);
+	EXPECT_EQ(partitioning->find_body(Vector2{ 1.5f * radius, 0 }), &bodies[1]);
+	EXPECT_EQ(partitioning->find_body(Vector2{ 10 * radius, 0 }), nullptr);
+}
+
+TEST_P(SPTestFixture, Queries)
+{
+	// Bodies of varied sizes, scattered unevenly over part of the partitioning's area.
+	std::vector<Body> bodies;
+	bodies.reserve(200);
+
+	for (int i = 0; i < 200; ++i)
+	{
+		float x = static_cast<float>((i * 37) % 101) * 7.0f - 350.0f;
+		float y = static_cast<float>((i * 53) % 89) * 6.0f - 250.0f + (i % 7) * 3.0f;
+		bodies.emplace_back(x, y, 100 + (i * 97) % 2000);
+		bodies.back().set_id(i);
+	}
+
+	for (Body& body : bodies)
+	{
+		partitioning->add_body(body);
+	}
+
+	partitioning->update();
+
+	auto sorted_ids = [](const std::vector<Body*>& found)
+	{
+		std::vector<int> ids;
+		for (const Body* body : found)
+		{
+			ids.push_back(body->get_id());
+		}
+
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	};
+
+	Rectangle area { -120.0f, -80.0f, 200.0f, 150.0f };
+	std::vector<int> in_area;
+	for (const Body& body : bodies)
+	{
+		if (body.intersects_rect(area))
+		{
+			in_area.push_back(body.get_id());
+		}
+	}
+
+	ASSERT_FALSE(in_area.empty());
+	EXPECT_EQ(sorted_ids(partitioning->query_rect(area)), in_area);
+
+	Vector2 center { 40.0f, -30.0f };
+	float radius = 90.0f;
+	std::vector<int> in_radius;
+	for (const Body& body : bodies)
+	{
+		float reach = radius + body.get_radius();
+		if (Physics::dist_squared(center, body.pos()) < reach * reach)
+		{
+			in_radius.push_back(body.get_id());
+		}
+	}
+
+	ASSERT_FALSE(in_radius.empty());
+	EXPECT_EQ(sorted_ids(partitioning->query_radius(center, radius)), in_radius);
+
+	for (int k : { 0, 1, 5, 30, 250 })
+	{
+		std::vector<const Body*> by_distance;
+		for (const Body& body : bodies)
+		{
+			by_distance.push_back(&body);
+		}
+
+		std::sort(by_distance.begin(), by_distance.end(), [center](const Body* a, const Body* b)
+		{
+			float dist_a = Physics::dist_squared(center, a->pos());
+			float dist_b = Physics::dist_squared(center, b->pos());
+			return dist_a != dist_b ? dist_a < dist_b : a->get_id() < b->get_id();
+		});
+		by_distance.resize(std::min<int>(k, by_distance.size()));
+
+		std::vector<Body*> nearest = partitioning->k_nearest(center, k);
+		ASSERT_EQ(nearest.size(), by_distance.size()) << "k = " << k;
+
+		for (int i = 0; i < nearest.size(); ++i)
+		{
+			EXPECT_EQ(nearest[i], by_distance[i]) << "k = " << k << ", i = " << i;
+		}
+	}
+}
+
+TEST_P(SPTestFixture, AddBodiesInBulk)
+{
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	// Rows of bodies close enough that neighbours along and across rows touch, with some touching several.
+	// Masses all differ, so every colliding pair has one order.
+	std::vector<Body> bodies;
+	for (int i = 0; i < 400; i++)
+	{
+		float x = (i % 20) * 1.9f * radius + (i % 7) * 0.1f * radius - 20 * radius;
+		float y = (i / 20) * 1.9f * radius + (i % 3) * 0.1f * radius - 20 * radius;
+		bodies.emplace_back(x, y, mass + i);
+		bodies.back().set_id(i);
+	}
+
+	// Some bodies are added one at a time, the rest in bulk among them.
+	std::vector<Body*> adding;
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		if (i % 5 == 0)
+		{
+			partitioning->add_body(bodies[i]);
+		}
+		else
+		{
+			adding.push_back(&bodies[i]);
+		}
+	}
+
+	partitioning->add_bodies(adding);
+	partitioning->update();
+
+	std::vector<Collision> expected;
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		for (int j = i + 1; j < bodies.size(); j++)
+		{
+			if (bodies[i].collided_with(bodies[j]))
+			{
+				expected.emplace_back(Body::get_sorted_pair(bodies[i], bodies[j]));
+			}
+		}
+	}
+
+	ASSERT_GT(expected.size(), bodies.size() / 2);
+
+	auto collisions = partitioning->get_collisions();
+	EXPECT_EQ(collisions.size(), expected.size());
+	for (const auto& c : collisions)
+	{
+		EXPECT_TRUE(std::find(expected.begin(), expected.end(), c) != expected.end()) << "Did not find: " << c.bigger.get_id() << ", " << c.smaller.get_id();
+	}
+}
+
 INSTANTIATE_TEST_CASE_P(SpatialPartitioningInterface, SPTestFixture,
 	testing::Values(&CreateQuadTree<2000.0f, 10, 10>,
+		&CreateQuadTree<2000.0f, 2, 10, 2.0f>,
 		&CreateGrid<2000.0f, 10>,
-		&CreateLineSweep));
+		&CreateLineSweep<512>,
+		&CreateLineSweep<2>,
+		&CreateSweepAndPrune,
+		&CreateDynamicAABBTree,
+		&CreateBarnesHutPartitioning<2000.0f>,
+		&CreateNeighbourList<20.0f>));
+
+TEST(SpatialPartitioning, GatherParallelMergesInOrder)
+{
+	std::vector<Body> bodies;
+	for (int i = 0; i < 8; i++)
+	{
+		bodies.emplace_back(i * 100.0f, 0.0f, 100);
+		bodies.back().set_id(i);
+	}
+
+	std::vector<Collision> collisions;
+	int checks = SpatialPartitioning::gather_parallel(4, [&bodies](int unit, std::vector<Collision>& unit_collisions)
+	{
+		unit_collisions.emplace_back(Body::get_sorted_pair(bodies[2 * unit], bodies[2 * unit + 1]));
+		return unit + 1;
+	}, collisions);
+
+	EXPECT_EQ(checks, 1 + 2 + 3 + 4);
+	ASSERT_EQ(collisions.size(), 4);
+
+	for (int i = 0; i < 4; i++)
+	{
+		int id_sum = collisions[i].bigger.get_id() + collisions[i].smaller.get_id();
+		EXPECT_EQ(id_sum, 4 * i + 1);
+	}
+}
+
+TEST(SweepAndPrune, RemBodyMovedSinceUpdate)
+{
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ radius, 0, mass },
+		{ 1.5f * radius, 0, mass },
+	};
+
+	SweepAndPrune partitioning;
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		partitioning.add_body(bodies[i]);
+	}
+
+	partitioning.update();
+
+	// Endpoints are still sorted by where body 1 was, not where it is now.
+	bodies[1].set_pos({ 50 * radius, 0 });
+	partitioning.rem_body(bodies[1]);
+	partitioning.update();
+
+	auto collisions = partitioning.get_collisions();
+	ASSERT_EQ(collisions.size(), 1);
+	EXPECT_EQ(collisions[0].bigger.get_id() + collisions[0].smaller.get_id(), 2);
+	EXPECT_EQ(partitioning.find_body(bodies[1].pos()), nullptr);
+	EXPECT_EQ(partitioning.get_representation().size(), 4);
+}
+
+TEST(NeighbourList, RebuildsOnlyAfterDrift)
+{
+	constexpr float skin = 20.0f;
+	NeighbourList lists { std::make_unique<Grid>(2000.0f, 10), skin };
+
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	// Body 1 starts just outside the skin of touching body 0, body 2 just inside it.
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ 2 * radius + skin + 1, 0, mass },
+		{ 0, 2 * radius + skin - 1, mass },
+	};
+
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		lists.add_body(bodies[i]);
+	}
+
+	lists.update();
+	EXPECT_EQ(lists.get_num_rebuilds(), 1);
+	EXPECT_EQ(lists.get_num_pairs(), 1);
+	EXPECT_TRUE(lists.get_collisions().empty());
+
+	// Moving body 2 less than half the skin keeps the lists.
+	bodies[2].set_pos({ 0, 2 * radius + skin / 2 });
+	lists.update();
+	EXPECT_EQ(lists.get_num_rebuilds(), 1);
+	EXPECT_FALSE(lists.was_rebuilt_tick());
+	EXPECT_TRUE(lists.get_collisions().empty());
+
+	// Moving body 1 into body 0 drifts by more than half the skin, so the lists are rebuilt and the collision found.
+	bodies[1].set_pos({ radius, 0 });
+	lists.update();
+	EXPECT_EQ(lists.get_num_rebuilds(), 2);
+	EXPECT_TRUE(lists.was_rebuilt_tick());
+
+	auto collisions = lists.get_collisions();
+	ASSERT_EQ(collisions.size(), 1);
+	EXPECT_EQ(collisions[0].bigger.get_id() + collisions[0].smaller.get_id(), 1);
+}
+
+TEST(NeighbourList, RoamingBodiesCollide)
+{
+	constexpr float skin = 20.0f;
+	NeighbourList lists { std::make_unique<LineSweep>(), skin };
+
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	std::vector<Body> bodies
+	{
+		{ 0, 0, mass },
+		{ 100 * radius, 0, mass },
+		{ 0, 100 * radius, mass },
+	};
+
+	// Body 2 moves too fast to be listed.
+	bodies[2].set_vel({ 0, -skin });
+
+	for (int i = 0; i < bodies.size(); ++i)
+	{
+		bodies[i].set_id(i);
+		lists.add_body(bodies[i]);
+	}
+
+	lists.update();
+	EXPECT_EQ(lists.get_num_roaming(), 1);
+	EXPECT_TRUE(lists.get_collisions().empty());
+
+	// A roaming body doesn't cause a rebuild when it moves, and still finds its collisions.
+	bodies[2].set_pos({ 0, radius });
+	lists.update();
+	EXPECT_EQ(lists.get_num_rebuilds(), 1);
+
+	auto collisions = lists.get_collisions();
+	ASSERT_EQ(collisions.size(), 1);
+	EXPECT_EQ(collisions[0].bigger.get_id() + collisions[0].smaller.get_id(), 2);
+}
+
+TEST(SweptCollisions, FindsBodiesPassingThrough)
+{
+	BodyList bodies;
+	LineSweep line_sweep;
+	SpatialPartitioning& partitioning = line_sweep;
+
+	constexpr int mass = 500;
+	auto radius = Body{ 0,0, mass }.get_radius();
+
+	// Body 1 jumps past body 0 in a single tick. Body 2 moves just as fast, but off to the side.
+	Body& still = bodies.add({ 0, 0, mass });
+	Body& passing = bodies.add({ 10 * radius, 0, mass });
+	Body& beside = bodies.add({ 10 * radius, 5 * radius, mass });
+	passing.set_vel({ 20 * radius, 0 });
+	beside.set_vel({ 20 * radius, 0 });
+
+	for (Body& body : bodies)
+	{
+		partitioning.add_body(body);
+	}
+	partitioning.update();
+
+	// Neither is touching body 0 at the end of the tick.
+	EXPECT_TRUE(partitioning.get_collisions().empty());
+
+	std::vector<SweptCollisions::Impact> impacts = SweptCollisions::find_missed(bodies, partitioning);
+	ASSERT_EQ(impacts.size(), 1);
+	EXPECT_EQ(impacts[0].collision.bigger.get_id() + impacts[0].collision.smaller.get_id(), still.get_id() + passing.get_id());
+	EXPECT_NE(impacts[0].collision.bigger, impacts[0].collision.smaller);
+
+	// Body 1 started 10 radii to the left of where body 0 is, and touched it after moving 8 of its 20 radii.
+	EXPECT_NEAR(impacts[0].time, 8.0f / 20, 0.001f);
+}
+
+TEST(SweptCollisions, AbsorberFiledWhereItMovesOnTo)
+{
+	UniverseSettings settings;
+	settings.universe_size_max = 2000.0f;
+	settings.num_rand_systems = 0;
+	settings.num_rand_planets = 0;
+	settings.grav_const = 0.0;
+	settings.continuous_collisions = true;
+	Universe universe { settings, std::make_unique<QuadTree>(2000.0f, 1, 10) };
+
+	// Bodies in the corners split the tree, so positions either side of the middle are in different nodes.
+	std::vector<Body> bodies
+	{
+		{ -800, -800, 10 },
+		{ 800, -800, 10 },
+		{ -800, 800, 10 },
+		{ 800, 800, 10 },
+		{ -400, 200, 1000 },
+		{ -700, 200, 2000 },
+	};
+	bodies.back().set_vel({ 800, 0 });
+	universe.add_bodies(std::move(bodies));
+
+	// The fast body ends the tick right of the middle, passing through the slow one, which puts it back left of it.
+	universe.update();
+	ASSERT_EQ(universe.get_num_bodies(), 5);
+
+	Body* absorber = universe.get_body(5);
+	ASSERT_NE(absorber, nullptr);
+	EXPECT_LT(absorber->pos().x, 0.0f);
+	EXPECT_EQ(universe.get_body(absorber->pos()), absorber);
+
+	universe.rem_body(*absorber);
+	EXPECT_EQ(universe.get_partitioning().query_rect({ -1000, -1000, 2000, 2000 }).size(), 4);
+}
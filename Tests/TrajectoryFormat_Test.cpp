@@ -0,0 +1,193 @@
+#include "pch.h"
+
+#include "TrajectoryFormat.h"
+#include "ByteStream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace
+{
+	// A power of two, so every multiple of it the tests use is exact as a float.
+	constexpr float STEP = 1.0f / 64;
+
+	// Adds a body whose velocity drifts a little each tick, so deltas aren't all zero.
+	void add_body(TrajectoryFrame& frame, int id, int tick)
+	{
+		Vector2 vel { 3.0f + id + 0.01f * tick * tick, -2.0f + 0.37f * id - 0.02f * tick };
+		Vector2 pos { -400.0f + 70.0f * id + vel.x * tick, 300.0f - 45.0f * id + vel.y * tick };
+
+		frame.ids.push_back(id);
+		frame.positions.push_back(pos);
+		frame.velocities.push_back(vel);
+		frame.masses.push_back(100 + 10 * id + tick / 3);
+	}
+
+	TrajectoryFrame make_frame(int tick, const std::vector<int>& ids)
+	{
+		TrajectoryFrame frame;
+		frame.tick = tick;
+		for (int id : ids)
+		{
+			add_body(frame, id, tick);
+		}
+
+		return frame;
+	}
+
+	// Decoded frames are ordered by id, so each decoded body is looked up in the original frame by its id.
+	void expect_decoded(const TrajectoryFrame& original, const TrajectoryFrame& decoded)
+	{
+		ASSERT_EQ(decoded.tick, original.tick);
+		ASSERT_EQ(decoded.get_num_bodies(), original.get_num_bodies());
+
+		for (int i = 0; i < decoded.get_num_bodies(); i++)
+		{
+			if (i > 0)
+			{
+				EXPECT_LT(decoded.ids[i - 1], decoded.ids[i]);
+			}
+
+			auto it = std::find(original.ids.begin(), original.ids.end(), decoded.ids[i]);
+			ASSERT_NE(it, original.ids.end());
+			int j = it - original.ids.begin();
+
+			EXPECT_LE(std::abs(decoded.positions[i].x - original.positions[j].x), STEP / 2);
+			EXPECT_LE(std::abs(decoded.positions[i].y - original.positions[j].y), STEP / 2);
+			EXPECT_LE(std::abs(decoded.velocities[i].x - original.velocities[j].x), STEP / 2);
+			EXPECT_LE(std::abs(decoded.velocities[i].y - original.velocities[j].y), STEP / 2);
+			EXPECT_EQ(decoded.masses[i], original.masses[j]);
+		}
+	}
+
+	// Encodes the frames one after another, as a keyframe every keyframe_every frames, and decodes them back.
+	void expect_round_trip(const std::vector<TrajectoryFrame>& frames, int keyframe_every)
+	{
+		std::vector<std::byte> payload;
+		ByteWriter writer { payload };
+		TrajectoryEncoder encoder { STEP };
+
+		for (int i = 0; i < frames.size(); i++)
+		{
+			encoder.encode(frames[i], i % keyframe_every == 0, writer);
+		}
+
+		ByteReader reader { payload };
+		TrajectoryDecoder decoder { STEP };
+		TrajectoryFrame decoded;
+
+		for (const TrajectoryFrame& frame : frames)
+		{
+			ASSERT_TRUE(decoder.decode(reader, decoded));
+			expect_decoded(frame, decoded);
+		}
+
+		EXPECT_EQ(reader.position(), payload.size());
+	}
+}
+
+TEST(TrajectoryFormat, KeyframesAndDeltas)
+{
+	// Ids out of order, since recorded frames list bodies in any order.
+	std::vector<TrajectoryFrame> frames;
+	for (int tick = 0; tick < 10; tick++)
+	{
+		frames.push_back(make_frame(tick, { 4, 0, 2, 9, 1 }));
+	}
+
+	expect_round_trip(frames, 4);
+}
+
+TEST(TrajectoryFormat, RecordEvery)
+{
+	// Frames 5 ticks apart, so positions are predicted over several ticks of velocity.
+	std::vector<TrajectoryFrame> frames;
+	for (int tick = 0; tick < 60; tick += 5)
+	{
+		frames.push_back(make_frame(tick, { 0, 1, 2, 3 }));
+	}
+
+	expect_round_trip(frames, 5);
+}
+
+TEST(TrajectoryFormat, BodiesCreatedAndRemoved)
+{
+	std::vector<TrajectoryFrame> frames;
+	frames.push_back(make_frame(0, { 0, 1, 2, 3 }));
+
+	// Body 1 is absorbed by body 0, body 3 is deleted without being listed, and bodies 4 and 7 are created.
+	frames.push_back(make_frame(1, { 7, 0, 2, 4 }));
+	frames[1].removed.push_back({ 1, 0 });
+
+	// Listed removals of bodies that were never recorded are dropped.
+	frames.push_back(make_frame(2, { 0, 2, 4, 7 }));
+	frames[2].removed.push_back({ 8, 0 });
+
+	expect_round_trip(frames, 100);
+
+	std::vector<std::byte> payload;
+	ByteWriter writer { payload };
+	TrajectoryEncoder encoder { STEP };
+	for (const TrajectoryFrame& frame : frames)
+	{
+		encoder.encode(frame, false, writer);
+	}
+
+	ByteReader reader { payload };
+	TrajectoryDecoder decoder { STEP };
+	TrajectoryFrame decoded;
+
+	ASSERT_TRUE(decoder.decode(reader, decoded));
+	EXPECT_TRUE(decoded.removed.empty());
+	EXPECT_TRUE(decoded.created.empty());
+
+	ASSERT_TRUE(decoder.decode(reader, decoded));
+	ASSERT_EQ(decoded.removed.size(), 2);
+	EXPECT_EQ(decoded.removed[0].id, 1);
+	EXPECT_EQ(decoded.removed[0].absorbed_by, 0);
+	EXPECT_EQ(decoded.removed[1].id, 3);
+	EXPECT_EQ(decoded.removed[1].absorbed_by, -1);
+	EXPECT_EQ(decoded.created, (std::vector<int> { 4, 7 }));
+
+	ASSERT_TRUE(decoder.decode(reader, decoded));
+	EXPECT_TRUE(decoded.removed.empty());
+	EXPECT_TRUE(decoded.created.empty());
+}
+
+TEST(TrajectoryFormat, TruncatedPayload)
+{
+	std::vector<TrajectoryFrame> frames { make_frame(0, { 0, 1, 2 }), make_frame(1, { 0, 1, 2 }) };
+
+	std::vector<std::byte> payload;
+	ByteWriter writer { payload };
+	TrajectoryEncoder encoder { STEP };
+	encoder.encode(frames[0], true, writer);
+	size_t keyframe_size = payload.size();
+	encoder.encode(frames[1], false, writer);
+
+	TrajectoryDecoder decoder { STEP };
+	TrajectoryFrame decoded;
+
+	// Every cut short of the whole keyframe fails.
+	for (size_t size = 0; size < keyframe_size; size++)
+	{
+		ByteReader reader { std::span(payload).first(size) };
+		EXPECT_FALSE(decoder.decode(reader, decoded)) << "keyframe cut to " << size << " bytes";
+	}
+
+	// A delta frame cut short fails, and the decoder then needs a keyframe again.
+	ByteReader cut { std::span(payload).first(payload.size() - 1) };
+	ASSERT_TRUE(decoder.decode(cut, decoded));
+	expect_decoded(frames[0], decoded);
+	EXPECT_FALSE(decoder.decode(cut, decoded));
+
+	ByteReader delta_only { std::span(payload).subspan(keyframe_size) };
+	EXPECT_FALSE(decoder.decode(delta_only, decoded));
+
+	ByteReader whole { payload };
+	ASSERT_TRUE(decoder.decode(whole, decoded));
+	ASSERT_TRUE(decoder.decode(whole, decoded));
+	expect_decoded(frames[1], decoded);
+}
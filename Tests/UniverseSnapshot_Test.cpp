@@ -0,0 +1,189 @@
+#include "pch.h"
+
+#include "UniverseSnapshot.h"
+#include "Universe.h"
+#include "QuadTree.h"
+#include "Grid.h"
+#include "LineSweep.h"
+#include "SweepAndPrune.h"
+#include "DynamicAABBTree.h"
+#include "BarnesHutPartitioning.h"
+#include "NullPartitioning.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace
+{
+	constexpr float UNIVERSE_SIZE = 2000.0f;
+
+	using PartitioningFactory = std::unique_ptr<SpatialPartitioning>(*)();
+
+	struct SnapshotParam
+	{
+		PartitioningFactory make_partitioning;
+		bool neighbour_lists;
+	};
+
+	template <class T>
+	std::unique_ptr<SpatialPartitioning> make_default()
+	{
+		return std::make_unique<T>();
+	}
+
+	std::unique_ptr<SpatialPartitioning> make_quad_tree()
+	{
+		return std::make_unique<QuadTree>(UNIVERSE_SIZE, 2, 10);
+	}
+
+	std::unique_ptr<SpatialPartitioning> make_grid()
+	{
+		return std::make_unique<Grid>(UNIVERSE_SIZE, 10);
+	}
+
+	std::unique_ptr<SpatialPartitioning> make_barnes_hut()
+	{
+		return std::make_unique<BarnesHutPartitioning>(UNIVERSE_SIZE, 0.5f);
+	}
+
+	UniverseSettings make_settings(const SnapshotParam& param)
+	{
+		UniverseSettings settings;
+		settings.universe_size_max = UNIVERSE_SIZE;
+		settings.num_rand_systems = 0;
+		settings.use_neighbour_lists = param.neighbour_lists;
+		return settings;
+	}
+
+	// Adds bodies spread out in a grid, far enough apart that none merge, and ticks once.
+	void fill(Universe& universe)
+	{
+		std::vector<Body> bodies;
+		for (int x = -5; x < 5; x++)
+		{
+			for (int y = -5; y < 5; y++)
+			{
+				bodies.emplace_back(x * 150.0f + 20.0f, y * 150.0f + 20.0f, 50 + 10 * (x + y + 10));
+			}
+		}
+
+		universe.add_bodies(std::move(bodies));
+		universe.update();
+	}
+}
+
+class SnapshotTestFixture : public testing::TestWithParam<SnapshotParam>
+{
+};
+
+TEST_P(SnapshotTestFixture, PartitioningInfo)
+{
+	Universe universe { make_settings(GetParam()), GetParam().make_partitioning() };
+	fill(universe);
+
+	Rectangle area { -400.0f, -400.0f, 600.0f, 500.0f };
+	UniverseSnapshot snapshot;
+	snapshot.capture(universe, false, area);
+
+	int num_in_area = 0;
+	for (const Body& body : snapshot.get_bodies())
+	{
+		const DebugInfo* info = snapshot.get_partitioning_info(body.get_id());
+		if (!body.intersects_rect(area))
+		{
+			EXPECT_EQ(info, nullptr);
+			continue;
+		}
+
+		num_in_area++;
+		ASSERT_NE(info, nullptr) << "body " << body.get_id();
+
+		// Partitionings that know bodies by address would say they don't know the snapshot's copies.
+		EXPECT_EQ(std::string(info->get()).find("not listed"), std::string::npos) << info->get();
+	}
+
+	EXPECT_GT(num_in_area, 0);
+}
+
+TEST_P(SnapshotTestFixture, AreaQueries)
+{
+	Universe universe { make_settings(GetParam()), GetParam().make_partitioning() };
+	fill(universe);
+
+	UniverseSnapshot snapshot;
+	snapshot.capture(universe, false, std::nullopt);
+
+	for (Rectangle area : { Rectangle{ -400.0f, -400.0f, 600.0f, 500.0f }, Rectangle{ -5000.0f, -5000.0f, 10000.0f, 10000.0f },
+		Rectangle{ 2000.0f, 2000.0f, 100.0f, 100.0f }, Rectangle{ 10.0f, 10.0f, 0.0f, 0.0f } })
+	{
+		std::vector<const Body*> expected;
+		for (const Body& body : snapshot.get_bodies())
+		{
+			if (body.intersects_rect(area))
+			{
+				expected.push_back(&body);
+			}
+		}
+
+		EXPECT_EQ(snapshot.get_bodies_in_area(area), expected);
+	}
+
+	for (const Body& body : snapshot.get_bodies())
+	{
+		EXPECT_EQ(snapshot.get_body(body.pos()), &body);
+	}
+
+	EXPECT_EQ(snapshot.get_body(Vector2{ 95.0f, 95.0f }), nullptr);
+}
+
+TEST_P(SnapshotTestFixture, InterpolationSnapsOverJumps)
+{
+	Universe universe { make_settings(GetParam()), GetParam().make_partitioning() };
+	fill(universe);
+
+	UniverseSnapshot snapshot;
+	snapshot.capture(universe, false, std::nullopt);
+
+	std::span<const Body> bodies = snapshot.get_bodies();
+	ASSERT_GE(bodies.size(), 3);
+	const Body& wrapped = bodies[0];
+	const Body& moved = bodies[1];
+	const Body& absorber = bodies[2];
+
+	Vector2 offset { 10.0f, -20.0f };
+	std::vector<Vector2> published_positions(universe.get_bodies().size() + 1);
+	published_positions[wrapped.get_id()] = Vector2Add(wrapped.pos(), Vector2{ UNIVERSE_SIZE * 0.9f, 0.0f });
+	published_positions[moved.get_id()] = Vector2Add(moved.pos(), offset);
+	published_positions[absorber.get_id()] = Vector2Add(absorber.pos(), offset);
+
+	Vector2 wrapped_pos = wrapped.pos();
+	Vector2 moved_pos = moved.pos();
+	Vector2 absorber_pos = absorber.pos();
+
+	std::vector<Removal> removals { { static_cast<int>(published_positions.size()) - 1, absorber.get_id() } };
+	snapshot.set_prev_positions(published_positions, removals);
+
+	auto now = std::chrono::steady_clock::now();
+	snapshot.set_published(now, std::chrono::seconds(2));
+	snapshot.interpolate(now + std::chrono::seconds(1));
+
+	EXPECT_EQ(wrapped.pos().x, wrapped_pos.x);
+	EXPECT_EQ(wrapped.pos().y, wrapped_pos.y);
+	EXPECT_FLOAT_EQ(moved.pos().x, moved_pos.x + offset.x / 2);
+	EXPECT_FLOAT_EQ(moved.pos().y, moved_pos.y + offset.y / 2);
+	EXPECT_EQ(absorber.pos().x, absorber_pos.x);
+	EXPECT_EQ(absorber.pos().y, absorber_pos.y);
+}
+
+INSTANTIATE_TEST_CASE_P(SnapshotPartitionings, SnapshotTestFixture,
+	testing::Values(SnapshotParam{ &make_quad_tree, false },
+		SnapshotParam{ &make_grid, false },
+		SnapshotParam{ &make_default<LineSweep>, false },
+		SnapshotParam{ &make_default<SweepAndPrune>, false },
+		SnapshotParam{ &make_default<DynamicAABBTree>, false },
+		SnapshotParam{ &make_barnes_hut, false },
+		SnapshotParam{ &make_default<NullPartitioning>, false },
+		SnapshotParam{ &make_default<LineSweep>, true },
+		SnapshotParam{ &make_default<DynamicAABBTree>, true },
+		SnapshotParam{ &make_default<SweepAndPrune>, true }));